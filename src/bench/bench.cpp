@@ -0,0 +1,473 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2023 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "bench.h"
+#include "../engine/mixer.h"
+#include "../ta-log.h"
+#include "../fileutils.h"
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+
+#define BENCH_RATE 44100
+#define BENCH_BUFSIZE 1024
+// cap for the sequencer benchmark (in ticks)
+#define BENCH_MAX_TICKS 1000000
+
+#define TIME_START std::chrono::steady_clock::time_point benchStart=std::chrono::steady_clock::now();
+#define TIME_END std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-benchStart).count()
+
+struct FurnaceBenchCore {
+  const char* confKey;
+  DivSystem sys;
+  int count;
+  const char* names[3];
+};
+
+// chips with more than one core. every core is measured.
+static const FurnaceBenchCore benchCores[]={
+  {"ym2612Core", DIV_SYSTEM_YM2612, 3, {"Nuked-OPN2", "ymfm", "YMF276-LLE"}},
+  {"arcadeCore", DIV_SYSTEM_YM2151, 2, {"ymfm", "Nuked-OPM", NULL}},
+  {"snCore", DIV_SYSTEM_SMS, 2, {"MAME", "Nuked-PSG", NULL}},
+  {"nesCore", DIV_SYSTEM_NES, 2, {"puNES", "NSFplay", NULL}},
+  {"fdsCore", DIV_SYSTEM_FDS, 2, {"puNES", "NSFplay", NULL}},
+  {"c64Core", DIV_SYSTEM_C64_6581, 3, {"reSID", "reSIDfp", "dSID"}},
+  {"pokeyCore", DIV_SYSTEM_POKEY, 2, {"mzpokeysnd", "ASAP", NULL}},
+  {"opnCore", DIV_SYSTEM_YM2610_FULL, 2, {"ymfm", "Nuked-OPN2+ymfm", NULL}},
+  {"opl2Core", DIV_SYSTEM_OPL2, 3, {"Nuked-OPL3", "ymfm", "YM3812-LLE"}},
+  {"opl3Core", DIV_SYSTEM_OPL3, 3, {"Nuked-OPL3", "ymfm", "YMF262-LLE"}}
+};
+
+#define BENCH_CORE_COUNT (int)(sizeof(benchCores)/sizeof(FurnaceBenchCore))
+
+// defaults used by the engine when there is no config
+static const int benchCoreDefaults[BENCH_CORE_COUNT]={
+  0, 0, 0, 0, 0, 0, 1, 1, 0, 0
+};
+
+void FurnaceBenchResult::calcStats() {
+  if (times.empty()) return;
+  std::vector<double> sorted=times;
+  std::sort(sorted.begin(),sorted.end());
+  min=sorted.front();
+  max=sorted.back();
+  if (sorted.size()&1) {
+    median=sorted[sorted.size()>>1];
+  } else {
+    median=(sorted[(sorted.size()>>1)-1]+sorted[sorted.size()>>1])*0.5;
+  }
+  mean=0.0;
+  for (double i: sorted) mean+=i;
+  mean/=(double)sorted.size();
+  stdDev=0.0;
+  for (double i: sorted) stdDev+=(i-mean)*(i-mean);
+  stdDev=sqrt(stdDev/(double)sorted.size());
+}
+
+void FurnaceBench::bindEngine(DivEngine* eng) {
+  e=eng;
+}
+
+void FurnaceBench::setOptions(int runCount, int warmupRuns, double seconds, const String& nameFilter, bool list) {
+  runs=MAX(1,runCount);
+  warmup=MAX(0,warmupRuns);
+  chipSeconds=seconds;
+  filter=nameFilter;
+  listOnly=list;
+}
+
+void FurnaceBench::addSong(const String& path) {
+  songs.push_back(path);
+}
+
+bool FurnaceBench::wanted(const String& name) {
+  if (filter.empty()) return true;
+  return name.find(filter)!=String::npos;
+}
+
+void FurnaceBench::measure(const String& name, const String& group, double audioLen, const std::function<double()>& func) {
+  if (!wanted(name)) return;
+  if (listOnly) {
+    printf("%s\n",name.c_str());
+    return;
+  }
+  logI("running %s...",name);
+  FurnaceBenchResult result(name,group,audioLen);
+  for (int i=0; i<warmup+runs; i++) {
+    double t=func();
+    if (t<0.0) {
+      logW("%s: failed. skipping",name);
+      return;
+    }
+    if (i>=warmup) result.times.push_back(t);
+  }
+  result.calcStats();
+  results.push_back(result);
+}
+
+// render some seconds of audio from a chip, with a note playing on every channel.
+// returns the time spent in acquire() in milliseconds. fillTime receives the time spent in fillBuf().
+double FurnaceBench::runDispatch(DivSystem sys, double seconds, double* fillTime) {
+  const DivSysDef* def=e->getSystemDef(sys);
+  if (def==NULL) return -1.0;
+
+  DivDispatchContainer dc;
+  DivConfig flags;
+  dc.init(sys,e,def->channels,BENCH_RATE,flags);
+  if (dc.dispatch==NULL) return -1.0;
+  dc.setRates(BENCH_RATE);
+  dc.setQuality(false,true);
+  if (dc.bb[0]==NULL) {
+    dc.quit();
+    return -1.0;
+  }
+
+  for (int i=0; i<def->channels; i++) {
+    int volMax=dc.dispatch->dispatch(DivCommand(DIV_CMD_GET_VOLMAX,i));
+    dc.dispatch->dispatch(DivCommand(DIV_CMD_INSTRUMENT,i,0,1));
+    dc.dispatch->dispatch(DivCommand(DIV_CMD_VOLUME,i,volMax));
+    dc.dispatch->dispatch(DivCommand(DIV_CMD_NOTE_ON,i,48+(i%12)));
+  }
+  dc.dispatch->tick();
+
+  size_t total=(size_t)(seconds*BENCH_RATE);
+  size_t done=0;
+  double acquireTime=0.0;
+  *fillTime=0.0;
+  while (done<total) {
+    size_t size=MIN(BENCH_BUFSIZE,total-done);
+    dc.lastAvail=blip_samples_avail(dc.bb[0]);
+    if (dc.lastAvail>0) dc.flush(dc.lastAvail);
+    if (size<dc.lastAvail) {
+      dc.runtotal=0;
+    } else {
+      dc.runtotal=blip_clocks_needed(dc.bb[0],size-dc.lastAvail);
+    }
+    if (dc.runtotal>dc.bbInLen) dc.grow(dc.runtotal+256);
+
+    // roughly one tick per buffer
+    dc.dispatch->tick();
+
+    {
+      TIME_START;
+      dc.acquire(0,dc.runtotal);
+      acquireTime+=TIME_END;
+    }
+    {
+      TIME_START;
+      dc.fillBuf(dc.runtotal,dc.lastAvail,size-dc.lastAvail);
+      *fillTime+=TIME_END;
+    }
+    done+=size;
+  }
+
+  dc.quit();
+  return acquireTime;
+}
+
+void FurnaceBench::benchDispatches() {
+  // chip cores
+  // each chip is rendered once per run, and acquire/fillBuf are reported separately.
+  auto benchChip=[this](DivSystem sys, const String& name) {
+    String acquireName="chip/"+name+"/acquire";
+    String fillName="chip/"+name+"/fillBuf";
+    bool wantAcquire=wanted(acquireName);
+    bool wantFill=wanted(fillName);
+    if (!wantAcquire && !wantFill) return;
+    if (listOnly) {
+      if (wantAcquire) printf("%s\n",acquireName.c_str());
+      if (wantFill) printf("%s\n",fillName.c_str());
+      return;
+    }
+    logI("running chip/%s...",name);
+    FurnaceBenchResult acquireResult(acquireName,"chip",chipSeconds);
+    FurnaceBenchResult fillResult(fillName,"fillBuf",chipSeconds);
+    for (int i=0; i<warmup+runs; i++) {
+      double fillTime=0.0;
+      double t=runDispatch(sys,chipSeconds,&fillTime);
+      if (t<0.0) {
+        logW("%s: could not initialize chip. skipping",name);
+        return;
+      }
+      if (i>=warmup) {
+        acquireResult.times.push_back(t);
+        fillResult.times.push_back(fillTime);
+      }
+    }
+    acquireResult.calcStats();
+    fillResult.calcStats();
+    if (wantAcquire) results.push_back(acquireResult);
+    if (wantFill) results.push_back(fillResult);
+  };
+
+  // remember the core settings so that they can be restored later
+  int oldCores[BENCH_CORE_COUNT];
+  for (int i=0; i<BENCH_CORE_COUNT; i++) {
+    oldCores[i]=e->getConfInt(benchCores[i].confKey,benchCoreDefaults[i]);
+    e->setConf(benchCores[i].confKey,benchCoreDefaults[i]);
+  }
+
+  // every chip with default cores
+  for (int i=1; i<DIV_MAX_CHIP_DEFS; i++) {
+    DivSystem sys=(DivSystem)i;
+    const DivSysDef* def=e->getSystemDef(sys);
+    if (def==NULL) continue;
+    // may drive the real PC speaker
+    if (sys==DIV_SYSTEM_PCSPKR) continue;
+    bool hasCores=false;
+    for (int j=0; j<BENCH_CORE_COUNT; j++) {
+      if (benchCores[j].sys==sys) {
+        hasCores=true;
+        break;
+      }
+    }
+    if (hasCores) continue;
+    benchChip(sys,def->name);
+  }
+
+  // chips with more than one core
+  for (int i=0; i<BENCH_CORE_COUNT; i++) {
+    const DivSysDef* def=e->getSystemDef(benchCores[i].sys);
+    if (def==NULL) continue;
+    for (int j=0; j<benchCores[i].count; j++) {
+      e->setConf(benchCores[i].confKey,j);
+      benchChip(benchCores[i].sys,fmt::sprintf("%s/%s",def->name,benchCores[i].names[j]));
+    }
+    e->setConf(benchCores[i].confKey,benchCoreDefaults[i]);
+  }
+
+  for (int i=0; i<BENCH_CORE_COUNT; i++) {
+    e->setConf(benchCores[i].confKey,oldCores[i]);
+  }
+}
+
+void FurnaceBench::benchMixer() {
+  // one second of stereo audio from 8 chip outputs
+  const size_t len=BENCH_RATE;
+  std::vector<short> src(len);
+  std::vector<float> outL(len), outR(len);
+  std::vector<float> ring(32768);
+  for (size_t i=0; i<len; i++) {
+    src[i]=(short)((i*1103515245+12345)>>8);
+  }
+
+  measure("mixer/addShort","mixer",1.0,[&]() -> double {
+    TIME_START;
+    for (size_t pos=0; pos<len; pos+=BENCH_BUFSIZE) {
+      size_t size=MIN((size_t)BENCH_BUFSIZE,len-pos);
+      for (int i=0; i<8; i++) {
+        DivMixer::addShort(&outL[pos],&src[pos],0.5f/32768.0f,size);
+        DivMixer::addShort(&outR[pos],&src[pos],0.5f/32768.0f,size);
+      }
+    }
+    return TIME_END;
+  });
+
+  measure("mixer/finish","mixer",1.0,[&]() -> double {
+    float* out[2];
+    TIME_START;
+    size_t ringPos=0;
+    for (size_t pos=0; pos<len; pos+=BENCH_BUFSIZE) {
+      size_t size=MIN((size_t)BENCH_BUFSIZE,len-pos);
+      out[0]=&outL[pos];
+      out[1]=&outR[pos];
+      DivMixer::copyToRing(ring.data(),32768,ringPos,out[0],size);
+      ringPos=(ringPos+size)&32767;
+      DivMixer::finish(out,2,size,false,true);
+    }
+    return TIME_END;
+  });
+}
+
+void FurnaceBench::benchSong(const String& path) {
+  String base=path;
+  size_t slash=base.find_last_of("/\\");
+  if (slash!=String::npos) base=base.substr(slash+1);
+
+  FILE* f=ps_fopen(path.c_str(),"rb");
+  if (f==NULL) {
+    logE("could not open %s! (%s)",path,strerror(errno));
+    return;
+  }
+  std::vector<unsigned char> data;
+  unsigned char buf[4096];
+  size_t got;
+  while ((got=fread(buf,1,4096,f))>0) {
+    data.insert(data.end(),buf,buf+got);
+  }
+  fclose(f);
+
+  auto loadSong=[this,&data]() -> bool {
+    unsigned char* copy=new unsigned char[data.size()];
+    memcpy(copy,data.data(),data.size());
+    // load() takes ownership of the buffer
+    return e->load(copy,data.size());
+  };
+
+  if (!loadSong()) {
+    logE("could not load %s! (%s)",path,e->getLastError());
+    return;
+  }
+
+  measure("song/"+base+"/load","load",0.0,[&]() -> double {
+    unsigned char* copy=new unsigned char[data.size()];
+    memcpy(copy,data.data(),data.size());
+    TIME_START;
+    bool ok=e->load(copy,data.size());
+    double t=TIME_END;
+    return ok?t:-1.0;
+  });
+
+  measure("song/"+base+"/save","save",0.0,[&]() -> double {
+    TIME_START;
+    SafeWriter* w=e->saveFur();
+    double t=TIME_END;
+    if (w==NULL) return -1.0;
+    w->finish();
+    delete w;
+    return t;
+  });
+
+  measure("song/"+base+"/renderSamples","samples",0.0,[&]() -> double {
+    TIME_START;
+    e->renderSamples();
+    return TIME_END;
+  });
+
+  // sequencer only (no chip rendering)
+  measure("song/"+base+"/sequencer","sequencer",0.0,[&]() -> double {
+    e->curOrder=0;
+    e->prevOrder=0;
+    e->remainingLoops=1;
+    e->playSub(false);
+    TIME_START;
+    for (int i=0; i<BENCH_MAX_TICKS; i++) {
+      if (e->nextTick()) break;
+    }
+    double t=TIME_END;
+    e->stop();
+    return t;
+  });
+
+  // whole playback. the stages come from the profiler.
+  String stageNames[4]={"tick", "render", "fill", "mix"};
+  DivProfilerStage stages[4]={DIV_PROF_TICK, DIV_PROF_RENDER, DIV_PROF_FILL, DIV_PROF_MIX};
+  std::vector<FurnaceBenchResult> stageResults;
+  for (int i=0; i<4; i++) {
+    stageResults.push_back(FurnaceBenchResult("song/"+base+"/playback/"+stageNames[i],"playback",0.0));
+  }
+  double songLen=0.0;
+  bool profilerWasOn=e->profiler.enabled;
+  measure("song/"+base+"/playback","playback",0.0,[&]() -> double {
+    float* outBuf[2];
+    std::vector<float> outL(BENCH_BUFSIZE), outR(BENCH_BUFSIZE);
+    outBuf[0]=outL.data();
+    outBuf[1]=outR.data();
+
+    e->curOrder=0;
+    e->prevOrder=0;
+    e->remainingLoops=1;
+    e->playSub(false);
+    e->profiler.reset();
+    e->profiler.enabled=true;
+
+    size_t frames=0;
+    TIME_START;
+    while (e->playing) {
+      e->nextBuf(NULL,outBuf,0,2,BENCH_BUFSIZE);
+      frames+=BENCH_BUFSIZE;
+    }
+    double t=TIME_END;
+    songLen=(double)frames/(double)e->got.rate;
+    for (int i=0; i<4; i++) {
+      stageResults[i].times.push_back((double)e->profiler.stage[stages[i]].total/1000000.0);
+    }
+    return t;
+  });
+  e->enableProfiler(profilerWasOn);
+  if (!results.empty() && results.back().name=="song/"+base+"/playback") {
+    results.back().audioLen=songLen;
+    for (FurnaceBenchResult& i: stageResults) {
+      // drop warm-up runs
+      i.times.erase(i.times.begin(),i.times.begin()+MIN((size_t)warmup,i.times.size()));
+      i.audioLen=songLen;
+      i.calcStats();
+      results.push_back(i);
+    }
+  }
+}
+
+void FurnaceBench::run() {
+  results.clear();
+  benchDispatches();
+  benchMixer();
+  for (String& i: songs) {
+    benchSong(i);
+  }
+}
+
+String FurnaceBench::toJSON() {
+  String ret="{\n";
+  ret+="  \"version\": \"" DIV_VERSION "\",\n";
+  ret+=fmt::sprintf("  \"runs\": %d,\n",runs);
+  ret+=fmt::sprintf("  \"warmup\": %d,\n",warmup);
+  ret+="  \"unit\": \"ms\",\n";
+  ret+="  \"results\": [\n";
+  for (size_t i=0; i<results.size(); i++) {
+    FurnaceBenchResult& r=results[i];
+    String name;
+    for (char c: r.name) {
+      if (c=='"' || c=='\\') name+='\\';
+      name+=c;
+    }
+    ret+=fmt::sprintf("    {\"name\": \"%s\", \"group\": \"%s\", \"min\": %.4f, \"median\": %.4f, \"mean\": %.4f, \"stdDev\": %.4f, \"max\": %.4f, \"audioLen\": %.3f, \"realTime\": %.2f}%s\n",
+      name,r.group,r.min,r.median,r.mean,r.stdDev,r.max,r.audioLen,
+      (r.audioLen>0.0 && r.median>0.0)?(r.audioLen*1000.0/r.median):0.0,
+      (i<results.size()-1)?",":""
+    );
+  }
+  ret+="  ]\n";
+  ret+="}\n";
+  return ret;
+}
+
+String FurnaceBench::toCSV() {
+  String ret="name,group,min_ms,median_ms,mean_ms,stddev_ms,max_ms,audio_len_s,realtime\n";
+  for (FurnaceBenchResult& r: results) {
+    String name="\"";
+    for (char c: r.name) {
+      if (c=='"') name+='"';
+      name+=c;
+    }
+    name+="\"";
+    ret+=fmt::sprintf("%s,%s,%.4f,%.4f,%.4f,%.4f,%.4f,%.3f,%.2f\n",
+      name,r.group,r.min,r.median,r.mean,r.stdDev,r.max,r.audioLen,
+      (r.audioLen>0.0 && r.median>0.0)?(r.audioLen*1000.0/r.median):0.0
+    );
+  }
+  return ret;
+}
+
+FurnaceBench::FurnaceBench():
+  e(NULL),
+  runs(10),
+  warmup(1),
+  chipSeconds(1.0),
+  listOnly(false) {}
@@ -0,0 +1,81 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2023 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef _FUR_BENCH_H
+#define _FUR_BENCH_H
+
+#include "../engine/engine.h"
+#include <functional>
+
+struct FurnaceBenchResult {
+  String name;
+  String group;
+  // per-run times in milliseconds
+  std::vector<double> times;
+  // how much audio (in seconds) one run produces, or 0 if not applicable
+  double audioLen;
+  double min, median, mean, stdDev, max;
+
+  void calcStats();
+  FurnaceBenchResult(const String& n, const String& g, double a):
+    name(n),
+    group(g),
+    audioLen(a),
+    min(0.0),
+    median(0.0),
+    mean(0.0),
+    stdDev(0.0),
+    max(0.0) {}
+};
+
+// runs micro-benchmarks on chip cores and engine stages.
+// every benchmark is run a number of times after some warm-up runs, so that
+// results can be compared between builds.
+class FurnaceBench {
+  DivEngine* e;
+  std::vector<FurnaceBenchResult> results;
+  std::vector<String> songs;
+  String filter;
+  int runs, warmup;
+  double chipSeconds;
+  bool listOnly;
+
+  bool wanted(const String& name);
+  // run a benchmark. func returns the time it took in milliseconds, or a negative value on failure.
+  void measure(const String& name, const String& group, double audioLen, const std::function<double()>& func);
+
+  double runDispatch(DivSystem sys, double seconds, double* fillTime);
+  void benchDispatches();
+  void benchMixer();
+  void benchSong(const String& path);
+
+  public:
+    void bindEngine(DivEngine* eng);
+    // runs: how many times each benchmark runs. warmupRuns: runs which are not measured.
+    // seconds: how much audio the chip benchmarks render per run.
+    void setOptions(int runCount, int warmupRuns, double seconds, const String& nameFilter, bool list);
+    void addSong(const String& path);
+    void run();
+    String toJSON();
+    String toCSV();
+    FurnaceBench();
+};
+
+#endif
@@ -0,0 +1,125 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2023 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+// furnace-bench: benchmark suite for chip cores and engine stages.
+
+#include <stdio.h>
+#include "../ta-log.h"
+#include "../fileutils.h"
+#include "bench.h"
+
+DivEngine e;
+FurnaceBench bench;
+
+void printUsage(const char* argv0) {
+  printf("usage: %s [options] [song...]\n\n",argv0);
+  printf("runs micro-benchmarks on every chip core and engine stage.\n");
+  printf("stages which need a song (load, save, sequencer, playback...) are run for every song.\n\n");
+  printf("options:\n");
+  printf("  -r <count>    number of measured runs (10 by default)\n");
+  printf("  -w <count>    number of warm-up runs (1 by default)\n");
+  printf("  -s <seconds>  audio length rendered by chip benchmarks (1 by default)\n");
+  printf("  -f <text>     only run benchmarks whose name contains text\n");
+  printf("  -o <file>     write results to file (.csv or .json). JSON to standard output by default\n");
+  printf("  -l            list benchmarks and exit\n");
+  printf("  -v            verbose log\n");
+}
+
+int main(int argc, char** argv) {
+  int runs=10;
+  int warmup=1;
+  double seconds=1.0;
+  String filter;
+  String outName;
+  bool list=false;
+
+  initLog();
+  logLevel=LOGLEVEL_WARN;
+
+  for (int i=1; i<argc; i++) {
+    String arg=argv[i];
+    bool hasValue=(i+1<argc);
+    try {
+      if (arg=="-r" && hasValue) {
+        runs=std::stoi(argv[++i]);
+      } else if (arg=="-w" && hasValue) {
+        warmup=std::stoi(argv[++i]);
+      } else if (arg=="-s" && hasValue) {
+        seconds=std::stod(argv[++i]);
+      } else if (arg=="-f" && hasValue) {
+        filter=argv[++i];
+      } else if (arg=="-o" && hasValue) {
+        outName=argv[++i];
+      } else if (arg=="-l") {
+        list=true;
+      } else if (arg=="-v") {
+        logLevel=LOGLEVEL_INFO;
+      } else if (arg=="-h" || arg=="--help") {
+        printUsage(argv[0]);
+        return 0;
+      } else if (!arg.empty() && arg[0]=='-') {
+        logE("invalid option %s.",arg);
+        printUsage(argv[0]);
+        return 1;
+      } else {
+        bench.addSong(arg);
+      }
+    } catch (std::exception& ex) {
+      logE("invalid value for %s.",arg);
+      return 1;
+    }
+  }
+
+  e.setAudio(DIV_AUDIO_DUMMY);
+  e.preInit(true);
+  if (!e.init()) {
+    logE("could not initialize engine!");
+    finishLogFile();
+    return 1;
+  }
+
+  bench.bindEngine(&e);
+  bench.setOptions(runs,warmup,seconds,filter,list);
+  bench.run();
+
+  if (!list) {
+    String lowerName=outName;
+    for (char& i: lowerName) i=tolower(i);
+    bool csv=(lowerName.size()>=4 && lowerName.substr(lowerName.size()-4)==".csv");
+    String data=csv?bench.toCSV():bench.toJSON();
+    if (outName.empty()) {
+      fputs(data.c_str(),stdout);
+    } else {
+      FILE* f=ps_fopen(outName.c_str(),"wb");
+      if (f==NULL) {
+        logE("could not open %s! (%s)",outName,strerror(errno));
+        e.quit();
+        finishLogFile();
+        return 1;
+      }
+      fwrite(data.c_str(),1,data.size(),f);
+      fclose(f);
+    }
+  }
+
+  e.quit();
+  finishLogFile();
+  return 0;
+}
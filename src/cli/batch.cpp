@@ -0,0 +1,188 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2023 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "batch.h"
+#include "../ta-log.h"
+#include "../fileutils.h"
+#include <chrono>
+
+void _batchWorker(FurnaceBatch* batch, DivEngine* eng) {
+  batch->runWorker(eng);
+}
+
+void FurnaceBatch::bindEngine(DivEngine* eng) {
+  e=eng;
+}
+
+void FurnaceBatch::setOptions(int loopCount, int subSong, DivAudioExportModes mode) {
+  loops=loopCount;
+  subsong=subSong;
+  outMode=mode;
+}
+
+bool FurnaceBatch::readJobs(const String& path) {
+  FILE* f;
+  if (path=="-") {
+    f=stdin;
+  } else {
+    f=ps_fopen(path.c_str(),"rb");
+    if (f==NULL) {
+      logE("could not open job list! (%s)",strerror(errno));
+      return false;
+    }
+  }
+
+  char line[4096];
+  while (fgets(line,4096,f)!=NULL) {
+    String l=line;
+    while (!l.empty() && (l.back()=='\n' || l.back()=='\r')) l.pop_back();
+    if (l.empty()) continue;
+    if (l[0]=='#') continue;
+
+    String inName, outName;
+    size_t tabPos=l.find('\t');
+    if (tabPos==String::npos) {
+      inName=l;
+    } else {
+      inName=l.substr(0,tabPos);
+      outName=l.substr(tabPos+1);
+    }
+    if (outName.empty()) {
+      size_t extPos=inName.rfind('.');
+      size_t dirPos=inName.find_last_of("/\\");
+      if (extPos!=String::npos && (dirPos==String::npos || extPos>dirPos)) {
+        outName=inName.substr(0,extPos)+".wav";
+      } else {
+        outName=inName+".wav";
+      }
+    }
+    jobs.push_back(FurnaceBatchJob(inName,outName));
+  }
+
+  if (f!=stdin) fclose(f);
+  logI("%d jobs in list.",(int)jobs.size());
+  return true;
+}
+
+bool FurnaceBatch::runJob(DivEngine* eng, FurnaceBatchJob& job) {
+  FILE* f=ps_fopen(job.inName.c_str(),"rb");
+  if (f==NULL) {
+    logE("%s: couldn't open file! (%s)",job.inName,strerror(errno));
+    return false;
+  }
+  if (fseek(f,0,SEEK_END)<0) {
+    logE("%s: couldn't get file size! (%s)",job.inName,strerror(errno));
+    fclose(f);
+    return false;
+  }
+  ssize_t len=ftell(f);
+  if (len==(SIZE_MAX>>1) || len<1) {
+    logE("%s: couldn't get file size!",job.inName);
+    fclose(f);
+    return false;
+  }
+  unsigned char* file=new unsigned char[len];
+  if (fseek(f,0,SEEK_SET)<0) {
+    logE("%s: couldn't seek! (%s)",job.inName,strerror(errno));
+    fclose(f);
+    delete[] file;
+    return false;
+  }
+  if (fread(file,1,(size_t)len,f)!=(size_t)len) {
+    logE("%s: couldn't read file! (%s)",job.inName,strerror(errno));
+    fclose(f);
+    delete[] file;
+    return false;
+  }
+  fclose(f);
+
+  // load() takes ownership of file
+  if (!eng->load(file,(size_t)len)) {
+    logE("%s: could not open file! (%s)",job.inName,eng->getLastError());
+    return false;
+  }
+  if (subsong!=-1) {
+    eng->changeSongP(subsong);
+  }
+  if (!eng->saveAudio(job.outName.c_str(),loops,outMode)) {
+    return false;
+  }
+  eng->waitAudioFile();
+  eng->finishAudioFile();
+  return true;
+}
+
+void FurnaceBatch::runWorker(DivEngine* eng) {
+  while (true) {
+    size_t which=nextJob++;
+    if (which>=jobs.size()) break;
+    FurnaceBatchJob& job=jobs[which];
+    logI("[%d/%d] %s -> %s",(int)which+1,(int)jobs.size(),job.inName,job.outName);
+    if (!runJob(eng,job)) failedJobs++;
+  }
+}
+
+int FurnaceBatch::run(int threads) {
+  if (jobs.empty()) return 0;
+  if (threads<1) threads=std::thread::hardware_concurrency();
+  if (threads>(int)jobs.size()) threads=jobs.size();
+  if (threads<1) threads=1;
+
+  std::chrono::steady_clock::time_point timeStart=std::chrono::steady_clock::now();
+
+  // set up the engines once. jobs reuse them.
+  std::vector<DivEngine*> engines;
+  for (int i=0; i<threads; i++) {
+    DivEngine* inst=e->createRenderInstance();
+    if (inst==NULL) break;
+    engines.push_back(inst);
+  }
+  if (engines.empty()) {
+    logE("could not create any render engine!");
+    return (int)jobs.size();
+  }
+  logI("rendering with %d engines...",(int)engines.size());
+
+  nextJob=0;
+  failedJobs=0;
+  std::vector<std::thread*> workers;
+  for (DivEngine* i: engines) {
+    workers.push_back(new std::thread(_batchWorker,this,i));
+  }
+  for (std::thread* i: workers) {
+    i->join();
+    delete i;
+  }
+  for (DivEngine* i: engines) {
+    i->quit();
+    delete i;
+  }
+
+  std::chrono::steady_clock::time_point timeEnd=std::chrono::steady_clock::now();
+  logI("%d jobs done in %dms (%d failed).",(int)jobs.size(),(int)std::chrono::duration_cast<std::chrono::milliseconds>(timeEnd-timeStart).count(),(int)failedJobs);
+  return failedJobs;
+}
+
+FurnaceBatch::FurnaceBatch():
+  e(NULL),
+  nextJob(0),
+  failedJobs(0),
+  loops(1),
+  subsong(-1),
+  outMode(DIV_EXPORT_MODE_ONE) {}
@@ -0,0 +1,60 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2023 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _FUR_BATCH_H
+#define _FUR_BATCH_H
+
+#include "../engine/engine.h"
+
+struct FurnaceBatchJob {
+  String inName;
+  String outName;
+  FurnaceBatchJob(const String& in, const String& out):
+    inName(in),
+    outName(out) {}
+};
+
+// renders many songs in one process.
+// every worker keeps its own engine warm between jobs, so sample ROMs, filter
+// tables and dispatch buffers are only set up once.
+class FurnaceBatch {
+  DivEngine* e;
+  std::vector<FurnaceBatchJob> jobs;
+  std::atomic<size_t> nextJob;
+  std::atomic<int> failedJobs;
+  int loops, subsong;
+  DivAudioExportModes outMode;
+
+  bool runJob(DivEngine* eng, FurnaceBatchJob& job);
+
+  public:
+    void runWorker(DivEngine* eng);
+    void bindEngine(DivEngine* eng);
+    void setOptions(int loopCount, int subSong, DivAudioExportModes mode);
+    // read a job list. each line is <input>[<TAB><output>].
+    // if the output is missing, it will be the input with .wav extension.
+    // "-" reads from standard input.
+    bool readJobs(const String& path);
+    // render all jobs using up to threads engines (0 means one per CPU core).
+    // returns the number of failed jobs.
+    int run(int threads);
+    FurnaceBatch();
+};
+
+#endif
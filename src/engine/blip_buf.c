@@ -7,6 +7,23 @@
 #include <string.h>
 #include <stdlib.h>
 
+/* SIMD paths for blip_add_deltas(). define BLIP_NO_SIMD to only
+build the scalar one. */
+#ifndef BLIP_NO_SIMD
+	#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+		#define BLIP_SSE2
+		#include <emmintrin.h>
+	#endif
+	#if defined(BLIP_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+		#define BLIP_AVX2
+		#include <immintrin.h>
+	#endif
+	#if defined(__ARM_NEON) || defined(__aarch64__)
+		#define BLIP_NEON
+		#include <arm_neon.h>
+	#endif
+#endif
+
 /* Library Copyright (C) 2003-2009 Shay Green. This library is free software;
 you can redistribute it and/or modify it under the terms of the GNU Lesser
 General Public License as published by the Free Software Foundation; either
@@ -58,6 +75,13 @@ limit the total buffered samples to blip_max_frame. That could only be
 increased by decreasing time_bits, which would reduce resample ratio accuracy.
 */
 
+typedef int buf_t;
+
+/* adds the step for one delta into 16 output samples (see blip_add_deltas()) */
+typedef void (*blip_kernel_t)( buf_t* out, short const* in, short const* rev, int delta, int delta2 );
+
+static blip_kernel_t blip_select_kernel( char const** name );
+
 /** Sample buffer that resamples to output rate and accumulates samples
 until they're read out */
 struct blip_t
@@ -68,10 +92,9 @@ struct blip_t
 	int size;
 	int integrator;
         unsigned char hipass;
+	blip_kernel_t kernel;
 };
 
-typedef int buf_t;
-
 /* probably not totally portable */
 #define SAMPLES( buf ) ((buf_t*) ((buf) + 1))
 
@@ -121,6 +144,9 @@ blip_t* blip_new( int size )
 		m->factor = time_unit / blip_max_ratio;
 		m->size   = size;
                 m->hipass = 1;
+		/* selected here rather than lazily, so that no state is shared
+		between threads */
+		m->kernel = blip_select_kernel( NULL );
 		blip_clear( m );
 		check_assumptions();
 	}
@@ -224,24 +250,41 @@ int blip_read_samples( blip_t* m, short out [], int count, int stereo )
 		buf_t const* in  = SAMPLES( m );
 		buf_t const* end = in + count;
 		int sum = m->integrator;
-		do
+		/* high-pass check hoisted out of the loop */
+		if ( m->hipass )
 		{
-			/* Eliminate fraction */
-			int s = ARITH_SHIFT( sum, delta_bits );
-			
-			sum += *in++;
-			
-			CLAMP( s );
-			
-			*out = s;
-			out += step;
-			
-			/* High-pass filter */
-                        if (m->hipass) {
-			  sum -= s << (delta_bits - bass_shift);
-                        }
+			do
+			{
+				/* Eliminate fraction */
+				int s = ARITH_SHIFT( sum, delta_bits );
+				
+				sum += *in++;
+				
+				CLAMP( s );
+				
+				*out = s;
+				out += step;
+				
+				/* High-pass filter */
+				sum -= s << (delta_bits - bass_shift);
+			}
+			while ( in != end );
+		}
+		else
+		{
+			do
+			{
+				int s = ARITH_SHIFT( sum, delta_bits );
+				
+				sum += *in++;
+				
+				CLAMP( s );
+				
+				*out = s;
+				out += step;
+			}
+			while ( in != end );
 		}
-		while ( in != end );
 		m->integrator = sum;
 		
 		remove_samples( m, count );
@@ -350,3 +393,242 @@ void blip_add_delta_fast( blip_t* m, unsigned time, int delta )
 	out [7] += delta * delta_unit - delta2;
 	out [8] += delta2;
 }
+
+/* batched delta synthesis.
+each kernel adds the step for one delta into 16 output samples, and is
+bit-exact with blip_add_delta() since all products fit in 32 bits. */
+
+static void blip_kernel_scalar( buf_t* out, short const* in, short const* rev, int delta, int delta2 )
+{
+	out [0] += in[0]*delta + in[half_width+0]*delta2;
+	out [1] += in[1]*delta + in[half_width+1]*delta2;
+	out [2] += in[2]*delta + in[half_width+2]*delta2;
+	out [3] += in[3]*delta + in[half_width+3]*delta2;
+	out [4] += in[4]*delta + in[half_width+4]*delta2;
+	out [5] += in[5]*delta + in[half_width+5]*delta2;
+	out [6] += in[6]*delta + in[half_width+6]*delta2;
+	out [7] += in[7]*delta + in[half_width+7]*delta2;
+	
+	in = rev;
+	out [ 8] += in[7]*delta + in[7-half_width]*delta2;
+	out [ 9] += in[6]*delta + in[6-half_width]*delta2;
+	out [10] += in[5]*delta + in[5-half_width]*delta2;
+	out [11] += in[4]*delta + in[4-half_width]*delta2;
+	out [12] += in[3]*delta + in[3-half_width]*delta2;
+	out [13] += in[2]*delta + in[2-half_width]*delta2;
+	out [14] += in[1]*delta + in[1-half_width]*delta2;
+	out [15] += in[0]*delta + in[0-half_width]*delta2;
+}
+
+#ifdef BLIP_SSE2
+/* SSE2 has no 32-bit low multiply */
+static __m128i blip_mullo_sse2( __m128i a, __m128i b )
+{
+	__m128i even = _mm_mul_epu32( a, b );
+	__m128i odd  = _mm_mul_epu32( _mm_srli_si128( a, 4 ), _mm_srli_si128( b, 4 ) );
+	return _mm_unpacklo_epi32( _mm_shuffle_epi32( even, _MM_SHUFFLE( 0, 0, 2, 0 ) ),
+			_mm_shuffle_epi32( odd, _MM_SHUFFLE( 0, 0, 2, 0 ) ) );
+}
+
+#define BLIP_REVERSE_SSE2( x ) \
+	_mm_shufflehi_epi16( _mm_shufflelo_epi16( _mm_shuffle_epi32( x, _MM_SHUFFLE( 1, 0, 3, 2 ) ), \
+			_MM_SHUFFLE( 0, 1, 2, 3 ) ), _MM_SHUFFLE( 0, 1, 2, 3 ) )
+
+#define BLIP_LO32_SSE2( x ) _mm_srai_epi32( _mm_unpacklo_epi16( x, x ), 16 )
+#define BLIP_HI32_SSE2( x ) _mm_srai_epi32( _mm_unpackhi_epi16( x, x ), 16 )
+
+static void blip_kernel_sse2( buf_t* out, short const* in, short const* rev, int delta, int delta2 )
+{
+	__m128i d1 = _mm_set1_epi32( delta );
+	__m128i d2 = _mm_set1_epi32( delta2 );
+	__m128i a  = _mm_loadu_si128( (__m128i const*) in );
+	__m128i b  = _mm_loadu_si128( (__m128i const*) (in + half_width) );
+	__m128i c  = BLIP_REVERSE_SSE2( _mm_loadu_si128( (__m128i const*) rev ) );
+	__m128i d  = BLIP_REVERSE_SSE2( _mm_loadu_si128( (__m128i const*) (rev - half_width) ) );
+	__m128i* o = (__m128i*) out;
+	
+	_mm_storeu_si128( o + 0, _mm_add_epi32( _mm_loadu_si128( o + 0 ), _mm_add_epi32(
+			blip_mullo_sse2( BLIP_LO32_SSE2( a ), d1 ), blip_mullo_sse2( BLIP_LO32_SSE2( b ), d2 ) ) ) );
+	_mm_storeu_si128( o + 1, _mm_add_epi32( _mm_loadu_si128( o + 1 ), _mm_add_epi32(
+			blip_mullo_sse2( BLIP_HI32_SSE2( a ), d1 ), blip_mullo_sse2( BLIP_HI32_SSE2( b ), d2 ) ) ) );
+	_mm_storeu_si128( o + 2, _mm_add_epi32( _mm_loadu_si128( o + 2 ), _mm_add_epi32(
+			blip_mullo_sse2( BLIP_LO32_SSE2( c ), d1 ), blip_mullo_sse2( BLIP_LO32_SSE2( d ), d2 ) ) ) );
+	_mm_storeu_si128( o + 3, _mm_add_epi32( _mm_loadu_si128( o + 3 ), _mm_add_epi32(
+			blip_mullo_sse2( BLIP_HI32_SSE2( c ), d1 ), blip_mullo_sse2( BLIP_HI32_SSE2( d ), d2 ) ) ) );
+}
+#endif
+
+#ifdef BLIP_AVX2
+__attribute__((target("avx2")))
+static void blip_kernel_avx2( buf_t* out, short const* in, short const* rev, int delta, int delta2 )
+{
+	__m256i const reverse = _mm256_set_epi32( 0, 1, 2, 3, 4, 5, 6, 7 );
+	__m256i d1 = _mm256_set1_epi32( delta );
+	__m256i d2 = _mm256_set1_epi32( delta2 );
+	__m256i a  = _mm256_cvtepi16_epi32( _mm_loadu_si128( (__m128i const*) in ) );
+	__m256i b  = _mm256_cvtepi16_epi32( _mm_loadu_si128( (__m128i const*) (in + half_width) ) );
+	__m256i c  = _mm256_permutevar8x32_epi32( _mm256_cvtepi16_epi32( _mm_loadu_si128( (__m128i const*) rev ) ), reverse );
+	__m256i d  = _mm256_permutevar8x32_epi32( _mm256_cvtepi16_epi32( _mm_loadu_si128( (__m128i const*) (rev - half_width) ) ), reverse );
+	__m256i* o = (__m256i*) out;
+	
+	_mm256_storeu_si256( o + 0, _mm256_add_epi32( _mm256_loadu_si256( o + 0 ), _mm256_add_epi32(
+			_mm256_mullo_epi32( a, d1 ), _mm256_mullo_epi32( b, d2 ) ) ) );
+	_mm256_storeu_si256( o + 1, _mm256_add_epi32( _mm256_loadu_si256( o + 1 ), _mm256_add_epi32(
+			_mm256_mullo_epi32( c, d1 ), _mm256_mullo_epi32( d, d2 ) ) ) );
+}
+#endif
+
+#ifdef BLIP_NEON
+static int16x8_t blip_reverse_neon( int16x8_t x )
+{
+	x = vrev64q_s16( x );
+	return vextq_s16( x, x, 4 );
+}
+
+static void blip_kernel_neon( buf_t* out, short const* in, short const* rev, int delta, int delta2 )
+{
+	int16x8_t a = vld1q_s16( in );
+	int16x8_t b = vld1q_s16( in + half_width );
+	int16x8_t c = blip_reverse_neon( vld1q_s16( rev ) );
+	int16x8_t d = blip_reverse_neon( vld1q_s16( rev - half_width ) );
+	
+	vst1q_s32( out +  0, vmlaq_n_s32( vmlaq_n_s32( vld1q_s32( out +  0 ), vmovl_s16( vget_low_s16 ( a ) ), delta ), vmovl_s16( vget_low_s16 ( b ) ), delta2 ) );
+	vst1q_s32( out +  4, vmlaq_n_s32( vmlaq_n_s32( vld1q_s32( out +  4 ), vmovl_s16( vget_high_s16( a ) ), delta ), vmovl_s16( vget_high_s16( b ) ), delta2 ) );
+	vst1q_s32( out +  8, vmlaq_n_s32( vmlaq_n_s32( vld1q_s32( out +  8 ), vmovl_s16( vget_low_s16 ( c ) ), delta ), vmovl_s16( vget_low_s16 ( d ) ), delta2 ) );
+	vst1q_s32( out + 12, vmlaq_n_s32( vmlaq_n_s32( vld1q_s32( out + 12 ), vmovl_s16( vget_high_s16( c ) ), delta ), vmovl_s16( vget_high_s16( d ) ), delta2 ) );
+}
+#endif
+
+static blip_kernel_t blip_select_kernel( char const** name )
+{
+#ifdef BLIP_AVX2
+	if ( __builtin_cpu_supports( "avx2" ) )
+	{
+		if ( name ) *name = "AVX2";
+		return blip_kernel_avx2;
+	}
+#endif
+#ifdef BLIP_SSE2
+	if ( name ) *name = "SSE2";
+	return blip_kernel_sse2;
+#elif defined(BLIP_NEON)
+	if ( name ) *name = "NEON";
+	return blip_kernel_neon;
+#else
+	if ( name ) *name = "scalar";
+	return blip_kernel_scalar;
+#endif
+}
+
+char const* blip_simd_name( void )
+{
+	char const* name = "scalar";
+	blip_select_kernel( &name );
+	return name;
+}
+
+#if defined(BLIP_SSE2) || defined(BLIP_NEON)
+static int blip_kernel_matches( blip_kernel_t kernel )
+{
+	unsigned seed = 1;
+	int phase, i, j;
+	for ( phase = 0; phase < phase_count; phase++ )
+	{
+		for ( i = 0; i < 64; i++ )
+		{
+			buf_t ref [16];
+			buf_t out [16];
+			int delta, delta2;
+			
+			/* any difference between two samples, plus the extremes */
+			seed = seed * 1103515245 + 12345;
+			delta = (int) ((seed >> 15) % 0x1ffff) - 0xffff;
+			if ( i == 0 ) delta = 0xffff;
+			if ( i == 1 ) delta = -0xffff;
+			delta2 = (delta * (int) (seed & (delta_unit - 1))) >> delta_bits;
+			
+			for ( j = 0; j < 16; j++ )
+				ref [j] = out [j] = (int) (seed >> (j & 7)) & 0xffff;
+			
+			blip_kernel_scalar( ref, bl_step [phase], bl_step [phase_count - phase], delta - delta2, delta2 );
+			kernel( out, bl_step [phase], bl_step [phase_count - phase], delta - delta2, delta2 );
+			if ( memcmp( ref, out, sizeof ref ) )
+				return 0;
+		}
+	}
+	return 1;
+}
+#endif
+
+char const* blip_check_kernels( void )
+{
+#ifdef BLIP_AVX2
+	if ( __builtin_cpu_supports( "avx2" ) && !blip_kernel_matches( blip_kernel_avx2 ) )
+		return "AVX2";
+#endif
+#ifdef BLIP_SSE2
+	if ( !blip_kernel_matches( blip_kernel_sse2 ) )
+		return "SSE2";
+#endif
+#ifdef BLIP_NEON
+	if ( !blip_kernel_matches( blip_kernel_neon ) )
+		return "NEON";
+#endif
+	return NULL;
+}
+
+void blip_add_deltas( blip_t* m, short const in [], unsigned count, int* last, int* prev, unsigned char fast )
+{
+	buf_t* const buf = SAMPLES( m ) + m->avail;
+	fixed_t pos = m->offset;
+	int cur = *last;
+	int prv = *prev;
+	unsigned i;
+	
+	if ( fast )
+	{
+		for ( i = 0; i < count; i++, pos += m->factor )
+		{
+			unsigned fixed;
+			buf_t* out;
+			int delta, delta2;
+			if ( in [i] == cur ) continue;
+			cur = in [i];
+			delta = cur - prv;
+			prv = cur;
+			
+			fixed = (unsigned) (pos >> pre_shift);
+			out = buf + (fixed >> frac_bits);
+			delta2 = delta * (int) (fixed >> (frac_bits - delta_bits) & (delta_unit - 1));
+			assert( out <= &SAMPLES( m ) [m->size + end_frame_extra] );
+			out [7] += delta * delta_unit - delta2;
+			out [8] += delta2;
+		}
+	}
+	else
+	{
+		int const phase_shift = frac_bits - phase_bits;
+		blip_kernel_t const kernel = m->kernel;
+		
+		for ( i = 0; i < count; i++, pos += m->factor )
+		{
+			unsigned fixed;
+			buf_t* out;
+			int phase, delta, delta2;
+			if ( in [i] == cur ) continue;
+			cur = in [i];
+			delta = cur - prv;
+			prv = cur;
+			
+			fixed = (unsigned) (pos >> pre_shift);
+			out = buf + (fixed >> frac_bits);
+			phase = fixed >> phase_shift & (phase_count - 1);
+			delta2 = (delta * (int) (fixed >> (phase_shift - delta_bits) & (delta_unit - 1))) >> delta_bits;
+			assert( out <= &SAMPLES( m ) [m->size + end_frame_extra] );
+			kernel( out, bl_step [phase], bl_step [phase_count - phase], delta - delta2, delta2 );
+		}
+	}
+	
+	*last = cur;
+	*prev = prv;
+}
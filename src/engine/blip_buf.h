@@ -41,6 +41,22 @@ void blip_add_delta( blip_t*, unsigned int clock_time, int delta );
 /** Same as blip_add_delta(), but uses faster, lower-quality synthesis. */
 void blip_add_delta_fast( blip_t*, unsigned int clock_time, int delta );
 
+/** adds a delta for every change in a buffer of input samples,
+where sample i is at clock time i. 'last' holds the last input sample and
+'prev' the level the next delta is relative to; both are updated. Same output
+as calling blip_add_delta() (or blip_add_delta_fast() if 'fast' is true) for
+each change. */
+void blip_add_deltas( blip_t*, short const in [], unsigned int count, int* last, int* prev, unsigned char fast );
+
+/** returns the name of the instruction set used by
+blip_add_deltas(). */
+char const* blip_simd_name( void );
+
+/** runs every SIMD kernel usable on this CPU against the scalar one with
+all phases and a range of deltas. returns NULL if all of them match, or the
+name of the first one which doesn't. */
+char const* blip_check_kernels( void );
+
 /** Length of time frame, in clocks, needed to make sample_count additional
 samples available. */
 int blip_clocks_needed( const blip_t*, int sample_count );
@@ -293,6 +293,8 @@ SafeWriter* DivEngine::saveCommand(bool binary) {
 
   memset(lastTick,0,DIV_MAX_CHANS*sizeof(int));
   while (!done) {
+    if (streamExportStep()) break;
+    applyMessages();
     if (nextTick(false,true) || !playing) {
       done=true;
     }
@@ -536,5 +538,12 @@ SafeWriter* DivEngine::saveCommand(bool binary) {
   extValuePresent=false;
   BUSY_END;
 
+  if (streamExportHalt) {
+    w->finish();
+    delete w;
+    lastError="export cancelled";
+    return NULL;
+  }
+
   return w;
 }
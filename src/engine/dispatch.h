@@ -22,6 +22,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <atomic>
 #include "../pch.h"
 #include "config.h"
 #include "chipUtils.h"
@@ -349,22 +350,116 @@ struct DivSamplePos {
     freq(0) {}
 };
 
+// samples kept per channel oscilloscope buffer (must be 65536 - needles wrap around)
+#define DIV_OSC_BUF_SIZE 65536
+// oscilloscope samples are decimated to stay at or below this rate
+#define DIV_OSC_MAX_RATE 192000
+
+/**
+ * a per-channel oscilloscope buffer.
+ * this is a single-producer, single-consumer ring:
+ * - the dispatch (audio thread) writes samples using putSample().
+ * - samples become visible to readers (GUI) after publish(), which the engine calls after every buffer.
+ * - readers use getData(), getNeedle() and getRate().
+ *
+ * sample data is only allocated once a reader asks for it (alloc()), so channels which
+ * are not being viewed (and engines without a GUI) skip the writes entirely.
+ */
 struct DivDispatchOscBuffer {
   bool follow;
+  // the rate at which the dispatch calls putSample().
   unsigned int rate;
+  // write position. audio thread only.
   unsigned short needle;
   unsigned short readNeedle;
   unsigned short followNeedle;
-  short data[65536];
+  // decimation factor and counter. audio thread only.
+  unsigned int decim, decimPos;
+  // the audio thread's view of the sample data (NULL if not capturing).
+  short* data;
+
+  // published state (for readers).
+  std::atomic<short*> sharedData;
+  std::atomic<unsigned short> sharedNeedle;
+  std::atomic<unsigned int> sharedRate;
+
+  /**
+   * write a sample. audio thread only.
+   * @param val the sample.
+   */
+  inline void putSample(short val) {
+    if (data==NULL) return;
+    if (decim>1) {
+      if (++decimPos<decim) return;
+      decimPos=0;
+    }
+    data[needle++]=val;
+  }
+
+  /**
+   * make written samples visible to readers, and pick up a newly allocated buffer. audio thread only.
+   */
+  void publish();
+
+  /**
+   * reset the write and read positions.
+   * @warning only call this with the engine locked!
+   */
+  void reset();
+
+  /**
+   * clear the sample data and reset the write and read positions.
+   * @warning only call this with the engine locked!
+   */
+  void clear();
+
+  /**
+   * allocate sample data if not done yet. reader thread only.
+   * @return the sample data.
+   */
+  short* alloc();
+
+  /**
+   * free sample data, disabling capture until alloc() is called again.
+   * @warning only call this with the engine locked!
+   */
+  void release();
+
+  /**
+   * get the sample data (for readers).
+   * @return the sample data, or NULL if not allocated.
+   */
+  inline const short* getData() {
+    return sharedData.load(std::memory_order_acquire);
+  }
+
+  /**
+   * get the position after the last published sample (for readers).
+   */
+  inline unsigned short getNeedle() {
+    return sharedNeedle.load(std::memory_order_acquire);
+  }
+
+  /**
+   * get the rate of the stored samples (after decimation) (for readers).
+   */
+  inline unsigned int getRate() {
+    return sharedRate.load(std::memory_order_relaxed);
+  }
 
   DivDispatchOscBuffer():
     follow(true),
     rate(65536),
     needle(0),
     readNeedle(0),
-    followNeedle(0) {
-    memset(data,0,65536*sizeof(short));
-  }
+    followNeedle(0),
+    decim(1),
+    decimPos(0),
+    data(NULL),
+    sharedData(NULL),
+    sharedNeedle(0),
+    sharedRate(65536) {}
+  ~DivDispatchOscBuffer();
 };
 
 struct DivChannelPair {
@@ -546,18 +641,26 @@ class DivDispatch {
     virtual int getRegisterPoolDepth();
 
     /**
-     * get this dispatch's state. DO NOT IMPLEMENT YET.
-     * @return a pointer to the dispatch's state. must be deallocated manually!
+     * get this dispatch's state. used by the seek index.
+     * this is the state which dispatch() and tick() change while register writes are skipped
+     * (channels, macros and so on), not the state of the chip itself.
+     * @return a pointer to the dispatch's state, or NULL if this dispatch does not support state saves.
+     * must be deallocated with freeState()!
      */
     virtual void* getState();
 
     /**
-     * set this dispatch's state. DO NOT IMPLEMENT YET.
-     * @param state a pointer to a state pertaining to this dispatch,
-     * or NULL if this dispatch does not support state saves.
+     * set this dispatch's state.
+     * @param state a pointer to a state returned by getState() on this dispatch.
      */
     virtual void setState(void* state);
 
+    /**
+     * deallocate a state returned by getState().
+     * @param state the state.
+     */
+    virtual void freeState(void* state);
+
     /**
      * mute a channel.
      * @param ch the channel to mute.
@@ -695,6 +798,39 @@ class DivDispatch {
      */
     virtual void poke(std::vector<DivRegWrite>& wlist);
 
+    /**
+     * whether this dispatch can have its register writes deferred.
+     * used by the batched renderer, which runs all ticks of a buffer first and then
+     * renders each chip in one go, putting writes back at the right time.
+     * if you return true here, acquire() must not depend on anything else that tick() or dispatch() changes.
+     * @return whether takeWrites()/putWrite() are implemented.
+     */
+    virtual bool canDeferWrites();
+
+    /**
+     * move all pending register writes out of the write queue.
+     * @param wlist the list to append the writes to.
+     * @param time the time (in samples) at which these writes shall happen.
+     */
+    virtual void takeWrites(std::vector<DivDelayedWrite>& wlist, int time);
+
+    /**
+     * put a previously taken register write back into the write queue.
+     * @param addr the address.
+     * @param val the value.
+     */
+    virtual void putWrite(unsigned int addr, unsigned int val);
+
+    /**
+     * fill a buffer with sound data, putting back taken register writes at the right time.
+     * used by the batched renderer to render a whole buffer in one call.
+     * the default implementation calls acquire() once for every distinct write time.
+     * @param buf pointers to output buffers.
+     * @param len the amount of samples to fill.
+     * @param wlist the writes, sorted by time (in samples from the start of buf).
+     */
+    virtual void acquireWithWrites(short** buf, size_t len, std::vector<DivDelayedWrite>& wlist);
+
     /**
      * get available registers.
      * @return an array of C strings, terminated by NULL; or NULL if none available.
@@ -767,6 +903,16 @@ class DivDispatch {
     virtual ~DivDispatch();
 };
 
+// helper define for acquire loops which support deferred writes (see acquireWithWrites()).
+// requires `std::vector<DivDelayedWrite>* wlist` and `size_t wlistPos` to be in scope.
+#define PUT_DUE_WRITES(h) \
+  if (wlist!=NULL) { \
+    while (wlistPos<wlist->size() && (*wlist)[wlistPos].time<=(int)(h)) { \
+      putWrite((*wlist)[wlistPos].write.addr,(*wlist)[wlistPos].write.val); \
+      wlistPos++; \
+    } \
+  }
+
 // custom chip clock helper define. put in setFlags, but before rate is set.
 #define CHECK_CUSTOM_CLOCK \
   if (flags.getInt("customClock",0)>0) { \
@@ -19,6 +19,7 @@
 
 #include "blip_buf.h"
 #include "engine.h"
+#include <chrono>
 #include "platform/genesis.h"
 #include "platform/genesisext.h"
 #include "platform/msm5232.h"
@@ -140,6 +141,13 @@ void DivDispatchContainer::grow(size_t size) {
   } \
   if (mustClear) clear(); \
 
+#define PROF_BEGIN \
+  std::chrono::steady_clock::time_point profStart; \
+  if (profile) profStart=std::chrono::steady_clock::now();
+
+#define PROF_END(x) \
+  if (profile) x+=std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-profStart).count();
+
 void DivDispatchContainer::acquire(size_t offset, size_t count) {
   CHECK_MISSING_BUFS;
 
@@ -154,7 +162,25 @@ void DivDispatchContainer::acquire(size_t offset, size_t count) {
       }
     }
   }
+  PROF_BEGIN;
   dispatch->acquire(bbInMapped,count);
+  PROF_END(profAcquire);
+}
+
+void DivDispatchContainer::acquireDeferred(size_t count) {
+  CHECK_MISSING_BUFS;
+
+  for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
+    if (i>=outs) {
+      bbInMapped[i]=NULL;
+    } else {
+      bbInMapped[i]=bbIn[i];
+    }
+  }
+  PROF_BEGIN;
+  dispatch->acquireWithWrites(bbInMapped,count,deferredWrites);
+  PROF_END(profAcquire);
+  deferredWrites.clear();
 }
 
 void DivDispatchContainer::flush(size_t count) {
@@ -168,6 +194,7 @@ void DivDispatchContainer::flush(size_t count) {
 
 void DivDispatchContainer::fillBuf(size_t runtotal, size_t offset, size_t size) {
   CHECK_MISSING_BUFS;
+  PROF_BEGIN;
 
   if (dcOffCompensation && runtotal>0) {
     dcOffCompensation=false;
@@ -178,28 +205,10 @@ void DivDispatchContainer::fillBuf(size_t runtotal, size_t offset, size_t size)
       }
     }
   }
-  if (lowQuality) {
-    for (int i=0; i<outs; i++) {
-      if (bbIn[i]==NULL) continue;
-      if (bb[i]==NULL) continue;
-      for (size_t j=0; j<runtotal; j++) {
-        if (bbIn[i][j]==temp[i]) continue;
-        temp[i]=bbIn[i][j];
-        blip_add_delta_fast(bb[i],j,temp[i]-prevSample[i]);
-        prevSample[i]=temp[i];
-      }
-    }
-  } else {
-    for (int i=0; i<outs; i++) {
-      if (bbIn[i]==NULL) continue;
-      if (bb[i]==NULL) continue;
-      for (size_t j=0; j<runtotal; j++) {
-        if (bbIn[i][j]==temp[i]) continue;
-        temp[i]=bbIn[i][j];
-        blip_add_delta(bb[i],j,temp[i]-prevSample[i]);
-        prevSample[i]=temp[i];
-      }
-    }
+  for (int i=0; i<outs; i++) {
+    if (bbIn[i]==NULL) continue;
+    if (bb[i]==NULL) continue;
+    blip_add_deltas(bb[i],bbIn[i],runtotal,&temp[i],&prevSample[i],lowQuality);
   }
 
   for (int i=0; i<outs; i++) {
@@ -208,6 +217,13 @@ void DivDispatchContainer::fillBuf(size_t runtotal, size_t offset, size_t size)
     blip_end_frame(bb[i],runtotal);
     blip_read_samples(bb[i],bbOut[i]+offset,size,0);
   }
+
+  // make this buffer's osc samples visible to readers
+  for (int i=0; i<chans; i++) {
+    DivDispatchOscBuffer* buf=dispatch->getOscBuffer(i);
+    if (buf!=NULL) buf->publish();
+  }
+  PROF_END(profFill);
   /*if (totalRead<(int)size && totalRead>0) {
     for (size_t i=totalRead; i<size; i++) {
       bbOut[0][i]=bbOut[0][totalRead-1];//bbOut[0][totalRead];
@@ -231,6 +247,8 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
   // quit if we already initialized
   if (dispatch!=NULL) return;
 
+  sampleSig=0;
+
   // initialize chip
   switch (sys) {
     case DIV_SYSTEM_YMU759:
@@ -653,31 +671,40 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
       break;
   }
   dispatch->init(eng,chanCount,gotRate,flags);
+  chans=chanCount;
 
   // initialize output buffers
   int outs=dispatch->getOutputCount();
   bbInLen=32768;
 
   for (int i=0; i<outs; i++) {
-    bb[i]=blip_new(bbInLen);
+    // reuse buffers kept by quit(true)
     if (bb[i]==NULL) {
-      logE("not enough memory!");
-      return;
+      bb[i]=blip_new(bbInLen);
+      if (bb[i]==NULL) {
+        logE("not enough memory!");
+        return;
+      }
+    } else {
+      blip_clear(bb[i]);
     }
 
-    bbIn[i]=new short[bbInLen];
-    bbOut[i]=new short[bbInLen];
+    if (bbIn[i]==NULL) bbIn[i]=new short[bbInLen];
+    if (bbOut[i]==NULL) bbOut[i]=new short[bbInLen];
     memset(bbIn[i],0,bbInLen*sizeof(short));
     memset(bbOut[i],0,bbInLen*sizeof(short));
     blip_set_dc(bb[i],hiPass);
   }
 }
 
-void DivDispatchContainer::quit() {
-  if (dispatch==NULL) return;
-  dispatch->quit();
-  delete dispatch;
-  dispatch=NULL;
+void DivDispatchContainer::quit(bool keepBufs) {
+  if (dispatch!=NULL) {
+    dispatch->quit();
+    delete dispatch;
+    dispatch=NULL;
+  }
+
+  if (keepBufs) return;
 
   for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
     if (bbOut[i]!=NULL) {
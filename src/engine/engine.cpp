@@ -41,7 +41,7 @@
 #include <fmt/printf.h>
 
 void process(void* u, float** in, float** out, int inChans, int outChans, unsigned int size) {
-  ((DivEngine*)u)->nextBuf(in,out,inChans,outChans,size);
+  ((DivEngine*)u)->nextBuf(in,out,inChans,outChans,size,true);
 }
 
 const char* DivEngine::getEffectDesc(unsigned char effect, int chan, bool notNull) {
@@ -294,20 +294,105 @@ double DivEngine::benchmarkSeek() {
   return tAvg;
 }
 
-void DivEngine::notifyInsChange(int ins) {
-  BUSY_BEGIN;
+void DivEngine::enableProfiler(bool enable) {
+  if (enable && !profiler.enabled) profiler.reset();
+  profiler.enabled=enable;
+}
+
+bool DivEngine::saveProfile(const char* path) {
+  std::vector<String> chipNames;
   for (int i=0; i<song.systemLen; i++) {
-    disCont[i].dispatch->notifyInsChange(ins);
+    chipNames.push_back(getSystemName(song.system[i]));
   }
-  BUSY_END;
+
+  String data;
+  String ext=path;
+  if (ext.size()>=4) ext=ext.substr(ext.size()-4);
+  for (char& i: ext) i=tolower(i);
+  if (ext==".csv") {
+    data=profiler.toCSV(chipNames);
+  } else {
+    data=profiler.toJSON(chipNames);
+  }
+
+  FILE* f=ps_fopen(path,"wb");
+  if (f==NULL) {
+    lastError=strerror(errno);
+    logE("could not write profile! (%s)",lastError);
+    return false;
+  }
+  fwrite(data.c_str(),1,data.size(),f);
+  fclose(f);
+  logI("saved profile to %s.",path);
+  return true;
+}
+
+void DivEngine::notifyInsChange(int ins) {
+  synchronized([this,ins]() {
+    truncateSeekIndex(0);
+    for (int i=0; i<song.systemLen; i++) {
+      disCont[i].dispatch->notifyInsChange(ins);
+    }
+  });
 }
 
 void DivEngine::notifyWaveChange(int wave) {
-  BUSY_BEGIN;
-  for (int i=0; i<song.systemLen; i++) {
-    disCont[i].dispatch->notifyWaveChange(wave);
+  synchronized([this,wave]() {
+    truncateSeekIndex(0);
+    for (int i=0; i<song.systemLen; i++) {
+      disCont[i].dispatch->notifyWaveChange(wave);
+    }
+  });
+}
+
+void DivEngine::postMessage(const DivEngineMessage& msg) {
+  if (messages.push(msg)) return;
+  // queue is full. apply it here
+  logW("message queue full!");
+  synchronized([this,&msg]() {
+    applyMessages();
+    applyMessage(msg);
+  });
+}
+
+void DivEngine::applyMessage(const DivEngineMessage& msg) {
+  switch (msg.type) {
+    case DIV_MSG_MUTE:
+      if (msg.chan<0 || msg.chan>=chans) break;
+      if (disCont[dispatchOfChan[msg.chan]].dispatch!=NULL) {
+        disCont[dispatchOfChan[msg.chan]].dispatch->muteChannel(dispatchChanOfChan[msg.chan],msg.note);
+      }
+      break;
+    case DIV_MSG_NOTE_ON:
+    case DIV_MSG_NOTE_OFF:
+      if (msg.chan<0 || msg.chan>=chans) break;
+      if (msg.type==DIV_MSG_NOTE_ON) {
+        pendingNotes.push_back(DivNoteEvent(msg.chan,msg.ins,msg.note,msg.vol,true));
+      } else {
+        pendingNotes.push_back(DivNoteEvent(msg.chan,-1,-1,-1,false));
+      }
+      if (!playing) {
+        reset();
+        freelance=true;
+        playing=true;
+      }
+      break;
+    case DIV_MSG_RESET_OSC:
+      for (int i=0; i<chans; i++) {
+        DivDispatchOscBuffer* buf=getOscBuffer(i);
+        if (buf!=NULL) buf->reset();
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void DivEngine::applyMessages() {
+  DivEngineMessage msg;
+  while (messages.pop(msg)) {
+    applyMessage(msg);
   }
-  BUSY_END;
 }
 
 int DivEngine::loadSampleROM(String path, ssize_t expectedSize, unsigned char*& ret) {
@@ -422,20 +507,72 @@ void DivEngine::renderSamples(int whichSample) {
   }
 
   // step 1: render samples
+  // samples which haven't changed since the last render are skipped (see DivSample::render()).
   if (whichSample==-1) {
-    for (int i=0; i<song.sampleLen; i++) {
-      song.sample[i]->render(formatMask);
+    if (song.sampleLen>1 && renderPoolThreads>1) {
+      // samples are independent of each other, so encode them in parallel
+      struct SampleRenderJob {
+        DivSample* sample;
+        unsigned int formatMask;
+      };
+      std::vector<SampleRenderJob> jobs;
+      jobs.reserve(song.sampleLen);
+      DivWorkPool* samplePool=new DivWorkPool(MIN(renderPoolThreads,(unsigned int)song.sampleLen));
+      for (int i=0; i<song.sampleLen; i++) {
+        jobs.push_back(SampleRenderJob{song.sample[i],formatMask});
+      }
+      for (SampleRenderJob& i: jobs) {
+        samplePool->push([](void* d) {
+          SampleRenderJob* job=(SampleRenderJob*)d;
+          job->sample->render(job->formatMask);
+        },&i);
+      }
+      samplePool->wait();
+      delete samplePool;
+    } else {
+      for (int i=0; i<song.sampleLen; i++) {
+        song.sample[i]->render(formatMask);
+      }
     }
   } else if (whichSample>=0 && whichSample<song.sampleLen) {
     song.sample[whichSample]->render(formatMask);
   }
 
   // step 2: render samples to dispatch
+  // only do so if something relevant to the chip has changed (or if explicitly asked to).
   for (int i=0; i<song.systemLen; i++) {
-    if (disCont[i].dispatch!=NULL) {
-      disCont[i].dispatch->renderSamples(i);
+    if (disCont[i].dispatch==NULL) continue;
+    unsigned long long sig=getSampleSignature(i);
+    if (sig==disCont[i].sampleSig && whichSample!=-2) {
+      logV("samples of chip %d unchanged",i);
+      continue;
+    }
+    disCont[i].dispatch->renderSamples(i);
+    disCont[i].sampleSig=sig;
+  }
+}
+
+unsigned long long DivEngine::getSampleSignature(int sysIndex) {
+  unsigned long long hash=0xcbf29ce484222325ULL;
+#define SIG_HASH(x) hash=(hash^(unsigned long long)(x))*0x100000001b3ULL
+  SIG_HASH(sysIndex);
+  SIG_HASH(song.system[sysIndex]);
+  SIG_HASH(song.sampleLen);
+  String flags=song.systemFlags[sysIndex].toBase64();
+  for (char i: flags) {
+    SIG_HASH((unsigned char)i);
+  }
+  for (int i=0; i<song.sampleLen; i++) {
+    DivSample* s=song.sample[i];
+    SIG_HASH(s->renderHash);
+    for (int j=0; j<DIV_MAX_SAMPLE_TYPE; j++) {
+      SIG_HASH(s->renderOn[j][sysIndex]);
     }
   }
+#undef SIG_HASH
+  // 0 means "not rendered"
+  if (hash==0) hash=1;
+  return hash;
 }
 
 String DivEngine::decodeSysDesc(String desc) {
@@ -550,8 +687,8 @@ void DivEngine::initSongWithDesc(const char* description, bool inBase64, bool ol
 
 void DivEngine::createNew(const char* description, String sysName, bool inBase64) {
   quitDispatch();
-  BUSY_BEGIN;
   saveLock.lock();
+  BUSY_BEGIN;
   song.unload();
   song=DivSong();
   changeSong(0);
@@ -564,8 +701,8 @@ void DivEngine::createNew(const char* description, String sysName, bool inBase64
     song.systemName=sysName;
   }
   recalcChans();
-  saveLock.unlock();
   BUSY_END;
+  saveLock.unlock();
   initDispatch();
   BUSY_BEGIN;
   renderSamples();
@@ -575,8 +712,8 @@ void DivEngine::createNew(const char* description, String sysName, bool inBase64
 
 void DivEngine::createNewFromDefaults() {
   quitDispatch();
-  BUSY_BEGIN;
   saveLock.lock();
+  BUSY_BEGIN;
   song.unload();
   song=DivSong();
   changeSong(0);
@@ -601,8 +738,8 @@ void DivEngine::createNewFromDefaults() {
   }
 
   recalcChans();
-  saveLock.unlock();
   BUSY_END;
+  saveLock.unlock();
   initDispatch();
   BUSY_BEGIN;
   renderSamples();
@@ -661,6 +798,7 @@ void DivEngine::stompChannel(int ch) {
 
 void DivEngine::changeSong(size_t songIndex) {
   if (songIndex>=song.subsong.size()) return;
+  truncateSeekIndex(0);
   curSubSong=song.subsong[songIndex];
   curPat=song.subsong[songIndex]->pat;
   curOrders=&song.subsong[songIndex]->orders;
@@ -752,191 +890,164 @@ void DivEngine::checkAssetDir(std::vector<DivAssetDir>& dir, size_t entries) {
 void DivEngine::swapChannelsP(int src, int dest) {
   if (src<0 || src>=chans) return;
   if (dest<0 || dest>=chans) return;
-  BUSY_BEGIN;
-  saveLock.lock();
-  swapChannels(src,dest);
-  saveLock.unlock();
-  BUSY_END;
+  lockEngine([&]() {
+    swapChannels(src,dest);
+  });
 }
 
 void DivEngine::changeSongP(size_t index) {
   if (index>=song.subsong.size()) return;
   if (index==curSubSongIndex) return;
   stop();
-  BUSY_BEGIN;
-  saveLock.lock();
-  changeSong(index);
-  saveLock.unlock();
-  BUSY_END;
+  lockEngine([&]() {
+    changeSong(index);
+  });
 }
 
 int DivEngine::addSubSong() {
   if (song.subsong.size()>=127) return -1;
-  BUSY_BEGIN;
-  saveLock.lock();
-  song.subsong.push_back(new DivSubSong);
-  saveLock.unlock();
-  BUSY_END;
+  lockEngine([&]() {
+    song.subsong.push_back(new DivSubSong);
+  });
   return song.subsong.size()-1;
 }
 
 int DivEngine::duplicateSubSong(int index) {
   if (song.subsong.size()>=127) return -1;
-  BUSY_BEGIN;
-  saveLock.lock();
-  DivSubSong* theCopy=new DivSubSong;
-  DivSubSong* theOrig=song.subsong[index];
-
-  theCopy->name=theOrig->name;
-  theCopy->notes=theOrig->notes;
-  theCopy->hilightA=theOrig->hilightA;
-  theCopy->hilightB=theOrig->hilightB;
-  theCopy->timeBase=theOrig->timeBase;
-  theCopy->arpLen=theOrig->arpLen;
-  theCopy->speeds=theOrig->speeds;
-  theCopy->virtualTempoN=theOrig->virtualTempoN;
-  theCopy->virtualTempoD=theOrig->virtualTempoD;
-  theCopy->hz=theOrig->hz;
-  theCopy->patLen=theOrig->patLen;
-  theCopy->ordersLen=theOrig->ordersLen;
-  theCopy->orders=theOrig->orders;
+  lockEngine([&]() {
+    DivSubSong* theCopy=new DivSubSong;
+    DivSubSong* theOrig=song.subsong[index];
+
+    theCopy->name=theOrig->name;
+    theCopy->notes=theOrig->notes;
+    theCopy->hilightA=theOrig->hilightA;
+    theCopy->hilightB=theOrig->hilightB;
+    theCopy->timeBase=theOrig->timeBase;
+    theCopy->arpLen=theOrig->arpLen;
+    theCopy->speeds=theOrig->speeds;
+    theCopy->virtualTempoN=theOrig->virtualTempoN;
+    theCopy->virtualTempoD=theOrig->virtualTempoD;
+    theCopy->hz=theOrig->hz;
+    theCopy->patLen=theOrig->patLen;
+    theCopy->ordersLen=theOrig->ordersLen;
+    theCopy->orders=theOrig->orders;
   
-  memcpy(theCopy->chanShow,theOrig->chanShow,DIV_MAX_CHANS*sizeof(bool));
-  memcpy(theCopy->chanCollapse,theOrig->chanCollapse,DIV_MAX_CHANS);
+    memcpy(theCopy->chanShow,theOrig->chanShow,DIV_MAX_CHANS*sizeof(bool));
+    memcpy(theCopy->chanCollapse,theOrig->chanCollapse,DIV_MAX_CHANS);
 
-  for (int i=0; i<DIV_MAX_CHANS; i++) {
-    theCopy->chanName[i]=theOrig->chanName[i];
-    theCopy->chanShortName[i]=theOrig->chanShortName[i];
+    for (int i=0; i<DIV_MAX_CHANS; i++) {
+      theCopy->chanName[i]=theOrig->chanName[i];
+      theCopy->chanShortName[i]=theOrig->chanShortName[i];
 
-    theCopy->pat[i].effectCols=theOrig->pat[i].effectCols;
+      theCopy->pat[i].effectCols=theOrig->pat[i].effectCols;
 
-    for (int j=0; j<DIV_MAX_PATTERNS; j++) {
-      if (theOrig->pat[i].data[j]==NULL) continue;
-      DivPattern* origPat=theOrig->pat[i].getPattern(j,false);
-      DivPattern* copyPat=theCopy->pat[i].getPattern(j,true);
-      origPat->copyOn(copyPat);
+      for (int j=0; j<DIV_MAX_PATTERNS; j++) {
+        if (theOrig->pat[i].data[j]==NULL) continue;
+        DivPattern* origPat=theOrig->pat[i].getPattern(j,false);
+        DivPattern* copyPat=theCopy->pat[i].getPattern(j,true);
+        origPat->copyOn(copyPat);
+      }
     }
-  }
 
-  song.subsong.push_back(theCopy);
-  
-  saveLock.unlock();
-  BUSY_END;
+    song.subsong.push_back(theCopy);
+  });
   return song.subsong.size()-1;
 }
 
 bool DivEngine::removeSubSong(int index) {
   if (song.subsong.size()<=1) return false;
   stop();
-  BUSY_BEGIN;
-  saveLock.lock();
-  song.subsong[index]->clearData();
-  delete song.subsong[index];
-  song.subsong.erase(song.subsong.begin()+index);
-  changeSong(0);
-  saveLock.unlock();
-  BUSY_END;
+  lockEngine([&]() {
+    song.subsong[index]->clearData();
+    delete song.subsong[index];
+    song.subsong.erase(song.subsong.begin()+index);
+    changeSong(0);
+  });
   return true;
 }
 
 void DivEngine::moveSubSongUp(size_t index) {
   if (index<1 || index>=song.subsong.size()) return;
-  BUSY_BEGIN;
-  saveLock.lock();
-
-  if (index==curSubSongIndex) {
-    curSubSongIndex--;
-  } else if (index-1==curSubSongIndex) {
-    curSubSongIndex++;
-  }
-
-  DivSubSong* prev=song.subsong[index-1];
-  song.subsong[index-1]=song.subsong[index];
-  song.subsong[index]=prev;
+  lockEngine([&]() {
+    if (index==curSubSongIndex) {
+      curSubSongIndex--;
+    } else if (index-1==curSubSongIndex) {
+      curSubSongIndex++;
+    }
 
-  saveLock.unlock();
-  BUSY_END;
+    DivSubSong* prev=song.subsong[index-1];
+    song.subsong[index-1]=song.subsong[index];
+    song.subsong[index]=prev;
+  });
 }
 
 void DivEngine::moveSubSongDown(size_t index) {
   if (index>=song.subsong.size()-1) return;
-  BUSY_BEGIN;
-  saveLock.lock();
-
-  if (index==curSubSongIndex) {
-    curSubSongIndex++;
-  } else if (index+1==curSubSongIndex) {
-    curSubSongIndex--;
-  }
-
-  DivSubSong* prev=song.subsong[index+1];
-  song.subsong[index+1]=song.subsong[index];
-  song.subsong[index]=prev;
+  lockEngine([&]() {
+    if (index==curSubSongIndex) {
+      curSubSongIndex++;
+    } else if (index+1==curSubSongIndex) {
+      curSubSongIndex--;
+    }
 
-  saveLock.unlock();
-  BUSY_END;
+    DivSubSong* prev=song.subsong[index+1];
+    song.subsong[index+1]=song.subsong[index];
+    song.subsong[index]=prev;
+  });
 }
 
 void DivEngine::clearSubSongs() {
-  BUSY_BEGIN;
-  saveLock.lock();
-  song.clearSongData();
-  changeSong(0);
-  curOrder=0;
-  prevOrder=0;
-  saveLock.unlock();
-  BUSY_END;
+  lockEngine([&]() {
+    song.clearSongData();
+    changeSong(0);
+    curOrder=0;
+    prevOrder=0;
+  });
 }
 
 void DivEngine::delUnusedIns() {
-  BUSY_BEGIN;
-  saveLock.lock();
-
-  bool isUsed[256];
-  memset(isUsed,0,256*sizeof(bool));
+  lockEngine([&]() {
+    bool isUsed[256];
+    memset(isUsed,0,256*sizeof(bool));
 
-  // scan
-  for (int i=0; i<chans; i++) {
-    for (size_t j=0; j<song.subsong.size(); j++) {
-      for (int k=0; k<DIV_MAX_PATTERNS; k++) {
-        if (song.subsong[j]->pat[i].data[k]==NULL) continue;
-        for (int l=0; l<song.subsong[j]->patLen; l++) {
-          if (song.subsong[j]->pat[i].data[k]->data[l][2]>=0 && song.subsong[j]->pat[i].data[k]->data[l][2]<256) {
-            isUsed[song.subsong[j]->pat[i].data[k]->data[l][2]]=true;
+    // scan
+    for (int i=0; i<chans; i++) {
+      for (size_t j=0; j<song.subsong.size(); j++) {
+        for (int k=0; k<DIV_MAX_PATTERNS; k++) {
+          if (song.subsong[j]->pat[i].data[k]==NULL) continue;
+          DivPattern* p=song.subsong[j]->pat[i].getPattern(k,false);
+          for (int l=0; l<song.subsong[j]->patLen; l++) {
+            if (p->data[l][2]>=0 && p->data[l][2]<256) {
+              isUsed[p->data[l][2]]=true;
+            }
           }
         }
       }
     }
-  }
   
-  // delete
-  for (int i=0; i<song.insLen; i++) {
-    if (!isUsed[i]) {
-      delInstrumentUnsafe(i);
-      // rotate
-      for (int j=i; j<255; j++) {
-        isUsed[j]=isUsed[j+1];
+    // delete
+    for (int i=0; i<song.insLen; i++) {
+      if (!isUsed[i]) {
+        delInstrumentUnsafe(i);
+        // rotate
+        for (int j=i; j<255; j++) {
+          isUsed[j]=isUsed[j+1];
+        }
+        isUsed[255]=true;
+        i--;
       }
-      isUsed[255]=true;
-      i--;
     }
-  }
-
-  saveLock.unlock();
-  BUSY_END;
+  });
 }
 
 void DivEngine::delUnusedWaves() {
-  BUSY_BEGIN;
-  saveLock.lock();
-
-  saveLock.unlock();
-  BUSY_END;
+  lockEngine([&]() {
+  });
 }
 
 void DivEngine::delUnusedSamples() {
-  BUSY_BEGIN;
   saveLock.lock();
+  BUSY_BEGIN;
 
   bool isUsed[256];
   memset(isUsed,0,256*sizeof(bool));
@@ -997,15 +1108,15 @@ void DivEngine::delUnusedSamples() {
   // render
   renderSamples();
 
-  saveLock.unlock();
   BUSY_END;
+  saveLock.unlock();
 }
 
 void DivEngine::changeSystem(int index, DivSystem which, bool preserveOrder) {
   int chanCount=chans;
   quitDispatch();
-  BUSY_BEGIN;
   saveLock.lock();
+  BUSY_BEGIN;
 
   if (!preserveOrder) {
     int firstChan=0;
@@ -1036,8 +1147,8 @@ void DivEngine::changeSystem(int index, DivSystem which, bool preserveOrder) {
   song.system[index]=which;
   song.systemFlags[index].clear();
   recalcChans();
-  saveLock.unlock();
   BUSY_END;
+  saveLock.unlock();
   initDispatch();
   BUSY_BEGIN;
   renderSamples();
@@ -1055,19 +1166,19 @@ bool DivEngine::addSystem(DivSystem which) {
     return false;
   }
   quitDispatch();
-  BUSY_BEGIN;
   saveLock.lock();
+  BUSY_BEGIN;
   song.system[song.systemLen]=which;
   song.systemVol[song.systemLen]=1.0;
   song.systemPan[song.systemLen]=0;
   song.systemPanFR[song.systemLen]=0;
   song.systemFlags[song.systemLen++].clear();
   recalcChans();
-  saveLock.unlock();
   BUSY_END;
+  saveLock.unlock();
   initDispatch();
-  BUSY_BEGIN;
   saveLock.lock();
+  BUSY_BEGIN;
   if (song.patchbayAuto) {
     autoPatchbay();
   } else {
@@ -1107,8 +1218,8 @@ bool DivEngine::removeSystem(int index, bool preserveOrder) {
   }
   int chanCount=chans;
   quitDispatch();
-  BUSY_BEGIN;
   saveLock.lock();
+  BUSY_BEGIN;
 
   if (!preserveOrder) {
     int firstChan=0;
@@ -1139,8 +1250,8 @@ bool DivEngine::removeSystem(int index, bool preserveOrder) {
     song.systemFlags[i]=song.systemFlags[i+1];
   }
   recalcChans();
-  saveLock.unlock();
   BUSY_END;
+  saveLock.unlock();
   initDispatch();
   BUSY_BEGIN;
   renderSamples();
@@ -1164,8 +1275,8 @@ bool DivEngine::swapSystem(int src, int dest, bool preserveOrder) {
   }
   //int chanCount=chans;
   quitDispatch();
-  BUSY_BEGIN;
   saveLock.lock();
+  BUSY_BEGIN;
 
   if (!preserveOrder) {
     // move channels
@@ -1284,8 +1395,8 @@ bool DivEngine::swapSystem(int src, int dest, bool preserveOrder) {
   }
 
   recalcChans();
-  saveLock.unlock();
   BUSY_END;
+  saveLock.unlock();
   initDispatch();
   BUSY_BEGIN;
   renderSamples();
@@ -1296,16 +1407,16 @@ bool DivEngine::swapSystem(int src, int dest, bool preserveOrder) {
 
 void DivEngine::poke(int sys, unsigned int addr, unsigned short val) {
   if (sys<0 || sys>=song.systemLen) return;
-  BUSY_BEGIN;
-  disCont[sys].dispatch->poke(addr,val);
-  BUSY_END;
+  synchronized([&]() {
+    disCont[sys].dispatch->poke(addr,val);
+  });
 }
 
 void DivEngine::poke(int sys, std::vector<DivRegWrite>& wlist) {
   if (sys<0 || sys>=song.systemLen) return;
-  BUSY_BEGIN;
-  disCont[sys].dispatch->poke(wlist);
-  BUSY_END;
+  synchronized([&]() {
+    disCont[sys].dispatch->poke(wlist);
+  });
 }
 
 String DivEngine::getLastError() {
@@ -1452,24 +1563,335 @@ DivDispatchOscBuffer* DivEngine::getOscBuffer(int chan) {
   return disCont[dispatchOfChan[chan]].dispatch->getOscBuffer(dispatchChanOfChan[chan]);
 }
 
+void DivEngine::resetOscBuffers() {
+  DivEngineMessage msg(DIV_MSG_RESET_OSC);
+  if (isAudioRunning()) {
+    postMessage(msg);
+  } else {
+    // nobody would drain the queue
+    synchronized([this,&msg]() {
+      applyMessage(msg);
+    });
+  }
+}
+
+DivDispatchOscBuffer* DivEngine::requestOscBuffer(int chan) {
+  if (!oscCapture) return NULL;
+  DivDispatchOscBuffer* buf=getOscBuffer(chan);
+  if (buf==NULL) return NULL;
+  if (buf->alloc()==NULL) return NULL;
+  return buf;
+}
+
+void DivEngine::setOscCapture(bool enable) {
+  synchronized([&]() {
+    if (!enable) {
+      for (int i=0; i<chans; i++) {
+        DivDispatchOscBuffer* buf=getOscBuffer(i);
+        if (buf!=NULL) buf->release();
+      }
+    }
+    oscCapture=enable;
+  });
+}
+
+bool DivEngine::getOscCapture() {
+  return oscCapture;
+}
+
 void DivEngine::enableCommandStream(bool enable) {
   cmdStreamEnabled=enable;
 }
 
 void DivEngine::getCommandStream(std::vector<DivCommand>& where) {
-  BUSY_BEGIN;
-  where.clear();
-  where.reserve(cmdStream.size());
-  for (DivCommand& i: cmdStream) {
-    where.push_back(i);
+  synchronized([&]() {
+    where.clear();
+    where.reserve(cmdStream.size());
+    for (DivCommand& i: cmdStream) {
+      where.push_back(i);
+    }
+    cmdStream.clear();
+  });
+}
+
+#define SEEK_HASH(h,x) \
+  for (size_t _i=0; _i<sizeof(x); _i++) { \
+    h^=((const unsigned char*)&(x))[_i]; \
+    h*=0x100000001b3ULL; \
   }
-  cmdStream.clear();
-  BUSY_END;
+
+uint64_t DivEngine::hashSeekOrder(int order) {
+  // patterns get a new revision whenever they're edited (see DivPattern::touch()),
+  // so there is no need to look at their contents
+  uint64_t h=0xcbf29ce484222325ULL;
+  for (int i=0; i<chans; i++) {
+    unsigned char pat=curOrders->ord[i][order];
+    SEEK_HASH(h,pat);
+    DivPattern* p=curPat[i].getPattern(pat,false);
+    SEEK_HASH(h,p->revision);
+  }
+  return h;
+}
+
+uint64_t DivEngine::hashSeekSettings() {
+  uint64_t h=0xcbf29ce484222325ULL;
+  SEEK_HASH(h,chans);
+  for (int i=0; i<chans; i++) {
+    SEEK_HASH(h,curPat[i].effectCols);
+  }
+  SEEK_HASH(h,curSubSong->speeds.val);
+  SEEK_HASH(h,curSubSong->speeds.len);
+  SEEK_HASH(h,curSubSong->hz);
+  SEEK_HASH(h,curSubSong->virtualTempoN);
+  SEEK_HASH(h,curSubSong->virtualTempoD);
+  SEEK_HASH(h,curSubSong->timeBase);
+  SEEK_HASH(h,curSubSong->patLen);
+  SEEK_HASH(h,curSubSong->ordersLen);
+  // snapshots hold frequencies worked out from the tuning
+  SEEK_HASH(h,song.tuning);
+  for (DivGroovePattern& i: song.grooves) {
+    SEEK_HASH(h,i.val);
+    SEEK_HASH(h,i.len);
+  }
+  // compatibility flags
+  SEEK_HASH(h,song.limitSlides);
+  SEEK_HASH(h,song.linearPitch);
+  SEEK_HASH(h,song.pitchSlideSpeed);
+  SEEK_HASH(h,song.loopModality);
+  SEEK_HASH(h,song.delayBehavior);
+  SEEK_HASH(h,song.jumpTreatment);
+  SEEK_HASH(h,song.properNoiseLayout);
+  SEEK_HASH(h,song.waveDutyIsVol);
+  SEEK_HASH(h,song.resetMacroOnPorta);
+  SEEK_HASH(h,song.legacyVolumeSlides);
+  SEEK_HASH(h,song.compatibleArpeggio);
+  SEEK_HASH(h,song.noteOffResetsSlides);
+  SEEK_HASH(h,song.targetResetsSlides);
+  SEEK_HASH(h,song.arpNonPorta);
+  SEEK_HASH(h,song.algMacroBehavior);
+  SEEK_HASH(h,song.brokenShortcutSlides);
+  SEEK_HASH(h,song.ignoreDuplicateSlides);
+  SEEK_HASH(h,song.stopPortaOnNoteOff);
+  SEEK_HASH(h,song.continuousVibrato);
+  SEEK_HASH(h,song.brokenDACMode);
+  SEEK_HASH(h,song.oneTickCut);
+  SEEK_HASH(h,song.newInsTriggersInPorta);
+  SEEK_HASH(h,song.arp0Reset);
+  SEEK_HASH(h,song.brokenSpeedSel);
+  SEEK_HASH(h,song.noSlidesOnFirstTick);
+  SEEK_HASH(h,song.rowResetsArpPos);
+  SEEK_HASH(h,song.ignoreJumpAtEnd);
+  SEEK_HASH(h,song.buggyPortaAfterSlide);
+  SEEK_HASH(h,song.gbInsAffectsEnvelope);
+  SEEK_HASH(h,song.sharedExtStat);
+  SEEK_HASH(h,song.ignoreDACModeOutsideIntendedChannel);
+  SEEK_HASH(h,song.e1e2AlsoTakePriority);
+  SEEK_HASH(h,song.newSegaPCM);
+  SEEK_HASH(h,song.fbPortaPause);
+  SEEK_HASH(h,song.snDutyReset);
+  SEEK_HASH(h,song.pitchMacroIsLinear);
+  SEEK_HASH(h,song.oldOctaveBoundary);
+  SEEK_HASH(h,song.noOPN2Vol);
+  SEEK_HASH(h,song.newVolumeScaling);
+  SEEK_HASH(h,song.volMacroLinger);
+  SEEK_HASH(h,song.brokenOutVol);
+  SEEK_HASH(h,song.brokenOutVol2);
+  SEEK_HASH(h,song.e1e2StopOnSameNote);
+  SEEK_HASH(h,song.brokenPortaArp);
+  SEEK_HASH(h,song.snNoLowPeriods);
+  SEEK_HASH(h,song.disableSampleMacro);
+  SEEK_HASH(h,song.autoSystem);
+  SEEK_HASH(h,song.oldArpStrategy);
+  SEEK_HASH(h,song.patchbayAuto);
+  SEEK_HASH(h,song.brokenPortaLegato);
+  SEEK_HASH(h,song.brokenFMOff);
+  SEEK_HASH(h,song.preNoteNoEffect);
+  SEEK_HASH(h,song.oldDPCM);
+  SEEK_HASH(h,song.resetArpPhaseOnNewNote);
+  SEEK_HASH(h,song.ceilVolumeScaling);
+  return h;
+}
+
+void DivEngine::truncateSeekIndex(int fromOrder) {
+  if (fromOrder<0) fromOrder=0;
+  for (size_t i=fromOrder; i<seekIndex.size(); i++) {
+    DivSeekSnapshot* s=seekIndex[i];
+    if (s==NULL) continue;
+    for (int j=0; j<song.systemLen; j++) {
+      if (s->dispatchState[j]!=NULL && disCont[j].dispatch!=NULL) {
+        disCont[j].dispatch->freeState(s->dispatchState[j]);
+      }
+    }
+    delete s;
+  }
+  if ((int)seekIndex.size()>fromOrder) seekIndex.resize(fromOrder);
+  if ((int)seekOrderHash.size()>fromOrder) seekOrderHash.resize(fromOrder);
+}
+
+void DivEngine::validateSeekIndex(int upTo) {
+  uint64_t settingsHash=hashSeekSettings();
+  if (settingsHash!=seekSettingsHash) {
+    if (!seekIndex.empty()) logV("seek index: song settings changed");
+    truncateSeekIndex(0);
+    seekSettingsHash=settingsHash;
+    return;
+  }
+  // snapshots from the first edited order onwards are stale
+  for (int i=0; i<=upTo && i<(int)seekOrderHash.size(); i++) {
+    if (hashSeekOrder(i)!=seekOrderHash[i]) {
+      logV("seek index: order %d changed",i);
+      truncateSeekIndex(i);
+      return;
+    }
+  }
+}
+
+void DivEngine::saveSeekSnapshot() {
+  if (seekIndexUnsupported) return;
+  if (curOrder<0 || curOrder>=curSubSong->ordersLen) return;
+  if ((int)seekIndex.size()>curOrder) {
+    if (seekIndex[curOrder]!=NULL) return;
+  }
+
+  DivSeekSnapshot* s=new DivSeekSnapshot;
+  for (int i=0; i<song.systemLen; i++) {
+    s->dispatchState[i]=disCont[i].dispatch->getState();
+    if (s->dispatchState[i]==NULL) {
+      logV("seek index: %s does not support state saves",getSystemName(song.system[i]));
+      for (int j=0; j<i; j++) {
+        disCont[j].dispatch->freeState(s->dispatchState[j]);
+      }
+      delete s;
+      seekIndexUnsupported=true;
+      return;
+    }
+  }
+  s->chan.assign(chan,chan+chans);
+  memcpy(s->walked,walked,8192);
+  s->speeds=speeds;
+  s->divider=divider;
+  s->clockDrift=clockDrift;
+  s->midiClockDrift=midiClockDrift;
+  s->midiTimeDrift=midiTimeDrift;
+  s->subticks=subticks;
+  s->ticks=ticks;
+  s->curRow=curRow;
+  s->curOrder=curOrder;
+  s->prevRow=prevRow;
+  s->prevOrder=prevOrder;
+  s->totalLoops=totalLoops;
+  s->lastLoopPos=lastLoopPos;
+  s->nextSpeed=nextSpeed;
+  s->elapsedBars=elapsedBars;
+  s->elapsedBeats=elapsedBeats;
+  s->curSpeed=curSpeed;
+  s->cycles=cycles;
+  s->midiClockCycles=midiClockCycles;
+  s->midiTimeCycles=midiTimeCycles;
+  s->stepPlay=stepPlay;
+  s->changeOrd=changeOrd;
+  s->changePos=changePos;
+  s->totalSeconds=totalSeconds;
+  s->totalTicks=totalTicks;
+  s->totalTicksR=totalTicksR;
+  s->curMidiClock=curMidiClock;
+  s->curMidiTime=curMidiTime;
+  s->curMidiTimePiece=curMidiTimePiece;
+  s->curMidiTimeCode=curMidiTimeCode;
+  s->globalPitch=globalPitch;
+  s->tempoAccum=tempoAccum;
+  s->extValue=extValue;
+  s->arpLen=curSubSong->arpLen;
+  s->pendingMetroTick=pendingMetroTick;
+  s->extValuePresent=extValuePresent;
+  s->endOfSong=endOfSong;
+  s->shallStop=shallStop;
+  s->shallStopSched=shallStopSched;
+  s->firstTick=firstTick;
+
+  // orders up to this one must be hashed for validation
+  for (int i=seekOrderHash.size(); i<=curOrder; i++) {
+    seekOrderHash.push_back(hashSeekOrder(i));
+  }
+  if ((int)seekIndex.size()<=curOrder) seekIndex.resize(curOrder+1,NULL);
+  seekIndex[curOrder]=s;
+}
+
+bool DivEngine::loadSeekSnapshot(int goal) {
+  DivSeekSnapshot* s=NULL;
+  for (int i=MIN(goal,(int)seekIndex.size()-1); i>0; i--) {
+    if (seekIndex[i]!=NULL) {
+      s=seekIndex[i];
+      break;
+    }
+  }
+  if (s==NULL) return false;
+  if ((int)s->chan.size()!=chans) return false;
+
+  for (int i=0; i<song.systemLen; i++) {
+    disCont[i].dispatch->setState(s->dispatchState[i]);
+  }
+  for (int i=0; i<chans; i++) {
+    chan[i]=s->chan[i];
+  }
+  memcpy(walked,s->walked,8192);
+  speeds=s->speeds;
+  divider=s->divider;
+  clockDrift=s->clockDrift;
+  midiClockDrift=s->midiClockDrift;
+  midiTimeDrift=s->midiTimeDrift;
+  subticks=s->subticks;
+  ticks=s->ticks;
+  curRow=s->curRow;
+  curOrder=s->curOrder;
+  prevRow=s->prevRow;
+  prevOrder=s->prevOrder;
+  totalLoops=s->totalLoops;
+  lastLoopPos=s->lastLoopPos;
+  nextSpeed=s->nextSpeed;
+  elapsedBars=s->elapsedBars;
+  elapsedBeats=s->elapsedBeats;
+  curSpeed=s->curSpeed;
+  cycles=s->cycles;
+  midiClockCycles=s->midiClockCycles;
+  midiTimeCycles=s->midiTimeCycles;
+  stepPlay=s->stepPlay;
+  changeOrd=s->changeOrd;
+  changePos=s->changePos;
+  totalSeconds=s->totalSeconds;
+  totalTicks=s->totalTicks;
+  totalTicksR=s->totalTicksR;
+  curMidiClock=s->curMidiClock;
+  curMidiTime=s->curMidiTime;
+  curMidiTimePiece=s->curMidiTimePiece;
+  curMidiTimeCode=s->curMidiTimeCode;
+  globalPitch=s->globalPitch;
+  tempoAccum=s->tempoAccum;
+  extValue=s->extValue;
+  curSubSong->arpLen=s->arpLen;
+  pendingMetroTick=s->pendingMetroTick;
+  extValuePresent=s->extValuePresent;
+  endOfSong=s->endOfSong;
+  shallStop=s->shallStop;
+  shallStopSched=s->shallStopSched;
+  firstTick=s->firstTick;
+  return true;
+}
+
+void DivEngine::invalidateSeekIndex() {
+  synchronized([&]() {
+    truncateSeekIndex(0);
+  });
 }
 
 void DivEngine::playSub(bool preserveDrift, int goalRow) {
   logV("playSub() called");
   std::chrono::high_resolution_clock::time_point timeStart=std::chrono::high_resolution_clock::now();
+  // apply queued mutes and notes before seeking. don't let a note start
+  // freelance playback, as we are about to start playing anyway.
+  bool wasFreelance=freelance;
+  applyMessages();
+  freelance=wasFreelance;
   for (int i=0; i<song.systemLen; i++) disCont[i].dispatch->setSkipRegisterWrites(false);
   reset();
   if (preserveDrift && curOrder==0) {
@@ -1516,7 +1938,18 @@ void DivEngine::playSub(bool preserveDrift, int goalRow) {
   memset(walked,0,8192);
   for (int i=0; i<song.systemLen; i++) disCont[i].dispatch->setSkipRegisterWrites(true);
   logV("goal: %d goalRow: %d",goal,goalRow);
+  // the seek index holds the state at the first time each order is reached.
+  // snapshots are only taken while orders go forward, as a backward jump may
+  // reach an order from a different state.
+  bool useSeekIndex=(!preserveDrift && goal>0);
+  if (useSeekIndex) {
+    validateSeekIndex(goal);
+    if (loadSeekSnapshot(goal)) {
+      logV("seek index: starting from order %d",curOrder);
+    }
+  }
   while (playing && curOrder<goal) {
+    int lastOrder=curOrder;
     if (nextTick(preserveDrift)) {
       skipping=false;
       cmdStream.clear();
@@ -1530,6 +1963,13 @@ void DivEngine::playSub(bool preserveDrift, int goalRow) {
       runMidiClock(cycles);
       runMidiTime(cycles);
     }
+    if (useSeekIndex && curOrder!=lastOrder) {
+      if (curOrder<lastOrder) {
+        useSeekIndex=false;
+      } else {
+        saveSeekSnapshot();
+      }
+    }
   }
   int oldOrder=curOrder;
   while (playing && (curRow<goalRow || ticks>1)) {
@@ -1601,10 +2041,16 @@ double DivEngine::calcBaseFreq(double clock, double divider, int note, bool peri
   if (song.linearPitch==2) { // full linear
     return (note<<7);
   }
+  DivFreqTable* table=freqCache.getTable(DIV_FREQ_BASE,clock,divider,song.tuning,period,0);
+  double ret;
+  if (table->get(note,ret)) return ret;
+
   double base=(period?(song.tuning*0.0625):song.tuning)*pow(2.0,(float)(note+3)/12.0);
-  return period?
-         (clock/base)/divider:
-         base*(divider/clock);
+  ret=period?
+      (clock/base)/divider:
+      base*(divider/clock);
+  table->put(note,ret);
+  return ret;
 }
 
 #define CONVERT_FNUM_BLOCK(bf,bits,note) \
@@ -1639,12 +2085,22 @@ double DivEngine::calcBaseFreq(double clock, double divider, int note, bool peri
   /* logV("f-num: %d block: %d",bf,block); */ \
   return bf|(block<<bits);
 
+int DivEngine::convertFNumBlock(int bf, int bits, int note, double clock, double divider) {
+  CONVERT_FNUM_BLOCK(bf,bits,note)
+}
+
 int DivEngine::calcBaseFreqFNumBlock(double clock, double divider, int note, int bits) {
   if (song.linearPitch==2) { // full linear
     return (note<<7);
   }
+  DivFreqTable* table=freqCache.getTable(DIV_FREQ_FNUM_BLOCK,clock,divider,song.tuning,false,bits);
+  double cached;
+  if (table->get(note,cached)) return (int)cached;
+
   int bf=calcBaseFreq(clock,divider,note,false);
-  CONVERT_FNUM_BLOCK(bf,bits,note)
+  bf=convertFNumBlock(bf,bits,note,clock,divider);
+  table->put(note,bf);
+  return bf;
 }
 
 int DivEngine::calcFreq(int base, int pitch, int arp, bool arpFixed, bool period, int octave, int pitch2, double clock, double divider, int blockBits) {
@@ -1658,15 +2114,19 @@ int DivEngine::calcFreq(int base, int pitch, int arp, bool arpFixed, bool period
         nbase+=arp<<7;
       }
     }
+    DivFreqTable* table=freqCache.getTable(DIV_FREQ_LINEAR,clock,divider,song.tuning,period,blockBits);
+    double cached;
+    if (table->get(nbase,cached)) return (int)cached;
+
     double fbase=(period?(song.tuning*0.0625):song.tuning)*pow(2.0,(float)(nbase+384)/(128.0*12.0));
     int bf=period?
            round((clock/fbase)/divider):
            round(fbase*(divider/clock));
     if (blockBits>0) {
-      CONVERT_FNUM_BLOCK(bf,blockBits,nbase>>7)
-    } else {
-      return bf;
+      bf=convertFNumBlock(bf,blockBits,nbase>>7,clock,divider);
     }
+    table->put(nbase,bf);
+    return bf;
   }
   if (song.linearPitch==1) {
     // global pitch multiplier
@@ -1727,194 +2187,192 @@ unsigned int DivEngine::convertPanLinearToSplit(int val, unsigned char bits, int
 }
 
 bool DivEngine::play() {
-  BUSY_BEGIN_SOFT;
-  curOrder=prevOrder;
-  sPreview.sample=-1;
-  sPreview.wave=-1;
-  sPreview.pos=0;
-  sPreview.dir=false;
-  shallStop=false;
-  if (stepPlay==0) {
-    freelance=false;
-    playSub(false);
-  } else {
-    stepPlay=0;
-  }
-  for (int i=0; i<DIV_MAX_CHANS; i++) {
-    keyHit[i]=false;
-  }
-  curMidiTimePiece=0;
-  if (output) if (!skipping && output->midiOut!=NULL) {
-    if (midiOutClock) {
-      output->midiOut->send(TAMidiMessage(TA_MIDI_POSITION,(curMidiClock>>7)&0x7f,curMidiClock&0x7f));
-    }
-    if (midiOutTime) {
-      TAMidiMessage msg;
-      msg.type=TA_MIDI_SYSEX;
-      msg.sysExData.reset(new unsigned char[10],std::default_delete<unsigned char[]>());
-      msg.sysExLen=10;
-      unsigned char* msgData=msg.sysExData.get();
-      int actualTime=curMidiTime;
-      int timeRate=midiOutTimeRate;
-      int drop=0;
-      if (timeRate<1 || timeRate>4) {
-        if (curSubSong->hz>=47.98 && curSubSong->hz<=48.02) {
-          timeRate=1;
-        } else if (curSubSong->hz>=49.98 && curSubSong->hz<=50.02) {
-          timeRate=2;
-        } else if (curSubSong->hz>=59.9 && curSubSong->hz<=60.11) {
-          timeRate=4;
-        } else {
-          timeRate=4;
-        }
+  bool didItPlay=false;
+  synchronized([&]() {
+    curOrder=prevOrder;
+    sPreview.sample=-1;
+    sPreview.wave=-1;
+    sPreview.pos=0;
+    sPreview.dir=false;
+    shallStop=false;
+    if (stepPlay==0) {
+      freelance=false;
+      playSub(false);
+    } else {
+      stepPlay=0;
+    }
+    for (int i=0; i<DIV_MAX_CHANS; i++) {
+      keyHit[i]=false;
+    }
+    curMidiTimePiece=0;
+    if (output) if (!skipping && output->midiOut!=NULL) {
+      if (midiOutClock) {
+        output->midiOut->send(TAMidiMessage(TA_MIDI_POSITION,(curMidiClock>>7)&0x7f,curMidiClock&0x7f));
       }
+      if (midiOutTime) {
+        TAMidiMessage msg;
+        msg.type=TA_MIDI_SYSEX;
+        msg.sysExData.reset(new unsigned char[10],std::default_delete<unsigned char[]>());
+        msg.sysExLen=10;
+        unsigned char* msgData=msg.sysExData.get();
+        int actualTime=curMidiTime;
+        int timeRate=midiOutTimeRate;
+        int drop=0;
+        if (timeRate<1 || timeRate>4) {
+          if (curSubSong->hz>=47.98 && curSubSong->hz<=48.02) {
+            timeRate=1;
+          } else if (curSubSong->hz>=49.98 && curSubSong->hz<=50.02) {
+            timeRate=2;
+          } else if (curSubSong->hz>=59.9 && curSubSong->hz<=60.11) {
+            timeRate=4;
+          } else {
+            timeRate=4;
+          }
+        }
 
-      switch (timeRate) {
-        case 1: // 24
-          msgData[5]=(actualTime/(60*60*24))%24;
-          msgData[6]=(actualTime/(60*24))%60;
-          msgData[7]=(actualTime/24)%60;
-          msgData[8]=actualTime%24;
-          break;
-        case 2: // 25
-          msgData[5]=(actualTime/(60*60*25))%24;
-          msgData[6]=(actualTime/(60*25))%60;
-          msgData[7]=(actualTime/25)%60;
-          msgData[8]=actualTime%25;
-          break;
-        case 3: // 29.97 (NTSC drop)
-          // drop
-          drop=((actualTime/(30*60))-(actualTime/(30*600)))*2;
-          actualTime+=drop;
-
-          msgData[5]=(actualTime/(60*60*30))%24;
-          msgData[6]=(actualTime/(60*30))%60;
-          msgData[7]=(actualTime/30)%60;
-          msgData[8]=actualTime%30;
-          break;
-        case 4: // 30 (NTSC non-drop)
-        default:
-          msgData[5]=(actualTime/(60*60*30))%24;
-          msgData[6]=(actualTime/(60*30))%60;
-          msgData[7]=(actualTime/30)%60;
-          msgData[8]=actualTime%30;
-          break;
-      }
+        switch (timeRate) {
+          case 1: // 24
+            msgData[5]=(actualTime/(60*60*24))%24;
+            msgData[6]=(actualTime/(60*24))%60;
+            msgData[7]=(actualTime/24)%60;
+            msgData[8]=actualTime%24;
+            break;
+          case 2: // 25
+            msgData[5]=(actualTime/(60*60*25))%24;
+            msgData[6]=(actualTime/(60*25))%60;
+            msgData[7]=(actualTime/25)%60;
+            msgData[8]=actualTime%25;
+            break;
+          case 3: // 29.97 (NTSC drop)
+            // drop
+            drop=((actualTime/(30*60))-(actualTime/(30*600)))*2;
+            actualTime+=drop;
+
+            msgData[5]=(actualTime/(60*60*30))%24;
+            msgData[6]=(actualTime/(60*30))%60;
+            msgData[7]=(actualTime/30)%60;
+            msgData[8]=actualTime%30;
+            break;
+          case 4: // 30 (NTSC non-drop)
+          default:
+            msgData[5]=(actualTime/(60*60*30))%24;
+            msgData[6]=(actualTime/(60*30))%60;
+            msgData[7]=(actualTime/30)%60;
+            msgData[8]=actualTime%30;
+            break;
+        }
 
-      msgData[5]|=(timeRate-1)<<5;
+        msgData[5]|=(timeRate-1)<<5;
 
-      msgData[0]=0xf0;
-      msgData[1]=0x7f;
-      msgData[2]=0x7f;
-      msgData[3]=0x01;
-      msgData[4]=0x01;
-      msgData[9]=0xf7;
-      output->midiOut->send(msg);
+        msgData[0]=0xf0;
+        msgData[1]=0x7f;
+        msgData[2]=0x7f;
+        msgData[3]=0x01;
+        msgData[4]=0x01;
+        msgData[9]=0xf7;
+        output->midiOut->send(msg);
+      }
+      output->midiOut->send(TAMidiMessage(TA_MIDI_MACHINE_PLAY,0,0));
     }
-    output->midiOut->send(TAMidiMessage(TA_MIDI_MACHINE_PLAY,0,0));
-  }
-  bool didItPlay=playing;
-  BUSY_END;
+    didItPlay=playing;
+  });
   return didItPlay;
 }
 
 bool DivEngine::playToRow(int row) {
-  BUSY_BEGIN_SOFT;
-  sPreview.sample=-1;
-  sPreview.wave=-1;
-  sPreview.pos=0;
-  sPreview.dir=false;
-  freelance=false;
-  playSub(false,row);
-  for (int i=0; i<DIV_MAX_CHANS; i++) {
-    keyHit[i]=false;
-  }
-  bool didItPlay=playing;
-  BUSY_END;
-  return didItPlay;
-}
-
-void DivEngine::stepOne(int row) {
-  if (!isPlaying()) {
-    BUSY_BEGIN_SOFT;
+  bool didItPlay=false;
+  synchronized([&]() {
+    sPreview.sample=-1;
+    sPreview.wave=-1;
+    sPreview.pos=0;
+    sPreview.dir=false;
     freelance=false;
     playSub(false,row);
     for (int i=0; i<DIV_MAX_CHANS; i++) {
       keyHit[i]=false;
     }
-  } else {
-    BUSY_BEGIN;
-  }
-  stepPlay=2;
-  ticks=1;
-  prevOrder=curOrder;
-  prevRow=curRow;
-  BUSY_END;
+    didItPlay=playing;
+  });
+  return didItPlay;
+}
+
+void DivEngine::stepOne(int row) {
+  synchronized([&]() {
+    if (!isPlaying()) {
+      freelance=false;
+      playSub(false,row);
+      for (int i=0; i<DIV_MAX_CHANS; i++) {
+        keyHit[i]=false;
+      }
+    }
+    stepPlay=2;
+    ticks=1;
+    prevOrder=curOrder;
+    prevRow=curRow;
+  });
 }
 
 void DivEngine::stop() {
-  BUSY_BEGIN;
-  freelance=false;
-  if (!playing) {
-    //Send midi panic
-    if (output) if (output->midiOut!=NULL) {
-      output->midiOut->send(TAMidiMessage(TA_MIDI_CONTROL,0x7B,0));
-      logV("Midi panic sent");
+  synchronized([&]() {
+    freelance=false;
+    if (!playing) {
+      //Send midi panic
+      if (output) if (output->midiOut!=NULL) {
+        output->midiOut->send(TAMidiMessage(TA_MIDI_CONTROL,0x7B,0));
+        logV("Midi panic sent");
+      }
     }
-  }
-  playing=false;
-  extValuePresent=false;
-  endOfSong=false; // what?
-  stepPlay=0;
-  curOrder=prevOrder;
-  curRow=prevRow;
-  remainingLoops=-1;
-  sPreview.sample=-1;
-  sPreview.wave=-1;
-  sPreview.pos=0;
-  sPreview.dir=false;
-  for (int i=0; i<song.systemLen; i++) {
-    disCont[i].dispatch->notifyPlaybackStop();
-  }
-  if (output) if (output->midiOut!=NULL) {
-    output->midiOut->send(TAMidiMessage(TA_MIDI_MACHINE_STOP,0,0));
-    for (int i=0; i<chans; i++) {
-      if (chan[i].curMidiNote>=0) {
-        output->midiOut->send(TAMidiMessage(0x80|(i&15),chan[i].curMidiNote,0));
+    playing=false;
+    extValuePresent=false;
+    endOfSong=false; // what?
+    stepPlay=0;
+    curOrder=prevOrder;
+    curRow=prevRow;
+    remainingLoops=-1;
+    sPreview.sample=-1;
+    sPreview.wave=-1;
+    sPreview.pos=0;
+    sPreview.dir=false;
+    for (int i=0; i<song.systemLen; i++) {
+      disCont[i].dispatch->notifyPlaybackStop();
+    }
+    if (output) if (output->midiOut!=NULL) {
+      output->midiOut->send(TAMidiMessage(TA_MIDI_MACHINE_STOP,0,0));
+      for (int i=0; i<chans; i++) {
+        if (chan[i].curMidiNote>=0) {
+          output->midiOut->send(TAMidiMessage(0x80|(i&15),chan[i].curMidiNote,0));
+        }
       }
     }
-  }
 
-  // reset all chan oscs
-  for (int i=0; i<chans; i++) {
-    DivDispatchOscBuffer* buf=disCont[dispatchOfChan[i]].dispatch->getOscBuffer(dispatchChanOfChan[i]);
-    if (buf!=NULL) {
-      memset(buf->data,0,65536*sizeof(short));
-      buf->needle=0;
-      buf->readNeedle=0;
+    // reset all chan oscs
+    for (int i=0; i<chans; i++) {
+      DivDispatchOscBuffer* buf=disCont[dispatchOfChan[i]].dispatch->getOscBuffer(dispatchChanOfChan[i]);
+      if (buf!=NULL) {
+        buf->clear();
+      }
     }
-  }
-  BUSY_END;
+  });
 }
 
 void DivEngine::halt() {
-  BUSY_BEGIN;
-  halted=true;
-  BUSY_END;
+  synchronized([&]() {
+    halted=true;
+  });
 }
 
 void DivEngine::resume() {
-  BUSY_BEGIN;
-  halted=false;
-  haltOn=DIV_HALT_NONE;
-  BUSY_END;
+  synchronized([&]() {
+    halted=false;
+    haltOn=DIV_HALT_NONE;
+  });
 }
 
 void DivEngine::haltWhen(DivHaltPositions when) {
-  BUSY_BEGIN;
-  halted=false;
-  haltOn=when;
-  BUSY_END;
+  synchronized([&]() {
+    halted=false;
+    haltOn=when;
+  });
 }
 
 bool DivEngine::isHalted() {
@@ -2000,9 +2458,9 @@ void DivEngine::reset() {
 }
 
 void DivEngine::syncReset() {
-  BUSY_BEGIN;
-  reset();
-  BUSY_END;
+  synchronized([&]() {
+    reset();
+  });
 }
 
 const int sampleRates[6]={
@@ -2064,27 +2522,27 @@ int DivEngine::getEffectiveSampleRate(int rate) {
 }
 
 void DivEngine::previewSample(int sample, int note, int pStart, int pEnd) {
-  BUSY_BEGIN;
-  previewSampleNoLock(sample,note,pStart,pEnd);
-  BUSY_END;
+  synchronized([&]() {
+    previewSampleNoLock(sample,note,pStart,pEnd);
+  });
 }
 
 void DivEngine::stopSamplePreview() {
-  BUSY_BEGIN;
-  stopSamplePreviewNoLock();
-  BUSY_END;
+  synchronized([&]() {
+    stopSamplePreviewNoLock();
+  });
 }
 
 void DivEngine::previewWave(int wave, int note) {
-  BUSY_BEGIN;
-  previewWaveNoLock(wave,note);
-  BUSY_END;
+  synchronized([&]() {
+    previewWaveNoLock(wave,note);
+  });
 }
 
 void DivEngine::stopWavePreview() {
-  BUSY_BEGIN;
-  stopWavePreviewNoLock();
-  BUSY_END;
+  synchronized([&]() {
+    stopWavePreviewNoLock();
+  });
 }
 
 void DivEngine::previewSampleNoLock(int sample, int note, int pStart, int pEnd) {
@@ -2244,9 +2702,9 @@ bool DivEngine::getRepeatPattern() {
 }
 
 void DivEngine::setRepeatPattern(bool value) {
-  BUSY_BEGIN;
-  repeatPattern=value;
-  BUSY_END;
+  synchronized([&]() {
+    repeatPattern=value;
+  });
 }
 
 bool DivEngine::hasExtValue() {
@@ -2290,43 +2748,24 @@ void DivEngine::toggleSolo(int chan) {
       }
     }
   }
-  BUSY_BEGIN;
-  if (!solo) {
-    for (int i=0; i<chans; i++) {
-      isMuted[i]=(i!=chan);
-      if (disCont[dispatchOfChan[i]].dispatch!=NULL) {
-        disCont[dispatchOfChan[i]].dispatch->muteChannel(dispatchChanOfChan[i],isMuted[i]);
-      }
-    }
-  } else {
-    for (int i=0; i<chans; i++) {
-      isMuted[i]=false;
-      if (disCont[dispatchOfChan[i]].dispatch!=NULL) {
-        disCont[dispatchOfChan[i]].dispatch->muteChannel(dispatchChanOfChan[i],isMuted[i]);
-      }
-    }
+  // isMuted is updated right away so that the GUI sees it.
+  // the dispatches are told on the next buffer.
+  for (int i=0; i<chans; i++) {
+    isMuted[i]=solo?false:(i!=chan);
+    postMessage(DivEngineMessage(DIV_MSG_MUTE,i,0,isMuted[i]));
   }
-  BUSY_END;
 }
 
 void DivEngine::muteChannel(int chan, bool mute) {
-  BUSY_BEGIN;
   isMuted[chan]=mute;
-  if (disCont[dispatchOfChan[chan]].dispatch!=NULL) {
-    disCont[dispatchOfChan[chan]].dispatch->muteChannel(dispatchChanOfChan[chan],isMuted[chan]);
-  }
-  BUSY_END;
+  postMessage(DivEngineMessage(DIV_MSG_MUTE,chan,0,mute));
 }
 
 void DivEngine::unmuteAll() {
-  BUSY_BEGIN;
   for (int i=0; i<chans; i++) {
     isMuted[i]=false;
-    if (disCont[dispatchOfChan[i]].dispatch!=NULL) {
-      disCont[dispatchOfChan[i]].dispatch->muteChannel(dispatchChanOfChan[i],isMuted[i]);
-    }
+    postMessage(DivEngineMessage(DIV_MSG_MUTE,i,0,false));
   }
-  BUSY_END;
 }
 
 void DivEngine::dumpSongInfo() {
@@ -2390,43 +2829,42 @@ void DivEngine::dumpSongInfo() {
 
 int DivEngine::addInstrument(int refChan, DivInstrumentType fallbackType) {
   if (song.ins.size()>=256) return -1;
-  BUSY_BEGIN;
-  DivInstrument* ins=new DivInstrument;
-  int insCount=(int)song.ins.size();
-  DivInstrumentType prefType;
-  if (refChan<0) {
-    prefType=fallbackType;
-  } else {
-    prefType=getPreferInsType(refChan);
-  }
-  switch (prefType) {
-    case DIV_INS_OPLL:
-      *ins=song.nullInsOPLL;
-      break;
-    case DIV_INS_OPL:
-      *ins=song.nullInsOPL;
-      break;
-    case DIV_INS_OPL_DRUMS:
-      *ins=song.nullInsOPLDrums;
-      break;
-    default:
-      break;
-  }
-  if (refChan>=0) {
-    if (sysOfChan[refChan]==DIV_SYSTEM_QSOUND) {
-      *ins=song.nullInsQSound;
+  int insCount=-1;
+  lockEngine([&]() {
+    DivInstrument* ins=new DivInstrument;
+    insCount=(int)song.ins.size();
+    DivInstrumentType prefType;
+    if (refChan<0) {
+      prefType=fallbackType;
+    } else {
+      prefType=getPreferInsType(refChan);
     }
-  }
-  ins->name=fmt::sprintf("Instrument %d",insCount);
-  if (prefType!=DIV_INS_NULL) {
-    ins->type=prefType;
-  }
-  saveLock.lock();
-  song.ins.push_back(ins);
-  song.insLen=insCount+1;
-  checkAssetDir(song.insDir,song.ins.size());
-  saveLock.unlock();
-  BUSY_END;
+    switch (prefType) {
+      case DIV_INS_OPLL:
+        *ins=song.nullInsOPLL;
+        break;
+      case DIV_INS_OPL:
+        *ins=song.nullInsOPL;
+        break;
+      case DIV_INS_OPL_DRUMS:
+        *ins=song.nullInsOPLDrums;
+        break;
+      default:
+        break;
+    }
+    if (refChan>=0) {
+      if (sysOfChan[refChan]==DIV_SYSTEM_QSOUND) {
+        *ins=song.nullInsQSound;
+      }
+    }
+    ins->name=fmt::sprintf("Instrument %d",insCount);
+    if (prefType!=DIV_INS_NULL) {
+      ins->type=prefType;
+    }
+    song.ins.push_back(ins);
+    song.insLen=insCount+1;
+    checkAssetDir(song.insDir,song.ins.size());
+  });
   return insCount;
 }
 
@@ -2435,29 +2873,29 @@ int DivEngine::addInstrumentPtr(DivInstrument* which) {
     delete which;
     return -1;
   }
-  BUSY_BEGIN;
-  saveLock.lock();
-  song.ins.push_back(which);
-  song.insLen=song.ins.size();
-  checkAssetDir(song.insDir,song.ins.size());
-  checkAssetDir(song.waveDir,song.wave.size());
-  checkAssetDir(song.sampleDir,song.sample.size());
-  saveLock.unlock();
-  BUSY_END;
+  lockEngine([&]() {
+    song.ins.push_back(which);
+    song.insLen=song.ins.size();
+    checkAssetDir(song.insDir,song.ins.size());
+    checkAssetDir(song.waveDir,song.wave.size());
+    checkAssetDir(song.sampleDir,song.sample.size());
+  });
   return song.insLen;
 }
 
 void DivEngine::loadTempIns(DivInstrument* which) {
-  BUSY_BEGIN;
-  if (tempIns==NULL) {
-    tempIns=new DivInstrument;
-  }
-  *tempIns=*which;
-  BUSY_END;
+  synchronized([&]() {
+    if (tempIns==NULL) {
+      tempIns=new DivInstrument;
+    }
+    *tempIns=*which;
+  });
 }
 
 void DivEngine::delInstrumentUnsafe(int index) {
   if (index>=0 && index<(int)song.ins.size()) {
+    // snapshots may point to this instrument
+    truncateSeekIndex(0);
     for (int i=0; i<song.systemLen; i++) {
       disCont[i].dispatch->notifyInsDeletion(song.ins[index]);
     }
@@ -2468,11 +2906,13 @@ void DivEngine::delInstrumentUnsafe(int index) {
       for (size_t j=0; j<song.subsong.size(); j++) {
         for (int k=0; k<DIV_MAX_PATTERNS; k++) {
           if (song.subsong[j]->pat[i].data[k]==NULL) continue;
+          DivPattern* p=song.subsong[j]->pat[i].getPattern(k,false);
           for (int l=0; l<song.subsong[j]->patLen; l++) {
-            if (song.subsong[j]->pat[i].data[k]->data[l][2]>index) {
-              song.subsong[j]->pat[i].data[k]->data[l][2]--;
+            if (p->data[l][2]>index) {
+              p->data[l][2]--;
             }
           }
+          p->touch();
         }
       }
     }
@@ -2482,11 +2922,9 @@ void DivEngine::delInstrumentUnsafe(int index) {
 }
 
 void DivEngine::delInstrument(int index) {
-  BUSY_BEGIN;
-  saveLock.lock();
-  delInstrumentUnsafe(index);
-  saveLock.unlock();
-  BUSY_END;
+  lockEngine([&]() {
+    delInstrumentUnsafe(index);
+  });
 }
 
 int DivEngine::addWave() {
@@ -2494,15 +2932,14 @@ int DivEngine::addWave() {
     lastError="too many wavetables!";
     return -1;
   }
-  BUSY_BEGIN;
-  saveLock.lock();
-  DivWavetable* wave=new DivWavetable;
-  int waveCount=(int)song.wave.size();
-  song.wave.push_back(wave);
-  song.waveLen=waveCount+1;
-  checkAssetDir(song.waveDir,song.wave.size());
-  saveLock.unlock();
-  BUSY_END;
+  int waveCount=-1;
+  lockEngine([&]() {
+    DivWavetable* wave=new DivWavetable;
+    waveCount=(int)song.wave.size();
+    song.wave.push_back(wave);
+    song.waveLen=waveCount+1;
+    checkAssetDir(song.waveDir,song.wave.size());
+  });
   return waveCount;
 }
 
@@ -2512,14 +2949,12 @@ int DivEngine::addWavePtr(DivWavetable* which) {
     delete which;
     return -1;
   }
-  BUSY_BEGIN;
-  saveLock.lock();
-  int waveCount=(int)song.wave.size();
-  song.wave.push_back(which);
-  song.waveLen=waveCount+1;
-  checkAssetDir(song.waveDir,song.wave.size());
-  saveLock.unlock();
-  BUSY_END;
+  lockEngine([&]() {
+    int waveCount=(int)song.wave.size();
+    song.wave.push_back(which);
+    song.waveLen=waveCount+1;
+    checkAssetDir(song.waveDir,song.wave.size());
+  });
   return song.waveLen;
 }
 
@@ -2667,6 +3102,7 @@ DivWavetable* DivEngine::waveFromFile(const char* path, bool addRaw) {
 
 void DivEngine::delWaveUnsafe(int index) {
   if (index>=0 && index<(int)song.wave.size()) {
+    truncateSeekIndex(0);
     delete song.wave[index];
     song.wave.erase(song.wave.begin()+index);
     song.waveLen=song.wave.size();
@@ -2676,11 +3112,9 @@ void DivEngine::delWaveUnsafe(int index) {
 }
 
 void DivEngine::delWave(int index) {
-  BUSY_BEGIN;
-  saveLock.lock();
-  delWaveUnsafe(index);
-  saveLock.unlock();
-  BUSY_END;
+  lockEngine([&]() {
+    delWaveUnsafe(index);
+  });
 }
 
 int DivEngine::addSample() {
@@ -2688,8 +3122,8 @@ int DivEngine::addSample() {
     lastError="too many samples!";
     return -1;
   }
-  BUSY_BEGIN;
   saveLock.lock();
+  BUSY_BEGIN;
   DivSample* sample=new DivSample;
   int sampleCount=(int)song.sample.size();
   sample->name=fmt::sprintf("Sample %d",sampleCount);
@@ -2712,8 +3146,8 @@ int DivEngine::addSamplePtr(DivSample* which) {
     return -1;
   }
   int sampleCount=(int)song.sample.size();
-  BUSY_BEGIN;
   saveLock.lock();
+  BUSY_BEGIN;
   song.sample.push_back(which);
   song.sampleLen=sampleCount+1;
   checkAssetDir(song.sampleDir,song.sample.size());
@@ -2728,6 +3162,7 @@ void DivEngine::delSampleUnsafe(int index, bool render) {
   sPreview.pos=0;
   sPreview.dir=false;
   if (index>=0 && index<(int)song.sample.size()) {
+    truncateSeekIndex(0);
     delete song.sample[index];
     song.sample.erase(song.sample.begin()+index);
     song.sampleLen=song.sample.size();
@@ -2755,179 +3190,161 @@ void DivEngine::delSampleUnsafe(int index, bool render) {
 }
 
 void DivEngine::delSample(int index) {
-  BUSY_BEGIN;
   saveLock.lock();
+  BUSY_BEGIN;
   delSampleUnsafe(index);
-  saveLock.unlock();
   BUSY_END;
+  saveLock.unlock();
 }
 
 void DivEngine::addOrder(int pos, bool duplicate, bool where) {
   unsigned char order[DIV_MAX_CHANS];
   if (curSubSong->ordersLen>=(DIV_MAX_PATTERNS-1)) return;
   memset(order,0,DIV_MAX_CHANS);
-  BUSY_BEGIN_SOFT;
-  if (duplicate) {
-    for (int i=0; i<DIV_MAX_CHANS; i++) {
-      order[i]=curOrders->ord[i][pos];
-    }
-  } else {
-    bool used[DIV_MAX_PATTERNS];
-    for (int i=0; i<chans; i++) {
-      memset(used,0,sizeof(bool)*DIV_MAX_PATTERNS);
-      for (int j=0; j<curSubSong->ordersLen; j++) {
-        used[curOrders->ord[i][j]]=true;
+  lockEngine([&]() {
+    if (duplicate) {
+      for (int i=0; i<DIV_MAX_CHANS; i++) {
+        order[i]=curOrders->ord[i][pos];
       }
-      order[i]=(DIV_MAX_PATTERNS-1);
-      for (int j=0; j<DIV_MAX_PATTERNS; j++) {
-        if (!used[j]) {
-          order[i]=j;
-          break;
+    } else {
+      bool used[DIV_MAX_PATTERNS];
+      for (int i=0; i<chans; i++) {
+        memset(used,0,sizeof(bool)*DIV_MAX_PATTERNS);
+        for (int j=0; j<curSubSong->ordersLen; j++) {
+          used[curOrders->ord[i][j]]=true;
+        }
+        order[i]=(DIV_MAX_PATTERNS-1);
+        for (int j=0; j<DIV_MAX_PATTERNS; j++) {
+          if (!used[j]) {
+            order[i]=j;
+            break;
+          }
         }
       }
     }
-  }
-  if (where) { // at the end
-    saveLock.lock();
-    for (int i=0; i<DIV_MAX_CHANS; i++) {
-      curOrders->ord[i][curSubSong->ordersLen]=order[i];
-    }
-    curSubSong->ordersLen++;
-    saveLock.unlock();
-  } else { // after current order
-    saveLock.lock();
-    for (int i=0; i<DIV_MAX_CHANS; i++) {
-      for (int j=curSubSong->ordersLen; j>pos; j--) {
-        curOrders->ord[i][j]=curOrders->ord[i][j-1];
+    if (where) { // at the end
+      for (int i=0; i<DIV_MAX_CHANS; i++) {
+        curOrders->ord[i][curSubSong->ordersLen]=order[i];
+      }
+      curSubSong->ordersLen++;
+    } else { // after current order
+      for (int i=0; i<DIV_MAX_CHANS; i++) {
+        for (int j=curSubSong->ordersLen; j>pos; j--) {
+          curOrders->ord[i][j]=curOrders->ord[i][j-1];
+        }
+        curOrders->ord[i][pos+1]=order[i];
+      }
+      curSubSong->ordersLen++;
+      curOrder=pos+1;
+      prevOrder=curOrder;
+      if (playing && !freelance) {
+        playSub(false);
       }
-      curOrders->ord[i][pos+1]=order[i];
-    }
-    curSubSong->ordersLen++;
-    saveLock.unlock();
-    curOrder=pos+1;
-    prevOrder=curOrder;
-    if (playing && !freelance) {
-      playSub(false);
     }
-  }
-  BUSY_END;
+  });
 }
 
 void DivEngine::deepCloneOrder(int pos, bool where) {
   unsigned char order[DIV_MAX_CHANS];
   if (curSubSong->ordersLen>=(DIV_MAX_PATTERNS-1)) return;
   warnings="";
-  BUSY_BEGIN_SOFT;
-  for (int i=0; i<chans; i++) {
-    bool didNotFind=true;
-    logD("channel %d",i);
-    order[i]=curOrders->ord[i][pos];
-    // find free slot
-    for (int j=0; j<DIV_MAX_PATTERNS; j++) {
-      logD("finding free slot in %d...",j);
-      if (curPat[i].data[j]==NULL) {
-        int origOrd=order[i];
-        order[i]=j;
-        DivPattern* oldPat=curPat[i].getPattern(origOrd,false);
-        DivPattern* pat=curPat[i].getPattern(j,true);
-        memcpy(pat->data,oldPat->data,DIV_MAX_ROWS*DIV_MAX_COLS*sizeof(short));
-        logD("found at %d",j);
-        didNotFind=false;
-        break;
-      }
-    }
-    if (didNotFind) {
-      addWarning(fmt::sprintf("no free patterns in channel %d!",i));
-    }
-  }
-  if (where) { // at the end
-    saveLock.lock();
-    for (int i=0; i<chans; i++) {
-      curOrders->ord[i][curSubSong->ordersLen]=order[i];
-    }
-    curSubSong->ordersLen++;
-    saveLock.unlock();
-  } else { // after current order
-    saveLock.lock();
+  lockEngine([&]() {
     for (int i=0; i<chans; i++) {
-      for (int j=curSubSong->ordersLen; j>pos; j--) {
-        curOrders->ord[i][j]=curOrders->ord[i][j-1];
+      bool didNotFind=true;
+      logD("channel %d",i);
+      order[i]=curOrders->ord[i][pos];
+      // find free slot
+      for (int j=0; j<DIV_MAX_PATTERNS; j++) {
+        logD("finding free slot in %d...",j);
+        if (curPat[i].data[j]==NULL) {
+          int origOrd=order[i];
+          order[i]=j;
+          DivPattern* oldPat=curPat[i].getPattern(origOrd,false);
+          DivPattern* pat=curPat[i].getPattern(j,true);
+          pat->grow(oldPat->rows);
+          memcpy(pat->data,oldPat->data,oldPat->rows*DIV_MAX_COLS*sizeof(short));
+          pat->touch();
+          logD("found at %d",j);
+          didNotFind=false;
+          break;
+        }
+      }
+      if (didNotFind) {
+        addWarning(fmt::sprintf("no free patterns in channel %d!",i));
       }
-      curOrders->ord[i][pos+1]=order[i];
     }
-    curSubSong->ordersLen++;
-    saveLock.unlock();
-    if (pos<=curOrder) curOrder++;
-    if (playing && !freelance) {
-      playSub(false);
+    if (where) { // at the end
+      for (int i=0; i<chans; i++) {
+        curOrders->ord[i][curSubSong->ordersLen]=order[i];
+      }
+      curSubSong->ordersLen++;
+    } else { // after current order
+      for (int i=0; i<chans; i++) {
+        for (int j=curSubSong->ordersLen; j>pos; j--) {
+          curOrders->ord[i][j]=curOrders->ord[i][j-1];
+        }
+        curOrders->ord[i][pos+1]=order[i];
+      }
+      curSubSong->ordersLen++;
+      if (pos<=curOrder) curOrder++;
+      if (playing && !freelance) {
+        playSub(false);
+      }
     }
-  }
-  BUSY_END;
+  });
 }
 
 void DivEngine::deleteOrder(int pos) {
   if (curSubSong->ordersLen<=1) return;
-  BUSY_BEGIN_SOFT;
-  saveLock.lock();
-  for (int i=0; i<DIV_MAX_CHANS; i++) {
-    for (int j=pos; j<curSubSong->ordersLen; j++) {
-      curOrders->ord[i][j]=curOrders->ord[i][j+1];
+  lockEngine([&]() {
+    for (int i=0; i<DIV_MAX_CHANS; i++) {
+      for (int j=pos; j<curSubSong->ordersLen; j++) {
+        curOrders->ord[i][j]=curOrders->ord[i][j+1];
+      }
     }
-  }
-  curSubSong->ordersLen--;
-  saveLock.unlock();
-  if (curOrder>pos) curOrder--;
-  if (curOrder>=curSubSong->ordersLen) curOrder=curSubSong->ordersLen-1;
-  if (playing && !freelance) {
-    playSub(false);
-  }
-  BUSY_END;
+    curSubSong->ordersLen--;
+    if (curOrder>pos) curOrder--;
+    if (curOrder>=curSubSong->ordersLen) curOrder=curSubSong->ordersLen-1;
+    if (playing && !freelance) {
+      playSub(false);
+    }
+  });
 }
 
 void DivEngine::moveOrderUp(int& pos) {
-  BUSY_BEGIN_SOFT;
-  if (pos<1) {
-    BUSY_END;
-    return;
-  }
-  saveLock.lock();
-  for (int i=0; i<DIV_MAX_CHANS; i++) {
-    curOrders->ord[i][pos]^=curOrders->ord[i][pos-1];
-    curOrders->ord[i][pos-1]^=curOrders->ord[i][pos];
-    curOrders->ord[i][pos]^=curOrders->ord[i][pos-1];
-  }
-  saveLock.unlock();
-  if (curOrder==pos) {
-    curOrder--;
-  }
-  pos--;
-  if (playing && !freelance) {
-    playSub(false);
-  }
-  BUSY_END;
+  lockEngine([&]() {
+    if (pos<1) return;
+    for (int i=0; i<DIV_MAX_CHANS; i++) {
+      curOrders->ord[i][pos]^=curOrders->ord[i][pos-1];
+      curOrders->ord[i][pos-1]^=curOrders->ord[i][pos];
+      curOrders->ord[i][pos]^=curOrders->ord[i][pos-1];
+    }
+    if (curOrder==pos) {
+      curOrder--;
+    }
+    pos--;
+    if (playing && !freelance) {
+      playSub(false);
+    }
+  });
 }
 
 void DivEngine::moveOrderDown(int& pos) {
-  BUSY_BEGIN_SOFT;
-  if (pos>=curSubSong->ordersLen-1) {
-    BUSY_END;
-    return;
-  }
-  saveLock.lock();
-  for (int i=0; i<DIV_MAX_CHANS; i++) {
-    curOrders->ord[i][pos]^=curOrders->ord[i][pos+1];
-    curOrders->ord[i][pos+1]^=curOrders->ord[i][pos];
-    curOrders->ord[i][pos]^=curOrders->ord[i][pos+1];
-  }
-  saveLock.unlock();
-  if (curOrder==pos) {
-    curOrder++;
-  }
-  pos++;
-  if (playing && !freelance) {
-    playSub(false);
-  }
-  BUSY_END;
+  lockEngine([&]() {
+    if (pos>=curSubSong->ordersLen-1) return;
+    for (int i=0; i<DIV_MAX_CHANS; i++) {
+      curOrders->ord[i][pos]^=curOrders->ord[i][pos+1];
+      curOrders->ord[i][pos+1]^=curOrders->ord[i][pos];
+      curOrders->ord[i][pos]^=curOrders->ord[i][pos+1];
+    }
+    if (curOrder==pos) {
+      curOrder++;
+    }
+    pos++;
+    if (playing && !freelance) {
+      playSub(false);
+    }
+  });
 }
 
 void DivEngine::exchangeIns(int one, int two) {
@@ -2935,13 +3352,15 @@ void DivEngine::exchangeIns(int one, int two) {
     for (size_t j=0; j<song.subsong.size(); j++) {
       for (int k=0; k<DIV_MAX_PATTERNS; k++) {
         if (song.subsong[j]->pat[i].data[k]==NULL) continue;
+        DivPattern* p=song.subsong[j]->pat[i].getPattern(k,false);
         for (int l=0; l<song.subsong[j]->patLen; l++) {
-          if (song.subsong[j]->pat[i].data[k]->data[l][2]==one) {
-            song.subsong[j]->pat[i].data[k]->data[l][2]=two;
-          } else if (song.subsong[j]->pat[i].data[k]->data[l][2]==two) {
-            song.subsong[j]->pat[i].data[k]->data[l][2]=one;
+          if (p->data[l][2]==one) {
+            p->data[l][2]=two;
+          } else if (p->data[l][2]==two) {
+            p->data[l][2]=one;
           }
         }
+        p->touch();
       }
     }
   }
@@ -2970,93 +3389,85 @@ void DivEngine::exchangeSample(int one, int two) {
 
 bool DivEngine::moveInsUp(int which) {
   if (which<1 || which>=(int)song.ins.size()) return false;
-  BUSY_BEGIN;
-  DivInstrument* prev=song.ins[which];
-  saveLock.lock();
-  song.ins[which]=song.ins[which-1];
-  song.ins[which-1]=prev;
-  moveAsset(song.insDir,which,which-1);
-  exchangeIns(which,which-1);
-  saveLock.unlock();
-  BUSY_END;
+  lockEngine([&]() {
+    DivInstrument* prev=song.ins[which];
+    song.ins[which]=song.ins[which-1];
+    song.ins[which-1]=prev;
+    moveAsset(song.insDir,which,which-1);
+    exchangeIns(which,which-1);
+  });
   return true;
 }
 
 bool DivEngine::moveWaveUp(int which) {
   if (which<1 || which>=(int)song.wave.size()) return false;
-  BUSY_BEGIN;
-  DivWavetable* prev=song.wave[which];
-  saveLock.lock();
-  song.wave[which]=song.wave[which-1];
-  song.wave[which-1]=prev;
-  moveAsset(song.waveDir,which,which-1);
-  exchangeWave(which,which-1);
-  saveLock.unlock();
-  BUSY_END;
+  lockEngine([&]() {
+    DivWavetable* prev=song.wave[which];
+    song.wave[which]=song.wave[which-1];
+    song.wave[which-1]=prev;
+    moveAsset(song.waveDir,which,which-1);
+    exchangeWave(which,which-1);
+  });
   return true;
 }
 
 bool DivEngine::moveSampleUp(int which) {
   if (which<1 || which>=(int)song.sample.size()) return false;
+  saveLock.lock();
   BUSY_BEGIN;
   sPreview.sample=-1;
   sPreview.pos=0;
   sPreview.dir=false;
   DivSample* prev=song.sample[which];
-  saveLock.lock();
   song.sample[which]=song.sample[which-1];
   song.sample[which-1]=prev;
   moveAsset(song.sampleDir,which,which-1);
   exchangeSample(which,which-1);
-  saveLock.unlock();
   renderSamples();
   BUSY_END;
+  saveLock.unlock();
   return true;
 }
 
 bool DivEngine::moveInsDown(int which) {
   if (which<0 || which>=((int)song.ins.size())-1) return false;
-  BUSY_BEGIN;
-  DivInstrument* prev=song.ins[which];
-  saveLock.lock();
-  song.ins[which]=song.ins[which+1];
-  song.ins[which+1]=prev;
-  exchangeIns(which,which+1);
-  moveAsset(song.insDir,which,which+1);
-  saveLock.unlock();
-  BUSY_END;
+  lockEngine([&]() {
+    DivInstrument* prev=song.ins[which];
+    song.ins[which]=song.ins[which+1];
+    song.ins[which+1]=prev;
+    exchangeIns(which,which+1);
+    moveAsset(song.insDir,which,which+1);
+  });
   return true;
 }
 
 bool DivEngine::moveWaveDown(int which) {
   if (which<0 || which>=((int)song.wave.size())-1) return false;
-  BUSY_BEGIN;
-  DivWavetable* prev=song.wave[which];
-  saveLock.lock();
-  song.wave[which]=song.wave[which+1];
-  song.wave[which+1]=prev;
-  exchangeWave(which,which+1);
-  moveAsset(song.waveDir,which,which+1);
-  saveLock.unlock();
-  BUSY_END;
+  lockEngine([&]() {
+    DivWavetable* prev=song.wave[which];
+    song.wave[which]=song.wave[which+1];
+    song.wave[which+1]=prev;
+    exchangeWave(which,which+1);
+    moveAsset(song.waveDir,which,which+1);
+  });
   return true;
 }
 
 bool DivEngine::moveSampleDown(int which) {
   if (which<0 || which>=((int)song.sample.size())-1) return false;
+  saveLock.lock();
   BUSY_BEGIN;
   sPreview.sample=-1;
   sPreview.pos=0;
   sPreview.dir=false;
   DivSample* prev=song.sample[which];
-  saveLock.lock();
   song.sample[which]=song.sample[which+1];
   song.sample[which+1]=prev;
   exchangeSample(which,which+1);
   moveAsset(song.sampleDir,which,which+1);
-  saveLock.unlock();
   renderSamples();
   BUSY_END;
+  saveLock.unlock();
   return true;
 }
 
@@ -3094,11 +3505,9 @@ void DivEngine::autoPatchbay() {
 }
 
 void DivEngine::autoPatchbayP() {
-  BUSY_BEGIN;
-  saveLock.lock();
-  autoPatchbay();
-  saveLock.unlock();
-  BUSY_END;
+  lockEngine([&]() {
+    autoPatchbay();
+  });
 }
 
 void DivEngine::recalcPatchbay() {
@@ -3110,81 +3519,61 @@ bool DivEngine::patchConnect(unsigned int src, unsigned int dest) {
   for (unsigned int i: song.patchbay) {
     if (i==armed) return false;
   }
-  BUSY_BEGIN;
-  saveLock.lock();
-  song.patchbay.push_back(armed);
-  song.patchbayAuto=false;
-  saveLock.unlock();
-  BUSY_END;
+  lockEngine([&]() {
+    song.patchbay.push_back(armed);
+    song.patchbayAuto=false;
+  });
   return true;
 }
 
 bool DivEngine::patchDisconnect(unsigned int src, unsigned int dest) {
   unsigned int armed=(src<<16)|(dest&0xffff);
-  for (auto i=song.patchbay.begin(); i!=song.patchbay.end(); i++) {
-    if (*i==armed) {
-      BUSY_BEGIN;
-      saveLock.lock();
-      song.patchbay.erase(i);
-      song.patchbayAuto=false;
-      saveLock.unlock();
-      BUSY_END;
-      return true;
+  bool found=false;
+  lockEngine([&]() {
+    for (auto i=song.patchbay.begin(); i!=song.patchbay.end(); i++) {
+      if (*i==armed) {
+        song.patchbay.erase(i);
+        song.patchbayAuto=false;
+        found=true;
+        break;
+      }
     }
-  }
-  return false;
+  });
+  return found;
 }
 
 void DivEngine::patchDisconnectAll(unsigned int portSet) {
-  BUSY_BEGIN;
-  saveLock.lock();
-
-  if (portSet&0x1000) {
-    portSet&=0xfff;
-
-    for (size_t i=0; i<song.patchbay.size(); i++) {
-      if ((song.patchbay[i]&0xfff0)==(portSet<<4)) {
-        song.patchbay.erase(song.patchbay.begin()+i);
-        i--;
+  lockEngine([&]() {
+    if (portSet&0x1000) {
+      portSet&=0xfff;
+
+      for (size_t i=0; i<song.patchbay.size(); i++) {
+        if ((song.patchbay[i]&0xfff0)==(portSet<<4)) {
+          song.patchbay.erase(song.patchbay.begin()+i);
+          i--;
+        }
       }
-    }
-  } else {
-    portSet&=0xfff;
+    } else {
+      portSet&=0xfff;
 
-    for (size_t i=0; i<song.patchbay.size(); i++) {
-      if ((song.patchbay[i]&0xfff00000)==(portSet<<20)) {
-        song.patchbay.erase(song.patchbay.begin()+i);
-        i--;
+      for (size_t i=0; i<song.patchbay.size(); i++) {
+        if ((song.patchbay[i]&0xfff00000)==(portSet<<20)) {
+          song.patchbay.erase(song.patchbay.begin()+i);
+          i--;
+        }
       }
     }
-  }
-
-  saveLock.unlock();
-  BUSY_END;
+  });
 }
 
 void DivEngine::noteOn(int chan, int ins, int note, int vol) {
   if (chan<0 || chan>=chans) return;
-  BUSY_BEGIN;
-  pendingNotes.push_back(DivNoteEvent(chan,ins,note,vol,true));
-  if (!playing) {
-    reset();
-    freelance=true;
-    playing=true;
-  }
-  BUSY_END;
+  postMessage(DivEngineMessage(DIV_MSG_NOTE_ON,chan,ins,note,vol));
 }
 
 void DivEngine::noteOff(int chan) {
   if (chan<0 || chan>=chans) return;
-  BUSY_BEGIN;
-  pendingNotes.push_back(DivNoteEvent(chan,-1,-1,-1,false));
-  if (!playing) {
-    reset();
-    freelance=true;
-    playing=true;
-  }
-  BUSY_END;
+  postMessage(DivEngineMessage(DIV_MSG_NOTE_OFF,chan));
 }
 
 bool DivEngine::autoNoteOn(int ch, int ins, int note, int vol) {
@@ -3285,27 +3674,30 @@ void DivEngine::setAutoNotePoly(bool poly) {
 }
 
 void DivEngine::setOrder(unsigned char order) {
-  BUSY_BEGIN_SOFT;
-  curOrder=order;
-  if (order>=curSubSong->ordersLen) curOrder=0;
-  prevOrder=curOrder;
-  if (playing && !freelance) {
-    playSub(false);
-  }
-  BUSY_END;
+  synchronized([&]() {
+    curOrder=order;
+    if (order>=curSubSong->ordersLen) curOrder=0;
+    prevOrder=curOrder;
+    if (playing && !freelance) {
+      playSub(false);
+    }
+  });
 }
 
 void DivEngine::updateSysFlags(int system, bool restart, bool render) {
+  saveLock.lock();
   BUSY_BEGIN_SOFT;
+  // snapshots hold frequencies worked out from the old clock
+  truncateSeekIndex(0);
   disCont[system].dispatch->setFlags(song.systemFlags[system]);
   disCont[system].setRates(got.rate);
+  // setFlags() may have changed the sample memory layout
+  disCont[system].sampleSig=0;
   if (render) renderSamples();
 
   // patchbay
   if (song.patchbayAuto) {
-    saveLock.lock();
     autoPatchbay();
-    saveLock.unlock();
   }
 
   if (restart) {
@@ -3316,15 +3708,21 @@ void DivEngine::updateSysFlags(int system, bool restart, bool render) {
     }
   }
   BUSY_END;
+  saveLock.unlock();
 }
 
 void DivEngine::setSongRate(float hz) {
-  BUSY_BEGIN;
-  saveLock.lock();
-  curSubSong->hz=hz;
-  divider=curSubSong->hz;
-  saveLock.unlock();
-  BUSY_END;
+  lockEngine([&]() {
+    curSubSong->hz=hz;
+    divider=curSubSong->hz;
+  });
+}
+
+void DivEngine::setPatternLength(size_t subSong, int len) {
+  if (subSong>=song.subsong.size()) return;
+  lockEngine([&]() {
+    song.subsong[subSong]->setPatLen(len);
+  });
 }
 
 void DivEngine::setAudio(DivAudioEngines which) {
@@ -3413,17 +3811,74 @@ bool DivEngine::sendMidiMessage(TAMidiMessage& msg) {
     logW("MIDI output is NULL!");
     return false;
   }
-  BUSY_BEGIN;
-  logD("sending MIDI message...");
-  bool ret=(output->midiOut->send(msg));
-  BUSY_END;
+  bool ret=false;
+  synchronized([&]() {
+    logD("sending MIDI message...");
+    ret=(output->midiOut->send(msg));
+  });
   return ret;
 }
 
+bool DivEngine::isAudioRunning() {
+  long long last=lastAudioBufTime;
+  if (last==0) return false;
+  // allow a few buffers of jitter before considering the device stopped
+  long long timeout=100000000;
+  if (got.rate>0) {
+    long long period=(long long)(4000000000.0*(double)got.bufsize/(double)got.rate);
+    if (period>timeout) timeout=period;
+  }
+  long long now=std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  return (now-last)<timeout;
+}
+
+void DivEngine::runPendingEdit() {
+  const std::function<void()>* what=pendingEdit.exchange(NULL);
+  if (what==NULL) return;
+  (*what)();
+  // the waiter polls as well, so a missed wakeup only delays it
+  editDone=true;
+  editCond.notify_one();
+}
+
 void DivEngine::synchronized(const std::function<void()>& what) {
-  BUSY_BEGIN;
-  what();
-  BUSY_END;
+  // we are the audio thread (or already hold the engine)
+  if (exclusiveThread==std::this_thread::get_id()) {
+    what();
+    return;
+  }
+  if (renderInstance || !isAudioRunning()) {
+    BUSY_BEGIN;
+    applyMessages();
+    what();
+    BUSY_END;
+    return;
+  }
+
+  // hand the edit to the audio thread, which runs it before its next buffer
+  editLock.lock();
+  editDone=false;
+  pendingEdit=&what;
+  bool ran=false;
+  while (!ran) {
+    std::unique_lock<std::mutex> waitLock(editWaitLock);
+    ran=editCond.wait_for(waitLock,std::chrono::milliseconds(1),[this]() {
+      return editDone.load();
+    });
+    waitLock.unlock();
+    if (!ran && !isAudioRunning()) {
+      // the audio device went away. take the edit back if it hasn't started
+      const std::function<void()>* expected=&what;
+      if (pendingEdit.compare_exchange_strong(expected,NULL)) {
+        BUSY_BEGIN;
+        applyMessages();
+        what();
+        BUSY_END;
+        ran=true;
+      }
+    }
+  }
+  editLock.unlock();
 }
 
 void DivEngine::lockSave(const std::function<void()>& what) {
@@ -3433,11 +3888,9 @@ void DivEngine::lockSave(const std::function<void()>& what) {
 }
 
 void DivEngine::lockEngine(const std::function<void()>& what) {
-  BUSY_BEGIN;
   saveLock.lock();
-  what();
+  synchronized(what);
   saveLock.unlock();
-  BUSY_END;
 }
 
 TAAudioDesc& DivEngine::getAudioDescWant() {
@@ -3480,8 +3933,11 @@ void DivEngine::rescanMidiDevices() {
 }
 
 void DivEngine::initDispatch(bool isRender) {
+  saveLock.lock();
   BUSY_BEGIN;
   logV("initializing dispatch...");
+  // render instances never play back live
+  if (renderInstance) isRender=true;
   if (isRender) logI("render cores set");
 
   lowQuality=getConfInt("audioQuality",0);
@@ -3493,19 +3949,22 @@ void DivEngine::initDispatch(bool isRender) {
     disCont[i].setQuality(lowQuality,dcHiPass);
   }
   if (song.patchbayAuto) {
-    saveLock.lock();
     autoPatchbay();
-    saveLock.unlock();
   }
   recalcChans();
   BUSY_END;
+  saveLock.unlock();
 }
 
 void DivEngine::quitDispatch() {
   BUSY_BEGIN;
   logV("terminating dispatch...");
+  messages.clear();
+  truncateSeekIndex(0);
+  seekIndexUnsupported=false;
+  freqCache.clear();
   for (int i=0; i<song.systemLen; i++) {
-    disCont[i].quit();
+    disCont[i].quit(renderInstance);
   }
   cycles=0;
   clockDrift=0;
@@ -3550,6 +4009,7 @@ void DivEngine::quitDispatch() {
 bool DivEngine::initAudioBackend() {
   // load values
   logI("initializing audio.");
+  logV("band-limited synthesis: %s",blip_simd_name());
   if (audioEngine==DIV_AUDIO_NULL) {
     if (getConfString("audioEngine","SDL")=="JACK") {
       audioEngine=DIV_AUDIO_JACK;
@@ -3584,6 +4044,7 @@ bool DivEngine::initAudioBackend() {
   if (previewVol<0.0f) previewVol=0.0f;
   if (previewVol>1.0f) previewVol=1.0f;
   renderPoolThreads=getConfInt("renderPoolThreads",0);
+  renderPoolBatch=getConfInt("renderPoolBatch",0);
 
   if (lowLatency) logI("using low latency mode.");
 
@@ -3725,6 +4186,8 @@ bool DivEngine::deinitAudioBackend(bool dueToSwitchMaster) {
     output->quitMidi();
     delete output;
     output=NULL;
+    // no more buffers will come. edits may take the engine lock again
+    lastAudioBufTime=0;
     if (dueToSwitchMaster) {
       audioEngine=DIV_AUDIO_NULL;
     }
@@ -3866,11 +4329,62 @@ bool DivEngine::init() {
   return true;
 }
 
+DivEngine* DivEngine::createRenderInstance() {
+  SafeWriter* w=saveFur(true);
+  if (w==NULL) {
+    logE("could not create render instance! (%s)",lastError.c_str());
+    return NULL;
+  }
+  size_t len=w->size();
+  unsigned char* data=new unsigned char[len];
+  memcpy(data,w->getFinalBuf(),len);
+  w->finish();
+  delete w;
+
+  DivEngine* inst=new DivEngine;
+  inst->renderInstance=true;
+  inst->configPath=configPath;
+  inst->configFile=configFile;
+  inst->conf=conf;
+  // render at our rate and don't spawn a render pool per instance
+  inst->conf.set("audioRate",(int)got.rate);
+  inst->conf.set("renderPoolThreads",0);
+  inst->setAudio(DIV_AUDIO_DUMMY);
+  inst->setConsoleMode(true);
+  // nobody is going to look at the oscilloscopes
+  inst->oscCapture=false;
+
+  // load() takes ownership of data
+  if (!inst->load(data,len)) {
+    logE("could not create render instance! (%s)",inst->getLastError().c_str());
+    delete inst;
+    return NULL;
+  }
+  if (!inst->init()) {
+    logE("could not initialize render instance!");
+    inst->quit();
+    delete inst;
+    return NULL;
+  }
+  if (curSubSongIndex!=0) {
+    inst->changeSongP(curSubSongIndex);
+  }
+  return inst;
+}
+
 bool DivEngine::quit() {
   deinitAudioBackend();
   quitDispatch();
-  logI("saving config.");
-  saveConf();
+  if (renderInstance) {
+    // free buffers kept by quitDispatch()
+    for (int i=0; i<DIV_MAX_CHIPS; i++) {
+      disCont[i].quit();
+    }
+  }
+  if (!renderInstance) {
+    logI("saving config.");
+    saveConf();
+  }
   active=false;
   for (int i=0; i<DIV_MAX_OUTPUTS; i++) {
     if (oscBuf[i]!=NULL) delete[] oscBuf[i];
@@ -3883,6 +4397,19 @@ bool DivEngine::quit() {
   if (yrw801ROM!=NULL) delete[] yrw801ROM;
   if (tg100ROM!=NULL) delete[] tg100ROM;
   if (mu5ROM!=NULL) delete[] mu5ROM;
+  if (samp_bb!=NULL) {
+    blip_delete(samp_bb);
+    samp_bb=NULL;
+  }
+  if (samp_bbIn!=NULL) {
+    delete[] samp_bbIn;
+    samp_bbIn=NULL;
+    samp_bbInLen=0;
+  }
+  if (samp_bbOut!=NULL) {
+    delete[] samp_bbOut;
+    samp_bbOut=NULL;
+  }
   song.unload();
   return true;
 }
@@ -28,9 +28,13 @@
 #include "dataErrors.h"
 #include "safeWriter.h"
 #include "cmdStream.h"
+#include "messageQueue.h"
+#include "profiler.h"
+#include "freqCache.h"
 #include "../audio/taAudio.h"
 #include "blip_buf.h"
 #include <functional>
+#include <condition_variable>
 #include <initializer_list>
 #include <thread>
 #include "../fixedQueue.h"
@@ -44,13 +48,16 @@ class DivWorkPool;
     warnings+=(String("\n")+x); \
   }
 
-#define BUSY_BEGIN softLocked=false; isBusy.lock();
-#define BUSY_BEGIN_SOFT softLocked=true; isBusy.lock();
-#define BUSY_END isBusy.unlock(); softLocked=false;
+// the audio thread never waits for isBusy. while another thread holds it, the
+// audio thread outputs silence, so only use these for operations which replace
+// the song or its chips. edits go through synchronized()/lockEngine() instead.
+#define BUSY_BEGIN softLocked=false; isBusy.lock(); exclusiveThread=std::this_thread::get_id();
+#define BUSY_BEGIN_SOFT softLocked=true; isBusy.lock(); exclusiveThread=std::this_thread::get_id();
+#define BUSY_END exclusiveThread=std::thread::id(); isBusy.unlock(); softLocked=false;
 
-#define EXTERN_BUSY_BEGIN e->softLocked=false; e->isBusy.lock();
-#define EXTERN_BUSY_BEGIN_SOFT e->softLocked=true; e->isBusy.lock();
-#define EXTERN_BUSY_END e->isBusy.unlock(); e->softLocked=false;
+#define EXTERN_BUSY_BEGIN e->softLocked=false; e->isBusy.lock(); e->exclusiveThread=std::this_thread::get_id();
+#define EXTERN_BUSY_BEGIN_SOFT e->softLocked=true; e->isBusy.lock(); e->exclusiveThread=std::this_thread::get_id();
+#define EXTERN_BUSY_END e->exclusiveThread=std::thread::id(); e->isBusy.unlock(); e->softLocked=false;
 
 #define DIV_UNSTABLE
 
@@ -197,6 +204,25 @@ struct DivNoteEvent {
     fromMIDI(false) {}
 };
 
+// sequencer and dispatch state right after an order is reached while seeking.
+// see DivEngine::playSub().
+struct DivSeekSnapshot {
+  std::vector<DivChannelState> chan;
+  void* dispatchState[DIV_MAX_CHIPS];
+  unsigned char walked[8192];
+  DivGroovePattern speeds;
+  double divider, clockDrift, midiClockDrift, midiTimeDrift;
+  int subticks, ticks, curRow, curOrder, prevRow, prevOrder, totalLoops, lastLoopPos, nextSpeed, elapsedBars, elapsedBeats, curSpeed;
+  int cycles, midiClockCycles, midiTimeCycles, stepPlay;
+  int changeOrd, changePos, totalSeconds, totalTicks, totalTicksR, curMidiClock, curMidiTime, curMidiTimePiece, curMidiTimeCode, globalPitch;
+  short tempoAccum;
+  unsigned char extValue, arpLen, pendingMetroTick;
+  bool extValuePresent, endOfSong, shallStop, shallStopSched, firstTick;
+  DivSeekSnapshot() {
+    memset(dispatchState,0,DIV_MAX_CHIPS*sizeof(void*));
+  }
+};
+
 struct DivDispatchContainer {
   DivDispatch* dispatch;
   blip_buffer_t* bb[DIV_MAX_OUTPUTS];
@@ -212,15 +238,31 @@ struct DivDispatchContainer {
   int cycles;
   unsigned int size;
 
+  // used in batched rendering
+  bool deferred;
+  std::vector<DivDelayedWrite> deferredWrites;
+
+  // used by the profiler (time spent in acquire/fillBuf during this buffer, in nanoseconds)
+  bool profile;
+  unsigned long long profAcquire, profFill;
+
+  // signature of the samples as of the last renderSamples() call on this chip (0 if never rendered)
+  unsigned long long sampleSig;
+
+  // channel count (for publishing osc buffers)
+  int chans;
+
   void setRates(double gotRate);
   void setQuality(bool lowQual, bool dcHiPass);
   void grow(size_t size);
   void acquire(size_t offset, size_t count);
+  void acquireDeferred(size_t count);
   void flush(size_t count);
   void fillBuf(size_t runtotal, size_t offset, size_t size);
   void clear();
   void init(DivSystem sys, DivEngine* eng, int chanCount, double gotRate, const DivConfig& flags, bool isRender=false);
-  void quit();
+  // if keepBufs is true, output buffers are kept for the next init()
+  void quit(bool keepBufs=false);
   DivDispatchContainer():
     dispatch(NULL),
     bbInLen(0),
@@ -233,7 +275,13 @@ struct DivDispatchContainer {
     hiPass(true),
     rateMemory(0.0),
     cycles(0),
-    size(0) {
+    size(0),
+    deferred(false),
+    profile(false),
+    profAcquire(0),
+    profFill(0),
+    sampleSig(0),
+    chans(0) {
     memset(bb,0,DIV_MAX_OUTPUTS*sizeof(blip_buffer_t*));
     memset(temp,0,DIV_MAX_OUTPUTS*sizeof(int));
     memset(prevSample,0,DIV_MAX_OUTPUTS*sizeof(int));
@@ -406,11 +454,12 @@ class DivEngine {
   bool repeatPattern;
   bool metronome;
   bool exporting;
-  bool stopExport;
+  std::atomic<bool> stopExport;
   bool halted;
   bool forceMono;
   bool clampSamples;
   bool cmdStreamEnabled;
+  bool oscCapture;
   bool softLocked;
   bool firstTick;
   bool skipping;
@@ -419,6 +468,7 @@ class DivEngine {
   bool lowLatency;
   bool systemsRegistered;
   bool hasLoadedSomething;
+  bool renderInstance;
   bool midiOutClock;
   bool midiOutTime;
   bool midiOutProgramChange;
@@ -448,12 +498,25 @@ class DivEngine {
   DivAudioEngines audioEngine;
   DivAudioExportModes exportMode;
   double exportFadeOut;
+  int exportJobs;
   DivConfig conf;
   FixedQueue<DivNoteEvent,8192> pendingNotes;
+  // mutes, note previews and instrument/wave changes from other threads.
+  // applied at the start of nextBuf() so that they don't take the engine lock.
+  DivMessageQueue messages;
   // bitfield
   unsigned char walked[8192];
   bool isMuted[DIV_MAX_CHANS];
   std::mutex isBusy, saveLock, playPosLock;
+  // thread which may currently touch the engine state (holder of isBusy)
+  std::atomic<std::thread::id> exclusiveThread;
+  // edit handed to the audio thread by synchronized(), and whether it ran
+  std::mutex editLock, editWaitLock;
+  std::condition_variable editCond;
+  std::atomic<const std::function<void()>*> pendingEdit;
+  std::atomic<bool> editDone;
+  // time of the last buffer requested by the audio device (in nanoseconds)
+  std::atomic<long long> lastAudioBufTime;
   String configPath;
   String configFile;
   String lastError;
@@ -462,6 +525,17 @@ class DivEngine {
   std::vector<String> midiIns;
   std::vector<String> midiOuts;
   std::vector<DivCommand> cmdStream;
+  // seek index: one snapshot per order (NULL if not taken yet)
+  std::vector<DivSeekSnapshot*> seekIndex;
+  // hash of every order at the time the snapshots were taken
+  std::vector<uint64_t> seekOrderHash;
+  uint64_t seekSettingsHash;
+  bool seekIndexUnsupported;
+  // memoized pitch calculations (see calcBaseFreq()/calcFreq())
+  DivFreqCache freqCache;
+  // progress and halt flag of a background stream export (see DivStreamExport)
+  std::atomic<float> streamExportProgress;
+  std::atomic<bool> streamExportHalt;
   std::vector<DivInstrumentType> possibleInsTypes;
   std::vector<DivEffectContainer> effectInst;
   static DivSysDef* sysDefs[DIV_MAX_CHIP_DEFS];
@@ -516,6 +590,7 @@ class DivEngine {
   size_t totalProcessed;
 
   unsigned int renderPoolThreads;
+  bool renderPoolBatch;
   DivWorkPool* renderPool;
 
   // MIDI stuff
@@ -534,9 +609,24 @@ class DivEngine {
   void recalcChans();
   void reset();
   void playSub(bool preserveDrift, int goalRow=0);
+  void runPendingEdit();
+  bool isAudioRunning();
+  void postMessage(const DivEngineMessage& msg);
+  void applyMessage(const DivEngineMessage& msg);
+  void applyMessages();
+
+  // seek index
+  uint64_t hashSeekOrder(int order);
+  uint64_t hashSeekSettings();
+  void validateSeekIndex(int upTo);
+  void truncateSeekIndex(int fromOrder);
+  void saveSeekSnapshot();
+  bool loadSeekSnapshot(int goal);
   void runMidiClock(int totalCycles=1);
   void runMidiTime(int totalCycles=1);
   bool shallSwitchCores();
+  // render a single channel stem to a file. stops early if *halt becomes true.
+  bool renderChanStem(int ch, const String& fname, std::atomic<bool>* halt);
 
   void testFunction();
 
@@ -567,7 +657,10 @@ class DivEngine {
   bool initAudioBackend();
   bool deinitAudioBackend(bool dueToSwitchMaster=false);
 
+  // the system definitions are shared by every engine (including render
+  // instances). registerSystems() builds them on first use only.
   void registerSystems();
+  void registerSystemDefs();
   void initSongWithDesc(const char* description, bool inBase64=true, bool oldVol=false);
 
   void exchangeIns(int one, int two);
@@ -596,6 +689,14 @@ class DivEngine {
   // add every export method here
   friend class DivROMExport;
   friend class DivExportAmigaValidation;
+  friend class FurnaceBench;
+  friend class DivStreamExport;
+
+  // update stream export progress. returns whether the export should stop.
+  bool streamExportStep();
+
+  // split a frequency into f-num/block.
+  int convertFNumBlock(int bf, int bits, int note, double clock, double divider);
 
   public:
     DivSong song;
@@ -614,9 +715,13 @@ class DivEngine {
     int tickMult;
     int lastNBIns, lastNBOuts, lastNBSize;
     std::atomic<size_t> processTime;
+    DivProfiler profiler;
 
     void runExportThread();
-    void nextBuf(float** in, float** out, int inChans, int outChans, unsigned int size);
+    void runStemWorker(DivEngine* inst, std::vector<int>* stems, std::atomic<size_t>* nextStem);
+    // render a buffer. realTime is set when called by the audio device, in
+    // which case this never waits for the engine lock.
+    void nextBuf(float** in, float** out, int inChans, int outChans, unsigned int size, bool realTime=false);
     DivInstrument* getIns(int index, DivInstrumentType fallbackType=DIV_INS_FM);
     DivWavetable* getWave(int index);
     DivSample* getSample(int index);
@@ -635,6 +740,20 @@ class DivEngine {
     // save as .fur.
     // if notPrimary is true then the song will not be altered
     SafeWriter* saveFur(bool notPrimary=false, bool newPatternFormat=true);
+    /**
+     * create an independent copy of this engine for offline rendering.
+     * the copy has its own dispatches, uses the dummy audio backend and never saves config.
+     * call quit() on it and delete it when done.
+     * @return the new engine, or NULL on failure.
+     */
+    DivEngine* createRenderInstance();
+    /**
+     * run a VGM/ZSM/command stream export on a copy of the song in the background.
+     * playback and editing may continue meanwhile, and several exports may run at once.
+     * @param opts export options.
+     * @return the export (delete it when done), or NULL on failure (see getLastError()).
+     */
+    DivStreamExport* startStreamExport(const DivStreamExportOptions& opts);
     // build a ROM file (TODO).
     // specify system to build ROM for.
     std::vector<DivROMExportOutput> buildROM(DivROMExportOptions sys);
@@ -644,7 +763,9 @@ class DivEngine {
     // - x to add x+1 ticks of trailing
     // - -1 to auto-determine trailing
     // - -2 to add a whole loop of trailing
-    SafeWriter* saveVGM(bool* sysToExport=NULL, bool loop=true, int version=0x171, bool patternHints=false, bool directStream=false, int trailingTicks=-1);
+    // optimize removes redundant register writes (not in direct stream mode).
+    // compress produces a gzipped file (VGZ).
+    SafeWriter* saveVGM(bool* sysToExport=NULL, bool loop=true, int version=0x171, bool patternHints=false, bool directStream=false, int trailingTicks=-1, bool optimize=false, bool compress=false);
     // dump to ZSM.
     SafeWriter* saveZSM(unsigned int zsmrate=60, bool loop=true, bool optimize=true);
     // dump command stream.
@@ -652,17 +773,26 @@ class DivEngine {
     // export to text
     SafeWriter* saveText(bool separatePatterns=true);
     // export to an audio file
-    bool saveAudio(const char* path, int loops, DivAudioExportModes mode, double fadeOutTime=0.0);
+    // jobs is the number of stems to render at once in per-channel mode (0 means one per CPU core)
+    bool saveAudio(const char* path, int loops, DivAudioExportModes mode, double fadeOutTime=0.0, int jobs=1);
     // wait for audio export to finish
     void waitAudioFile();
     // stop audio file export
     bool haltAudioFile();
     // return back to playback cores if necessary
     void finishAudioFile();
+    // render the song to memory as interleaved 16-bit stereo at the current rate, in the calling thread.
+    // only use this on a render instance (or while audio is not running).
+    // returns false if halt became true.
+    bool renderToBuffer(std::vector<short>& out, int loops, double fadeOutTime=0.0, std::atomic<bool>* halt=NULL);
     // notify instrument parameter change
     void notifyInsChange(int ins);
     // notify wavetable change
     void notifyWaveChange(int wave);
+    // discard the seek index.
+    // pattern and order edits are detected automatically, so this is only
+    // needed after changes which affect playback elsewhere (e.g. instruments).
+    void invalidateSeekIndex();
 
     // dispatch a command
     int dispatchCmd(DivCommand c);
@@ -683,6 +813,12 @@ class DivEngine {
     double benchmarkPlayback();
     double benchmarkSeek();
 
+    // enable or disable the profiler (statistics are cleared when enabling)
+    void enableProfiler(bool enable);
+
+    // write profiler statistics to a file (CSV if the name ends in .csv, JSON otherwise)
+    bool saveProfile(const char* path);
+
     // returns the minimum VGM version which may carry the specified system, or 0 if none.
     int minVGMVersion(DivSystem which);
 
@@ -1023,6 +1159,9 @@ class DivEngine {
     // set Hz
     void setSongRate(float hz);
 
+    // set the pattern length of a sub-song. grows its patterns as needed.
+    void setPatternLength(size_t subSong, int len);
+
     // set remaining loops. -1 means loop forever.
     void setLoops(int loops);
 
@@ -1053,6 +1192,18 @@ class DivEngine {
     // get osc buffer
     DivDispatchOscBuffer* getOscBuffer(int chan);
 
+    // clear all osc buffers (without waiting for the audio thread)
+    void resetOscBuffers();
+
+    // get osc buffer for reading, enabling capture on it if necessary.
+    // returns NULL if the channel has no osc buffer or if capture is disabled.
+    DivDispatchOscBuffer* requestOscBuffer(int chan);
+
+    // enable or disable oscilloscope capture (disabling frees all osc buffers).
+    // chips skip oscilloscope writes on channels which haven't been requested.
+    void setOscCapture(bool enable);
+    bool getOscCapture();
+
     // enable command stream dumping
     void enableCommandStream(bool enable);
 
@@ -1119,6 +1270,9 @@ class DivEngine {
     // UNSAFE render samples - only execute when locked
     void renderSamples(int whichSample=-1);
 
+    // compute a signature of everything which affects the sample memory of a chip
+    unsigned long long getSampleSignature(int sysIndex);
+
     // public render samples
     // values for whichSample
     // -2: don't render anything - just update chip sample memory
@@ -1208,13 +1362,15 @@ class DivEngine {
     // send MIDI message
     bool sendMidiMessage(TAMidiMessage& msg);
 
-    // perform secure/sync operation
+    // perform secure/sync operation.
+    // while audio is running, what() is run by the audio thread at the start of
+    // its next buffer and this waits for it, so keep it short.
     void synchronized(const std::function<void()>& what);
 
     // perform secure/sync song operation
     void lockSave(const std::function<void()>& what);
 
-    // perform secure/sync song operation (and lock audio too)
+    // perform secure/sync song operation (and synchronize with audio too)
     void lockEngine(const std::function<void()>& what);
 
     // get audio desc want
@@ -1266,6 +1422,7 @@ class DivEngine {
       halted(false),
       forceMono(false),
       cmdStreamEnabled(false),
+      oscCapture(true),
       softLocked(false),
       firstTick(false),
       skipping(false),
@@ -1274,6 +1431,7 @@ class DivEngine {
       lowLatency(false),
       systemsRegistered(false),
       hasLoadedSomething(false),
+      renderInstance(false),
       midiOutClock(false),
       midiOutTime(false),
       midiOutProgramChange(false),
@@ -1326,6 +1484,14 @@ class DivEngine {
       audioEngine(DIV_AUDIO_NULL),
       exportMode(DIV_EXPORT_MODE_ONE),
       exportFadeOut(0.0),
+      exportJobs(1),
+      pendingEdit(NULL),
+      editDone(false),
+      lastAudioBufTime(0),
+      seekSettingsHash(0),
+      seekIndexUnsupported(false),
+      streamExportProgress(0.0f),
+      streamExportHalt(false),
       cmdStreamInt(NULL),
       midiBaseChan(0),
       midiPoly(true),
@@ -1347,6 +1513,7 @@ class DivEngine {
       previewVol(1.0f),
       totalProcessed(0),
       renderPoolThreads(0),
+      renderPoolBatch(false),
       renderPool(NULL),
       curOrders(NULL),
       curPat(NULL),
@@ -1373,15 +1540,9 @@ class DivEngine {
       memset(reversePitchTable,0,4096*sizeof(int));
       memset(pitchTable,0,4096*sizeof(int));
       memset(effectSlotMap,-1,4096*sizeof(short));
-      memset(sysDefs,0,DIV_MAX_CHIP_DEFS*sizeof(void*));
       memset(walked,0,8192);
       memset(oscBuf,0,DIV_MAX_OUTPUTS*(sizeof(float*)));
 
-      for (int i=0; i<DIV_MAX_CHIP_DEFS; i++) {
-        sysFileMapFur[i]=DIV_SYSTEM_NULL;
-        sysFileMapDMF[i]=DIV_SYSTEM_NULL;
-      }
-
       changeSong(0);
     }
 };
@@ -35,3 +35,120 @@ std::vector<DivROMExportOutput> DivEngine::buildROM(DivROMExportOptions sys) {
   delete exporter;
   return ret;
 }
+
+bool DivEngine::streamExportStep() {
+  if (curSubSong->ordersLen>0) {
+    // don't go back when looping
+    float p=(float)curOrder/(float)curSubSong->ordersLen;
+    if (p>streamExportProgress) streamExportProgress=p;
+  }
+  return streamExportHalt;
+}
+
+DivStreamExport* DivEngine::startStreamExport(const DivStreamExportOptions& opts) {
+  if (opts.subSong>=(int)song.subsong.size()) {
+    lastError="invalid sub-song";
+    return NULL;
+  }
+  DivEngine* inst=createRenderInstance();
+  if (inst==NULL) {
+    if (lastError.empty()) lastError="could not create render instance";
+    return NULL;
+  }
+  if (opts.subSong>=0) {
+    inst->changeSongP(opts.subSong);
+  }
+  DivStreamExport* ret=new DivStreamExport(inst,opts);
+  ret->start();
+  return ret;
+}
+
+void DivStreamExport::run() {
+  switch (opts.type) {
+    case DIV_STREAM_EXPORT_VGM:
+      result=inst->saveVGM(opts.vgmSystems,opts.loop,opts.vgmVersion,opts.vgmPatternHints,opts.vgmDirectStream,opts.vgmTrailingTicks,opts.vgmOptimize,opts.vgmCompress);
+      break;
+    case DIV_STREAM_EXPORT_ZSM:
+      result=inst->saveZSM(opts.zsmRate,opts.loop,opts.zsmOptimize);
+      break;
+    case DIV_STREAM_EXPORT_COMMAND:
+      result=inst->saveCommand(false);
+      break;
+    case DIV_STREAM_EXPORT_COMMAND_BINARY:
+      result=inst->saveCommand(true);
+      break;
+  }
+  if (result==NULL) error=inst->getLastError();
+  warnings=inst->getWarnings();
+  inst->streamExportProgress=1.0f;
+  running=false;
+}
+
+void DivStreamExport::start() {
+  if (thread!=NULL) return;
+  running=true;
+  thread=new std::thread([this]() {
+    run();
+  });
+}
+
+bool DivStreamExport::isRunning() {
+  return running;
+}
+
+float DivStreamExport::getProgress() {
+  if (inst==NULL) return 1.0f;
+  return inst->streamExportProgress;
+}
+
+void DivStreamExport::cancel() {
+  if (inst==NULL) return;
+  inst->streamExportHalt=true;
+}
+
+SafeWriter* DivStreamExport::finish() {
+  if (thread!=NULL) {
+    thread->join();
+    delete thread;
+    thread=NULL;
+  }
+  if (inst!=NULL) {
+    inst->quit();
+    delete inst;
+    inst=NULL;
+  }
+  SafeWriter* ret=result;
+  result=NULL;
+  return ret;
+}
+
+const String& DivStreamExport::getError() {
+  return error;
+}
+
+const String& DivStreamExport::getWarnings() {
+  return warnings;
+}
+
+const DivStreamExportOptions& DivStreamExport::getOptions() {
+  return opts;
+}
+
+DivStreamExport::DivStreamExport(DivEngine* instance, const DivStreamExportOptions& o):
+  inst(instance),
+  thread(NULL),
+  result(NULL),
+  running(false),
+  opts(o) {
+  inst->streamExportHalt=false;
+  inst->streamExportProgress=0.0f;
+}
+
+DivStreamExport::~DivStreamExport() {
+  cancel();
+  SafeWriter* w=finish();
+  if (w!=NULL) {
+    w->finish();
+    delete w;
+  }
+}
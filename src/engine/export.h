@@ -21,7 +21,10 @@
 #define _EXPORT_H
 
 #include "song.h"
+#include "safeWriter.h"
 #include <initializer_list>
+#include <atomic>
+#include <thread>
 #include "../pch.h"
 
 class DivEngine;
@@ -72,4 +75,101 @@ struct DivROMExportDef {
   }
 };
 
+enum DivStreamExportTypes {
+  DIV_STREAM_EXPORT_VGM=0,
+  DIV_STREAM_EXPORT_ZSM,
+  DIV_STREAM_EXPORT_COMMAND,
+  DIV_STREAM_EXPORT_COMMAND_BINARY
+};
+
+struct DivStreamExportOptions {
+  DivStreamExportTypes type;
+  // sub-song to export (-1 for the current one)
+  int subSong;
+  bool loop;
+  // VGM
+  bool vgmSystems[DIV_MAX_CHIPS];
+  int vgmVersion;
+  bool vgmPatternHints, vgmDirectStream, vgmOptimize, vgmCompress;
+  int vgmTrailingTicks;
+  // ZSM
+  unsigned int zsmRate;
+  bool zsmOptimize;
+
+  DivStreamExportOptions():
+    type(DIV_STREAM_EXPORT_VGM),
+    subSong(-1),
+    loop(true),
+    vgmVersion(0x171),
+    vgmPatternHints(false),
+    vgmDirectStream(false),
+    vgmOptimize(false),
+    vgmCompress(false),
+    vgmTrailingTicks(-1),
+    zsmRate(60),
+    zsmOptimize(true) {
+    for (int i=0; i<DIV_MAX_CHIPS; i++) {
+      vgmSystems[i]=true;
+    }
+  }
+};
+
+/**
+ * a VGM/ZSM/command stream export running on a private copy of the song in
+ * a background thread. create one with DivEngine::startStreamExport().
+ */
+class DivStreamExport {
+  DivEngine* inst;
+  std::thread* thread;
+  SafeWriter* result;
+  String error, warnings;
+  std::atomic<bool> running;
+  DivStreamExportOptions opts;
+
+  void run();
+
+  public:
+    /**
+     * start the export thread.
+     */
+    void start();
+
+    /**
+     * @return whether the export is still running.
+     */
+    bool isRunning();
+
+    /**
+     * @return export progress, from 0 to 1.
+     */
+    float getProgress();
+
+    /**
+     * ask the export to stop. finish() will return NULL afterwards.
+     */
+    void cancel();
+
+    /**
+     * wait for the export to end and take its output.
+     * the private engine is freed afterwards.
+     * @return the output (you have to delete it), or NULL on failure/cancellation.
+     */
+    SafeWriter* finish();
+
+    /**
+     * @return the error message if finish() returned NULL.
+     */
+    const String& getError();
+
+    /**
+     * @return warnings produced by the export.
+     */
+    const String& getWarnings();
+
+    const DivStreamExportOptions& getOptions();
+
+    DivStreamExport(DivEngine* instance, const DivStreamExportOptions& o);
+    ~DivStreamExport();
+};
+
 #endif
@@ -101,6 +101,7 @@ std::vector<DivROMExportOutput> DivExportAmigaValidation::go(DivEngine* e) {
         //writeLoop=true;
       }
     }
+    e->applyMessages();
     if (e->nextTick(false,true)) {
       done=true;
       amiga->getRegisterWrites().clear();
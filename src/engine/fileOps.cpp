@@ -24,6 +24,7 @@
 #include "song.h"
 #include <zlib.h>
 #include <fmt/printf.h>
+#include <chrono>
 
 #define DIV_READ_SIZE 131072
 #define DIV_DMF_MAGIC ".DelekDefleMask."
@@ -33,21 +34,6 @@
 #define DIV_FC14_MAGIC "FC14"
 #define DIV_S3M_MAGIC "SCRM"
 
-struct InflateBlock {
-  unsigned char* buf;
-  size_t len;
-  size_t blockSize;
-  InflateBlock(size_t s) {
-    buf=new unsigned char[s];
-    len=s;
-    blockSize=0;
-  }
-  ~InflateBlock() {
-    delete[] buf;
-    len=0;
-  }
-};
-
 struct NotZlibException {
   int what;
   NotZlibException(int w):
@@ -249,9 +235,9 @@ bool DivEngine::loadDMF(unsigned char* file, size_t len) {
       }
     }
     if (ds.version>0x17) {
-      ds.subsong[0]->patLen=reader.readI();
+      ds.subsong[0]->setPatLen(reader.readI());
     } else {
-      ds.subsong[0]->patLen=(unsigned char)reader.readC();
+      ds.subsong[0]->setPatLen((unsigned char)reader.readC());
     }
     ds.subsong[0]->ordersLen=(unsigned char)reader.readC();
 
@@ -1077,14 +1063,14 @@ bool DivEngine::loadDMF(unsigned char* file, size_t len) {
     ds.systemName=getSongSystemLegacyName(ds,!getConfInt("noMultiSystem",0));
 
     if (active) quitDispatch();
-    BUSY_BEGIN_SOFT;
     saveLock.lock();
+    BUSY_BEGIN_SOFT;
     song.unload();
     song=ds;
     changeSong(0);
     recalcChans();
-    saveLock.unlock();
     BUSY_END;
+    saveLock.unlock();
     if (active) {
       initDispatch();
       BUSY_BEGIN;
@@ -1905,7 +1891,7 @@ bool DivEngine::loadFur(unsigned char* file, size_t len) {
     subSong->arpLen=reader.readC();
     subSong->hz=reader.readF();
 
-    subSong->patLen=reader.readS();
+    subSong->setPatLen(reader.readS());
     subSong->ordersLen=reader.readS();
 
     subSong->hilightA=reader.readC();
@@ -2567,7 +2553,7 @@ bool DivEngine::loadFur(unsigned char* file, size_t len) {
         subSong->arpLen=reader.readC();
         subSong->hz=reader.readF();
 
-        subSong->patLen=reader.readS();
+        subSong->setPatLen(reader.readS());
         subSong->ordersLen=reader.readS();
 
         subSong->hilightA=reader.readC();
@@ -3068,14 +3054,14 @@ bool DivEngine::loadFur(unsigned char* file, size_t len) {
     }
 
     if (active) quitDispatch();
-    BUSY_BEGIN_SOFT;
     saveLock.lock();
+    BUSY_BEGIN_SOFT;
     song.unload();
     song=ds;
     changeSong(0);
     recalcChans();
-    saveLock.unlock();
     BUSY_END;
+    saveLock.unlock();
     if (active) {
       initDispatch();
       BUSY_BEGIN;
@@ -3246,7 +3232,7 @@ bool DivEngine::loadMod(unsigned char* file, size_t len) {
     }
 
     // patterns
-    ds.subsong[0]->patLen=64;
+    ds.subsong[0]->setPatLen(64);
     for (int ch=0; ch<chCount; ch++) {
       for (int i=0; i<5; i++) {
         fxUsage[ch][i]=false;
@@ -3493,14 +3479,14 @@ bool DivEngine::loadMod(unsigned char* file, size_t len) {
     ds.insLen=ds.ins.size();
     
     if (active) quitDispatch();
-    BUSY_BEGIN_SOFT;
     saveLock.lock();
+    BUSY_BEGIN_SOFT;
     song.unload();
     song=ds;
     changeSong(0);
     recalcChans();
-    saveLock.unlock();
     BUSY_END;
+    saveLock.unlock();
     if (active) {
       initDispatch();
       BUSY_BEGIN;
@@ -3822,14 +3808,14 @@ bool DivEngine::loadS3M(unsigned char* file, size_t len) {
     }
 
     if (active) quitDispatch();
-    BUSY_BEGIN_SOFT;
     saveLock.lock();
+    BUSY_BEGIN_SOFT;
     song.unload();
     song=ds;
     changeSong(0);
     recalcChans();
-    saveLock.unlock();
     BUSY_END;
+    saveLock.unlock();
     if (active) {
       initDispatch();
       BUSY_BEGIN;
@@ -4137,7 +4123,7 @@ bool DivEngine::loadFC(unsigned char* file, size_t len) {
 
     // convert
     ds.subsong[0]->ordersLen=seqLen;
-    ds.subsong[0]->patLen=32;
+    ds.subsong[0]->setPatLen(32);
     ds.subsong[0]->hz=50;
     ds.subsong[0]->pat[3].effectCols=3;
     ds.subsong[0]->speeds.val[0]=3;
@@ -4420,14 +4406,14 @@ bool DivEngine::loadFC(unsigned char* file, size_t len) {
     ds.subsong[0]->rearrangePatterns();
 
     if (active) quitDispatch();
-    BUSY_BEGIN_SOFT;
     saveLock.lock();
+    BUSY_BEGIN_SOFT;
     song.unload();
     song=ds;
     changeSong(0);
     recalcChans();
-    saveLock.unlock();
     BUSY_END;
+    saveLock.unlock();
     if (active) {
       initDispatch();
       BUSY_BEGIN;
@@ -4882,7 +4868,7 @@ bool DivEngine::loadFTM(unsigned char* file, size_t len) {
           }
           if (blockVersion>=2) {
             s->virtualTempoN=reader.readI();
-            s->patLen=reader.readI();
+            s->setPatLen(reader.readI());
           }
           int why=tchans;
           if (blockVersion==1) {
@@ -4906,7 +4892,7 @@ bool DivEngine::loadFTM(unsigned char* file, size_t len) {
         if (blockVersion==1) {
           int patLenOld=reader.readI();
           for (DivSubSong* i: ds.subsong) {
-            i->patLen=patLenOld;
+            i->setPatLen(patLenOld);
           }
         }
 
@@ -4926,6 +4912,11 @@ bool DivEngine::loadFTM(unsigned char* file, size_t len) {
             } else {
               row=reader.readC();
             }
+            if (row>=DIV_MAX_ROWS) {
+              logE("row %d out of range!",row);
+              throw EndOfFileException(&reader,reader.tell());
+            }
+            pat->grow(row+1);
 
             unsigned char nextNote=reader.readC();
             unsigned char nextOctave=reader.readC();
@@ -5011,14 +5002,14 @@ bool DivEngine::loadFTM(unsigned char* file, size_t len) {
     ds.version=DIV_VERSION_FTM;
 
     if (active) quitDispatch();
-    BUSY_BEGIN_SOFT;
     saveLock.lock();
+    BUSY_BEGIN_SOFT;
     song.unload();
     song=ds;
     changeSong(0);
     recalcChans();
-    saveLock.unlock();
     BUSY_END;
+    saveLock.unlock();
     if (active) {
       initDispatch();
       BUSY_BEGIN;
@@ -5048,7 +5039,10 @@ bool DivEngine::load(unsigned char* f, size_t slen) {
 
   if (!systemsRegistered) registerSystems();
 
+  std::chrono::steady_clock::time_point loadStart=std::chrono::steady_clock::now();
+
   // step 1: try loading as a zlib-compressed file
+  // this inflates into a single buffer which is grown geometrically.
   logD("trying zlib...");
   try {
     z_stream zl;
@@ -5073,11 +5067,20 @@ bool DivEngine::load(unsigned char* f, size_t slen) {
       throw NotZlibException(0);
     }
 
-    std::vector<InflateBlock*> blocks;
+    // songs usually compress to about a quarter of their size
+    size_t bufLen=MAX(DIV_READ_SIZE,slen*4);
+    size_t finalSize=0;
+    unsigned char* buf=new unsigned char[bufLen];
     while (true) {
-      InflateBlock* ib=new InflateBlock(DIV_READ_SIZE);
-      zl.next_out=ib->buf;
-      zl.avail_out=ib->len;
+      if (finalSize>=bufLen) {
+        unsigned char* newBuf=new unsigned char[bufLen*2];
+        memcpy(newBuf,buf,finalSize);
+        delete[] buf;
+        buf=newBuf;
+        bufLen*=2;
+      }
+      zl.next_out=&buf[finalSize];
+      zl.avail_out=bufLen-finalSize;
 
       nextErr=inflate(&zl,Z_SYNC_FLUSH);
       if (nextErr!=Z_OK && nextErr!=Z_STREAM_END) {
@@ -5088,14 +5091,11 @@ bool DivEngine::load(unsigned char* f, size_t slen) {
           logD("zlib inflate: %s",zl.msg);
           lastError=fmt::sprintf("decompression error: %s",zl.msg);
         }
-        for (InflateBlock* i: blocks) delete i;
-        blocks.clear();
-        delete ib;
+        delete[] buf;
         inflateEnd(&zl);
         throw NotZlibException(0);
       }
-      ib->blockSize=ib->len-zl.avail_out;
-      blocks.push_back(ib);
+      finalSize=bufLen-zl.avail_out;
       if (nextErr==Z_STREAM_END) {
         break;
       }
@@ -5109,32 +5109,20 @@ bool DivEngine::load(unsigned char* f, size_t slen) {
         logD("zlib end: %s",zl.msg);
         lastError=fmt::sprintf("decompression finish error: %s",zl.msg);
       }
-      for (InflateBlock* i: blocks) delete i;
-      blocks.clear();
+      delete[] buf;
       throw NotZlibException(0);
     }
 
-    size_t finalSize=0;
-    size_t curSeek=0;
-    for (InflateBlock* i: blocks) {
-      finalSize+=i->blockSize;
-    }
     if (finalSize<1) {
       logD("compressed too small!");
       lastError="file too small";
-      for (InflateBlock* i: blocks) delete i;
-      blocks.clear();
+      delete[] buf;
       throw NotZlibException(0);
     }
-    file=new unsigned char[finalSize];
-    for (InflateBlock* i: blocks) {
-      memcpy(&file[curSeek],i->buf,i->blockSize);
-      curSeek+=i->blockSize;
-      delete i;
-    }
-    blocks.clear();
+    file=buf;
     len=finalSize;
     delete[] f;
+    logD("decompressed %d bytes into %d in %.2fms",(int)slen,(int)len,std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-loadStart).count());
   } catch (NotZlibException& e) {
     logD("not zlib. loading as raw...");
     file=f;
@@ -5142,27 +5130,31 @@ bool DivEngine::load(unsigned char* f, size_t slen) {
   }
 
   // step 2: try loading as .fur or .dmf
+  bool ret=false;
   if (memcmp(file,DIV_DMF_MAGIC,16)==0) {
-    return loadDMF(file,len); 
+    ret=loadDMF(file,len); 
   } else if (memcmp(file,DIV_FTM_MAGIC,18)==0) {
-    return loadFTM(file,len);
+    ret=loadFTM(file,len);
   } else if (memcmp(file,DIV_FUR_MAGIC,16)==0) {
-    return loadFur(file,len);
+    ret=loadFur(file,len);
   } else if (memcmp(file,DIV_FC13_MAGIC,4)==0 || memcmp(file,DIV_FC14_MAGIC,4)==0) {
-    return loadFC(file,len);
+    ret=loadFC(file,len);
+  } else if (file==f && loadMod(f,slen)) {
+    // step 3: try loading as .mod
+    delete[] f;
+    ret=true;
+  } else {
+    // step 4: not a valid file
+    logE("not a valid module!");
+    lastError="not a compatible song";
+    delete[] file;
+    return false;
   }
 
-  // step 3: try loading as .mod
-  if (loadMod(f,slen)) {
-    delete[] f;
-    return true;
+  if (ret) {
+    logI("loaded song in %dms.",(int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()-loadStart).count());
   }
-  
-  // step 4: not a valid file
-  logE("not a valid module!");
-  lastError="not a compatible song";
-  delete[] file;
-  return false;
+  return ret;
 }
 
 struct PatToWrite {
@@ -5226,6 +5218,7 @@ DivDataErrors DivEngine::readAssetDirData(SafeReader& reader, std::vector<DivAss
 }
 
 SafeWriter* DivEngine::saveFur(bool notPrimary, bool newPatternFormat) {
+  std::chrono::steady_clock::time_point saveStart=std::chrono::steady_clock::now();
   saveLock.lock();
   std::vector<int> subSongPtr;
   std::vector<int> sysFlagsPtr;
@@ -5851,6 +5844,7 @@ SafeWriter* DivEngine::saveFur(bool notPrimary, bool newPatternFormat) {
   }
 
   saveLock.unlock();
+  logD("built song data (%d bytes) in %.2fms",(int)w->size(),std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-saveStart).count());
   return w;
 }
 
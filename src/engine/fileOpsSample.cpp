@@ -29,7 +29,6 @@ DivSample* DivEngine::sampleFromFile(const char* path) {
     lastError="too many samples!";
     return NULL;
   }
-  BUSY_BEGIN;
   warnings="";
 
   const char* pathRedux=strrchr(path,DIR_SEPARATOR);
@@ -65,7 +64,6 @@ DivSample* DivEngine::sampleFromFile(const char* path) {
 
       FILE* f=ps_fopen(path,"rb");
       if (f==NULL) {
-        BUSY_END;
         lastError=fmt::sprintf("could not open file! (%s)",strerror(errno));
         delete sample;
         return NULL;
@@ -73,7 +71,6 @@ DivSample* DivEngine::sampleFromFile(const char* path) {
 
       if (fseek(f,0,SEEK_END)<0) {
         fclose(f);
-        BUSY_END;
         lastError=fmt::sprintf("could not get file length! (%s)",strerror(errno));
         delete sample;
         return NULL;
@@ -83,7 +80,6 @@ DivSample* DivEngine::sampleFromFile(const char* path) {
 
       if (len==0) {
         fclose(f);
-        BUSY_END;
         lastError="file is empty!";
         delete sample;
         return NULL;
@@ -91,7 +87,6 @@ DivSample* DivEngine::sampleFromFile(const char* path) {
 
       if (len==(SIZE_MAX>>1)) {
         fclose(f);
-        BUSY_END;
         lastError="file is invalid!";
         delete sample;
         return NULL;
@@ -99,7 +94,6 @@ DivSample* DivEngine::sampleFromFile(const char* path) {
 
       if (fseek(f,0,SEEK_SET)<0) {
         fclose(f);
-        BUSY_END;
         lastError=fmt::sprintf("could not seek to beginning of file! (%s)",strerror(errno));
         delete sample;
         return NULL;
@@ -117,7 +111,6 @@ DivSample* DivEngine::sampleFromFile(const char* path) {
         sample->init(16*(len/9));
       } else {
         fclose(f);
-        BUSY_END;
         lastError="wait... is that right? no I don't think so...";
         delete sample;
         return NULL;
@@ -144,14 +137,12 @@ DivSample* DivEngine::sampleFromFile(const char* path) {
           len-=2;
           if (len==0) {
             fclose(f);
-            BUSY_END;
             lastError="BRR sample is empty!";
             delete sample;
             return NULL;
           }
         } else if ((len%9)!=0) {
           fclose(f);
-          BUSY_END;
           lastError="possibly corrupt BRR sample!";
           delete sample;
           return NULL;
@@ -160,12 +151,10 @@ DivSample* DivEngine::sampleFromFile(const char* path) {
 
       if (fread(dataBuf,1,len,f)==0) {
         fclose(f);
-        BUSY_END;
         lastError=fmt::sprintf("could not read file! (%s)",strerror(errno));
         delete sample;
         return NULL;
       }
-      BUSY_END;
       return sample;
     }
   }
@@ -179,7 +168,6 @@ DivSample* DivEngine::sampleFromFile(const char* path) {
   memset(&si,0,sizeof(SF_INFO));
   SNDFILE* f=sfWrap.doOpen(path,SFM_READ,&si);
   if (f==NULL) {
-    BUSY_END;
     int err=sf_error(NULL);
     if (err==SF_ERR_SYSTEM) {
       lastError=fmt::sprintf("could not open file! (%s %s)",sf_error_number(err),strerror(errno));
@@ -191,7 +179,6 @@ DivSample* DivEngine::sampleFromFile(const char* path) {
   if (si.frames>16777215) {
     lastError="this sample is too big! max sample size is 16777215.";
     sfWrap.doClose();
-    BUSY_END;
     return NULL;
   }
   void* buf=NULL;
@@ -297,7 +284,6 @@ DivSample* DivEngine::sampleFromFile(const char* path) {
   if (sample->centerRate<4000) sample->centerRate=4000;
   if (sample->centerRate>64000) sample->centerRate=64000;
   sfWrap.doClose();
-  BUSY_END;
   return sample;
 #endif
 }
@@ -315,7 +301,6 @@ DivSample* DivEngine::sampleFromFileRaw(const char* path, DivSampleDepth depth,
       channels=1;
     }
   }
-  BUSY_BEGIN;
   warnings="";
 
   const char* pathRedux=strrchr(path,DIR_SEPARATOR);
@@ -341,7 +326,6 @@ DivSample* DivEngine::sampleFromFileRaw(const char* path, DivSampleDepth depth,
 
   FILE* f=ps_fopen(path,"rb");
   if (f==NULL) {
-    BUSY_END;
     lastError=fmt::sprintf("could not open file! (%s)",strerror(errno));
     delete sample;
     return NULL;
@@ -349,7 +333,6 @@ DivSample* DivEngine::sampleFromFileRaw(const char* path, DivSampleDepth depth,
 
   if (fseek(f,0,SEEK_END)<0) {
     fclose(f);
-    BUSY_END;
     lastError=fmt::sprintf("could not get file length! (%s)",strerror(errno));
     delete sample;
     return NULL;
@@ -359,7 +342,6 @@ DivSample* DivEngine::sampleFromFileRaw(const char* path, DivSampleDepth depth,
 
   if (len==0) {
     fclose(f);
-    BUSY_END;
     lastError="file is empty!";
     delete sample;
     return NULL;
@@ -367,7 +349,6 @@ DivSample* DivEngine::sampleFromFileRaw(const char* path, DivSampleDepth depth,
 
   if (len==(SIZE_MAX>>1)) {
     fclose(f);
-    BUSY_END;
     lastError="file is invalid!";
     delete sample;
     return NULL;
@@ -375,7 +356,6 @@ DivSample* DivEngine::sampleFromFileRaw(const char* path, DivSampleDepth depth,
 
   if (fseek(f,0,SEEK_SET)<0) {
     fclose(f);
-    BUSY_END;
     lastError=fmt::sprintf("could not seek to beginning of file! (%s)",strerror(errno));
     delete sample;
     return NULL;
@@ -414,7 +394,6 @@ DivSample* DivEngine::sampleFromFileRaw(const char* path, DivSampleDepth depth,
 
   if (samples>16777215) {
     fclose(f);
-    BUSY_END;
     lastError="this sample is too big! max sample size is 16777215.";
     delete sample;
     return NULL;
@@ -428,7 +407,6 @@ DivSample* DivEngine::sampleFromFileRaw(const char* path, DivSampleDepth depth,
   unsigned char* buf=new unsigned char[len];
   if (fread(buf,1,len,f)==0) {
     fclose(f);
-    BUSY_END;
     lastError=fmt::sprintf("could not read file! (%s)",strerror(errno));
     delete[] buf;
     delete sample;
@@ -519,6 +497,5 @@ DivSample* DivEngine::sampleFromFileRaw(const char* path, DivSampleDepth depth,
     }
   }
 
-  BUSY_END;
   return sample;
 }
@@ -19,113 +19,211 @@
 
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <mutex>
 #include "filter.h"
 #include "../ta-log.h"
 
-float* DivFilterTables::cubicTable=NULL;
-float* DivFilterTables::sincTable=NULL;
-float* DivFilterTables::sincTable8=NULL;
-float* DivFilterTables::sincIntegralTable=NULL;
-float* DivFilterTables::sincIntegralSmallTable=NULL;
+std::atomic<float*> DivFilterTables::cubicTable(NULL);
+std::atomic<float*> DivFilterTables::sincTable(NULL);
+std::atomic<float*> DivFilterTables::sincTable8(NULL);
+std::atomic<float*> DivFilterTables::sincIntegralTable(NULL);
+std::atomic<float*> DivFilterTables::sincIntegralSmallTable(NULL);
+std::atomic<float*> DivFilterTables::sincPolyphaseTable(NULL);
+std::atomic<float*> DivFilterTables::sincIntegralPolyphaseTable(NULL);
+
+// tables may be requested by several engines at once (e.g. when rendering stems)
+static std::mutex tableLock;
 
 // portions from Schism Tracker (scripts/lutgen.c)
 // licensed under same license as this program.
 float* DivFilterTables::getCubicTable() {
-  if (cubicTable==NULL) {
-    logD("initializing cubic spline table.");
-    cubicTable=new float[4096];
-
-    for (int i=0; i<1024; i++) {
-      float x=(float)i/1024.0;
-      cubicTable[(i<<2)]=-0.5*pow(x,3)+1.0*pow(x,2)-0.5*x;
-      cubicTable[1+(i<<2)]=1.5*pow(x,3)-2.5*pow(x,2)+1.0;
-      cubicTable[2+(i<<2)]=-1.5*pow(x,3)+2.0*pow(x,2)+0.5*x;
-      cubicTable[3+(i<<2)]=0.5*pow(x,3)-0.5*pow(x,2);
+  float* ret=cubicTable.load(std::memory_order_acquire);
+  if (ret==NULL) {
+    tableLock.lock();
+    ret=cubicTable.load(std::memory_order_relaxed);
+    if (ret==NULL) {
+      logD("initializing cubic spline table.");
+      float* table=new float[4096];
+
+      for (int i=0; i<1024; i++) {
+        float x=(float)i/1024.0;
+        table[(i<<2)]=-0.5*pow(x,3)+1.0*pow(x,2)-0.5*x;
+        table[1+(i<<2)]=1.5*pow(x,3)-2.5*pow(x,2)+1.0;
+        table[2+(i<<2)]=-1.5*pow(x,3)+2.0*pow(x,2)+0.5*x;
+        table[3+(i<<2)]=0.5*pow(x,3)-0.5*pow(x,2);
+      }
+      cubicTable.store(table,std::memory_order_release);
+      ret=table;
     }
+    tableLock.unlock();
   }
-  return cubicTable;
+  return ret;
 }
 
 float* DivFilterTables::getSincTable() {
-  if (sincTable==NULL) {
-    logD("initializing sinc table.");
-    sincTable=new float[65536];
-
-    sincTable[0]=1.0f;
-    for (int i=1; i<65536; i++) {
-      int mapped=((i&8191)<<3)|(i>>13);
-      double x=(double)i*M_PI/8192.0;
-      sincTable[mapped]=sin(x)/x;
-    }
-
-    for (int i=0; i<65536; i++) {
-      int mapped=((i&8191)<<3)|(i>>13);
-      sincTable[mapped]*=pow(cos(M_PI*(double)i/131072.0),2.0);
+  float* ret=sincTable.load(std::memory_order_acquire);
+  if (ret==NULL) {
+    tableLock.lock();
+    ret=sincTable.load(std::memory_order_relaxed);
+    if (ret==NULL) {
+      logD("initializing sinc table.");
+      float* table=new float[65536];
+
+      table[0]=1.0f;
+      for (int i=1; i<65536; i++) {
+        int mapped=((i&8191)<<3)|(i>>13);
+        double x=(double)i*M_PI/8192.0;
+        table[mapped]=sin(x)/x;
+      }
+
+      for (int i=0; i<65536; i++) {
+        int mapped=((i&8191)<<3)|(i>>13);
+        table[mapped]*=pow(cos(M_PI*(double)i/131072.0),2.0);
+      }
+      sincTable.store(table,std::memory_order_release);
+      ret=table;
     }
+    tableLock.unlock();
   }
-  return sincTable;
+  return ret;
 }
 
 float* DivFilterTables::getSincTable8() {
-  if (sincTable8==NULL) {
-    logD("initializing sinc table (8).");
-    sincTable8=new float[32768];
-
-    sincTable8[0]=1.0f;
-    for (int i=1; i<32768; i++) {
-      int mapped=((i&8191)<<2)|(i>>13);
-      double x=(double)i*M_PI/8192.0;
-      sincTable8[mapped]=sin(x)/x;
-    }
-
-    for (int i=0; i<32768; i++) {
-      int mapped=((i&8191)<<2)|(i>>13);
-      sincTable8[mapped]*=pow(cos(M_PI*(double)i/65536.0),2.0);
+  float* ret=sincTable8.load(std::memory_order_acquire);
+  if (ret==NULL) {
+    tableLock.lock();
+    ret=sincTable8.load(std::memory_order_relaxed);
+    if (ret==NULL) {
+      logD("initializing sinc table (8).");
+      float* table=new float[32768];
+
+      table[0]=1.0f;
+      for (int i=1; i<32768; i++) {
+        int mapped=((i&8191)<<2)|(i>>13);
+        double x=(double)i*M_PI/8192.0;
+        table[mapped]=sin(x)/x;
+      }
+
+      for (int i=0; i<32768; i++) {
+        int mapped=((i&8191)<<2)|(i>>13);
+        table[mapped]*=pow(cos(M_PI*(double)i/65536.0),2.0);
+      }
+      sincTable8.store(table,std::memory_order_release);
+      ret=table;
     }
+    tableLock.unlock();
   }
-  return sincTable8;
+  return ret;
 }
 
 float* DivFilterTables::getSincIntegralTable() {
-  if (sincIntegralTable==NULL) {
-    logD("initializing sinc integral table.");
-    sincIntegralTable=new float[65536];
-
-    sincIntegralTable[0]=-0.5f;
-    for (int i=1; i<65536; i++) {
-      int mapped=((i&8191)<<3)|(i>>13);
-      int mappedPrev=(((i-1)&8191)<<3)|((i-1)>>13);
-      double x=(double)i*M_PI/8192.0;
-      double sinc=sin(x)/x;
-      sincIntegralTable[mapped]=sincIntegralTable[mappedPrev]+(sinc/8192.0);
+  float* ret=sincIntegralTable.load(std::memory_order_acquire);
+  if (ret==NULL) {
+    tableLock.lock();
+    ret=sincIntegralTable.load(std::memory_order_relaxed);
+    if (ret==NULL) {
+      logD("initializing sinc integral table.");
+      float* table=new float[65536];
+
+      table[0]=-0.5f;
+      for (int i=1; i<65536; i++) {
+        int mapped=((i&8191)<<3)|(i>>13);
+        int mappedPrev=(((i-1)&8191)<<3)|((i-1)>>13);
+        double x=(double)i*M_PI/8192.0;
+        double sinc=sin(x)/x;
+        table[mapped]=table[mappedPrev]+(sinc/8192.0);
+      }
+
+      for (int i=0; i<65536; i++) {
+        int mapped=((i&8191)<<3)|(i>>13);
+        table[mapped]*=pow(cos(M_PI*(double)i/131072.0),2.0);
+      }
+      sincIntegralTable.store(table,std::memory_order_release);
+      ret=table;
     }
+    tableLock.unlock();
+  }
+  return ret;
+}
 
-    for (int i=0; i<65536; i++) {
-      int mapped=((i&8191)<<3)|(i>>13);
-      sincIntegralTable[mapped]*=pow(cos(M_PI*(double)i/131072.0),2.0);
+float* DivFilterTables::getSincIntegralSmallTable() {
+  float* ret=sincIntegralSmallTable.load(std::memory_order_acquire);
+  if (ret==NULL) {
+    tableLock.lock();
+    ret=sincIntegralSmallTable.load(std::memory_order_relaxed);
+    if (ret==NULL) {
+      logD("initializing small sinc integral table.");
+      float* table=new float[512];
+
+      table[0]=-0.5f;
+      for (int i=1; i<512; i++) {
+        int mapped=((i&63)<<3)|(i>>6);
+        int mappedPrev=(((i-1)&63)<<3)|((i-1)>>6);
+        double x=(double)i*M_PI/64.0;
+        double sinc=sin(x)/x;
+        table[mapped]=table[mappedPrev]+(sinc/64.0);
+      }
+
+      for (int i=0; i<512; i++) {
+        int mapped=((i&63)<<3)|(i>>6);
+        table[mapped]*=pow(cos(M_PI*(double)i/1024.0),2.0);
+      }
+      sincIntegralSmallTable.store(table,std::memory_order_release);
+      ret=table;
     }
+    tableLock.unlock();
   }
-  return sincIntegralTable;
+  return ret;
 }
 
-float* DivFilterTables::getSincIntegralSmallTable() {
-  if (sincIntegralSmallTable==NULL) {
-    logD("initializing small sinc integral table.");
-    sincIntegralSmallTable=new float[512];
-
-    sincIntegralSmallTable[0]=-0.5f;
-    for (int i=1; i<512; i++) {
-      int mapped=((i&63)<<3)|(i>>6);
-      int mappedPrev=(((i-1)&63)<<3)|((i-1)>>6);
-      double x=(double)i*M_PI/64.0;
-      double sinc=sin(x)/x;
-      sincIntegralSmallTable[mapped]=sincIntegralSmallTable[mappedPrev]+(sinc/64.0);
+float* DivFilterTables::getSincPolyphaseTable() {
+  float* ret=sincPolyphaseTable.load(std::memory_order_acquire);
+  if (ret==NULL) {
+    float* sinc=getSincTable();
+    tableLock.lock();
+    ret=sincPolyphaseTable.load(std::memory_order_relaxed);
+    if (ret==NULL) {
+      logD("initializing polyphase sinc table.");
+      float* table=new float[131072];
+
+      for (int i=0; i<8192; i++) {
+        float* t1=&sinc[(8191-i)<<3];
+        float* t2=&sinc[i<<3];
+        for (int j=0; j<8; j++) {
+          table[(i<<4)+j]=t2[7-j];
+          table[(i<<4)+8+j]=t1[j];
+        }
+      }
+      sincPolyphaseTable.store(table,std::memory_order_release);
+      ret=table;
     }
+    tableLock.unlock();
+  }
+  return ret;
+}
 
-    for (int i=0; i<512; i++) {
-      int mapped=((i&63)<<3)|(i>>6);
-      sincIntegralSmallTable[mapped]*=pow(cos(M_PI*(double)i/1024.0),2.0);
+float* DivFilterTables::getSincIntegralPolyphaseTable() {
+  float* ret=sincIntegralPolyphaseTable.load(std::memory_order_acquire);
+  if (ret==NULL) {
+    float* sincI=getSincIntegralTable();
+    tableLock.lock();
+    ret=sincIntegralPolyphaseTable.load(std::memory_order_relaxed);
+    if (ret==NULL) {
+      logD("initializing polyphase sinc integral table.");
+      float* table=new float[131072];
+
+      for (int i=0; i<8192; i++) {
+        float* t1=&sincI[(8191-i)<<3];
+        float* t2=&sincI[i<<3];
+        for (int j=0; j<8; j++) {
+          table[(i<<4)+7-j]=-t1[j];
+          table[(i<<4)+8+j]=t2[j];
+        }
+      }
+      sincIntegralPolyphaseTable.store(table,std::memory_order_release);
+      ret=table;
     }
+    tableLock.unlock();
   }
-  return sincIntegralSmallTable;
-}
\ No newline at end of file
+  return ret;
+}
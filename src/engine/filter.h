@@ -17,13 +17,19 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <atomic>
+
 class DivFilterTables {
   public:
-    static float* cubicTable;
-    static float* sincTable;
-    static float* sincTable8;
-    static float* sincIntegralTable;
-    static float* sincIntegralSmallTable;
+    // published with release ordering once filled, so that readers which
+    // load them with acquire ordering see the contents.
+    static std::atomic<float*> cubicTable;
+    static std::atomic<float*> sincTable;
+    static std::atomic<float*> sincTable8;
+    static std::atomic<float*> sincIntegralTable;
+    static std::atomic<float*> sincIntegralSmallTable;
+    static std::atomic<float*> sincPolyphaseTable;
+    static std::atomic<float*> sincIntegralPolyphaseTable;
 
     /**
      * get a 1024x4 cubic spline table.
@@ -54,4 +60,18 @@ class DivFilterTables {
      * @return the table.
      */
     static float* getSincIntegralSmallTable();
+
+    /**
+     * get a 8192x16 two-side sinc table, built from the one-side sinc table.
+     * each phase has its 16 taps in order, so that it can be applied to 16 consecutive samples.
+     * @return the table.
+     */
+    static float* getSincPolyphaseTable();
+
+    /**
+     * get a 8192x16 two-side sinc integral table, built from the one-side sinc integral table.
+     * each phase has its 16 taps in order (the left side is negated).
+     * @return the table.
+     */
+    static float* getSincIntegralPolyphaseTable();
 };
\ No newline at end of file
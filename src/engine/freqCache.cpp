@@ -0,0 +1,86 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2023 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "freqCache.h"
+#include "../ta-log.h"
+#include <string.h>
+
+DivFreqTablePage::DivFreqTablePage() {
+  memset(filled,0,DIV_FREQ_PAGE_SIZE*sizeof(bool));
+}
+
+void DivFreqTable::put(int index, double value) {
+  if (index<=-DIV_FREQ_MAX_INDEX || index>=DIV_FREQ_MAX_INDEX) return;
+  int page=index>>DIV_FREQ_PAGE_BITS;
+  if (pages.empty()) {
+    firstPage=page;
+    pages.push_back(NULL);
+  } else if (page<firstPage) {
+    pages.insert(pages.begin(),firstPage-page,NULL);
+    firstPage=page;
+  } else if (page-firstPage>=(int)pages.size()) {
+    pages.resize(page-firstPage+1,NULL);
+  }
+  DivFreqTablePage*& p=pages[page-firstPage];
+  if (p==NULL) p=new DivFreqTablePage;
+  int pos=index&(DIV_FREQ_PAGE_SIZE-1);
+  p->val[pos]=value;
+  p->filled[pos]=true;
+}
+
+DivFreqTable::~DivFreqTable() {
+  for (DivFreqTablePage* i: pages) {
+    delete i;
+  }
+  pages.clear();
+}
+
+DivFreqTable* DivFreqCache::findTable(DivFreqTableKinds kind, double clock, double divider, double tuning, bool period, int bits) {
+  for (size_t i=0; i<tables.size(); i++) {
+    DivFreqTable* t=tables[i];
+    if (t->kind==kind && t->clock==clock && t->divider==divider && t->tuning==tuning && t->period==period && t->bits==bits) {
+      lastTable=i;
+      return t;
+    }
+  }
+  DivFreqTable* t=new DivFreqTable(kind,clock,divider,tuning,period,bits);
+  lastTable=tables.size();
+  tables.push_back(t);
+  return t;
+}
+
+void DivFreqCache::trim() {
+  // stale tables (old clocks/tuning) pile up here
+  if (tables.size()>=DIV_FREQ_MAX_TABLES) {
+    logD("flushing frequency cache");
+    clear();
+  }
+}
+
+void DivFreqCache::clear() {
+  for (DivFreqTable* i: tables) {
+    delete i;
+  }
+  tables.clear();
+  lastTable=0;
+}
+
+DivFreqCache::~DivFreqCache() {
+  clear();
+}
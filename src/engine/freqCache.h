@@ -0,0 +1,129 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2023 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _FREQCACHE_H
+#define _FREQCACHE_H
+
+#include <stddef.h>
+#include <vector>
+
+// must be a power of 2
+#define DIV_FREQ_PAGE_BITS 10
+#define DIV_FREQ_PAGE_SIZE (1<<DIV_FREQ_PAGE_BITS)
+// indexes beyond this are not cached
+#define DIV_FREQ_MAX_INDEX (1<<22)
+// the cache is flushed by trim() when it gets this many tables
+#define DIV_FREQ_MAX_TABLES 64
+
+enum DivFreqTableKinds {
+  DIV_FREQ_BASE=0, // calcBaseFreq(), indexed by note
+  DIV_FREQ_FNUM_BLOCK, // calcBaseFreqFNumBlock(), indexed by note
+  DIV_FREQ_LINEAR // calcFreq() in full linear pitch mode, indexed by pitch (1/128 semitone)
+};
+
+struct DivFreqTablePage {
+  double val[DIV_FREQ_PAGE_SIZE];
+  bool filled[DIV_FREQ_PAGE_SIZE];
+  DivFreqTablePage();
+};
+
+/**
+ * results of a frequency calculation for one set of parameters.
+ * entries are filled in on first use, so they are exactly what the calculation returns.
+ */
+struct DivFreqTable {
+  DivFreqTableKinds kind;
+  double clock, divider, tuning;
+  bool period;
+  int bits;
+  int firstPage;
+  std::vector<DivFreqTablePage*> pages;
+
+  /**
+   * look up a result.
+   * @return whether it was there.
+   */
+  inline bool get(int index, double& value) {
+    int page=(index>>DIV_FREQ_PAGE_BITS)-firstPage;
+    if (page<0 || page>=(int)pages.size()) return false;
+    DivFreqTablePage* p=pages[page];
+    if (p==NULL) return false;
+    int pos=index&(DIV_FREQ_PAGE_SIZE-1);
+    if (!p->filled[pos]) return false;
+    value=p->val[pos];
+    return true;
+  }
+
+  /**
+   * store a result.
+   */
+  void put(int index, double value);
+
+  DivFreqTable(DivFreqTableKinds k, double c, double d, double t, bool p, int b):
+    kind(k),
+    clock(c),
+    divider(d),
+    tuning(t),
+    period(p),
+    bits(b),
+    firstPage(0) {}
+  ~DivFreqTable();
+};
+
+/**
+ * frequency tables for every combination of chip clock, divider, tuning and
+ * mode in use. this takes pow() out of the per-tick pitch path.
+ * not thread-safe (only the engine thread uses it).
+ */
+class DivFreqCache {
+  std::vector<DivFreqTable*> tables;
+  size_t lastTable;
+
+  public:
+    /**
+     * get (or create) the table for a set of parameters.
+     */
+    inline DivFreqTable* getTable(DivFreqTableKinds kind, double clock, double divider, double tuning, bool period, int bits) {
+      // dispatches usually ask for the same table several times in a row
+      if (lastTable<tables.size()) {
+        DivFreqTable* t=tables[lastTable];
+        if (t->kind==kind && t->clock==clock && t->divider==divider && t->tuning==tuning && t->period==period && t->bits==bits) return t;
+      }
+      return findTable(kind,clock,divider,tuning,period,bits);
+    }
+
+    DivFreqTable* findTable(DivFreqTableKinds kind, double clock, double divider, double tuning, bool period, int bits);
+
+    /**
+     * free all tables if there are too many.
+     * invalidates every table pointer, so don't call it during a lookup.
+     */
+    void trim();
+
+    /**
+     * free all tables.
+     */
+    void clear();
+
+    DivFreqCache():
+      lastTable(0) {}
+    ~DivFreqCache();
+};
+
+#endif
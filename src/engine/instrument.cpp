@@ -293,6 +293,86 @@ void DivInstrument::writeFeatureFM(SafeWriter* w, bool fui) {
   FEATURE_END;
 }
 
+// the first value is the capacity
+static const int emptyMacroData[257]={256};
+
+int* DivMacroData::reserve(int count) {
+  int* cur=data.load(std::memory_order_relaxed);
+  if (cur!=NULL && cur[-1]>=count) return cur;
+
+  int cap=16;
+  while (cap<count) cap<<=2;
+  if (cap>256) cap=256;
+
+  int* newData=new int[cap+1];
+  newData[0]=cap;
+  memset(&newData[1],0,cap*sizeof(int));
+  if (cur!=NULL) {
+    memcpy(&newData[1],cur,cur[-1]*sizeof(int));
+    // the audio thread may still be reading the old block
+    if (retired[0]==NULL) {
+      retired[0]=cur-1;
+    } else {
+      retired[1]=cur-1;
+    }
+  }
+  data.store(&newData[1],std::memory_order_release);
+  return &newData[1];
+}
+
+const int* DivMacroData::get(int& len) const {
+  int* d=data.load(std::memory_order_acquire);
+  if (d==NULL) {
+    len=256;
+    return &emptyMacroData[1];
+  }
+  len=d[-1];
+  return d;
+}
+
+const int* DivMacroData::get() const {
+  // storage always holds at least 16 values
+  int* d=data.load(std::memory_order_acquire);
+  return (d==NULL)?&emptyMacroData[1]:d;
+}
+
+void DivMacroData::copyTo(int* dest) const {
+  int len;
+  const int* d=get(len);
+  memcpy(dest,d,len*sizeof(int));
+  if (len<256) memset(&dest[len],0,(256-len)*sizeof(int));
+}
+
+DivMacroData::DivMacroData(const DivMacroData& other):
+  data(NULL) {
+  retired[0]=NULL;
+  retired[1]=NULL;
+  *this=other;
+}
+
+DivMacroData& DivMacroData::operator=(const DivMacroData& other) {
+  if (this==&other) return *this;
+  int otherLen;
+  const int* otherData=other.get(otherLen);
+  int* d=data.load(std::memory_order_relaxed);
+  if (!other.isAllocated()) {
+    // keep our storage (if any), as a pointer to it may be held elsewhere
+    if (d!=NULL) memset(d,0,d[-1]*sizeof(int));
+    return *this;
+  }
+  d=reserve(otherLen);
+  memcpy(d,otherData,otherLen*sizeof(int));
+  if (d[-1]>otherLen) memset(&d[otherLen],0,(d[-1]-otherLen)*sizeof(int));
+  return *this;
+}
+
+DivMacroData::~DivMacroData() {
+  int* d=data.load(std::memory_order_relaxed);
+  if (d!=NULL) delete[] (d-1);
+  delete[] retired[0];
+  delete[] retired[1];
+}
+
 void DivInstrument::writeMacro(SafeWriter* w, const DivInstrumentMacro& m) {
   if (!m.len) return;
 
@@ -2680,7 +2760,7 @@ DivDataErrors DivInstrument::readInsDataNew(SafeReader& reader, short version, b
 
   // <187 C64 cutoff macro compatibility
   if (type==DIV_INS_C64 && volIsCutoff && version<187) {
-    memcpy(&std.algMacro,&std.volMacro,sizeof(DivInstrumentMacro));
+    std.algMacro=std.volMacro;
     std.algMacro.macroType=DIV_MACRO_ALG;
     std.volMacro=DivInstrumentMacro(DIV_MACRO_VOL,true);
 
@@ -3432,7 +3512,7 @@ DivDataErrors DivInstrument::readInsDataOld(SafeReader &reader, short version) {
 
   // <187 C64 cutoff macro compatibility
   if (type==DIV_INS_C64 && volIsCutoff && version<187) {
-    memcpy(&std.algMacro,&std.volMacro,sizeof(DivInstrumentMacro));
+    std.algMacro=std.volMacro;
     std.algMacro.macroType=DIV_MACRO_ALG;
     std.volMacro=DivInstrumentMacro(DIV_MACRO_VOL,true);
 
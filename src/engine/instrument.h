@@ -19,6 +19,7 @@
 
 #ifndef _INSTRUMENT_H
 #define _INSTRUMENT_H
+#include <atomic>
 #include "safeWriter.h"
 #include "dataErrors.h"
 #include "../ta-utils.h"
@@ -243,8 +244,122 @@ struct DivInstrumentFM {
 };
 
 // this is getting out of hand
+// macro values.
+// storage is allocated on first write access and grows in steps (16, 64 and
+// 256 values) as higher positions are written to. taking a writable pointer
+// always gets the full 256 values, which never move afterwards.
+// the storage is published atomically, and replaced blocks are kept until
+// destruction, as the audio thread may still be reading them.
+// get() and const access never allocate, reading zeros past the end.
+class DivMacroData {
+  // the value before the first one holds the capacity
+  std::atomic<int*> data;
+  int* retired[2];
+  int* reserve(int count);
+  public:
+    int& operator[](int i) {
+      int* d=data.load(std::memory_order_relaxed);
+      if (d==NULL || i>=d[-1]) d=reserve(i+1);
+      return d[i];
+    }
+    int operator[](int i) const {
+      int len;
+      const int* d=get(len);
+      return (i<len)?d[i]:0;
+    }
+    operator int*() {
+      return reserve(256);
+    }
+
+    /**
+     * get the values for reading.
+     * @param len set to the number of values which may be read.
+     * @return the values, or a zero-filled array if not allocated.
+     */
+    const int* get(int& len) const;
+
+    /**
+     * get the first 16 values (the ones used by ADSR and LFO modes) for reading.
+     * @return the values, or a zero-filled array if not allocated.
+     */
+    const int* get() const;
+
+    /**
+     * copy all 256 values (with zeros past the end of storage).
+     */
+    void copyTo(int* dest) const;
+
+    /**
+     * whether storage has been allocated.
+     */
+    bool isAllocated() const {
+      return data.load(std::memory_order_relaxed)!=NULL;
+    }
+
+    DivMacroData():
+      data(NULL) {
+      retired[0]=NULL;
+      retired[1]=NULL;
+    }
+    DivMacroData(const DivMacroData& other);
+    DivMacroData& operator=(const DivMacroData& other);
+    ~DivMacroData();
+};
+
+// macro editor state. not saved in the file.
+struct DivMacroEditState {
+  int vScroll, vZoom;
+  int typeMemory[16];
+  unsigned char lenMemory;
+
+  DivMacroEditState():
+    vScroll(0),
+    vZoom(-1),
+    lenMemory(0) {
+    memset(typeMemory,0,16*sizeof(int));
+  }
+};
+
+// holds a DivMacroEditState, which is only allocated once the macro is
+// accessed by the editor.
+class DivMacroEdit {
+  DivMacroEditState* state;
+  public:
+    DivMacroEditState* operator->() {
+      if (state==NULL) state=new DivMacroEditState;
+      return state;
+    }
+
+    /**
+     * make the editor work out the zoom again, without allocating.
+     */
+    void resetZoom() {
+      if (state!=NULL) state->vZoom=-1;
+    }
+
+    DivMacroEdit():
+      state(NULL) {}
+    DivMacroEdit(const DivMacroEdit& other):
+      state((other.state==NULL)?NULL:new DivMacroEditState(*other.state)) {}
+    DivMacroEdit& operator=(const DivMacroEdit& other) {
+      if (this==&other) return *this;
+      if (other.state==NULL) {
+        delete state;
+        state=NULL;
+      } else if (state==NULL) {
+        state=new DivMacroEditState(*other.state);
+      } else {
+        *state=*other.state;
+      }
+      return *this;
+    }
+    ~DivMacroEdit() {
+      delete state;
+    }
+};
+
 struct DivInstrumentMacro {
-  int val[256];
+  DivMacroData val;
   unsigned int mode;
   unsigned char open;
   unsigned char len, delay, speed, loop, rel;
@@ -252,10 +367,8 @@ struct DivInstrumentMacro {
   // 32+: operator (top 3 bits select operator, starting from 1)
   unsigned char macroType;
   
-  // the following variables are used by the GUI and not saved in the file
-  int vScroll, vZoom;
-  int typeMemory[16];
-  unsigned char lenMemory;
+  // used by the GUI
+  DivMacroEdit edit;
 
   explicit DivInstrumentMacro(unsigned char initType, bool initOpen=false):
     mode(0),
@@ -265,13 +378,7 @@ struct DivInstrumentMacro {
     speed(1),
     loop(255),
     rel(255),
-    macroType(initType),
-    vScroll(0),
-    vZoom(-1),
-    lenMemory(0) {
-    memset(val,0,256*sizeof(int));
-    memset(typeMemory,0,16*sizeof(int));
-  }
+    macroType(initType) {}
 };
 
 struct DivInstrumentSTD {
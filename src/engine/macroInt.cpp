@@ -22,23 +22,24 @@
 #include "engine.h"
 #include "../ta-log.h"
 
-#define ADSR_LOW source.val[0]
-#define ADSR_HIGH source.val[1]
-#define ADSR_AR source.val[2]
-#define ADSR_HT source.val[3]
-#define ADSR_DR source.val[4]
-#define ADSR_SL source.val[5]
-#define ADSR_ST source.val[6]
-#define ADSR_SR source.val[7]
-#define ADSR_RR source.val[8]
+#define ADSR_LOW sourceVal[0]
+#define ADSR_HIGH sourceVal[1]
+#define ADSR_AR sourceVal[2]
+#define ADSR_HT sourceVal[3]
+#define ADSR_DR sourceVal[4]
+#define ADSR_SL sourceVal[5]
+#define ADSR_ST sourceVal[6]
+#define ADSR_SR sourceVal[7]
+#define ADSR_RR sourceVal[8]
 
-#define LFO_SPEED source.val[11]
-#define LFO_WAVE source.val[12]
-#define LFO_PHASE source.val[13]
-#define LFO_LOOP source.val[14]
-#define LFO_GLOBAL source.val[15]
+#define LFO_SPEED sourceVal[11]
+#define LFO_WAVE sourceVal[12]
+#define LFO_PHASE sourceVal[13]
+#define LFO_LOOP sourceVal[14]
+#define LFO_GLOBAL sourceVal[15]
 
 void DivMacroStruct::prepare(DivInstrumentMacro& source, DivEngine* e) {
+  const int* sourceVal=source.val.get();
   has=had=actualHad=will=true;
   mode=source.mode;
   type=(source.open>>1)&3;
@@ -48,6 +49,8 @@ void DivMacroStruct::prepare(DivInstrumentMacro& source, DivEngine* e) {
 }
 
 void DivMacroStruct::doMacro(DivInstrumentMacro& source, bool released, bool tick) {
+  int sourceValLen;
+  const int* sourceVal=source.val.get(sourceValLen);
   if (!tick) {
     had=false;
     return;
@@ -87,7 +90,8 @@ void DivMacroStruct::doMacro(DivInstrumentMacro& source, bool released, bool tic
   if (has) {
     if (type==0) { // sequence
       lastPos=pos;
-      val=source.val[pos++];
+      val=(pos<sourceValLen)?sourceVal[pos]:0;
+      pos++;
       if (pos>source.rel && !released) {
         if (source.loop<source.len && source.loop<source.rel) {
           pos=source.loop;
@@ -408,7 +412,7 @@ void DivMacroInt::init(DivInstrument* which) {
       macroList[i]->prepare(*macroSource[i],e);
       // check ADSR mode
       if ((macroSource[i]->open&6)==2) {
-        if (macroSource[i]->val[8]>0) {
+        if (macroSource[i]->val.get()[8]>0) {
           hasRelease=true;
         }
       } else if (macroSource[i]->rel<macroSource[i]->len) {
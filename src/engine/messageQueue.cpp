@@ -0,0 +1,42 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2023 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "messageQueue.h"
+
+bool DivMessageQueue::push(const DivEngineMessage& msg) {
+  std::lock_guard<std::mutex> lock(producerLock);
+  unsigned int t=tail.load(std::memory_order_relaxed);
+  if (t-head.load(std::memory_order_acquire)>=DIV_MESSAGE_QUEUE_SIZE) return false;
+  slots[t&(DIV_MESSAGE_QUEUE_SIZE-1)]=msg;
+  tail.store(t+1,std::memory_order_release);
+  return true;
+}
+
+bool DivMessageQueue::pop(DivEngineMessage& msg) {
+  unsigned int h=head.load(std::memory_order_relaxed);
+  if (h==tail.load(std::memory_order_acquire)) return false;
+  msg=slots[h&(DIV_MESSAGE_QUEUE_SIZE-1)];
+  head.store(h+1,std::memory_order_release);
+  return true;
+}
+
+void DivMessageQueue::clear() {
+  head.store(tail.load(std::memory_order_acquire),std::memory_order_release);
+}
@@ -0,0 +1,90 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2023 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef _MESSAGEQUEUE_H
+#define _MESSAGEQUEUE_H
+
+#include <atomic>
+#include <mutex>
+
+// must be a power of 2
+#define DIV_MESSAGE_QUEUE_SIZE 1024
+
+enum DivEngineMessageType: unsigned char {
+  DIV_MSG_NULL=0,
+  DIV_MSG_MUTE, // chan, note (1 if muted)
+  DIV_MSG_NOTE_ON, // chan, ins, note, vol
+  DIV_MSG_NOTE_OFF, // chan
+  DIV_MSG_RESET_OSC
+};
+
+struct DivEngineMessage {
+  DivEngineMessageType type;
+  int chan, ins, note, vol;
+  DivEngineMessage(DivEngineMessageType t, int c=0, int i=0, int n=0, int v=0):
+    type(t),
+    chan(c),
+    ins(i),
+    note(n),
+    vol(v) {}
+  DivEngineMessage():
+    type(DIV_MSG_NULL),
+    chan(0),
+    ins(0),
+    note(0),
+    vol(0) {}
+};
+
+/**
+ * a bounded queue of messages to the audio thread.
+ * producers are serialized with a lock, but the consumer (which always holds
+ * the engine lock) never waits.
+ */
+struct DivMessageQueue {
+  std::atomic<unsigned int> head;
+  std::atomic<unsigned int> tail;
+  std::mutex producerLock;
+  DivEngineMessage slots[DIV_MESSAGE_QUEUE_SIZE];
+
+  /**
+   * put a message in the queue.
+   * @return whether there was room for it.
+   */
+  bool push(const DivEngineMessage& msg);
+
+  /**
+   * take a message out of the queue.
+   * only call this with the engine lock held.
+   * @return whether there was a message.
+   */
+  bool pop(DivEngineMessage& msg);
+
+  /**
+   * drop all messages.
+   * only call this with the engine lock held.
+   */
+  void clear();
+
+  DivMessageQueue():
+    head(0),
+    tail(0) {}
+};
+
+#endif
@@ -0,0 +1,155 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2023 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include <string.h>
+#include "mixer.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#define MIXER_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#define MIXER_NEON
+#include <arm_neon.h>
+#endif
+
+void DivMixer::addShort(float* dest, const short* src, float gain, size_t len) {
+  size_t i=0;
+#if defined(MIXER_SSE2)
+  const __m128 g=_mm_set1_ps(gain);
+  for (; i+8<=len; i+=8) {
+    __m128i s=_mm_loadu_si128((const __m128i*)&src[i]);
+    __m128 lo=_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s,s),16));
+    __m128 hi=_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s,s),16));
+    _mm_storeu_ps(&dest[i],_mm_add_ps(_mm_loadu_ps(&dest[i]),_mm_mul_ps(lo,g)));
+    _mm_storeu_ps(&dest[i+4],_mm_add_ps(_mm_loadu_ps(&dest[i+4]),_mm_mul_ps(hi,g)));
+  }
+#elif defined(MIXER_NEON)
+  for (; i+8<=len; i+=8) {
+    int16x8_t s=vld1q_s16(&src[i]);
+    float32x4_t lo=vcvtq_f32_s32(vmovl_s16(vget_low_s16(s)));
+    float32x4_t hi=vcvtq_f32_s32(vmovl_s16(vget_high_s16(s)));
+    vst1q_f32(&dest[i],vmlaq_n_f32(vld1q_f32(&dest[i]),lo,gain));
+    vst1q_f32(&dest[i+4],vmlaq_n_f32(vld1q_f32(&dest[i+4]),hi,gain));
+  }
+#endif
+  for (; i<len; i++) {
+    dest[i]+=(float)src[i]*gain;
+  }
+}
+
+void DivMixer::addFloat(float* dest, const float* src, size_t len) {
+  size_t i=0;
+#if defined(MIXER_SSE2)
+  for (; i+4<=len; i+=4) {
+    _mm_storeu_ps(&dest[i],_mm_add_ps(_mm_loadu_ps(&dest[i]),_mm_loadu_ps(&src[i])));
+  }
+#elif defined(MIXER_NEON)
+  for (; i+4<=len; i+=4) {
+    vst1q_f32(&dest[i],vaddq_f32(vld1q_f32(&dest[i]),vld1q_f32(&src[i])));
+  }
+#endif
+  for (; i<len; i++) {
+    dest[i]+=src[i];
+  }
+}
+
+void DivMixer::copyToRing(float* ring, size_t ringLen, size_t pos, const float* src, size_t len) {
+  // only the last ringLen samples survive
+  if (len>ringLen) {
+    pos=(pos+len-ringLen)%ringLen;
+    src+=len-ringLen;
+    len=ringLen;
+  }
+  size_t first=ringLen-pos;
+  if (first>len) first=len;
+  memcpy(&ring[pos],src,first*sizeof(float));
+  if (len>first) memcpy(ring,&src[first],(len-first)*sizeof(float));
+}
+
+void DivMixer::finish(float** out, int chans, size_t len, bool mono, bool clamp) {
+  if (chans<1) return;
+  if (mono && chans<2) mono=false;
+  if (!mono && !clamp) return;
+  const float monoGain=1.0f/chans;
+  size_t i=0;
+#if defined(MIXER_SSE2)
+  const __m128 g=_mm_set1_ps(monoGain);
+  const __m128 lo=_mm_set1_ps(-1.0f);
+  const __m128 hi=_mm_set1_ps(1.0f);
+  for (; i+4<=len; i+=4) {
+    if (mono) {
+      __m128 sum=_mm_loadu_ps(&out[0][i]);
+      for (int j=1; j<chans; j++) {
+        sum=_mm_add_ps(sum,_mm_loadu_ps(&out[j][i]));
+      }
+      sum=_mm_mul_ps(sum,g);
+      if (clamp) sum=_mm_min_ps(_mm_max_ps(sum,lo),hi);
+      for (int j=0; j<chans; j++) {
+        _mm_storeu_ps(&out[j][i],sum);
+      }
+    } else {
+      for (int j=0; j<chans; j++) {
+        _mm_storeu_ps(&out[j][i],_mm_min_ps(_mm_max_ps(_mm_loadu_ps(&out[j][i]),lo),hi));
+      }
+    }
+  }
+#elif defined(MIXER_NEON)
+  const float32x4_t lo=vdupq_n_f32(-1.0f);
+  const float32x4_t hi=vdupq_n_f32(1.0f);
+  for (; i+4<=len; i+=4) {
+    if (mono) {
+      float32x4_t sum=vld1q_f32(&out[0][i]);
+      for (int j=1; j<chans; j++) {
+        sum=vaddq_f32(sum,vld1q_f32(&out[j][i]));
+      }
+      sum=vmulq_n_f32(sum,monoGain);
+      if (clamp) sum=vminq_f32(vmaxq_f32(sum,lo),hi);
+      for (int j=0; j<chans; j++) {
+        vst1q_f32(&out[j][i],sum);
+      }
+    } else {
+      for (int j=0; j<chans; j++) {
+        vst1q_f32(&out[j][i],vminq_f32(vmaxq_f32(vld1q_f32(&out[j][i]),lo),hi));
+      }
+    }
+  }
+#endif
+  for (; i<len; i++) {
+    if (mono) {
+      float sum=out[0][i];
+      for (int j=1; j<chans; j++) {
+        sum+=out[j][i];
+      }
+      sum*=monoGain;
+      if (clamp) {
+        if (sum<-1.0f) sum=-1.0f;
+        if (sum>1.0f) sum=1.0f;
+      }
+      for (int j=0; j<chans; j++) {
+        out[j][i]=sum;
+      }
+    } else {
+      for (int j=0; j<chans; j++) {
+        if (out[j][i]<-1.0f) out[j][i]=-1.0f;
+        if (out[j][i]>1.0f) out[j][i]=1.0f;
+      }
+    }
+  }
+}
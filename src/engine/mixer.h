@@ -0,0 +1,69 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2023 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef _MIXER_H
+#define _MIXER_H
+
+#include <stddef.h>
+
+// vectorized helpers for the final mixing stage.
+// SSE2 or NEON are used if the compiler targets them, plain loops otherwise.
+class DivMixer {
+  public:
+    /**
+     * add a buffer of 16-bit samples to a float buffer.
+     * @param dest the buffer to mix into.
+     * @param src the samples.
+     * @param gain volume, including the 1/32768 scale.
+     * @param len length in samples.
+     */
+    static void addShort(float* dest, const short* src, float gain, size_t len);
+
+    /**
+     * add a float buffer to another.
+     * @param dest the buffer to mix into.
+     * @param src the samples.
+     * @param len length in samples.
+     */
+    static void addFloat(float* dest, const float* src, size_t len);
+
+    /**
+     * copy a buffer into a ring buffer.
+     * @param ring the ring buffer.
+     * @param ringLen its length.
+     * @param pos write position.
+     * @param src the samples.
+     * @param len length in samples.
+     */
+    static void copyToRing(float* ring, size_t ringLen, size_t pos, const float* src, size_t len);
+
+    /**
+     * downmix all channels to mono and optionally clamp, in one pass.
+     * each channel ends up with the same data.
+     * @param out the channels.
+     * @param chans number of channels.
+     * @param len length in samples.
+     * @param mono whether to downmix.
+     * @param clamp whether to clamp to [-1, 1].
+     */
+    static void finish(float** out, int chans, size_t len, bool mono, bool clamp);
+};
+
+#endif
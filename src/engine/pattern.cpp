@@ -19,17 +19,86 @@
 
 #include "engine.h"
 #include "../ta-log.h"
+#include <atomic>
 
+static std::atomic<unsigned int> patRevision(0);
 static DivPattern emptyPat;
 
-DivPattern::DivPattern() {
-  clear();
+static void clearRows(short (*data)[DIV_MAX_COLS], int from, int to) {
+  if (to<=from) return;
+  memset(data[from],-1,(to-from)*DIV_MAX_COLS*sizeof(short));
+  for (int i=from; i<to; i++) {
+    data[i][0]=0;
+    data[i][1]=0;
+  }
+}
+
+DivPattern::DivPattern(int rowCount):
+  data(NULL),
+  rows(0),
+  revision(0) {
+  grow(rowCount);
+  touch();
+}
+
+DivPattern::DivPattern(const DivPattern& other):
+  data(NULL),
+  rows(0),
+  revision(0) {
+  *this=other;
+}
+
+void DivPattern::touch() {
+  revision=++patRevision;
+}
+
+DivPattern& DivPattern::operator=(const DivPattern& other) {
+  if (this==&other) return *this;
+  name=other.name;
+  grow(other.rows);
+  memcpy(data,other.data,other.rows*DIV_MAX_COLS*sizeof(short));
+  clearRows(data,other.rows,rows);
+  touch();
+  return *this;
+}
+
+DivPattern::~DivPattern() {
+  delete[] (short*)data;
+  for (short* i: retired) delete[] i;
+}
+
+void DivPattern::grow(int newRows) {
+  if (newRows>DIV_MAX_ROWS) newRows=DIV_MAX_ROWS;
+  if (newRows<=rows) return;
+  newRows=(newRows+DIV_PATTERN_ROW_BLOCK-1)&(~(DIV_PATTERN_ROW_BLOCK-1));
+  if (newRows>DIV_MAX_ROWS) newRows=DIV_MAX_ROWS;
+
+  short (*newData)[DIV_MAX_COLS]=(short(*)[DIV_MAX_COLS])new short[newRows*DIV_MAX_COLS];
+  if (data!=NULL) {
+    memcpy(newData,data,rows*DIV_MAX_COLS*sizeof(short));
+    retired.push_back((short*)data);
+  }
+  clearRows(newData,rows,newRows);
+  data=newData;
+  rows=newRows;
+  touch();
+}
+
+bool DivPattern::sameAs(DivPattern* other) {
+  int common=MIN(rows,other->rows);
+  if (memcmp(data,other->data,common*DIV_MAX_COLS*sizeof(short))!=0) return false;
+  // any extra rows must be empty
+  DivPattern* longer=(rows>other->rows)?this:other;
+  if (longer->rows>common) {
+    if (memcmp(longer->data[common],emptyPat.data[common],(longer->rows-common)*DIV_MAX_COLS*sizeof(short))!=0) return false;
+  }
+  return true;
 }
 
 DivPattern* DivChannelData::getPattern(int index, bool create) {
   if (data[index]==NULL) {
     if (create) {
-      data[index]=new DivPattern;
+      data[index]=new DivPattern((patLen==NULL)?DIV_MAX_ROWS:CLAMP(*patLen,1,DIV_MAX_ROWS));
     } else {
       return &emptyPat;
     }
@@ -37,6 +106,12 @@ DivPattern* DivChannelData::getPattern(int index, bool create) {
   return data[index];
 }
 
+void DivChannelData::growPatterns(int rows) {
+  for (int i=0; i<DIV_MAX_PATTERNS; i++) {
+    if (data[i]!=NULL) data[i]->grow(rows);
+  }
+}
+
 std::vector<std::pair<int,int>> DivChannelData::optimize() {
   std::vector<std::pair<int,int>> ret;
   for (int i=0; i<DIV_MAX_PATTERNS; i++) {
@@ -45,7 +120,7 @@ std::vector<std::pair<int,int>> DivChannelData::optimize() {
       for (int j=0; j<DIV_MAX_PATTERNS; j++) {
         if (j==i) continue;
         if (data[j]==NULL) continue;
-        if (memcmp(data[i]->data,data[j]->data,DIV_MAX_ROWS*DIV_MAX_COLS*sizeof(short))==0) {
+        if (data[i]->sameAs(data[j])) {
           delete data[j];
           data[j]=NULL;
           logV("%d == %d",i,j);
@@ -86,18 +161,19 @@ void DivChannelData::wipePatterns() {
 
 void DivPattern::copyOn(DivPattern* dest) {
   dest->name=name;
-  memcpy(dest->data,data,sizeof(data));
+  dest->grow(rows);
+  memcpy(dest->data,data,rows*DIV_MAX_COLS*sizeof(short));
+  clearRows(dest->data,rows,dest->rows);
+  dest->touch();
 }
 
 void DivPattern::clear() {
-  memset(data,-1,DIV_MAX_ROWS*DIV_MAX_COLS*sizeof(short));
-  for (int i=0; i<DIV_MAX_ROWS; i++) {
-    data[i][0]=0;
-    data[i][1]=0;
-  }
+  clearRows(data,0,rows);
+  touch();
 }
 
 DivChannelData::DivChannelData():
-  effectCols(1) {
+  effectCols(1),
+  patLen(NULL) {
   memset(data,0,DIV_MAX_PATTERNS*sizeof(void*));
 }
@@ -22,7 +22,19 @@
 
 struct DivPattern {
   String name;
-  short data[DIV_MAX_ROWS][DIV_MAX_COLS];
+  // only the first `rows` rows are allocated.
+  // they're grown in blocks of DIV_PATTERN_ROW_BLOCK as needed.
+  short (*data)[DIV_MAX_COLS];
+  int rows;
+  // changes every time the contents do. taken from a global counter, so a
+  // (pattern, revision) pair never repeats even if a pattern is reallocated.
+  unsigned int revision;
+
+  /**
+   * mark the pattern as modified.
+   * call this after writing to data directly.
+   */
+  void touch();
 
   /**
    * clear the pattern.
@@ -34,7 +46,30 @@ struct DivPattern {
    * @param dest the destination pattern.
    */
   void copyOn(DivPattern* dest);
-  DivPattern();
+
+  /**
+   * make sure at least this many rows are allocated.
+   * a previous buffer is kept alive until the pattern is destroyed, as other
+   * threads may still be reading it.
+   * not thread-safe! lock the engine if the pattern is in use.
+   * @param newRows the number of rows.
+   */
+  void grow(int newRows);
+
+  /**
+   * check whether two patterns have the same contents.
+   * @param other the other pattern.
+   * @return whether they are equal.
+   */
+  bool sameAs(DivPattern* other);
+
+  DivPattern(int rowCount=DIV_MAX_ROWS);
+  DivPattern(const DivPattern& other);
+  DivPattern& operator=(const DivPattern& other);
+  ~DivPattern();
+
+  private:
+    std::vector<short*> retired;
 };
 
 struct DivChannelData {
@@ -48,6 +83,10 @@ struct DivChannelData {
   // 4-5+: effect/effect value
   // do NOT access directly unless you know what you're doing!
   DivPattern* data[DIV_MAX_PATTERNS];
+  // points to the pattern length of the owning sub-song.
+  // patterns are allocated with that many rows, and DivSubSong::setPatLen()
+  // grows them when it increases.
+  const int* patLen;
 
   /**
    * get a pattern from this channel, or the empty pattern if not initialized.
@@ -57,6 +96,13 @@ struct DivChannelData {
    */
   DivPattern* getPattern(int index, bool create);
 
+  /**
+   * grow all patterns on this DivChannelData to at least this many rows.
+   * not thread-safe! use a mutex!
+   * @param rows the number of rows.
+   */
+  void growPatterns(int rows);
+
   /**
    * optimize pattern data.
    * not thread-safe! use a mutex!
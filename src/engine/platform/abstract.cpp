@@ -16,10 +16,61 @@
  * with this program; if not, write to the Free Software Foundation, Inc.,
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
-
 #include "../dispatch.h"
+#include "../defines.h"
 #include "../../ta-log.h"
 
+void DivDispatchOscBuffer::publish() {
+  if (data==NULL) {
+    data=sharedData.load(std::memory_order_acquire);
+  }
+  unsigned int newDecim=(rate+DIV_OSC_MAX_RATE-1)/DIV_OSC_MAX_RATE;
+  if (newDecim<1) newDecim=1;
+  if (newDecim!=decim) {
+    decim=newDecim;
+    decimPos=0;
+  }
+  sharedRate.store(rate/decim,std::memory_order_relaxed);
+  sharedNeedle.store(needle,std::memory_order_release);
+}
+
+void DivDispatchOscBuffer::reset() {
+  needle=0;
+  readNeedle=0;
+  decimPos=0;
+  sharedNeedle.store(0,std::memory_order_release);
+}
+
+void DivDispatchOscBuffer::clear() {
+  short* oldData=sharedData.load(std::memory_order_acquire);
+  if (oldData!=NULL) memset(oldData,0,DIV_OSC_BUF_SIZE*sizeof(short));
+  reset();
+}
+
+short* DivDispatchOscBuffer::alloc() {
+  short* ret=sharedData.load(std::memory_order_acquire);
+  if (ret!=NULL) return ret;
+
+  short* newData=new short[DIV_OSC_BUF_SIZE];
+  memset(newData,0,DIV_OSC_BUF_SIZE*sizeof(short));
+  if (!sharedData.compare_exchange_strong(ret,newData,std::memory_order_acq_rel)) {
+    // someone else got there first
+    delete[] newData;
+    return ret;
+  }
+  return newData;
+}
+
+void DivDispatchOscBuffer::release() {
+  short* oldData=sharedData.exchange(NULL,std::memory_order_acq_rel);
+  data=NULL;
+  if (oldData!=NULL) delete[] oldData;
+}
+
+DivDispatchOscBuffer::~DivDispatchOscBuffer() {
+  release();
+}
+
 void DivDispatch::acquire(short** buf, size_t len) {
 }
 
@@ -76,6 +127,9 @@ void* DivDispatch::getState() {
 void DivDispatch::setState(void* state) {
 }
 
+void DivDispatch::freeState(void* state) {
+}
+
 void DivDispatch::muteChannel(int ch, bool mute) {
 }
 
@@ -175,6 +229,42 @@ void DivDispatch::poke(std::vector<DivRegWrite>& wlist) {
   
 }
 
+bool DivDispatch::canDeferWrites() {
+  return false;
+}
+
+void DivDispatch::takeWrites(std::vector<DivDelayedWrite>& wlist, int time) {
+}
+
+void DivDispatch::putWrite(unsigned int addr, unsigned int val) {
+}
+
+void DivDispatch::acquireWithWrites(short** buf, size_t len, std::vector<DivDelayedWrite>& wlist) {
+  short* bufOff[DIV_MAX_OUTPUTS];
+  int outs=getOutputCount();
+  size_t pos=0;
+  size_t writePos=0;
+  while (pos<len) {
+    while (writePos<wlist.size() && wlist[writePos].time<=(int)pos) {
+      putWrite(wlist[writePos].write.addr,wlist[writePos].write.val);
+      writePos++;
+    }
+    size_t next=len;
+    if (writePos<wlist.size() && wlist[writePos].time<(int)len) {
+      next=wlist[writePos].time;
+    }
+    for (int i=0; i<outs && i<DIV_MAX_OUTPUTS; i++) {
+      bufOff[i]=(buf[i]==NULL)?NULL:(buf[i]+pos);
+    }
+    acquire(bufOff,next-pos);
+    pos=next;
+  }
+  while (writePos<wlist.size()) {
+    putWrite(wlist[writePos].write.addr,wlist[writePos].write.val);
+    writePos++;
+  }
+}
+
 const char** DivDispatch::getRegisterSheet() {
   return NULL;
 }
@@ -51,10 +51,12 @@ const char** DivPlatformArcade::getRegisterSheet() {
   return regCheatSheetOPM;
 }
 
-void DivPlatformArcade::acquire_nuked(short** buf, size_t len) {
+void DivPlatformArcade::acquire_nuked(short** buf, size_t len, std::vector<DivDelayedWrite>* wlist) {
   thread_local int o[2];
+  size_t wlistPos=0;
 
   for (size_t h=0; h<len; h++) {
+    PUT_DUE_WRITES(h);
     for (int i=0; i<8; i++) {
       if (!writes.empty() && !fm.write_busy) {
         QueuedWrite& w=writes.front();
@@ -77,7 +79,7 @@ void DivPlatformArcade::acquire_nuked(short** buf, size_t len) {
 
     for (int i=0; i<8; i++) {
       int chOut=(int16_t)fm.ch_out[i];
-      oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(chOut<<1,-32768,32767);
+      oscBuf[i]->putSample(CLAMP(chOut<<1,-32768,32767));
     }
 
     if (o[0]<-32768) o[0]=-32768;
@@ -89,14 +91,17 @@ void DivPlatformArcade::acquire_nuked(short** buf, size_t len) {
     buf[0][h]=o[0];
     buf[1][h]=o[1];
   }
+  PUT_DUE_WRITES(len);
 }
 
-void DivPlatformArcade::acquire_ymfm(short** buf, size_t len) {
+void DivPlatformArcade::acquire_ymfm(short** buf, size_t len, std::vector<DivDelayedWrite>* wlist) {
   thread_local int os[2];
+  size_t wlistPos=0;
 
   ymfm::ym2151::fm_engine* fme=fm_ymfm->debug_engine();
 
   for (size_t h=0; h<len; h++) {
+    PUT_DUE_WRITES(h);
     os[0]=0; os[1]=0;
     if (!writes.empty()) {
       if (--delay<1) {
@@ -113,7 +118,7 @@ void DivPlatformArcade::acquire_ymfm(short** buf, size_t len) {
 
     for (int i=0; i<8; i++) {
       int chOut=fme->debug_channel(i)->debug_output(0)+fme->debug_channel(i)->debug_output(1);
-      oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(chOut,-32768,32767);
+      oscBuf[i]->putSample(CLAMP(chOut,-32768,32767));
     }
 
     os[0]=out_ymfm.data[0];
@@ -127,16 +132,29 @@ void DivPlatformArcade::acquire_ymfm(short** buf, size_t len) {
     buf[0][h]=os[0];
     buf[1][h]=os[1];
   }
+  PUT_DUE_WRITES(len);
 }
 
 void DivPlatformArcade::acquire(short** buf, size_t len) {
   if (useYMFM) {
-    acquire_ymfm(buf,len);
+    acquire_ymfm(buf,len,NULL);
   } else {
-    acquire_nuked(buf,len);
+    acquire_nuked(buf,len,NULL);
   }
 }
 
+void DivPlatformArcade::acquireWithWrites(short** buf, size_t len, std::vector<DivDelayedWrite>& wlist) {
+  if (useYMFM) {
+    acquire_ymfm(buf,len,&wlist);
+  } else {
+    acquire_nuked(buf,len,&wlist);
+  }
+}
+
+bool DivPlatformArcade::canDeferWrites() {
+  return true;
+}
+
 static unsigned char noteMap[12]={
   0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14
 };
@@ -58,13 +58,15 @@ class DivPlatformArcade: public DivPlatformOPM {
     int toFreq(int freq);
     void commitState(int ch, DivInstrument* ins);
 
-    void acquire_nuked(short** buf, size_t len);
-    void acquire_ymfm(short** buf, size_t len);
+    void acquire_nuked(short** buf, size_t len, std::vector<DivDelayedWrite>* wlist);
+    void acquire_ymfm(short** buf, size_t len, std::vector<DivDelayedWrite>* wlist);
 
     friend void putDispatchChan(void*,int,int);
     friend void putDispatchChip(void*,int);
   public:
     void acquire(short** buf, size_t len);
+    void acquireWithWrites(short** buf, size_t len, std::vector<DivDelayedWrite>& wlist);
+    bool canDeferWrites();
     int dispatch(DivCommand c);
     void* getChanState(int chan);
     DivDispatchOscBuffer* getOscBuffer(int chan);
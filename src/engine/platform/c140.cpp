@@ -91,7 +91,7 @@ void DivPlatformC140::acquire_219(short** buf, size_t len) {
     buf[1][h]=c219.rout;
 
     for (int i=0; i<totalChans; i++) {
-      oscBuf[i]->data[oscBuf[i]->needle++]=(c219.voice[i].lout+c219.voice[i].rout)>>10;
+      oscBuf[i]->putSample((c219.voice[i].lout+c219.voice[i].rout)>>10);
     }
   }
 }
@@ -120,7 +120,7 @@ void DivPlatformC140::acquire_140(short** buf, size_t len) {
     buf[1][h]=c140.rout;
 
     for (int i=0; i<totalChans; i++) {
-      oscBuf[i]->data[oscBuf[i]->needle++]=(c140.voice[i].lout+c140.voice[i].rout)>>10;
+      oscBuf[i]->putSample((c140.voice[i].lout+c140.voice[i].rout)>>10);
     }
   }
 }
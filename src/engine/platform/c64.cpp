@@ -120,26 +120,26 @@ void DivPlatformC64::acquire(short** buf, size_t len) {
       buf[0][i]=32767*CLAMP(o,-1.0,1.0);
       if (++writeOscBuf>=4) {
         writeOscBuf=0;
-        oscBuf[0]->data[oscBuf[0]->needle++]=sid_d->lastOut[0];
-        oscBuf[1]->data[oscBuf[1]->needle++]=sid_d->lastOut[1];
-        oscBuf[2]->data[oscBuf[2]->needle++]=sid_d->lastOut[2];
+        oscBuf[0]->putSample(sid_d->lastOut[0]);
+        oscBuf[1]->putSample(sid_d->lastOut[1]);
+        oscBuf[2]->putSample(sid_d->lastOut[2]);
       }
     } else if (sidCore==1) {
       sid_fp->clock(4,&buf[0][i]);
       if (++writeOscBuf>=4) {
         writeOscBuf=0;
-        oscBuf[0]->data[oscBuf[0]->needle++]=runFakeFilter(0,(sid_fp->lastChanOut[0]-dcOff)>>5);
-        oscBuf[1]->data[oscBuf[1]->needle++]=runFakeFilter(1,(sid_fp->lastChanOut[1]-dcOff)>>5);
-        oscBuf[2]->data[oscBuf[2]->needle++]=runFakeFilter(2,(sid_fp->lastChanOut[2]-dcOff)>>5);
+        oscBuf[0]->putSample(runFakeFilter(0,(sid_fp->lastChanOut[0]-dcOff)>>5));
+        oscBuf[1]->putSample(runFakeFilter(1,(sid_fp->lastChanOut[1]-dcOff)>>5));
+        oscBuf[2]->putSample(runFakeFilter(2,(sid_fp->lastChanOut[2]-dcOff)>>5));
       }
     } else {
       sid->clock();
       buf[0][i]=sid->output();
       if (++writeOscBuf>=16) {
         writeOscBuf=0;
-        oscBuf[0]->data[oscBuf[0]->needle++]=runFakeFilter(0,(sid->last_chan_out[0]-dcOff)>>5);
-        oscBuf[1]->data[oscBuf[1]->needle++]=runFakeFilter(1,(sid->last_chan_out[1]-dcOff)>>5);
-        oscBuf[2]->data[oscBuf[2]->needle++]=runFakeFilter(2,(sid->last_chan_out[2]-dcOff)>>5);
+        oscBuf[0]->putSample(runFakeFilter(0,(sid->last_chan_out[0]-dcOff)>>5));
+        oscBuf[1]->putSample(runFakeFilter(1,(sid->last_chan_out[1]-dcOff)>>5));
+        oscBuf[2]->putSample(runFakeFilter(2,(sid->last_chan_out[2]-dcOff)>>5));
       }
     }
   }
@@ -137,7 +137,30 @@ class DivPlatformFMBase: public DivDispatch {
     }
 
     friend void putDispatchChan(void*,int,int);
-  
+
+  public:
+    void takeWrites(std::vector<DivDelayedWrite>& wlist, int time) {
+      // a write in progress (address already sent) stays
+      bool inProgress=(!writes.empty() && writes.front().addrOrVal);
+      QueuedWrite first;
+      if (inProgress) {
+        first=writes.front();
+        writes.pop_front();
+      }
+      while (!writes.empty()) {
+        QueuedWrite& w=writes.front();
+        wlist.push_back(DivDelayedWrite(time,w.addr,w.val));
+        writes.pop_front();
+      }
+      if (inProgress) {
+        writes.push_front(first);
+      }
+    }
+    void putWrite(unsigned int addr, unsigned int val) {
+      writes.push_back(QueuedWrite(addr,val));
+    }
+
+  protected:
     DivPlatformFMBase():
       DivDispatch(),
       lastBusy(0),
@@ -75,7 +75,7 @@ void DivPlatformGB::acquire(short** buf, size_t len) {
     buf[1][i]=gb->apu_output.final_sample.right;
 
     for (int i=0; i<4; i++) {
-      oscBuf[i]->data[oscBuf[i]->needle++]=(gb->apu_output.current_sample[i].left+gb->apu_output.current_sample[i].right)<<6;
+      oscBuf[i]->putSample((gb->apu_output.current_sample[i].left+gb->apu_output.current_sample[i].right)<<6);
     }
   }
 }
@@ -655,6 +655,33 @@ void DivPlatformGB::notifyInsDeletion(void* ins) {
   }
 }
 
+void* DivPlatformGB::getState() {
+  State* s=new State;
+  for (int i=0; i<4; i++) {
+    s->chan[i]=chan[i];
+  }
+  s->ws=ws;
+  s->lastPan=lastPan;
+  s->antiClickPeriodCount=antiClickPeriodCount;
+  s->antiClickWavePos=antiClickWavePos;
+  return s;
+}
+
+void DivPlatformGB::setState(void* state) {
+  State* s=(State*)state;
+  for (int i=0; i<4; i++) {
+    chan[i]=s->chan[i];
+  }
+  ws=s->ws;
+  lastPan=s->lastPan;
+  antiClickPeriodCount=s->antiClickPeriodCount;
+  antiClickWavePos=s->antiClickWavePos;
+}
+
+void DivPlatformGB::freeState(void* state) {
+  delete (State*)state;
+}
+
 void DivPlatformGB::poke(unsigned int addr, unsigned short val) {
   immWrite(addr,val);
 }
@@ -68,6 +68,12 @@ class DivPlatformGB: public DivDispatch {
     QueuedWrite(unsigned char a, unsigned char v): addr(a), val(v) {}
   };
   FixedQueue<QueuedWrite,256> writes;
+  struct State {
+    Channel chan[4];
+    DivWaveSynth ws;
+    unsigned char lastPan;
+    int antiClickPeriodCount, antiClickWavePos;
+  };
 
   int antiClickPeriodCount, antiClickWavePos;
 
@@ -98,6 +104,9 @@ class DivPlatformGB: public DivDispatch {
     void notifyInsChange(int ins);
     void notifyWaveChange(int wave);
     void notifyInsDeletion(void* ins);
+    void* getState();
+    void setState(void* state);
+    void freeState(void* state);
     void poke(unsigned int addr, unsigned short val);
     void poke(std::vector<DivRegWrite>& wlist);
     const char** getRegisterSheet();
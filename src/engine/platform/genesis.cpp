@@ -131,84 +131,164 @@ void DivPlatformGenesis::processDAC(int iRate) {
   }
 }
 
-void DivPlatformGenesis::acquire_nuked(short** buf, size_t len) {
-  thread_local short o[2];
-  thread_local int os[2];
-
-  for (size_t h=0; h<len; h++) {
-    processDAC(rate);
+// returns how many of the next samples (up to maxLen) processDAC() would do
+// nothing in but advance its timers, and advances them past those samples.
+size_t DivPlatformGenesis::skipQuietDAC(int iRate, size_t maxLen) {
+  size_t quiet=maxLen;
+  if (softPCM) {
+    // the timer fires on the first sample which takes it past iRate
+    int step=chipClock/576;
+    if (softPCMTimer>iRate) return 0;
+    if (step<=0) return maxLen;
+    quiet=MIN(maxLen,(size_t)((iRate-softPCMTimer)/step));
+    softPCMTimer+=(int)quiet*step;
+  } else if (chan[5].dacMode && chan[5].dacSample!=-1) {
+    // the sample advances on the first sample which takes the period to iRate
+    if (chan[5].dacPeriod>=iRate) return 0;
+    if (chan[5].dacRate<=0) return maxLen;
+    quiet=MIN(maxLen,(size_t)((iRate-1-chan[5].dacPeriod)/chan[5].dacRate));
+    chan[5].dacPeriod+=(int)quiet*chan[5].dacRate;
+  }
+  return quiet;
+}
 
-    os[0]=0; os[1]=0;
-    for (int i=0; i<6; i++) {
-      if (!writes.empty()) {
-        QueuedWrite& w=writes.front();
-        if (w.addrOrVal) {
-          //logV("%.3x = %.2x",w.addr,w.val);
-          OPN2_Write(&fm,0x1+((w.addr>>8)<<1),w.val);
-          regPool[w.addr&0x1ff]=w.val;
-          writes.pop_front();
+// runs the chip one sample (6 cycles) at a time.
+// stretches with nothing to write (no queued writes and no DAC sample due) are
+// run in one go, without looking at the write queue or the DAC. otherwise the
+// write queue is looked at on every cycle.
+// scope samples are gathered after the cycles run (and not at all if nobody is looking).
+// only the output stage differs between YM2612/YM3438 and YMF276, hence the template.
+template<bool isYMF276> void DivPlatformGenesis::acquire_nukedLoop(short** buf, size_t len) {
+  short o[2];
+  int os[2];
+  int chOut[6];
+
+  bool capture=false;
+  for (int i=0; i<7; i++) {
+    if (oscBuf[i]->data!=NULL) capture=true;
+  }
 
-          if (dacWrite>=0) {
-            if (!canWriteDAC) {
-              canWriteDAC=true;
-            } else {
-              urgentWrite(0x2a,dacWrite);
-              dacWrite=-1;
-              canWriteDAC=writes.empty();
-            }
-          }
+  auto clockChip=[&](int i) {
+    OPN2_Clock(&fm,o);
+    if (isYMF276) {
+      os[0]+=CLAMP(o[0],-8192,8191);
+      os[1]+=CLAMP(o[1],-8192,8191);
+    } else {
+      os[0]+=o[0];
+      os[1]+=o[1];
+    }
+    chOut[i]=fm.ch_out[i];
+  };
+
+  auto finishSample=[&](size_t h) {
+    if (capture) {
+      // channel i is sampled on cycle i, and the DAC after the last one
+      for (int i=0; i<5; i++) {
+        oscBuf[i]->putSample(CLAMP(chOut[i]<<(isYMF276?1:6),-32768,32767));
+      }
+      if (fm.dacen) {
+        if (softPCM) {
+          oscBuf[5]->putSample(chan[5].dacOutput<<6);
+          oscBuf[6]->putSample(chan[6].dacOutput<<6);
         } else {
-          if (fm.write_busy==0) {
-            OPN2_Write(&fm,0x0+((w.addr>>8)<<1),w.addr);
-            w.addrOrVal=true;
-          }
+          oscBuf[5]->putSample(((fm.dacdata^0x100)-0x100)<<6);
+          oscBuf[6]->putSample(0);
         }
       } else {
+        oscBuf[5]->putSample(CLAMP(chOut[5]<<(isYMF276?1:6),-32768,32767));
+        oscBuf[6]->putSample(0);
+      }
+    }
+
+    if (!isYMF276) os[0]=(os[0]<<5);
+    if (os[0]<-32768) os[0]=-32768;
+    if (os[0]>32767) os[0]=32767;
+
+    if (!isYMF276) os[1]=(os[1]<<5);
+    if (os[1]<-32768) os[1]=-32768;
+    if (os[1]>32767) os[1]=32767;
+
+    buf[0][h]=os[0];
+    buf[1][h]=os[1];
+  };
+
+  size_t h=0;
+  while (h<len) {
+    if (writes.empty() && dacWrite<0) {
+      // run the chip until the DAC has something to write
+      size_t quiet=skipQuietDAC(rate,len-h);
+      if (quiet>0) {
         canWriteDAC=true;
-        if (dacWrite>=0) {
-          urgentWrite(0x2a,dacWrite);
-          dacWrite=-1;
-        }
         flushFirst=false;
+        for (size_t runEnd=h+quiet; h<runEnd; h++) {
+          os[0]=0; os[1]=0;
+          for (int i=0; i<6; i++) {
+            clockChip(i);
+          }
+          finishSample(h);
+        }
+        continue;
       }
-      
-      OPN2_Clock(&fm,o);
-      if (chipType==2) {
-        os[0]+=CLAMP(o[0],-8192,8191);
-        os[1]+=CLAMP(o[1],-8192,8191);
-      } else {
-        os[0]+=o[0];
-        os[1]+=o[1];
+    }
+
+    processDAC(rate);
+
+    os[0]=0; os[1]=0;
+    if (writes.empty() && dacWrite<0) {
+      // nothing to write during this sample
+      canWriteDAC=true;
+      flushFirst=false;
+      for (int i=0; i<6; i++) {
+        clockChip(i);
       }
-      //OPN2_Write(&fm,0,0);
-      if (i==5) {
-        if (fm.dacen) {
-          if (softPCM) {
-            oscBuf[5]->data[oscBuf[5]->needle++]=chan[5].dacOutput<<6;
-            oscBuf[6]->data[oscBuf[6]->needle++]=chan[6].dacOutput<<6;
+    } else {
+      for (int i=0; i<6; i++) {
+        if (!writes.empty()) {
+          QueuedWrite& w=writes.front();
+          if (w.addrOrVal) {
+            //logV("%.3x = %.2x",w.addr,w.val);
+            OPN2_Write(&fm,0x1+((w.addr>>8)<<1),w.val);
+            regPool[w.addr&0x1ff]=w.val;
+            writes.pop_front();
+
+            if (dacWrite>=0) {
+              if (!canWriteDAC) {
+                canWriteDAC=true;
+              } else {
+                urgentWrite(0x2a,dacWrite);
+                dacWrite=-1;
+                canWriteDAC=writes.empty();
+              }
+            }
           } else {
-            oscBuf[i]->data[oscBuf[i]->needle++]=((fm.dacdata^0x100)-0x100)<<6;
-            oscBuf[6]->data[oscBuf[6]->needle++]=0;
+            if (fm.write_busy==0) {
+              OPN2_Write(&fm,0x0+((w.addr>>8)<<1),w.addr);
+              w.addrOrVal=true;
+            }
           }
         } else {
-          oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fm.ch_out[i]<<(chipType==2?1:6),-32768,32767);
-          oscBuf[6]->data[oscBuf[6]->needle++]=0;
+          canWriteDAC=true;
+          if (dacWrite>=0) {
+            urgentWrite(0x2a,dacWrite);
+            dacWrite=-1;
+          }
+          flushFirst=false;
         }
-      } else {
-        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fm.ch_out[i]<<(chipType==2?1:6),-32768,32767);
+
+        clockChip(i);
       }
     }
-    
-    if (chipType!=2) os[0]=(os[0]<<5);
-    if (os[0]<-32768) os[0]=-32768;
-    if (os[0]>32767) os[0]=32767;
 
-    if (chipType!=2) os[1]=(os[1]<<5);
-    if (os[1]<-32768) os[1]=-32768;
-    if (os[1]>32767) os[1]=32767;
-  
-    buf[0][h]=os[0];
-    buf[1][h]=os[1];
+    finishSample(h);
+    h++;
+  }
+}
+
+void DivPlatformGenesis::acquire_nuked(short** buf, size_t len) {
+  if (chipType==2) {
+    acquire_nukedLoop<true>(buf,len);
+  } else {
+    acquire_nukedLoop<false>(buf,len);
   }
 }
 
@@ -263,18 +343,18 @@ void DivPlatformGenesis::acquire_ymfm(short** buf, size_t len) {
       if (i==5) {
         if (fm_ymfm->debug_dac_enable()) {
           if (softPCM) {
-            oscBuf[5]->data[oscBuf[5]->needle++]=chan[5].dacOutput<<6;
-            oscBuf[6]->data[oscBuf[6]->needle++]=chan[6].dacOutput<<6;
+            oscBuf[5]->putSample(chan[5].dacOutput<<6);
+            oscBuf[6]->putSample(chan[6].dacOutput<<6);
           } else {
-            oscBuf[i]->data[oscBuf[i]->needle++]=((fm_ymfm->debug_dac_data()^0x100)-0x100)<<6;
-            oscBuf[6]->data[oscBuf[6]->needle++]=0;
+            oscBuf[i]->putSample(((fm_ymfm->debug_dac_data()^0x100)-0x100)<<6);
+            oscBuf[6]->putSample(0);
           }
         } else {
-          oscBuf[i]->data[oscBuf[i]->needle++]=chOut;
-          oscBuf[6]->data[oscBuf[6]->needle++]=0;
+          oscBuf[i]->putSample(chOut);
+          oscBuf[6]->putSample(0);
         }
       } else {
-        oscBuf[i]->data[oscBuf[i]->needle++]=chOut;
+        oscBuf[i]->putSample(chOut);
       }
     }
     
@@ -1398,6 +1478,31 @@ void DivPlatformGenesis::notifyInsDeletion(void* ins) {
   }
 }
 
+void* DivPlatformGenesis::getState() {
+  State* s=new State;
+  for (int i=0; i<10; i++) {
+    s->chan[i]=chan[i];
+  }
+  s->lfoValue=lfoValue;
+  s->lastExtChPan=lastExtChPan;
+  s->extMode=extMode;
+  return s;
+}
+
+void DivPlatformGenesis::setState(void* state) {
+  State* s=(State*)state;
+  for (int i=0; i<10; i++) {
+    chan[i]=s->chan[i];
+  }
+  lfoValue=s->lfoValue;
+  lastExtChPan=s->lastExtChPan;
+  extMode=s->extMode;
+}
+
+void DivPlatformGenesis::freeState(void* state) {
+  delete (State*)state;
+}
+
 void DivPlatformGenesis::poke(unsigned int addr, unsigned short val) {
   immWrite(addr,val);
 }
@@ -91,12 +91,20 @@ class DivPlatformGenesis: public DivPlatformOPN {
     short dacWrite;
   
     unsigned char dacVolTable[128];
+
+    struct State {
+      Channel chan[10];
+      unsigned char lfoValue, lastExtChPan;
+      bool extMode;
+    };
   
     friend void putDispatchChip(void*,int);
     friend void putDispatchChan(void*,int,int);
 
     inline void processDAC(int iRate);
+    inline size_t skipQuietDAC(int iRate, size_t maxLen);
     inline void commitState(int ch, DivInstrument* ins);
+    template<bool isYMF276> void acquire_nukedLoop(short** buf, size_t len);
     void acquire_nuked(short** buf, size_t len);
     void acquire_nuked276(short** buf, size_t len);
     void acquire_ymfm(short** buf, size_t len);
@@ -128,6 +136,9 @@ class DivPlatformGenesis: public DivPlatformOPN {
     void setFlags(const DivConfig& flags);
     void notifyInsChange(int ins);
     virtual void notifyInsDeletion(void* ins);
+    virtual void* getState();
+    virtual void setState(void* state);
+    virtual void freeState(void* state);
     void setSoftPCM(bool value);
     int getPortaFloor(int ch);
     void poke(unsigned int addr, unsigned short val);
@@ -865,6 +865,29 @@ void DivPlatformGenesisExt::notifyInsDeletion(void* ins) {
   }
 }
 
+void* DivPlatformGenesisExt::getState() {
+  ExtState* s=new ExtState;
+  s->base=DivPlatformGenesis::getState();
+  for (int i=0; i<4; i++) {
+    s->opChan[i]=opChan[i];
+  }
+  return s;
+}
+
+void DivPlatformGenesisExt::setState(void* state) {
+  ExtState* s=(ExtState*)state;
+  DivPlatformGenesis::setState(s->base);
+  for (int i=0; i<4; i++) {
+    opChan[i]=s->opChan[i];
+  }
+}
+
+void DivPlatformGenesisExt::freeState(void* state) {
+  ExtState* s=(ExtState*)state;
+  DivPlatformGenesis::freeState(s->base);
+  delete s;
+}
+
 int DivPlatformGenesisExt::getPortaFloor(int ch) {
   return (ch>8)?12:0;
 }
@@ -27,6 +27,10 @@
 class DivPlatformGenesisExt: public DivPlatformGenesis {
   OPNOpChannelStereo opChan[4];
   bool isOpMuted[4];
+  struct ExtState {
+    void* base;
+    OPNOpChannelStereo opChan[4];
+  };
   friend void putDispatchChip(void*,int);
   friend void putDispatchChan(void*,int,int);
   inline void commitStateExt(int ch, DivInstrument* ins);
@@ -45,6 +49,9 @@ class DivPlatformGenesisExt: public DivPlatformGenesis {
     bool keyOffAffectsPorta(int ch);
     void notifyInsChange(int ins);
     void notifyInsDeletion(void* ins);
+    void* getState();
+    void setState(void* state);
+    void freeState(void* state);
     int getPortaFloor(int ch);
     void setCSMChannel(unsigned char ch);
     int init(DivEngine* parent, int channels, int sugRate, const DivConfig& flags);
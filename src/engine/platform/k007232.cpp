@@ -81,7 +81,7 @@ void DivPlatformK007232::acquire(short** buf, size_t len) {
       if (++oscDivider>=8) {
         oscDivider=0;
         for (int i=0; i<2; i++) {
-          oscBuf[i]->data[oscBuf[i]->needle++]=(lout[i]+rout[i])<<3;
+          oscBuf[i]->putSample((lout[i]+rout[i])<<3);
         }
       }
     } else {
@@ -91,7 +91,7 @@ void DivPlatformK007232::acquire(short** buf, size_t len) {
       if (++oscDivider>=8) {
         oscDivider=0;
         for (int i=0; i<2; i++) {
-          oscBuf[i]->data[oscBuf[i]->needle++]=out[i]<<4;
+          oscBuf[i]->putSample(out[i]<<4);
         }
       }
     }
@@ -80,7 +80,7 @@ void DivPlatformMSM6295::acquire(short** buf, size_t len) {
     if (++updateOsc>=22) {
       updateOsc=0;
       for (int i=0; i<4; i++) {
-        oscBuf[i]->data[oscBuf[i]->needle++]=msm.voice_out(i)<<5;
+        oscBuf[i]->putSample(msm.voice_out(i)<<5);
       }
     }
   }
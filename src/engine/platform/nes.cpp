@@ -115,11 +115,11 @@ void DivPlatformNES::acquire_puNES(short** buf, size_t len) {
     buf[0][i]=sample;
     if (++writeOscBuf>=32) {
       writeOscBuf=0;
-      oscBuf[0]->data[oscBuf[0]->needle++]=isMuted[0]?0:(nes->S1.output<<11);
-      oscBuf[1]->data[oscBuf[1]->needle++]=isMuted[1]?0:(nes->S2.output<<11);
-      oscBuf[2]->data[oscBuf[2]->needle++]=isMuted[2]?0:(nes->TR.output<<11);
-      oscBuf[3]->data[oscBuf[3]->needle++]=isMuted[3]?0:(nes->NS.output<<11);
-      oscBuf[4]->data[oscBuf[4]->needle++]=isMuted[4]?0:(nes->DMC.output<<8);
+      oscBuf[0]->putSample(isMuted[0]?0:(nes->S1.output<<11));
+      oscBuf[1]->putSample(isMuted[1]?0:(nes->S2.output<<11));
+      oscBuf[2]->putSample(isMuted[2]?0:(nes->TR.output<<11));
+      oscBuf[3]->putSample(isMuted[3]?0:(nes->NS.output<<11));
+      oscBuf[4]->putSample(isMuted[4]?0:(nes->DMC.output<<8));
     }
   }
 }
@@ -142,11 +142,11 @@ void DivPlatformNES::acquire_NSFPlay(short** buf, size_t len) {
     buf[0][i]=sample;
     if (++writeOscBuf>=4) {
       writeOscBuf=0;
-      oscBuf[0]->data[oscBuf[0]->needle++]=nes1_NP->out[0]<<11;
-      oscBuf[1]->data[oscBuf[1]->needle++]=nes1_NP->out[1]<<11;
-      oscBuf[2]->data[oscBuf[2]->needle++]=nes2_NP->out[0]<<11;
-      oscBuf[3]->data[oscBuf[3]->needle++]=nes2_NP->out[1]<<11;
-      oscBuf[4]->data[oscBuf[4]->needle++]=nes2_NP->out[2]<<8;
+      oscBuf[0]->putSample(nes1_NP->out[0]<<11);
+      oscBuf[1]->putSample(nes1_NP->out[1]<<11);
+      oscBuf[2]->putSample(nes2_NP->out[0]<<11);
+      oscBuf[3]->putSample(nes2_NP->out[1]<<11);
+      oscBuf[4]->putSample(nes2_NP->out[2]<<8);
     }
   }
 }
@@ -211,9 +211,9 @@ void DivPlatformOPL::acquire_nuked(short** buf, size_t len) {
       if (!isMuted[adpcmChan]) {
         os[0]-=aOut.data[0]>>3;
         os[1]-=aOut.data[0]>>3;
-        oscBuf[adpcmChan]->data[oscBuf[adpcmChan]->needle++]=aOut.data[0]>>1;
+        oscBuf[adpcmChan]->putSample(aOut.data[0]>>1);
       } else {
-        oscBuf[adpcmChan]->data[oscBuf[adpcmChan]->needle++]=0;
+        oscBuf[adpcmChan]->putSample(0);
       }
     }
 
@@ -234,13 +234,13 @@ void DivPlatformOPL::acquire_nuked(short** buf, size_t len) {
         if (fm.channel[i].out[3]!=NULL) {
           chOut+=*fm.channel[ch].out[3];
         }
-        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(chOut<<(i==melodicChans?1:2),-32768,32767);
+        oscBuf[i]->putSample(CLAMP(chOut<<(i==melodicChans?1:2),-32768,32767));
       }
       // special
-      oscBuf[melodicChans+1]->data[oscBuf[melodicChans+1]->needle++]=fm.slot[16].out*4;
-      oscBuf[melodicChans+2]->data[oscBuf[melodicChans+2]->needle++]=fm.slot[14].out*4;
-      oscBuf[melodicChans+3]->data[oscBuf[melodicChans+3]->needle++]=fm.slot[17].out*4;
-      oscBuf[melodicChans+4]->data[oscBuf[melodicChans+4]->needle++]=fm.slot[13].out*4;
+      oscBuf[melodicChans+1]->putSample(fm.slot[16].out*4);
+      oscBuf[melodicChans+2]->putSample(fm.slot[14].out*4);
+      oscBuf[melodicChans+3]->putSample(fm.slot[17].out*4);
+      oscBuf[melodicChans+4]->putSample(fm.slot[13].out*4);
     } else {
       for (int i=0; i<chans; i++) {
         unsigned char ch=outChanMap[i];
@@ -258,7 +258,7 @@ void DivPlatformOPL::acquire_nuked(short** buf, size_t len) {
         if (fm.channel[i].out[3]!=NULL) {
           chOut+=*fm.channel[ch].out[3];
         }
-        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(chOut<<2,-32768,32767);
+        oscBuf[i]->putSample(CLAMP(chOut<<2,-32768,32767));
       }
     }
     
@@ -320,15 +320,15 @@ void DivPlatformOPL::acquire_ymfm1(short** buf, size_t len) {
 
     if (properDrums) {
       for (int i=0; i<7; i++) {
-        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767);
+        oscBuf[i]->putSample(CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767));
       }
-      oscBuf[7]->data[oscBuf[7]->needle++]=CLAMP(fmChan[7]->debug_special1()<<2,-32768,32767);
-      oscBuf[8]->data[oscBuf[8]->needle++]=CLAMP(fmChan[8]->debug_special1()<<2,-32768,32767);
-      oscBuf[9]->data[oscBuf[9]->needle++]=CLAMP(fmChan[8]->debug_special2()<<2,-32768,32767);
-      oscBuf[10]->data[oscBuf[10]->needle++]=CLAMP(fmChan[7]->debug_special2()<<2,-32768,32767);
+      oscBuf[7]->putSample(CLAMP(fmChan[7]->debug_special1()<<2,-32768,32767));
+      oscBuf[8]->putSample(CLAMP(fmChan[8]->debug_special1()<<2,-32768,32767));
+      oscBuf[9]->putSample(CLAMP(fmChan[8]->debug_special2()<<2,-32768,32767));
+      oscBuf[10]->putSample(CLAMP(fmChan[7]->debug_special2()<<2,-32768,32767));
     } else {
       for (int i=0; i<9; i++) {
-        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767);
+        oscBuf[i]->putSample(CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767));
       }
     }
   }
@@ -362,15 +362,15 @@ void DivPlatformOPL::acquire_ymfm2(short** buf, size_t len) {
 
     if (properDrums) {
       for (int i=0; i<7; i++) {
-        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767);
+        oscBuf[i]->putSample(CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767));
       }
-      oscBuf[7]->data[oscBuf[7]->needle++]=CLAMP(fmChan[7]->debug_special1()<<2,-32768,32767);
-      oscBuf[8]->data[oscBuf[8]->needle++]=CLAMP(fmChan[8]->debug_special1()<<2,-32768,32767);
-      oscBuf[9]->data[oscBuf[9]->needle++]=CLAMP(fmChan[8]->debug_special2()<<2,-32768,32767);
-      oscBuf[10]->data[oscBuf[10]->needle++]=CLAMP(fmChan[7]->debug_special2()<<2,-32768,32767);
+      oscBuf[7]->putSample(CLAMP(fmChan[7]->debug_special1()<<2,-32768,32767));
+      oscBuf[8]->putSample(CLAMP(fmChan[8]->debug_special1()<<2,-32768,32767));
+      oscBuf[9]->putSample(CLAMP(fmChan[8]->debug_special2()<<2,-32768,32767));
+      oscBuf[10]->putSample(CLAMP(fmChan[7]->debug_special2()<<2,-32768,32767));
     } else {
       for (int i=0; i<9; i++) {
-        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767);
+        oscBuf[i]->putSample(CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767));
       }
     }
   }
@@ -405,18 +405,18 @@ void DivPlatformOPL::acquire_ymfm8950(short** buf, size_t len) {
 
     if (properDrums) {
       for (int i=0; i<7; i++) {
-        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767);
+        oscBuf[i]->putSample(CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767));
       }
-      oscBuf[7]->data[oscBuf[7]->needle++]=CLAMP(fmChan[7]->debug_special1()<<2,-32768,32767);
-      oscBuf[8]->data[oscBuf[8]->needle++]=CLAMP(fmChan[8]->debug_special1()<<2,-32768,32767);
-      oscBuf[9]->data[oscBuf[9]->needle++]=CLAMP(fmChan[8]->debug_special2()<<2,-32768,32767);
-      oscBuf[10]->data[oscBuf[10]->needle++]=CLAMP(fmChan[7]->debug_special2()<<2,-32768,32767);
-      oscBuf[11]->data[oscBuf[11]->needle++]=CLAMP(abe->get_last_out(0),-32768,32767);
+      oscBuf[7]->putSample(CLAMP(fmChan[7]->debug_special1()<<2,-32768,32767));
+      oscBuf[8]->putSample(CLAMP(fmChan[8]->debug_special1()<<2,-32768,32767));
+      oscBuf[9]->putSample(CLAMP(fmChan[8]->debug_special2()<<2,-32768,32767));
+      oscBuf[10]->putSample(CLAMP(fmChan[7]->debug_special2()<<2,-32768,32767));
+      oscBuf[11]->putSample(CLAMP(abe->get_last_out(0),-32768,32767));
     } else {
       for (int i=0; i<9; i++) {
-        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767);
+        oscBuf[i]->putSample(CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767));
       }
-      oscBuf[9]->data[oscBuf[9]->needle++]=CLAMP(abe->get_last_out(0),-32768,32767);
+      oscBuf[9]->putSample(CLAMP(abe->get_last_out(0),-32768,32767));
     }
   }
 }
@@ -476,15 +476,15 @@ void DivPlatformOPL::acquire_ymfm3(short** buf, size_t len) {
           chOut=fmChan[ch]->debug_output(3);
         }
         if (i==15) {
-          oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(chOut,-32768,32767);
+          oscBuf[i]->putSample(CLAMP(chOut,-32768,32767));
         } else {
-          oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(chOut<<1,-32768,32767);
+          oscBuf[i]->putSample(CLAMP(chOut<<1,-32768,32767));
         }
       }
-      oscBuf[16]->data[oscBuf[16]->needle++]=CLAMP(fmChan[7]->debug_special2()<<1,-32768,32767);
-      oscBuf[17]->data[oscBuf[17]->needle++]=CLAMP(fmChan[8]->debug_special1()<<1,-32768,32767);
-      oscBuf[18]->data[oscBuf[18]->needle++]=CLAMP(fmChan[8]->debug_special2()<<1,-32768,32767);
-      oscBuf[19]->data[oscBuf[19]->needle++]=CLAMP(fmChan[7]->debug_special1()<<1,-32768,32767);
+      oscBuf[16]->putSample(CLAMP(fmChan[7]->debug_special2()<<1,-32768,32767));
+      oscBuf[17]->putSample(CLAMP(fmChan[8]->debug_special1()<<1,-32768,32767));
+      oscBuf[18]->putSample(CLAMP(fmChan[8]->debug_special2()<<1,-32768,32767));
+      oscBuf[19]->putSample(CLAMP(fmChan[7]->debug_special1()<<1,-32768,32767));
     } else {
       for (int i=0; i<18; i++) {
         unsigned char ch=outChanMap[i];
@@ -499,7 +499,7 @@ void DivPlatformOPL::acquire_ymfm3(short** buf, size_t len) {
         if (chOut==0) {
           chOut=fmChan[ch]->debug_output(3);
         }
-        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(chOut<<1,-32768,32767);
+        oscBuf[i]->putSample(CLAMP(chOut<<1,-32768,32767));
       }
     }
   }
@@ -637,7 +637,7 @@ void DivPlatformOPL::acquire_nukedLLE2(short** buf, size_t len) {
       }
       if (chOut[i]<-32768) chOut[i]=-32768;
       if (chOut[i]>32767) chOut[i]=32767;
-      oscBuf[i]->data[oscBuf[i]->needle++]=chOut[i];
+      oscBuf[i]->putSample(chOut[i]);
     }
 
     if (chipType==8950) {
@@ -647,9 +647,9 @@ void DivPlatformOPL::acquire_nukedLLE2(short** buf, size_t len) {
 
       if (!isMuted[adpcmChan]) {
         dacOut-=aOut.data[0]>>3;
-        oscBuf[adpcmChan]->data[oscBuf[adpcmChan]->needle++]=aOut.data[0]>>1;
+        oscBuf[adpcmChan]->putSample(aOut.data[0]>>1);
       } else {
-        oscBuf[adpcmChan]->data[oscBuf[adpcmChan]->needle++]=0;
+        oscBuf[adpcmChan]->putSample(0);
       }
     }
 
@@ -753,7 +753,7 @@ void DivPlatformOPL::acquire_nukedLLE3(short** buf, size_t len) {
       }
       if (chOut[i]<-32768) chOut[i]=-32768;
       if (chOut[i]>32767) chOut[i]=32767;
-      oscBuf[i]->data[oscBuf[i]->needle++]=chOut[i];
+      oscBuf[i]->putSample(chOut[i]);
     }
 
     for (int i=0; i<MIN(4,totalOutputs); i++) {
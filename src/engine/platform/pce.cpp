@@ -102,7 +102,7 @@ void DivPlatformPCE::acquire(short** buf, size_t len) {
     pce->ResetTS(0);
 
     for (int i=0; i<6; i++) {
-      oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(pce->channel[i].blip_prev_samp[0]+pce->channel[i].blip_prev_samp[1],-32768,32767);
+      oscBuf[i]->putSample(CLAMP(pce->channel[i].blip_prev_samp[0]+pce->channel[i].blip_prev_samp[1],-32768,32767));
     }
 
     tempL[0]=(tempL[0]>>1)+(tempL[0]>>2);
@@ -607,6 +607,35 @@ void DivPlatformPCE::notifyInsDeletion(void* ins) {
   }
 }
 
+void* DivPlatformPCE::getState() {
+  State* s=new State;
+  for (int i=0; i<6; i++) {
+    s->chan[i]=chan[i];
+  }
+  s->lastPan=lastPan;
+  s->sampleBank=sampleBank;
+  s->lfoMode=lfoMode;
+  s->lfoSpeed=lfoSpeed;
+  s->updateLFO=updateLFO;
+  return s;
+}
+
+void DivPlatformPCE::setState(void* state) {
+  State* s=(State*)state;
+  for (int i=0; i<6; i++) {
+    chan[i]=s->chan[i];
+  }
+  lastPan=s->lastPan;
+  sampleBank=s->sampleBank;
+  lfoMode=s->lfoMode;
+  lfoSpeed=s->lfoSpeed;
+  updateLFO=s->updateLFO;
+}
+
+void DivPlatformPCE::freeState(void* state) {
+  delete (State*)state;
+}
+
 void DivPlatformPCE::setFlags(const DivConfig& flags) {
   if (flags.getInt("clockSel",0)) { // technically there is no PAL PC Engine but oh well...
     chipClock=COLOR_PAL*4.0/5.0;
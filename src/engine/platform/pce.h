@@ -67,6 +67,11 @@ class DivPlatformPCE: public DivDispatch {
   };
   FixedQueue<QueuedWrite,512> writes;
   unsigned char lastPan;
+  struct State {
+    Channel chan[6];
+    unsigned char lastPan, sampleBank, lfoMode, lfoSpeed;
+    bool updateLFO;
+  };
 
   int cycles, curChan, delay;
   int tempL[32];
@@ -98,6 +103,9 @@ class DivPlatformPCE: public DivDispatch {
     void setFlags(const DivConfig& flags);
     void notifyWaveChange(int wave);
     void notifyInsDeletion(void* ins);
+    void* getState();
+    void setState(void* state);
+    void freeState(void* state);
     void poke(unsigned int addr, unsigned short val);
     void poke(std::vector<DivRegWrite>& wlist);
     const char** getRegisterSheet();
@@ -33,7 +33,7 @@ void DivPlatformPCMDAC::acquire(short** buf, size_t len) {
     if (!chan[0].active) {
       buf[0][h]=0;
       buf[1][h]=0;
-      oscBuf->data[oscBuf->needle++]=0;
+      oscBuf->putSample(0);
       continue;
     }
     if (chan[0].useWave || (chan[0].sample>=0 && chan[0].sample<parent->song.sampleLen)) {
@@ -229,7 +229,7 @@ void DivPlatformPCMDAC::acquire(short** buf, size_t len) {
     } else {
       output=output*chan[0].vol*chan[0].envVol/16384;
     }
-    oscBuf->data[oscBuf->needle++]=((output>>depthScale)<<depthScale)>>1;
+    oscBuf->putSample(((output>>depthScale)<<depthScale)>>1);
     if (outStereo) {
       buf[0][h]=((output*chan[0].panL)>>(depthScale+8))<<depthScale;
       buf[1][h]=((output*chan[0].panR)>>(depthScale+8))<<depthScale;
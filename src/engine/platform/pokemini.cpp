@@ -103,10 +103,10 @@ void DivPlatformPokeMini::acquire(short** buf, size_t len) {
     if (on) {
       out=(pos>=pivot && !isMuted[0])?volTable[vol&3]:0;
       buf[0][i]=out;
-      oscBuf->data[oscBuf->needle++]=out;
+      oscBuf->putSample(out);
     } else {
       buf[0][i]=0;
-      oscBuf->data[oscBuf->needle++]=0;
+      oscBuf->putSample(0);
     }
   }
 }
@@ -274,7 +274,7 @@ void DivPlatformQSound::acquire(short** buf, size_t len) {
       int data=chip.voice_output[i]<<1;
       if (data<-32768) data=-32768;
       if (data>32767) data=32767;
-      oscBuf[i]->data[oscBuf[i]->needle++]=data;
+      oscBuf[i]->putSample(data);
     }
   }
 }
@@ -60,10 +60,12 @@ void DivPlatformSMS::poolWrite(unsigned short a, unsigned char v) {
   }
 }
 
-void DivPlatformSMS::acquire_nuked(short** buf, size_t len) {
+void DivPlatformSMS::acquire_nuked(short** buf, size_t len, std::vector<DivDelayedWrite>* wlist) {
   int oL=0;
   int oR=0;
+  size_t wlistPos=0;
   for (size_t h=0; h<len; h++) {
+    PUT_DUE_WRITES(h);
     if (!writes.empty()) {
       QueuedWrite w=writes.front();
       if (w.addr==0) {
@@ -101,28 +103,31 @@ void DivPlatformSMS::acquire_nuked(short** buf, size_t len) {
     if (stereo) buf[1][h]=oR;
     for (int i=0; i<4; i++) {
       if (isMuted[i]) {
-        oscBuf[i]->data[oscBuf[i]->needle++]=0;
+        oscBuf[i]->putSample(0);
       } else {
-        oscBuf[i]->data[oscBuf[i]->needle++]=sn_nuked.vol_table[sn_nuked.volume_out[i]]*3;
+        oscBuf[i]->putSample(sn_nuked.vol_table[sn_nuked.volume_out[i]]*3);
       }
     }
   }
+  PUT_DUE_WRITES(len);
 }
 
-void DivPlatformSMS::acquire_mame(short** buf, size_t len) {
-  while (!writes.empty()) {
-    QueuedWrite w=writes.front();
-    if (stereo && (w.addr==1))
-      sn->stereo_w(w.val);
-    else if (w.addr==0) {
-      sn->write(w.val);
-    }
+void DivPlatformSMS::acquire_mame(short** buf, size_t len, std::vector<DivDelayedWrite>* wlist) {
+  size_t wlistPos=0;
+  for (size_t h=0; h<len; h++) {
+    PUT_DUE_WRITES(h);
+    while (!writes.empty()) {
+      QueuedWrite w=writes.front();
+      if (stereo && (w.addr==1))
+        sn->stereo_w(w.val);
+      else if (w.addr==0) {
+        sn->write(w.val);
+      }
 
-    poolWrite(w.addr,w.val);
+      poolWrite(w.addr,w.val);
 
-    writes.pop();
-  }
-  for (size_t h=0; h<len; h++) {
+      writes.pop();
+    }
     short* outs[2]={
       &buf[0][h],
       stereo?(&buf[1][h]):NULL
@@ -130,19 +135,28 @@ void DivPlatformSMS::acquire_mame(short** buf, size_t len) {
     sn->sound_stream_update(outs,1);
     for (int i=0; i<4; i++) {
       if (isMuted[i]) {
-        oscBuf[i]->data[oscBuf[i]->needle++]=0;
+        oscBuf[i]->putSample(0);
       } else {
-        oscBuf[i]->data[oscBuf[i]->needle++]=sn->get_channel_output(i)*3;
+        oscBuf[i]->putSample(sn->get_channel_output(i)*3);
       }
     }
   }
+  PUT_DUE_WRITES(len);
 }
 
 void DivPlatformSMS::acquire(short** buf, size_t len) {
   if (nuked) {
-    acquire_nuked(buf,len);
+    acquire_nuked(buf,len,NULL);
   } else {
-    acquire_mame(buf,len);
+    acquire_mame(buf,len,NULL);
+  }
+}
+
+void DivPlatformSMS::acquireWithWrites(short** buf, size_t len, std::vector<DivDelayedWrite>& wlist) {
+  if (nuked) {
+    acquire_nuked(buf,len,&wlist);
+  } else {
+    acquire_mame(buf,len,&wlist);
   }
 }
 
@@ -519,6 +533,33 @@ void DivPlatformSMS::notifyInsDeletion(void* ins) {
   }
 }
 
+void* DivPlatformSMS::getState() {
+  State* s=new State;
+  for (int i=0; i<4; i++) {
+    s->chan[i]=chan[i];
+  }
+  s->lastPan=lastPan;
+  s->oldValue=oldValue;
+  s->snNoiseMode=snNoiseMode;
+  s->updateSNMode=updateSNMode;
+  return s;
+}
+
+void DivPlatformSMS::setState(void* state) {
+  State* s=(State*)state;
+  for (int i=0; i<4; i++) {
+    chan[i]=s->chan[i];
+  }
+  lastPan=s->lastPan;
+  oldValue=s->oldValue;
+  snNoiseMode=s->snNoiseMode;
+  updateSNMode=s->updateSNMode;
+}
+
+void DivPlatformSMS::freeState(void* state) {
+  delete (State*)state;
+}
+
 void DivPlatformSMS::poke(unsigned int addr, unsigned short val) {
   rWrite(addr,val);
 }
@@ -527,6 +568,22 @@ void DivPlatformSMS::poke(std::vector<DivRegWrite>& wlist) {
   for (DivRegWrite& i: wlist) rWrite(i.addr,i.val);
 }
 
+bool DivPlatformSMS::canDeferWrites() {
+  return true;
+}
+
+void DivPlatformSMS::takeWrites(std::vector<DivDelayedWrite>& wlist, int time) {
+  while (!writes.empty()) {
+    QueuedWrite& w=writes.front();
+    wlist.push_back(DivDelayedWrite(time,w.addr,w.val));
+    writes.pop();
+  }
+}
+
+void DivPlatformSMS::putWrite(unsigned int addr, unsigned int val) {
+  writes.push(QueuedWrite(addr,val));
+}
+
 void DivPlatformSMS::setFlags(const DivConfig& flags) {
   switch (flags.getInt("clockSel",0)) {
     case 1:
@@ -63,6 +63,11 @@ class DivPlatformSMS: public DivDispatch {
     QueuedWrite(unsigned short a, unsigned char v): addr(a), val(v), addrOrVal(false) {}
   };
   FixedQueue<QueuedWrite,128> writes;
+  struct State {
+    Channel chan[4];
+    unsigned char lastPan, oldValue, snNoiseMode;
+    bool updateSNMode;
+  };
   friend void putDispatchChip(void*,int);
   friend void putDispatchChan(void*,int,int);
 
@@ -70,10 +75,11 @@ class DivPlatformSMS: public DivDispatch {
   int snCalcFreq(int ch);
   void poolWrite(unsigned short a, unsigned char v);
 
-  void acquire_nuked(short** buf, size_t len);
-  void acquire_mame(short** buf, size_t len);
+  void acquire_nuked(short** buf, size_t len, std::vector<DivDelayedWrite>* wlist);
+  void acquire_mame(short** buf, size_t len, std::vector<DivDelayedWrite>* wlist);
   public:
     void acquire(short** buf, size_t len);
+    void acquireWithWrites(short** buf, size_t len, std::vector<DivDelayedWrite>& wlist);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
     DivMacroInt* getChanMacroInt(int ch);
@@ -93,8 +99,14 @@ class DivPlatformSMS: public DivDispatch {
     int getPortaFloor(int ch);
     void setFlags(const DivConfig& flags);
     void notifyInsDeletion(void* ins);
+    void* getState();
+    void setState(void* state);
+    void freeState(void* state);
     void poke(unsigned int addr, unsigned short val);
     void poke(std::vector<DivRegWrite>& wlist);
+    bool canDeferWrites();
+    void takeWrites(std::vector<DivDelayedWrite>& wlist, int time);
+    void putWrite(unsigned int addr, unsigned int val);
     const char** getRegisterSheet();
     void setNuked(bool value);
     int init(DivEngine* parent, int channels, int sugRate, const DivConfig& flags);
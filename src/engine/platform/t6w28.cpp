@@ -35,8 +35,10 @@ const char** DivPlatformT6W28::getRegisterSheet() {
   return regCheatSheetT6W28;
 }
 
-void DivPlatformT6W28::acquire(short** buf, size_t len) {
+void DivPlatformT6W28::acquire_internal(short** buf, size_t len, std::vector<DivDelayedWrite>* wlist) {
+  size_t wlistPos=0;
   for (size_t h=0; h<len; h++) {
+    PUT_DUE_WRITES(h);
     cycles=0;
     while (!writes.empty() && cycles<16) {
       QueuedWrite w=writes.front();
@@ -54,7 +56,7 @@ void DivPlatformT6W28::acquire(short** buf, size_t len) {
     tempL=0;
     tempR=0;
     for (int i=0; i<4; i++) {
-      oscBuf[i]->data[oscBuf[i]->needle++]=(out[i][1].curValue+out[i][2].curValue)<<7;
+      oscBuf[i]->putSample((out[i][1].curValue+out[i][2].curValue)<<7);
       tempL+=out[i][1].curValue<<7;
       tempR+=out[i][2].curValue<<7;
     }
@@ -67,6 +69,15 @@ void DivPlatformT6W28::acquire(short** buf, size_t len) {
     buf[0][h]=tempL;
     buf[1][h]=tempR;
   }
+  PUT_DUE_WRITES(len);
+}
+
+void DivPlatformT6W28::acquire(short** buf, size_t len) {
+  acquire_internal(buf,len,NULL);
+}
+
+void DivPlatformT6W28::acquireWithWrites(short** buf, size_t len, std::vector<DivDelayedWrite>& wlist) {
+  acquire_internal(buf,len,&wlist);
 }
 
 void DivPlatformT6W28::writeOutVol(int ch) {
@@ -386,6 +397,22 @@ void DivPlatformT6W28::poke(std::vector<DivRegWrite>& wlist) {
   for (DivRegWrite& i: wlist) rWrite(i.addr,i.val);
 }
 
+bool DivPlatformT6W28::canDeferWrites() {
+  return true;
+}
+
+void DivPlatformT6W28::takeWrites(std::vector<DivDelayedWrite>& wlist, int time) {
+  while (!writes.empty()) {
+    QueuedWrite& w=writes.front();
+    wlist.push_back(DivDelayedWrite(time,w.addr,w.val));
+    writes.pop();
+  }
+}
+
+void DivPlatformT6W28::putWrite(unsigned int addr, unsigned int val) {
+  writes.push(QueuedWrite(addr,val));
+}
+
 int DivPlatformT6W28::init(DivEngine* p, int channels, int sugRate, const DivConfig& flags) {
   parent=p;
   dumpWrites=false;
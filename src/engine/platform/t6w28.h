@@ -58,8 +58,10 @@ class DivPlatformT6W28: public DivDispatch {
   int snCalcFreq(int ch);
   
   void writeOutVol(int ch);
+  void acquire_internal(short** buf, size_t len, std::vector<DivDelayedWrite>* wlist);
   public:
     void acquire(short** buf, size_t len);
+    void acquireWithWrites(short** buf, size_t len, std::vector<DivDelayedWrite>& wlist);
     int dispatch(DivCommand c);
     void* getChanState(int chan);
     DivMacroInt* getChanMacroInt(int ch);
@@ -78,6 +80,9 @@ class DivPlatformT6W28: public DivDispatch {
     void notifyInsDeletion(void* ins);
     void poke(unsigned int addr, unsigned short val);
     void poke(std::vector<DivRegWrite>& wlist);
+    bool canDeferWrites();
+    void takeWrites(std::vector<DivDelayedWrite>& wlist, int time);
+    void putWrite(unsigned int addr, unsigned int val);
     const char** getRegisterSheet();
     int init(DivEngine* parent, int channels, int sugRate, const DivConfig& flags);
     void quit();
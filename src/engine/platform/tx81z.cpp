@@ -57,12 +57,14 @@ const char** DivPlatformTX81Z::getRegisterSheet() {
   return regCheatSheetOPZ;
 }
 
-void DivPlatformTX81Z::acquire(short** buf, size_t len) {
+void DivPlatformTX81Z::acquire_internal(short** buf, size_t len, std::vector<DivDelayedWrite>* wlist) {
   thread_local int os[2];
+  size_t wlistPos=0;
 
   ymfm::ym2414::fm_engine* fme=fm_ymfm->debug_engine();
 
   for (size_t h=0; h<len; h++) {
+    PUT_DUE_WRITES(h);
     os[0]=0; os[1]=0;
     if (!writes.empty()) {
       if (--delay<1) {
@@ -78,7 +80,7 @@ void DivPlatformTX81Z::acquire(short** buf, size_t len) {
     fm_ymfm->generate(&out_ymfm);
 
     for (int i=0; i<8; i++) {
-      oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fme->debug_channel(i)->debug_output(0)+fme->debug_channel(i)->debug_output(1),-32768,32767);
+      oscBuf[i]->putSample(CLAMP(fme->debug_channel(i)->debug_output(0)+fme->debug_channel(i)->debug_output(1),-32768,32767));
     }
 
     os[0]=out_ymfm.data[0];
@@ -92,6 +94,19 @@ void DivPlatformTX81Z::acquire(short** buf, size_t len) {
     buf[0][h]=os[0];
     buf[1][h]=os[1];
   }
+  PUT_DUE_WRITES(len);
+}
+
+void DivPlatformTX81Z::acquire(short** buf, size_t len) {
+  acquire_internal(buf,len,NULL);
+}
+
+void DivPlatformTX81Z::acquireWithWrites(short** buf, size_t len, std::vector<DivDelayedWrite>& wlist) {
+  acquire_internal(buf,len,&wlist);
+}
+
+bool DivPlatformTX81Z::canDeferWrites() {
+  return true;
 }
 
 static unsigned char noteMap[12]={
@@ -58,10 +58,13 @@ class DivPlatformTX81Z: public DivPlatformOPM {
     int octave(int freq);
     int toFreq(int freq);
     void commitState(int ch, DivInstrument* ins);
+    void acquire_internal(short** buf, size_t len, std::vector<DivDelayedWrite>* wlist);
 
     friend void putDispatchChip(void*,int);
   public:
     void acquire(short** buf, size_t len);
+    void acquireWithWrites(short** buf, size_t len, std::vector<DivDelayedWrite>& wlist);
+    bool canDeferWrites();
     int dispatch(DivCommand c);
     void* getChanState(int chan);
     DivMacroInt* getChanMacroInt(int ch);
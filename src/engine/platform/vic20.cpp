@@ -69,7 +69,7 @@ void DivPlatformVIC20::acquire(short** buf, size_t len) {
     vic_sound_machine_calculate_samples(vic,&samp,1,1,0,SAMP_DIVIDER);
     buf[0][h]=samp;
     for (int i=0; i<4; i++) {
-      oscBuf[i]->data[oscBuf[i]->needle++]=vic->ch[i].out?(vic->volume<<11):0;
+      oscBuf[i]->putSample(vic->ch[i].out?(vic->volume<<11):0);
     }
   }
 }
@@ -47,11 +47,11 @@ void DivPlatformZXBeeperQuadTone::acquire(short** buf, size_t len) {
       }
       curSamplePeriod+=40;
       if ((outputClock&3)==0) {
-        oscBuf[0]->data[oscBuf[0]->needle++]=0;
-        oscBuf[1]->data[oscBuf[1]->needle++]=0;
-        oscBuf[2]->data[oscBuf[2]->needle++]=0;
-        oscBuf[3]->data[oscBuf[3]->needle++]=0;
-        oscBuf[4]->data[oscBuf[4]->needle++]=o?32767:0;
+        oscBuf[0]->putSample(0);
+        oscBuf[1]->putSample(0);
+        oscBuf[2]->putSample(0);
+        oscBuf[3]->putSample(0);
+        oscBuf[4]->putSample(o?32767:0);
       }
     } else {
       int ch=outputClock/2;
@@ -62,10 +62,10 @@ void DivPlatformZXBeeperQuadTone::acquire(short** buf, size_t len) {
         if (isMuted[ch]) chan[ch].out=0;
       }
       if ((outputClock&3)==0) {
-        oscBuf[4]->data[oscBuf[4]->needle++]=0;
+        oscBuf[4]->putSample(0);
       }
       o=chan[ch].out&0x10;
-      oscBuf[ch]->data[oscBuf[ch]->needle++]=o?32767:0;
+      oscBuf[ch]->putSample(o?32767:0);
       chan[ch].out<<=1;
 
       // if muted, ztill run sample
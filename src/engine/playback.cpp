@@ -23,6 +23,7 @@
 #include "dispatch.h"
 #include "engine.h"
 #include "workPool.h"
+#include "mixer.h"
 #include "../ta-log.h"
 #include <math.h>
 
@@ -1332,6 +1333,7 @@ void DivEngine::nextRow() {
 bool DivEngine::nextTick(bool noAccum, bool inhibitLowLat) {
   bool ret=false;
   if (divider<1) divider=1;
+  freqCache.trim();
 
   if (lowLatency && !skipping && !inhibitLowLat) {
     tickMult=1000/divider;
@@ -1606,9 +1608,7 @@ bool DivEngine::nextTick(bool noAccum, bool inhibitLowLat) {
     for (int i=0; i<chans; i++) {
       DivDispatchOscBuffer* buf=disCont[dispatchOfChan[i]].dispatch->getOscBuffer(dispatchChanOfChan[i]);
       if (buf!=NULL) {
-        memset(buf->data,0,65536*sizeof(short));
-        buf->needle=0;
-        buf->readNeedle=0;
+        buf->clear();
       }
     }
     return ret;
@@ -1793,7 +1793,7 @@ void _runDispatch2(void* d) {
 
 }
 
-void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsigned int size) {
+void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsigned int size, bool realTime) {
   lastNBIns=inChans;
   lastNBOuts=outChans;
   lastNBSize=size;
@@ -1810,17 +1810,27 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
     }
   }
 
-  if (softLocked) {
+  if (realTime) {
+    lastAudioBufTime=std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    // never wait here. edits are handed to us (see synchronized()), so the
+    // lock is only held elsewhere while the song or its chips are replaced.
     if (!isBusy.try_lock()) {
-      logV("audio is soft-locked (%d)",softLockCount++);
+      logV("audio is suspended (%d)",softLockCount++);
+      profiler.softLocks++;
       return;
     }
   } else {
     isBusy.lock();
   }
+  exclusiveThread=std::this_thread::get_id();
   got.bufsize=size;
 
+  // messages first, as they were posted before any pending edit
+  applyMessages();
+  runPendingEdit();
+
   std::chrono::steady_clock::time_point ts_processBegin=std::chrono::steady_clock::now();
+  profiler.begin();
 
   if (renderPool==NULL) {
     unsigned int howManyThreads=song.systemLen;
@@ -1878,6 +1888,7 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
     //logD("%.2x",msg.type);
     output->midiIn->queue.pop();
   }
+  profiler.mark(DIV_PROF_MIDI);
   
   // process sample/wave preview
   if ((sPreview.sample>=0 && sPreview.sample<(int)song.sample.size()) || (sPreview.wave>=0 && sPreview.wave<(int)song.wave.size())) {
@@ -2026,11 +2037,18 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
     memset(samp_bbOut,0,size*sizeof(short));
   }
 
+  profiler.mark(DIV_PROF_PREVIEW);
+
   // process audio
   bool mustPlay=playing && !halted;
   if (mustPlay) {
     // logic starts here
+    bool allDeferred=true;
+    bool profile=profiler.enabled;
     for (int i=0; i<song.systemLen; i++) {
+      disCont[i].profile=profile;
+      disCont[i].profAcquire=0;
+      disCont[i].profFill=0;
       // TODO: we may have a problem here
       disCont[i].lastAvail=blip_samples_avail(disCont[i].bb[0]);
       if (disCont[i].lastAvail>0) {
@@ -2047,6 +2065,17 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
       }
       disCont[i].runLeft=disCont[i].runtotal;
       disCont[i].runPos=0;
+
+      // in batch mode, chips which support it get rendered after all ticks have run
+      disCont[i].deferred=renderPoolBatch && disCont[i].dispatch->canDeferWrites();
+      if (disCont[i].deferred) {
+        // writes left over from a skipped buffer happen right away
+        for (DivDelayedWrite& j: disCont[i].deferredWrites) {
+          j.time=0;
+        }
+        disCont[i].dispatch->takeWrites(disCont[i].deferredWrites,0);
+      }
+      if (!disCont[i].deferred) allDeferred=false;
     }
 
     if (metroTickLen<size) {
@@ -2071,6 +2100,7 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
       // 2. check whether we gonna tick
       if (cycles<=0) {
         // we have to tick
+        profiler.mark(DIV_PROF_RENDER);
         if (nextTick()) {
           /*totalTicks=0;
           totalSeconds=0;*/
@@ -2089,12 +2119,17 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
             }
           }
         }
+        profiler.addTick(profiler.mark(DIV_PROF_TICK),curOrder,curRow);
         if (pendingMetroTick) {
           unsigned int realPos=size-(runLeftG>>MASTER_CLOCK_PREC);
           if (realPos>=size) realPos=size-1;
           metroTick[realPos]=pendingMetroTick;
           pendingMetroTick=0;
         }
+        for (int i=0; i<song.systemLen; i++) {
+          if (!disCont[i].deferred) continue;
+          disCont[i].dispatch->takeWrites(disCont[i].deferredWrites,disCont[i].runPos);
+        }
       } else {
         // 3. run MIDI clock
         int midiTotal=MIN(cycles,runLeftG);
@@ -2108,6 +2143,13 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
           for (int i=0; i<song.systemLen; i++) {
             disCont[i].cycles=cycles;
             disCont[i].size=size;
+            if (disCont[i].deferred) {
+              // just advance. the chip is rendered after all ticks
+              int total=(disCont[i].cycles*disCont[i].runtotal)/(disCont[i].size<<MASTER_CLOCK_PREC);
+              disCont[i].runLeft-=total;
+              disCont[i].runPos+=total;
+              continue;
+            }
             renderPool->push([](void* d) {
               DivDispatchContainer* dc=(DivDispatchContainer*)d;
               int total=(dc->cycles*dc->runtotal)/(dc->size<<MASTER_CLOCK_PREC);
@@ -2116,45 +2158,76 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
               dc->runPos+=total;
             },&disCont[i]);
           }
-          renderPool->wait();
+          if (!allDeferred) renderPool->wait();
           runLeftG-=cycles;
           cycles=0;
         } else {
           cycles-=runLeftG;
           runLeftG=0;
           for (int i=0; i<song.systemLen; i++) {
+            if (disCont[i].deferred) {
+              disCont[i].runPos+=disCont[i].runLeft;
+              disCont[i].runLeft=0;
+              continue;
+            }
             renderPool->push([](void* d) {
               DivDispatchContainer* dc=(DivDispatchContainer*)d;
               dc->acquire(dc->runPos,dc->runLeft);
               dc->runLeft=0;
             },&disCont[i]);
           }
-          renderPool->wait();
+          if (!allDeferred) renderPool->wait();
         }
       }
     }
 
+    profiler.mark(DIV_PROF_RENDER);
+
     //logD("attempts: %d",attempts);
     if (attempts>=(int)(size+10)) {
       logE("hang detected! stopping! at %d seconds %d micro (%d>=%d)",totalSeconds,totalTicks,attempts,(int)size);
+      profiler.hangs++;
       freelance=false;
       playing=false;
       extValuePresent=false;
     }
     totalProcessed=size-(runLeftG>>MASTER_CLOCK_PREC);
 
+    // deferred chips are rendered here, all at once
+    bool anyDeferred=false;
     for (int i=0; i<song.systemLen; i++) {
       if (size<disCont[i].lastAvail) {
         logW("%d: size<lastAvail! %d<%d",i,size,disCont[i].lastAvail);
         continue;
       }
       disCont[i].size=size;
+      if (!disCont[i].deferred) continue;
+      renderPool->push([](void* d) {
+        DivDispatchContainer* dc=(DivDispatchContainer*)d;
+        dc->acquireDeferred(dc->runPos);
+      },&disCont[i]);
+      anyDeferred=true;
+    }
+    if (anyDeferred) {
+      renderPool->wait();
+      profiler.mark(DIV_PROF_RENDER);
+    }
+
+    for (int i=0; i<song.systemLen; i++) {
+      if (size<disCont[i].lastAvail) continue;
       renderPool->push([](void* d) {
         DivDispatchContainer* dc=(DivDispatchContainer*)d;
         dc->fillBuf(dc->runtotal,dc->lastAvail,dc->size-dc->lastAvail);
       },&disCont[i]);
     }
     renderPool->wait();
+    profiler.mark(DIV_PROF_FILL);
+
+    if (profile) {
+      for (int i=0; i<song.systemLen; i++) {
+        profiler.addChip(i,disCont[i].profAcquire,disCont[i].profFill);
+      }
+    }
   }
 
   // process metronome
@@ -2226,20 +2299,14 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
               break;
           }
 
-          for (size_t j=0; j<size; j++) {
-            out[destSubPort][j]+=((float)disCont[srcPortSet].bbOut[srcSubPort][j]/32768.0)*vol;
-          }
+          DivMixer::addShort(out[destSubPort],disCont[srcPortSet].bbOut[srcSubPort],vol/32768.0f,size);
         }
       } else if (srcPortSet==0xffd) {
         // sample preview
-        for (size_t j=0; j<size; j++) {
-          out[destSubPort][j]+=previewVol*(samp_bbOut[j]/32768.0);
-        }
+        DivMixer::addShort(out[destSubPort],samp_bbOut,previewVol/32768.0f,size);
       } else if (srcPortSet==0xffe && playing && !halted) {
         // metronome
-        for (size_t j=0; j<size; j++) {
-          out[destSubPort][j]+=metroBuf[j];
-        }
+        DivMixer::addFloat(out[destSubPort],metroBuf,size);
       }
 
       // nothing/invalid
@@ -2248,39 +2315,22 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
     // nothing/invalid
   }
 
+  profiler.mark(DIV_PROF_MIX);
+
   // dump to oscillator buffer
-  for (unsigned int i=0; i<size; i++) {
-    for (int j=0; j<outChans; j++) {
-      if (oscBuf[j]==NULL) continue;
-      oscBuf[j][oscWritePos]=out[j][i];
-    }
-    if (++oscWritePos>=32768) oscWritePos=0;
+  for (int j=0; j<outChans; j++) {
+    if (oscBuf[j]==NULL) continue;
+    DivMixer::copyToRing(oscBuf[j],32768,oscWritePos,out[j],size);
   }
+  oscWritePos=(oscWritePos+size)&32767;
   oscSize=size;
+  profiler.mark(DIV_PROF_OSC);
 
-  // force mono audio (if enabled)
-  if (forceMono && outChans>1) {
-    for (size_t i=0; i<size; i++) {
-      float chanSum=out[0][i];
-      for (int j=1; j<outChans; j++) {
-        chanSum+=out[j][i];
-      }
-      out[0][i]=chanSum/outChans;
-      for (int j=1; j<outChans; j++) {
-        out[j][i]=out[0][i];
-      }
-    }
-  }
-
-  // clamp output (if enabled)
-  if (clampSamples) {
-    for (size_t i=0; i<size; i++) {
-      for (int j=0; j<outChans; j++) {
-        if (out[j][i]<-1.0) out[j][i]=-1.0;
-        if (out[j][i]>1.0) out[j][i]=1.0;
-      }
-    }
-  }
+  // force mono audio and clamp output (if enabled)
+  DivMixer::finish(out,outChans,size,forceMono,clampSamples);
+  profiler.mark(DIV_PROF_MIX);
+  profiler.end(got.rate>0?(1000000000.0*(double)size/(double)got.rate):0.0);
+  exclusiveThread=std::thread::id();
   isBusy.unlock();
 
   std::chrono::steady_clock::time_point ts_processEnd=std::chrono::steady_clock::now();
@@ -0,0 +1,229 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2023 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "profiler.h"
+#include "../ta-log.h"
+#include <algorithm>
+#include <string.h>
+
+static const char* stageNames[DIV_PROF_MAX]={
+  "midi",
+  "preview",
+  "tick",
+  "render",
+  "fill",
+  "mix",
+  "osc",
+  "total"
+};
+
+void DivProfilerHistory::push(unsigned long long ns) {
+  if (ns>0xffffffff) ns=0xffffffff;
+  unsigned int p=pos.load(std::memory_order_relaxed);
+  samples[p].store((unsigned int)ns,std::memory_order_relaxed);
+  pos.store((p+1)%DIV_PROFILER_WINDOW,std::memory_order_relaxed);
+  if (count.load(std::memory_order_relaxed)<DIV_PROFILER_WINDOW) count.fetch_add(1,std::memory_order_relaxed);
+  total.fetch_add(ns,std::memory_order_relaxed);
+}
+
+DivProfilerStats DivProfilerHistory::getStats() {
+  DivProfilerStats ret;
+  unsigned int n=count.load(std::memory_order_relaxed);
+  if (n==0) return ret;
+
+  // the window is always filled from the start, so the first n samples are valid
+  std::vector<unsigned int> sorted;
+  sorted.reserve(n);
+  unsigned long long sum=0;
+  for (unsigned int i=0; i<n; i++) {
+    unsigned int s=samples[i].load(std::memory_order_relaxed);
+    sorted.push_back(s);
+    sum+=s;
+  }
+  std::sort(sorted.begin(),sorted.end());
+
+  ret.count=n;
+  ret.min=(double)sorted.front()/1000.0;
+  ret.max=(double)sorted.back()/1000.0;
+  ret.avg=(double)sum/(1000.0*(double)n);
+  ret.p99=(double)sorted[((size_t)n*99)/100]/1000.0;
+  return ret;
+}
+
+void DivProfilerHistory::reset() {
+  for (int i=0; i<DIV_PROFILER_WINDOW; i++) samples[i]=0;
+  pos=0;
+  count=0;
+  total=0;
+}
+
+void DivProfiler::begin() {
+  if (!enabled) return;
+  memset(cur,0,DIV_PROF_MAX*sizeof(unsigned long long));
+  memset(curChipAcquire,0,DIV_MAX_CHIPS*sizeof(unsigned long long));
+  memset(curChipFill,0,DIV_MAX_CHIPS*sizeof(unsigned long long));
+  curChips=0;
+  bufStart=std::chrono::steady_clock::now();
+  lastMark=bufStart;
+}
+
+void DivProfiler::addChip(int index, unsigned long long acquireTime, unsigned long long fillTime) {
+  if (!enabled) return;
+  if (index<0 || index>=DIV_MAX_CHIPS) return;
+  curChipAcquire[index]+=acquireTime;
+  curChipFill[index]+=fillTime;
+  if (curChips<=index) curChips=index+1;
+}
+
+void DivProfiler::addTick(unsigned long long time, int order, int row) {
+  if (!enabled) return;
+  tick.push(time);
+  if (time>slowestTick) {
+    slowestTick=time;
+    slowestTickOrder=order;
+    slowestTickRow=row;
+  }
+}
+
+void DivProfiler::end(double budget) {
+  if (!enabled) return;
+  cur[DIV_PROF_TOTAL]=std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-bufStart).count();
+  for (int i=0; i<DIV_PROF_MAX; i++) {
+    stage[i].push(cur[i]);
+  }
+  for (int i=0; i<curChips; i++) {
+    chipAcquire[i].push(curChipAcquire[i]);
+    chipFill[i].push(curChipFill[i]);
+  }
+  if (chips<curChips) chips=curChips;
+  buffers++;
+  if (budget>0.0 && (double)cur[DIV_PROF_TOTAL]>budget) overruns++;
+}
+
+void DivProfiler::reset() {
+  for (int i=0; i<DIV_PROF_MAX; i++) {
+    stage[i].reset();
+  }
+  for (int i=0; i<DIV_MAX_CHIPS; i++) {
+    chipAcquire[i].reset();
+    chipFill[i].reset();
+  }
+  tick.reset();
+  slowestTick=0;
+  slowestTickOrder=0;
+  slowestTickRow=0;
+  chips=0;
+  buffers=0;
+  overruns=0;
+  softLocks=0;
+  hangs=0;
+}
+
+static String jsonEscape(const String& s) {
+  String ret;
+  for (char c: s) {
+    if (c=='"' || c=='\\') {
+      ret+='\\';
+      ret+=c;
+    } else if ((unsigned char)c<0x20) {
+      ret+=fmt::sprintf("\\u%.4x",(int)c);
+    } else {
+      ret+=c;
+    }
+  }
+  return ret;
+}
+
+static String jsonStats(const DivProfilerStats& s) {
+  return fmt::sprintf("{\"count\": %u, \"min\": %.3f, \"avg\": %.3f, \"max\": %.3f, \"p99\": %.3f}",s.count,s.min,s.avg,s.max,s.p99);
+}
+
+String DivProfiler::toJSON(const std::vector<String>& chipNames) {
+  String ret="{\n";
+  ret+=fmt::sprintf("  \"buffers\": %llu,\n",(unsigned long long)buffers);
+  ret+=fmt::sprintf("  \"overruns\": %llu,\n",(unsigned long long)overruns);
+  ret+=fmt::sprintf("  \"softLocks\": %llu,\n",(unsigned long long)softLocks);
+  ret+=fmt::sprintf("  \"hangs\": %llu,\n",(unsigned long long)hangs);
+  ret+="  \"unit\": \"us\",\n";
+  ret+="  \"stages\": {\n";
+  for (int i=0; i<DIV_PROF_MAX; i++) {
+    ret+=fmt::sprintf("    \"%s\": %s%s\n",stageNames[i],jsonStats(stage[i].getStats()),(i<DIV_PROF_MAX-1)?",":"");
+  }
+  ret+="  },\n";
+  ret+=fmt::sprintf("  \"ticks\": %s,\n",jsonStats(tick.getStats()));
+  ret+=fmt::sprintf("  \"slowestTick\": {\"time\": %.3f, \"order\": %d, \"row\": %d},\n",(double)slowestTick/1000.0,(int)slowestTickOrder,(int)slowestTickRow);
+  ret+="  \"chips\": [\n";
+  int chipCount=chips;
+  for (int i=0; i<chipCount; i++) {
+    String name=(i<(int)chipNames.size())?chipNames[i]:"?";
+    ret+=fmt::sprintf("    {\"index\": %d, \"name\": \"%s\", \"acquire\": %s, \"fill\": %s}%s\n",i,jsonEscape(name),jsonStats(chipAcquire[i].getStats()),jsonStats(chipFill[i].getStats()),(i<chipCount-1)?",":"");
+  }
+  ret+="  ]\n";
+  ret+="}\n";
+  return ret;
+}
+
+static String csvStats(const String& name, const char* what, const DivProfilerStats& s) {
+  String quoted="\"";
+  for (char c: name) {
+    if (c=='"') quoted+='"';
+    quoted+=c;
+  }
+  quoted+="\"";
+  return fmt::sprintf("%s,%s,%u,%.3f,%.3f,%.3f,%.3f\n",quoted,what,s.count,s.min,s.avg,s.max,s.p99);
+}
+
+String DivProfiler::toCSV(const std::vector<String>& chipNames) {
+  String ret="name,stage,count,min_us,avg_us,max_us,p99_us\n";
+  for (int i=0; i<DIV_PROF_MAX; i++) {
+    ret+=csvStats("engine",stageNames[i],stage[i].getStats());
+  }
+  ret+=csvStats("engine","per_tick",tick.getStats());
+  int chipCount=chips;
+  for (int i=0; i<chipCount; i++) {
+    String name=fmt::sprintf("%d: %s",i,(i<(int)chipNames.size())?chipNames[i]:"?");
+    ret+=csvStats(name,"acquire",chipAcquire[i].getStats());
+    ret+=csvStats(name,"fill",chipFill[i].getStats());
+  }
+  ret+=fmt::sprintf("\"engine\",buffers,%llu,,,,\n",(unsigned long long)buffers);
+  ret+=fmt::sprintf("\"engine\",overruns,%llu,,,,\n",(unsigned long long)overruns);
+  ret+=fmt::sprintf("\"engine\",softLocks,%llu,,,,\n",(unsigned long long)softLocks);
+  ret+=fmt::sprintf("\"engine\",hangs,%llu,,,,\n",(unsigned long long)hangs);
+  ret+=fmt::sprintf("\"engine\",slowest_tick,1,%.3f,%.3f,%.3f,%.3f\n",(double)slowestTick/1000.0,(double)slowestTick/1000.0,(double)slowestTick/1000.0,(double)slowestTick/1000.0);
+  ret+=fmt::sprintf("\"engine\",slowest_tick_order,%d,,,,\n",(int)slowestTickOrder);
+  ret+=fmt::sprintf("\"engine\",slowest_tick_row,%d,,,,\n",(int)slowestTickRow);
+  return ret;
+}
+
+DivProfiler::DivProfiler():
+  curChips(0),
+  enabled(false),
+  chips(0),
+  slowestTick(0),
+  slowestTickOrder(0),
+  slowestTickRow(0),
+  buffers(0),
+  overruns(0),
+  softLocks(0),
+  hangs(0) {
+  memset(cur,0,DIV_PROF_MAX*sizeof(unsigned long long));
+  memset(curChipAcquire,0,DIV_MAX_CHIPS*sizeof(unsigned long long));
+  memset(curChipFill,0,DIV_MAX_CHIPS*sizeof(unsigned long long));
+}
@@ -0,0 +1,172 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2023 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef _PROFILER_H
+#define _PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include "defines.h"
+#include "../ta-utils.h"
+
+// how many buffers are kept for statistics
+#define DIV_PROFILER_WINDOW 1024
+
+enum DivProfilerStage {
+  DIV_PROF_MIDI=0, // MIDI input
+  DIV_PROF_PREVIEW, // sample/wave preview
+  DIV_PROF_TICK, // sequencer (nextTick)
+  DIV_PROF_RENDER, // chip rendering (wall time, including waiting for threads)
+  DIV_PROF_FILL, // blip_buf synthesis (fillBuf)
+  DIV_PROF_MIX, // metronome, patchbay and output stage
+  DIV_PROF_OSC, // oscilloscope capture
+  DIV_PROF_TOTAL, // the whole nextBuf() call
+
+  DIV_PROF_MAX
+};
+
+struct DivProfilerStats {
+  // number of buffers in the window
+  unsigned int count;
+  // in microseconds
+  double min, avg, max, p99;
+  DivProfilerStats():
+    count(0),
+    min(0.0),
+    avg(0.0),
+    max(0.0),
+    p99(0.0) {}
+};
+
+/**
+ * a rolling window of timings (in nanoseconds).
+ * written by the audio thread and read by any other.
+ */
+struct DivProfilerHistory {
+  std::atomic<unsigned int> samples[DIV_PROFILER_WINDOW];
+  std::atomic<unsigned int> pos;
+  std::atomic<unsigned int> count;
+  // sum of all samples since the last reset (not just the window)
+  std::atomic<unsigned long long> total;
+
+  void push(unsigned long long ns);
+  DivProfilerStats getStats();
+  void reset();
+  DivProfilerHistory():
+    pos(0),
+    count(0),
+    total(0) {
+    for (int i=0; i<DIV_PROFILER_WINDOW; i++) samples[i]=0;
+  }
+};
+
+/**
+ * per-stage and per-chip timing of nextBuf().
+ * does nothing until enabled.
+ *
+ * all the begin()/mark()/end() calls happen on the audio thread, with the engine lock held.
+ */
+class DivProfiler {
+  std::chrono::steady_clock::time_point bufStart, lastMark;
+  unsigned long long cur[DIV_PROF_MAX];
+  unsigned long long curChipAcquire[DIV_MAX_CHIPS];
+  unsigned long long curChipFill[DIV_MAX_CHIPS];
+  int curChips;
+
+  public:
+    std::atomic<bool> enabled;
+
+    DivProfilerHistory stage[DIV_PROF_MAX];
+    DivProfilerHistory chipAcquire[DIV_MAX_CHIPS];
+    DivProfilerHistory chipFill[DIV_MAX_CHIPS];
+    std::atomic<int> chips;
+    // one sample per tick rather than per buffer
+    DivProfilerHistory tick;
+    // the slowest tick since the last reset
+    std::atomic<unsigned long long> slowestTick;
+    std::atomic<int> slowestTickOrder, slowestTickRow;
+
+    // buffers processed
+    std::atomic<unsigned long long> buffers;
+    // buffers which took longer than their duration
+    std::atomic<unsigned long long> overruns;
+    // buffers dropped because the engine was soft-locked
+    std::atomic<unsigned long long> softLocks;
+    // playback stopped because of a hang
+    std::atomic<unsigned long long> hangs;
+
+    /**
+     * start timing a buffer.
+     */
+    void begin();
+
+    /**
+     * attribute the time since the last mark to a stage.
+     * @return the time in nanoseconds, or 0 if disabled.
+     */
+    inline unsigned long long mark(DivProfilerStage s) {
+      if (!enabled) return 0;
+      std::chrono::steady_clock::time_point now=std::chrono::steady_clock::now();
+      unsigned long long elapsed=std::chrono::duration_cast<std::chrono::nanoseconds>(now-lastMark).count();
+      cur[s]+=elapsed;
+      lastMark=now;
+      return elapsed;
+    }
+
+    /**
+     * record how long a single tick took.
+     * @param order the order being played.
+     * @param row the row being played.
+     */
+    void addTick(unsigned long long time, int order, int row);
+
+    /**
+     * add the time a chip took to the current buffer.
+     */
+    void addChip(int index, unsigned long long acquireTime, unsigned long long fillTime);
+
+    /**
+     * finish timing a buffer.
+     * @param budget the duration of the buffer in nanoseconds.
+     */
+    void end(double budget);
+
+    /**
+     * clear all statistics.
+     */
+    void reset();
+
+    /**
+     * get statistics as JSON.
+     * @param chipNames the name of each chip.
+     */
+    String toJSON(const std::vector<String>& chipNames);
+
+    /**
+     * get statistics as CSV (one row per stage or chip).
+     * @param chipNames the name of each chip.
+     */
+    String toCSV(const std::vector<String>& chipNames);
+
+    DivProfiler();
+};
+
+#endif
@@ -25,14 +25,19 @@ unsigned char* SafeWriter::getFinalBuf() {
   return buf;
 }
 
+// grows geometrically, so that building a large file doesn't copy the
+// buffer over and over again.
 void SafeWriter::checkSize(size_t amount) {
-  while ((curSeek+amount)>=bufLen) {
-    unsigned char* newBuf=new unsigned char[bufLen+WRITER_BUF_SIZE];
-    memcpy(newBuf,buf,bufLen);
-    delete[] buf;
-    buf=newBuf;
-    bufLen+=WRITER_BUF_SIZE;
+  if ((curSeek+amount)<bufLen) return;
+  size_t newLen=MAX(bufLen,(size_t)WRITER_BUF_SIZE);
+  while ((curSeek+amount)>=newLen) {
+    newLen<<=1;
   }
+  unsigned char* newBuf=new unsigned char[newLen];
+  memcpy(newBuf,buf,bufLen);
+  delete[] buf;
+  buf=newBuf;
+  bufLen=newLen;
 }
 
 bool SafeWriter::seek(ssize_t where, int whence) {
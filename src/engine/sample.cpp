@@ -27,6 +27,17 @@
 #endif
 #include "filter.h"
 #include "bsr.h"
+#include "workPool.h"
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#define SAMPLE_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#define SAMPLE_NEON
+#include <arm_neon.h>
+#endif
 
 extern "C" {
 #include "../../extern/adpcm/bs_codec.h"
@@ -557,6 +568,7 @@ bool DivSample::initInternal(DivSampleDepth d, int count) {
       memset(dataK,0,(lengthK+255)&(~0xff));
       break;
     case DIV_SAMPLE_DEPTH_8BIT: // 8-bit
+      invalidateSummary();
       if (data8!=NULL) delete[] data8;
       length8=count;
       // for padding X1-010 sample
@@ -588,6 +600,7 @@ bool DivSample::initInternal(DivSampleDepth d, int count) {
       memset(dataC219,0,(count+4095)&(~0xfff));
       break;
     case DIV_SAMPLE_DEPTH_16BIT: // 16-bit
+      invalidateSummary();
       if (data16!=NULL) delete[] data16;
       length16=count*2;
       data16=new short[(count+511)&(~0x1ff)];
@@ -889,39 +902,234 @@ bool DivSample::resampleNone(double sRate, double tRate) {
   return true;
 }
 
-bool DivSample::resampleLinear(double sRate, double tRate) {
-  RESAMPLE_BEGIN;
+// resampling helpers.
+// positions are 32.32 fixed-point and computed from the output index, which means
+// that any range of the output can be rendered on its own (and in parallel).
+#define RESAMPLE_ONE 4294967296.0
+// padding before/after the sample data (in samples) in the float input buffer
+#define RESAMPLE_PAD 16
+// only split resampling across threads for outputs longer than this
+#define RESAMPLE_PARALLEL_MIN 262144
+
+static inline unsigned long long resampleStep(double factor) {
+  return (unsigned long long)(factor*RESAMPLE_ONE+0.5);
+}
 
-  double posFrac=0;
-  unsigned int posInt=0;
-  double factor=sRate/tRate;
+// dot product of two float arrays. len must be a multiple of 4.
+static inline float resampleDot(const float* a, const float* b, int len) {
+#if defined(SAMPLE_SSE2)
+  __m128 sum=_mm_mul_ps(_mm_loadu_ps(a),_mm_loadu_ps(b));
+  for (int i=4; i<len; i+=4) {
+    sum=_mm_add_ps(sum,_mm_mul_ps(_mm_loadu_ps(&a[i]),_mm_loadu_ps(&b[i])));
+  }
+  __m128 shuf=_mm_shuffle_ps(sum,sum,_MM_SHUFFLE(2,3,0,1));
+  sum=_mm_add_ps(sum,shuf);
+  shuf=_mm_movehl_ps(shuf,sum);
+  sum=_mm_add_ss(sum,shuf);
+  return _mm_cvtss_f32(sum);
+#elif defined(SAMPLE_NEON)
+  float32x4_t sum=vmulq_f32(vld1q_f32(a),vld1q_f32(b));
+  for (int i=4; i<len; i+=4) {
+    sum=vmlaq_f32(sum,vld1q_f32(&a[i]),vld1q_f32(&b[i]));
+  }
+  float32x2_t half=vadd_f32(vget_low_f32(sum),vget_high_f32(sum));
+  return vget_lane_f32(vpadd_f32(half,half),0);
+#else
+  float sum=0;
+  for (int i=0; i<len; i++) {
+    sum+=a[i]*b[i];
+  }
+  return sum;
+#endif
+}
 
-  if (depth==DIV_SAMPLE_DEPTH_16BIT) {
-    for (int i=0; i<finalCount; i++) {
-      short s1=(posInt>=samples)?0:oldData16[posInt];
-      short s2=(posInt+1>=samples)?((loopStart>=0 && loopStart<(int)samples)?oldData16[loopStart]:0):oldData16[posInt+1];
+// dest[i]+=src[i]*k for 16 elements.
+static inline void resampleAxpy16(float* dest, const float* src, float k) {
+#if defined(SAMPLE_SSE2)
+  const __m128 kv=_mm_set1_ps(k);
+  for (int i=0; i<16; i+=4) {
+    _mm_storeu_ps(&dest[i],_mm_add_ps(_mm_loadu_ps(&dest[i]),_mm_mul_ps(_mm_loadu_ps(&src[i]),kv)));
+  }
+#elif defined(SAMPLE_NEON)
+  for (int i=0; i<16; i+=4) {
+    vst1q_f32(&dest[i],vaddq_f32(vld1q_f32(&dest[i]),vmulq_n_f32(vld1q_f32(&src[i]),k)));
+  }
+#else
+  for (int i=0; i<16; i++) {
+    dest[i]+=src[i]*k;
+  }
+#endif
+}
+
+// convert sample data to float, with RESAMPLE_PAD zeros on each side.
+template<typename T> static float* resampleInput(const T* data, unsigned int samples) {
+  float* ret=new float[samples+RESAMPLE_PAD*2];
+  memset(ret,0,RESAMPLE_PAD*sizeof(float));
+  for (unsigned int i=0; i<samples; i++) {
+    ret[RESAMPLE_PAD+i]=data[i];
+  }
+  memset(&ret[RESAMPLE_PAD+samples],0,RESAMPLE_PAD*sizeof(float));
+  return ret;
+}
+
+// run a resampling kernel over [0,count), splitting it across threads if it's long enough.
+template<typename K> static void resampleRun(int count, const K& kernel) {
+  unsigned int threads=std::thread::hardware_concurrency();
+  if (count<RESAMPLE_PARALLEL_MIN || threads<2) {
+    kernel(0,count);
+    return;
+  }
+
+  struct Chunk {
+    const K* kernel;
+    int start, end;
+  };
+  int chunkCount=threads*4;
+  int chunkSize=(count+chunkCount-1)/chunkCount;
+  std::vector<Chunk> chunks;
+  for (int i=0; i<count; i+=chunkSize) {
+    chunks.push_back(Chunk{&kernel,i,MIN(i+chunkSize,count)});
+  }
+  logV("resampling in %d chunks",(int)chunks.size());
+
+  DivWorkPool* pool=new DivWorkPool(threads);
+  for (Chunk& i: chunks) {
+    pool->push([](void* d) {
+      Chunk* c=(Chunk*)d;
+      (*c->kernel)(c->start,c->end);
+    },&i);
+  }
+  pool->wait();
+  delete pool;
+}
 
-      data16[i]=s1+(float)(s2-s1)*posFrac;
+template<typename T> static void resampleLinearKernel(T* out, const T* in, unsigned int samples, int loopStart, double factor, int count) {
+  const unsigned long long step=resampleStep(factor);
+  const short loopVal=(loopStart>=0 && loopStart<(int)samples)?in[loopStart]:0;
+  resampleRun(count,[&](int start, int end) {
+    for (int i=start; i<end; i++) {
+      unsigned long long pos=(unsigned long long)i*step;
+      unsigned int posInt=pos>>32;
+      double posFrac=(double)(unsigned int)pos/RESAMPLE_ONE;
+      short s1=(posInt>=samples)?0:in[posInt];
+      short s2=(posInt+1>=samples)?loopVal:in[posInt+1];
+
+      out[i]=s1+(float)(s2-s1)*posFrac;
+    }
+  });
+}
 
-      posFrac+=factor;
-      while (posFrac>=1.0) {
-        posFrac-=1.0;
-        posInt++;
+template<typename T> static void resampleCubicKernel(T* out, const T* in, unsigned int samples, int loopStart, double factor, int count) {
+  const unsigned long long step=resampleStep(factor);
+  const float loopVal=(loopStart>=0 && loopStart<(int)samples)?in[loopStart]:0;
+  const float minVal=std::numeric_limits<T>::min();
+  const float maxVal=std::numeric_limits<T>::max();
+  const float* cubicTable=DivFilterTables::getCubicTable();
+  float* inF=resampleInput(in,samples);
+
+  resampleRun(count,[&](int start, int end) {
+    for (int i=start; i<end; i++) {
+      unsigned long long pos=(unsigned long long)i*step;
+      unsigned int posInt=pos>>32;
+      const float* t=&cubicTable[((unsigned int)pos>>22)<<2];
+      float result;
+      if (posInt>=1 && posInt+2<samples) {
+        result=resampleDot(&inF[RESAMPLE_PAD+posInt-1],t,4);
+      } else {
+        float s0=(posInt<1)?0:in[posInt-1];
+        float s1=(posInt>=samples)?0:in[posInt];
+        float s2=(posInt+1>=samples)?loopVal:in[posInt+1];
+        float s3=(posInt+2>=samples)?loopVal:in[posInt+2];
+        result=s0*t[0]+s1*t[1]+s2*t[2]+s3*t[3];
       }
+      if (result<minVal) result=minVal;
+      if (result>maxVal) result=maxVal;
+      out[i]=result;
     }
-  } else if (depth==DIV_SAMPLE_DEPTH_8BIT) {
-    for (int i=0; i<finalCount; i++) {
-      short s1=(posInt>=samples)?0:oldData8[posInt];
-      short s2=(posInt+1>=samples)?((loopStart>=0 && loopStart<(int)samples)?oldData8[loopStart]:0):oldData8[posInt+1];
+  });
 
-      data8[i]=s1+(float)(s2-s1)*posFrac;
+  delete[] inF;
+}
+
+template<typename T> static void resampleBlepKernel(T* out, const T* in, unsigned int samples, double factor, int count) {
+  // each input step is an event which happens at output ceil(k*factor).
+  // every chunk renders the events which touch it into a local buffer,
+  // so the result does not depend on how the output is split.
+  const unsigned long long step=resampleStep(factor);
+  const float minVal=std::numeric_limits<T>::min();
+  const float maxVal=std::numeric_limits<T>::max();
+  const float* sincITable=DivFilterTables::getSincIntegralPolyphaseTable();
+
+  resampleRun(count,[&](int start, int end) {
+    // local buffer covers [start-RESAMPLE_PAD,end+RESAMPLE_PAD)
+    const int base=start-RESAMPLE_PAD;
+    float* floatData=new float[end-start+RESAMPLE_PAD*2];
+    memset(floatData,0,(end-start+RESAMPLE_PAD*2)*sizeof(float));
+
+    // events at outputs [start-8,end+8) may touch this chunk
+    unsigned long long k=(start>8)?((((unsigned long long)(start-9))<<32)/step+1):0;
+    for (;; k++) {
+      unsigned long long pos=k*step;
+      long long o=(long long)((pos+0xffffffffULL)>>32);
+      if (o>=end+8 || o>=count) break;
+      if (o<start-8) continue;
+      unsigned int n=((unsigned int)((((unsigned long long)o)<<32)-pos))>>19;
+      float delta=(float)((k+1<samples)?in[k+1]:0)-(float)((k<samples)?in[k]:0);
+      resampleAxpy16(&floatData[o-7-base],&sincITable[n<<4],delta);
+    }
+    // the first output does not receive the left side of the step
+    if (start==0) floatData[-base]=0;
+
+    // add the stepped signal
+    unsigned long long h=(start>0)?((((unsigned long long)(start-1))<<32)/step+1):0;
+    for (int i=start; i<end; i++) {
+      if (i>0) {
+        while (h*step<=(((unsigned long long)(i-1))<<32)) h++;
+      }
+      T hold=(h<samples)?in[h]:0;
+      float result=floatData[i-base]+hold;
+      if (result<minVal) result=minVal;
+      if (result>maxVal) result=maxVal;
+      out[i]=round(result);
+    }
+    delete[] floatData;
+  });
+}
 
-      posFrac+=factor;
-      while (posFrac>=1.0) {
-        posFrac-=1.0;
-        posInt++;
+template<typename T> static void resampleSincKernel(T* out, const T* in, unsigned int samples, double factor, int count) {
+  // output i is the input window ending at position (i+8)*factor.
+  // the first input sample is not part of the window (this was always the case).
+  const unsigned long long step=resampleStep(factor);
+  const float minVal=std::numeric_limits<T>::min();
+  const float maxVal=std::numeric_limits<T>::max();
+  const float* sincTable=DivFilterTables::getSincPolyphaseTable();
+  float* inF=resampleInput(in,samples);
+  inF[RESAMPLE_PAD]=0;
+
+  resampleRun(count,[&](int start, int end) {
+    for (int i=start; i<end; i++) {
+      unsigned long long pos=(unsigned long long)(i+8)*step;
+      unsigned long long posInt=pos>>32;
+      float result=0;
+      if (posInt<samples+RESAMPLE_PAD) {
+        result=resampleDot(&inF[posInt+1],&sincTable[((unsigned int)pos>>19)<<4],16);
       }
+      if (result<minVal) result=minVal;
+      if (result>maxVal) result=maxVal;
+      out[i]=result;
     }
+  });
+
+  delete[] inF;
+}
+
+bool DivSample::resampleLinear(double sRate, double tRate) {
+  RESAMPLE_BEGIN;
+
+  if (depth==DIV_SAMPLE_DEPTH_16BIT) {
+    resampleLinearKernel(data16,oldData16,samples,loopStart,sRate/tRate,finalCount);
+  } else if (depth==DIV_SAMPLE_DEPTH_8BIT) {
+    resampleLinearKernel(data8,oldData8,samples,loopStart,sRate/tRate,finalCount);
   }
 
   RESAMPLE_END;
@@ -931,51 +1139,10 @@ bool DivSample::resampleLinear(double sRate, double tRate) {
 bool DivSample::resampleCubic(double sRate, double tRate) {
   RESAMPLE_BEGIN;
 
-  double posFrac=0;
-  unsigned int posInt=0;
-  double factor=sRate/tRate;
-  float* cubicTable=DivFilterTables::getCubicTable();
-
   if (depth==DIV_SAMPLE_DEPTH_16BIT) {
-    for (int i=0; i<finalCount; i++) {
-      unsigned int n=((unsigned int)(posFrac*1024.0))&1023;
-      float* t=&cubicTable[n<<2];
-      float s0=(posInt<1)?0:oldData16[posInt-1];
-      float s1=(posInt>=samples)?0:oldData16[posInt];
-      float s2=(posInt+1>=samples)?((loopStart>=0 && loopStart<(int)samples)?oldData16[loopStart]:0):oldData16[posInt+1];
-      float s3=(posInt+2>=samples)?((loopStart>=0 && loopStart<(int)samples)?oldData16[loopStart]:0):oldData16[posInt+2];
-
-      float result=s0*t[0]+s1*t[1]+s2*t[2]+s3*t[3];
-      if (result<-32768) result=-32768;
-      if (result>32767) result=32767;
-      data16[i]=result;
-
-      posFrac+=factor;
-      while (posFrac>=1.0) {
-        posFrac-=1.0;
-        posInt++;
-      }
-    }
+    resampleCubicKernel(data16,oldData16,samples,loopStart,sRate/tRate,finalCount);
   } else if (depth==DIV_SAMPLE_DEPTH_8BIT) {
-    for (int i=0; i<finalCount; i++) {
-      unsigned int n=((unsigned int)(posFrac*1024.0))&1023;
-      float* t=&cubicTable[n<<2];
-      float s0=(posInt<1)?0:oldData8[posInt-1];
-      float s1=(posInt>=samples)?0:oldData8[posInt];
-      float s2=(posInt+1>=samples)?((loopStart>=0 && loopStart<(int)samples)?oldData8[loopStart]:0):oldData8[posInt+1];
-      float s3=(posInt+2>=samples)?((loopStart>=0 && loopStart<(int)samples)?oldData8[loopStart]:0):oldData8[posInt+2];
-
-      float result=s0*t[0]+s1*t[1]+s2*t[2]+s3*t[3];
-      if (result<-128) result=-128;
-      if (result>127) result=127;
-      data8[i]=result;
-
-      posFrac+=factor;
-      while (posFrac>=1.0) {
-        posFrac-=1.0;
-        posInt++;
-      }
-    }
+    resampleCubicKernel(data8,oldData8,samples,loopStart,sRate/tRate,finalCount);
   }
 
   RESAMPLE_END;
@@ -985,82 +1152,11 @@ bool DivSample::resampleCubic(double sRate, double tRate) {
 bool DivSample::resampleBlep(double sRate, double tRate) {
   RESAMPLE_BEGIN;
 
-  double posFrac=0;
-  unsigned int posInt=0;
-  double factor=tRate/sRate;
-  float* sincITable=DivFilterTables::getSincIntegralTable();
-
-  float* floatData=new float[finalCount];
-  memset(floatData,0,finalCount*sizeof(float));
-
   if (depth==DIV_SAMPLE_DEPTH_16BIT) {
-    memset(data16,0,finalCount*sizeof(short));
-    for (int i=0; i<finalCount; i++) {
-      if (posInt<samples) {
-        data16[i]=oldData16[posInt];
-      }
-      
-      posFrac+=1.0;
-      while (posFrac>=1.0) {
-        unsigned int n=((unsigned int)(posFrac*8192.0))&8191;
-        posFrac-=factor;
-        posInt++;
-
-        float* t1=&sincITable[(8191-n)<<3];
-        float* t2=&sincITable[n<<3];
-        float delta=oldData16[posInt]-oldData16[posInt-1];
-
-        for (int j=0; j<8; j++) {
-          if (i-j>0) {
-            floatData[i-j]+=t1[j]*-delta;
-          }
-          if (i+j+1<finalCount) {
-            floatData[i+j+1]+=t2[j]*delta;
-          }
-        }
-      }
-    }
-    for (int i=0; i<finalCount; i++) {
-      float result=floatData[i]+data16[i];
-      if (result<-32768) result=-32768;
-      if (result>32767) result=32767;
-      data16[i]=round(result);
-    }
+    resampleBlepKernel(data16,oldData16,samples,tRate/sRate,finalCount);
   } else if (depth==DIV_SAMPLE_DEPTH_8BIT) {
-    memset(data8,0,finalCount);
-    for (int i=0; i<finalCount; i++) {
-      if (posInt<samples) {
-        data8[i]=oldData8[posInt];
-      }
-      
-      posFrac+=1.0;
-      while (posFrac>=1.0) {
-        unsigned int n=((unsigned int)(posFrac*8192.0))&8191;
-        posFrac-=factor;
-        posInt++;
-
-        float* t1=&sincITable[(8191-n)<<3];
-        float* t2=&sincITable[n<<3];
-        float delta=oldData8[posInt]-oldData8[posInt-1];
-
-        for (int j=0; j<8; j++) {
-          if (i-j>0) {
-            floatData[i-j]+=t1[j]*-delta;
-          }
-          if (i+j+1<finalCount) {
-            floatData[i+j+1]+=t2[j]*delta;
-          }
-        }
-      }
-    }
-    for (int i=0; i<finalCount; i++) {
-      float result=floatData[i]+data8[i];
-      if (result<-128) result=-128;
-      if (result>127) result=127;
-      data8[i]=round(result);
-    }
+    resampleBlepKernel(data8,oldData8,samples,tRate/sRate,finalCount);
   }
-  delete[] floatData;
 
   RESAMPLE_END;
   return true;
@@ -1069,64 +1165,10 @@ bool DivSample::resampleBlep(double sRate, double tRate) {
 bool DivSample::resampleSinc(double sRate, double tRate) {
   RESAMPLE_BEGIN;
 
-  double posFrac=0;
-  unsigned int posInt=0;
-  double factor=sRate/tRate;
-  float* sincTable=DivFilterTables::getSincTable();
-  float s[16];
-
-  memset(s,0,16*sizeof(float));
-
   if (depth==DIV_SAMPLE_DEPTH_16BIT) {
-    for (int i=0; i<finalCount+8; i++) {
-      unsigned int n=((unsigned int)(posFrac*8192.0))&8191;
-      float result=0;
-      float* t1=&sincTable[(8191-n)<<3];
-      float* t2=&sincTable[n<<3];
-      for (int j=0; j<8; j++) {
-        result+=s[j]*t2[7-j];
-        result+=s[8+j]*t1[j];
-      }
-      if (result<-32768) result=-32768;
-      if (result>32767) result=32767;
-      if (i>=8) {
-        data16[i-8]=result;
-      }
-      
-      posFrac+=factor;
-      while (posFrac>=1.0) {
-        posFrac-=1.0;
-        posInt++;
-
-        for (int j=0; j<15; j++) s[j]=s[j+1];
-        s[15]=(posInt>=samples)?0:oldData16[posInt];
-      }
-    }
+    resampleSincKernel(data16,oldData16,samples,sRate/tRate,finalCount);
   } else if (depth==DIV_SAMPLE_DEPTH_8BIT) {
-    for (int i=0; i<finalCount+8; i++) {
-      unsigned int n=((unsigned int)(posFrac*8192.0))&8191;
-      float result=0;
-      float* t1=&sincTable[(8191-n)<<3];
-      float* t2=&sincTable[n<<3];
-      for (int j=0; j<8; j++) {
-        result+=s[j]*t2[7-j];
-        result+=s[8+j]*t1[j];
-      }
-      if (result<-128) result=-128;
-      if (result>127) result=127;
-      if (i>=8) {
-        data8[i-8]=result;
-      }
-      
-      posFrac+=factor;
-      while (posFrac>=1.0) {
-        posFrac-=1.0;
-        posInt++;
-
-        for (int j=0; j<15; j++) s[j]=s[j+1];
-        s[15]=(posInt>=samples)?0:oldData8[posInt];
-      }
-    }
+    resampleSincKernel(data8,oldData8,samples,sRate/tRate,finalCount);
   }
 
   RESAMPLE_END;
@@ -1200,9 +1242,51 @@ signed char adpcmKTable[16]={
   0, 1, 2, 4, 8, 16, 32, 64, -128, -64, -32, -16, -8, -4, -2, -1
 };
 
+#define RENDER_HASH(x) hash=(hash^(unsigned long long)(x))*0x100000001b3ULL
+
+unsigned long long DivSample::getRenderHash() {
+  // FNV-1a (one word at a time)
+  unsigned long long hash=0xcbf29ce484222325ULL;
+  RENDER_HASH(depth);
+  RENDER_HASH(samples);
+  RENDER_HASH(loop);
+  RENDER_HASH(loopStart);
+  RENDER_HASH(loopEnd);
+  RENDER_HASH(loopMode);
+  RENDER_HASH(brrEmphasis);
+  RENDER_HASH(dither);
+
+  const unsigned char* buf=(const unsigned char*)getCurBuf();
+  unsigned int len=getCurBufLen();
+  if (buf==NULL) return 0;
+  unsigned int i=0;
+  for (; i+4<=len; i+=4) {
+    unsigned int word;
+    memcpy(&word,&buf[i],4);
+    RENDER_HASH(word);
+  }
+  for (; i<len; i++) {
+    RENDER_HASH(buf[i]);
+  }
+  // 0 means "not rendered"
+  if (hash==0) hash=1;
+  return hash;
+}
+
 void DivSample::render(unsigned int formatMask) {
+  unsigned long long hash=getRenderHash();
+  if (hash!=0 && hash==renderHash) {
+    // only render what is missing
+    formatMask&=~renderedFormats;
+    if (formatMask==0) return;
+  } else {
+    renderedFormats=0;
+  }
+  // invalidate in case we bail out
+  renderHash=0;
+
   // step 1: convert to 16-bit if needed
-  if (depth!=DIV_SAMPLE_DEPTH_16BIT) {
+  if (depth!=DIV_SAMPLE_DEPTH_16BIT && (data16==NULL || !(renderedFormats&(1U<<DIV_SAMPLE_DEPTH_16BIT)))) {
     if (!initInternal(DIV_SAMPLE_DEPTH_16BIT,samples)) return;
     switch (depth) {
       case DIV_SAMPLE_DEPTH_1BIT: // 1-bit
@@ -1442,6 +1526,9 @@ void DivSample::render(unsigned int formatMask) {
       dataC219[i]=x|(negate?0x80:0);
     }
   }
+
+  renderedFormats|=formatMask|(1U<<DIV_SAMPLE_DEPTH_16BIT);
+  renderHash=hash;
 }
 
 void* DivSample::getCurBuf() {
@@ -1512,6 +1599,153 @@ unsigned int DivSample::getCurBufLen() {
   return 0;
 }
 
+void DivSample::invalidateSummary(unsigned int begin, unsigned int end) {
+  if (summary==NULL) return;
+  if (end<=begin) return;
+  unsigned int blockBegin=begin>>DIV_SAMPLE_SUMMARY_SHIFT;
+  unsigned int blockEnd=(end>>DIV_SAMPLE_SUMMARY_SHIFT)+1;
+  if (summaryDirtyStart>=summaryDirtyEnd) {
+    summaryDirtyStart=blockBegin;
+    summaryDirtyEnd=blockEnd;
+  } else {
+    if (blockBegin<summaryDirtyStart) summaryDirtyStart=blockBegin;
+    if (blockEnd>summaryDirtyEnd) summaryDirtyEnd=blockEnd;
+  }
+}
+
+bool DivSample::updateSummary() {
+  // 8-bit samples are summarized from data8, everything else from data16
+  // (which is the rendered form for other depths)
+  bool is8=(depth==DIV_SAMPLE_DEPTH_8BIT);
+  if ((is8?(void*)data8:(void*)data16)==NULL || samples==0) {
+    if (summary!=NULL) {
+      delete[] summary;
+      summary=NULL;
+    }
+    return false;
+  }
+
+  unsigned int blocks=(samples+DIV_SAMPLE_SUMMARY_BLOCK-1)>>DIV_SAMPLE_SUMMARY_SHIFT;
+
+  if (summary==NULL || summaryLen!=samples || summary8!=is8) {
+    // (re)allocate. the pyramid has blocks+ceil(blocks/2)+... entries
+    unsigned int total=0;
+    for (unsigned int n=blocks; ; n=(n+1)>>1) {
+      total+=n;
+      if (n<=1) break;
+    }
+    if (summary!=NULL) delete[] summary;
+    summary=new DivSampleSummary[total];
+    summaryLen=samples;
+    summary8=is8;
+    summaryDirtyStart=0;
+    summaryDirtyEnd=blocks;
+  }
+
+  if (summaryDirtyEnd>blocks) summaryDirtyEnd=blocks;
+  if (summaryDirtyStart>=summaryDirtyEnd) return true;
+
+  // level 0
+  for (unsigned int i=summaryDirtyStart; i<summaryDirtyEnd; i++) {
+    unsigned int pos=i<<DIV_SAMPLE_SUMMARY_SHIFT;
+    unsigned int posEnd=MIN(pos+DIV_SAMPLE_SUMMARY_BLOCK,samples);
+    int sMin=32767;
+    int sMax=-32768;
+    float sumSq=0;
+    for (unsigned int j=pos; j<posEnd; j++) {
+      int val=is8?(data8[j]<<8):data16[j];
+      if (val<sMin) sMin=val;
+      if (val>sMax) sMax=val;
+      sumSq+=(float)val*(float)val;
+    }
+    summary[i].min=sMin;
+    summary[i].max=sMax;
+    summary[i].sumSq=sumSq;
+  }
+
+  // propagate upwards
+  unsigned int lo=summaryDirtyStart;
+  unsigned int hi=summaryDirtyEnd;
+  unsigned int offset=0;
+  for (unsigned int n=blocks; n>1; n=(n+1)>>1) {
+    DivSampleSummary* cur=&summary[offset];
+    DivSampleSummary* next=&summary[offset+n];
+    lo>>=1;
+    hi=(hi+1)>>1;
+    for (unsigned int i=lo; i<hi; i++) {
+      next[i]=cur[i<<1];
+      if ((i<<1)+1<n) {
+        const DivSampleSummary& other=cur[(i<<1)+1];
+        if (other.min<next[i].min) next[i].min=other.min;
+        if (other.max>next[i].max) next[i].max=other.max;
+        next[i].sumSq+=other.sumSq;
+      }
+    }
+    offset+=n;
+  }
+
+  summaryDirtyStart=0;
+  summaryDirtyEnd=0;
+  return true;
+}
+
+bool DivSample::getSummary(unsigned int begin, unsigned int end, int& min, int& max, float* rms) {
+  if (end>samples) end=samples;
+  if (begin>=end) return false;
+  if (!updateSummary()) return false;
+
+  int sMin=32767;
+  int sMax=-32768;
+  double sumSq=0;
+
+  // unaligned edges are read directly
+  unsigned int blockBegin=(begin+DIV_SAMPLE_SUMMARY_BLOCK-1)>>DIV_SAMPLE_SUMMARY_SHIFT;
+  unsigned int blockEnd=end>>DIV_SAMPLE_SUMMARY_SHIFT;
+  unsigned int rawEnd=(blockBegin<blockEnd)?(blockBegin<<DIV_SAMPLE_SUMMARY_SHIFT):end;
+  unsigned int rawBegin=(blockBegin<blockEnd)?(blockEnd<<DIV_SAMPLE_SUMMARY_SHIFT):end;
+  for (int k=0; k<2; k++) {
+    unsigned int from=k?rawBegin:begin;
+    unsigned int to=k?end:rawEnd;
+    for (unsigned int i=from; i<to; i++) {
+      int val=summary8?(data8[i]<<8):data16[i];
+      if (val<sMin) sMin=val;
+      if (val>sMax) sMax=val;
+      sumSq+=(double)val*(double)val;
+    }
+  }
+
+  // whole blocks are taken from the pyramid, bottom-up
+  if (blockBegin<blockEnd) {
+    unsigned int n=(samples+DIV_SAMPLE_SUMMARY_BLOCK-1)>>DIV_SAMPLE_SUMMARY_SHIFT;
+    unsigned int offset=0;
+    unsigned int lo=blockBegin;
+    unsigned int hi=blockEnd;
+    while (lo<hi) {
+      if (lo&1) {
+        const DivSampleSummary& s=summary[offset+(lo++)];
+        if (s.min<sMin) sMin=s.min;
+        if (s.max>sMax) sMax=s.max;
+        sumSq+=s.sumSq;
+      }
+      if (hi&1) {
+        const DivSampleSummary& s=summary[offset+(--hi)];
+        if (s.min<sMin) sMin=s.min;
+        if (s.max>sMax) sMax=s.max;
+        sumSq+=s.sumSq;
+      }
+      lo>>=1;
+      hi>>=1;
+      offset+=n;
+      n=(n+1)>>1;
+    }
+  }
+
+  min=sMin;
+  max=sMax;
+  if (rms!=NULL) *rms=sqrt(sumSq/(double)(end-begin));
+  return true;
+}
+
 DivSampleHistory* DivSample::prepareUndo(bool data, bool doNotPush) {
   DivSampleHistory* h;
   if (data) {
@@ -1605,6 +1839,7 @@ DivSample::~DivSample() {
   }
   if (data8) delete[] data8;
   if (data16) delete[] data16;
+  if (summary) delete[] summary;
   if (data1) delete[] data1;
   if (dataDPCM) delete[] dataDPCM;
   if (dataZ) delete[] dataZ;
@@ -26,6 +26,10 @@
 #include "dataErrors.h"
 #include "../fixedQueue.h"
 
+// samples per level 0 entry of the waveform summary (log2)
+#define DIV_SAMPLE_SUMMARY_SHIFT 6
+#define DIV_SAMPLE_SUMMARY_BLOCK (1<<DIV_SAMPLE_SUMMARY_SHIFT)
+
 enum DivSampleLoopMode: unsigned char {
   DIV_SAMPLE_LOOP_FORWARD=0,
   DIV_SAMPLE_LOOP_BACKWARD,
@@ -98,6 +102,13 @@ struct DivSampleHistory {
   ~DivSampleHistory();
 };
 
+// one entry of the waveform summary pyramid.
+// min/max are always in 16-bit scale.
+struct DivSampleSummary {
+  short min, max;
+  float sumSq;
+};
+
 struct DivSample {
   String name;
   int rate, centerRate, loopStart, loopEnd;
@@ -144,6 +155,20 @@ struct DivSample {
 
   unsigned int samples;
 
+  // render cache: hash of the source data/parameters at the last render(),
+  // and which formats (bit mask, same as formatMask) are up to date.
+  // renderHash is 0 when nothing has been rendered yet.
+  unsigned long long renderHash;
+  unsigned int renderedFormats;
+
+  // waveform summary pyramid (see getSummary()).
+  // level 0 covers DIV_SAMPLE_SUMMARY_BLOCK samples per entry, and each level
+  // above combines two entries of the one below. built on demand.
+  // the dirty range is in level 0 blocks.
+  DivSampleSummary* summary;
+  unsigned int summaryLen, summaryDirtyStart, summaryDirtyEnd;
+  bool summary8;
+
   FixedQueue<DivSampleHistory*,128> undoHist;
   FixedQueue<DivSampleHistory*,128> redoHist;
 
@@ -272,6 +297,7 @@ struct DivSample {
 
   /**
    * change the sample rate.
+   * long samples are resampled on several threads.
    * @warning do not attempt to resample outside of a synchronized block!
    * @param sRate source rate.
    * @param tRate target rate.
@@ -287,11 +313,47 @@ struct DivSample {
    */
   void convert(DivSampleDepth newDepth);
 
+  /**
+   * compute a hash of the sample data and every parameter which affects rendering.
+   * @return the hash.
+   */
+  unsigned long long getRenderHash();
+
   /**
    * initialize the rest of sample formats for this sample.
+   * formats which are already up to date (same data and parameters as the last
+   * render) are not rendered again.
+   * @param formatMask the formats to render.
    */
   void render(unsigned int formatMask=0xffffffff);
 
+  /**
+   * mark part of the waveform summary as out of date.
+   * call this after writing to data8/data16 directly.
+   * @param begin the first modified sample.
+   * @param end the sample after the last modified one.
+   */
+  void invalidateSummary(unsigned int begin=0, unsigned int end=0xffffffff);
+
+  /**
+   * bring the waveform summary up to date, only rebuilding what changed.
+   * @return whether there is a summary (false if there is no data).
+   */
+  bool updateSummary();
+
+  /**
+   * get the minimum/maximum (and optionally RMS) of a range of samples.
+   * runs in O(log(end-begin)) using the summary pyramid.
+   * values are in 16-bit scale (8-bit samples are shifted left by 8).
+   * @param begin the first sample.
+   * @param end the sample after the last one.
+   * @param min where to store the minimum.
+   * @param max where to store the maximum.
+   * @param rms if not NULL, where to store the RMS.
+   * @return whether the range is not empty.
+   */
+  bool getSummary(unsigned int begin, unsigned int end, int& min, int& max, float* rms=NULL);
+
   /**
    * get the sample data for the current depth.
    * @return the sample data, or NULL if not created.
@@ -362,7 +424,14 @@ struct DivSample {
     lengthVOX(0),
     lengthMuLaw(0),
     lengthC219(0),
-    samples(0) {
+    samples(0),
+    renderHash(0),
+    renderedFormats(0),
+    summary(NULL),
+    summaryLen(0),
+    summaryDirtyStart(0),
+    summaryDirtyEnd(0),
+    summary8(false) {
     for (int i=0; i<DIV_MAX_CHIPS; i++) {
       for (int j=0; j<DIV_MAX_SAMPLE_TYPE; j++) {
         renderOn[j][i]=true;
@@ -29,6 +29,13 @@ void DivSubSong::clearData() {
   ordersLen=1;
 }
 
+void DivSubSong::setPatLen(int len) {
+  patLen=len;
+  for (int i=0; i<DIV_MAX_CHANS; i++) {
+    pat[i].growPatterns(CLAMP(len,1,DIV_MAX_ROWS));
+  }
+}
+
 void DivSubSong::optimizePatterns() {
   for (int i=0; i<DIV_MAX_CHANS; i++) {
     logD("optimizing channel %d...",i);
@@ -170,6 +170,9 @@ struct DivSubSong {
   String chanShortName[DIV_MAX_CHANS];
 
   void clearData();
+  // set the pattern length and grow all patterns to it.
+  // not thread-safe! use DivEngine::setPatternLength() on a song in use.
+  void setPatLen(int len);
   void optimizePatterns();
   void rearrangePatterns();
 
@@ -187,6 +190,7 @@ struct DivSubSong {
       chanShow[i]=true;
       chanShowChanOsc[i]=true;
       chanCollapse[i]=0;
+      pat[i].patLen=&patLen;
     }
   }
 };
@@ -22,6 +22,7 @@
 #include "instrument.h"
 #include "song.h"
 #include "../ta-log.h"
+#include <mutex>
 
 DivSysDef* DivEngine::sysDefs[DIV_MAX_CHIP_DEFS];
 DivSystem DivEngine::sysFileMapFur[DIV_MAX_CHIP_DEFS];
@@ -420,8 +421,22 @@ template<const int bits, const int shift> int effectValLongShift(unsigned char c
 };
 
 void DivEngine::registerSystems() {
+  static std::once_flag sysDefsOnce;
+  std::call_once(sysDefsOnce,[this]() {
+    registerSystemDefs();
+  });
+  systemsRegistered=true;
+}
+
+void DivEngine::registerSystemDefs() {
   logD("registering systems...");
 
+  memset(sysDefs,0,DIV_MAX_CHIP_DEFS*sizeof(void*));
+  for (int i=0; i<DIV_MAX_CHIP_DEFS; i++) {
+    sysFileMapFur[i]=DIV_SYSTEM_NULL;
+    sysFileMapDMF[i]=DIV_SYSTEM_NULL;
+  }
+
   // Common effect handler maps
 
   EffectHandlerMap ayPostEffectHandlerMap={
@@ -1939,6 +1954,4 @@ void DivEngine::registerSystems() {
       sysFileMapDMF[sysDefs[i]->id_DMF]=(DivSystem)i;
     }
   }
-
-  systemsRegistered=true;
 }
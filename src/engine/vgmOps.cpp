@@ -21,6 +21,7 @@
 #include "../ta-log.h"
 #include "../utfutils.h"
 #include "song.h"
+#include <zlib.h>
 
 constexpr int MASTER_CLOCK_PREC=(sizeof(void*)==8)?8:0;
 
@@ -1111,7 +1112,142 @@ void DivEngine::performVGMWrite(SafeWriter* w, DivSystem sys, DivRegWrite& write
   chipVol.push_back((_id)|(0x80000100)|(((unsigned int)_vol)<<16)); \
 }
 
-SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool patternHints, bool directStream, int trailingTicks) {
+// registers which hold plain state (writing the same value twice does nothing).
+// key-on, latched frequency, timer, DAC and ADPCM registers are left out.
+static bool vgmRegIsPureState(DivSystem sys, unsigned int addr) {
+  if (addr>=0x200) return false;
+  unsigned char reg=addr&0xff;
+  bool secondPort=(addr>=0x100);
+  switch (sys) {
+    case DIV_SYSTEM_YM2612:
+    case DIV_SYSTEM_YM2612_EXT:
+    case DIV_SYSTEM_YM2612_DUALPCM:
+    case DIV_SYSTEM_YM2612_DUALPCM_EXT:
+      // 0xa0-0xaf is skipped: the high byte is latched until the low byte is written
+      return (reg>=0x30 && reg<0xa0) || (reg>=0xb0 && reg<0xb8);
+    case DIV_SYSTEM_YM2610:
+    case DIV_SYSTEM_YM2610_FULL:
+    case DIV_SYSTEM_YM2610B:
+    case DIV_SYSTEM_YM2610_EXT:
+    case DIV_SYSTEM_YM2610_FULL_EXT:
+    case DIV_SYSTEM_YM2610B_EXT:
+    case DIV_SYSTEM_YM2608:
+    case DIV_SYSTEM_YM2608_EXT:
+      if (!secondPort && reg<0x0d) return true; // SSG (0x0d restarts the envelope)
+      return (reg>=0x30 && reg<0xa0) || (reg>=0xb0 && reg<0xb8);
+    case DIV_SYSTEM_YM2203:
+    case DIV_SYSTEM_YM2203_EXT:
+      if (secondPort) return false;
+      if (reg<0x0d) return true;
+      return (reg>=0x30 && reg<0xa0) || (reg>=0xb0 && reg<0xb3);
+    case DIV_SYSTEM_YM2151:
+      return !secondPort && reg>=0x20;
+    case DIV_SYSTEM_OPLL:
+    case DIV_SYSTEM_OPLL_DRUMS:
+    case DIV_SYSTEM_VRC7:
+      if (secondPort) return false;
+      return reg<0x08 || (reg>=0x10 && reg<0x19) || (reg>=0x30 && reg<0x39);
+    case DIV_SYSTEM_OPL:
+    case DIV_SYSTEM_OPL_DRUMS:
+    case DIV_SYSTEM_OPL2:
+    case DIV_SYSTEM_OPL2_DRUMS:
+    case DIV_SYSTEM_Y8950:
+    case DIV_SYSTEM_Y8950_DRUMS:
+      if (secondPort) return false;
+      // fall through
+    case DIV_SYSTEM_OPL3:
+    case DIV_SYSTEM_OPL3_DRUMS:
+      if (reg>=0x20 && reg<0xa0) return (reg&0x1f)<0x16;
+      if (reg>=0xe0) return (reg&0x1f)<0x16;
+      return (reg>=0xa0 && reg<0xa9) || (reg>=0xc0 && reg<0xc9);
+    case DIV_SYSTEM_AY8910:
+      // not AY8930: 0x0d also switches banks there
+      return reg<0x0d;
+    default:
+      break;
+  }
+  return false;
+}
+
+// remove redundant writes of one tick:
+// - writes overwritten later in the same tick (until a write with side effects)
+// - writes which don't change the register (according to shadow)
+// shadow holds VGM_SHADOW_SIZE values, -1 meaning unknown.
+// returns the number of writes removed.
+#define VGM_SHADOW_SIZE 0x200
+static int vgmOptimizeWrites(DivSystem sys, std::vector<DivRegWrite>& writes, int* shadow) {
+  if (writes.empty()) return 0;
+  unsigned int lastSeen[VGM_SHADOW_SIZE];
+  unsigned int run=1;
+  memset(lastSeen,0,VGM_SHADOW_SIZE*sizeof(unsigned int));
+  std::vector<bool> keep(writes.size(),true);
+
+  // walk backwards so that the last write to a register survives
+  for (size_t i=writes.size(); i>0; i--) {
+    DivRegWrite& w=writes[i-1];
+    if (!vgmRegIsPureState(sys,w.addr)) {
+      run++;
+      continue;
+    }
+    if (lastSeen[w.addr]==run) {
+      keep[i-1]=false;
+    } else {
+      lastSeen[w.addr]=run;
+    }
+  }
+
+  size_t out=0;
+  for (size_t i=0; i<writes.size(); i++) {
+    if (!keep[i]) continue;
+    DivRegWrite& w=writes[i];
+    if (vgmRegIsPureState(sys,w.addr)) {
+      if (shadow[w.addr]==(int)w.val) continue;
+      shadow[w.addr]=w.val;
+    }
+    writes[out++]=w;
+  }
+  int removed=writes.size()-out;
+  writes.resize(out);
+  return removed;
+}
+
+// gzip a VGM into a VGZ.
+static SafeWriter* compressVGZ(SafeWriter* w) {
+  z_stream zl;
+  memset(&zl,0,sizeof(z_stream));
+  // 15+16: gzip header instead of zlib one
+  if (deflateInit2(&zl,Z_BEST_COMPRESSION,Z_DEFLATED,15+16,8,Z_DEFAULT_STRATEGY)!=Z_OK) {
+    logE("could not initialize deflate!");
+    return NULL;
+  }
+  unsigned char* outBuf=new unsigned char[131072];
+  SafeWriter* ret=new SafeWriter;
+  ret->init();
+
+  zl.avail_in=w->size();
+  zl.next_in=(Bytef*)w->getFinalBuf();
+  int status=Z_OK;
+  while (status!=Z_STREAM_END) {
+    zl.avail_out=131072;
+    zl.next_out=outBuf;
+    status=deflate(&zl,Z_FINISH);
+    if (status==Z_STREAM_ERROR) {
+      logE("deflate error: %s",zl.msg==NULL?"unknown":zl.msg);
+      deflateEnd(&zl);
+      delete[] outBuf;
+      ret->finish();
+      delete ret;
+      return NULL;
+    }
+    ret->write(outBuf,131072-zl.avail_out);
+  }
+  logD("compressed VGM: %d -> %d bytes",(int)w->size(),(int)ret->size());
+  deflateEnd(&zl);
+  delete[] outBuf;
+  return ret;
+}
+
+SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool patternHints, bool directStream, int trailingTicks, bool optimize, bool compress) {
   if (version<0x150) {
     lastError="VGM version is too low";
     return NULL;
@@ -1140,6 +1276,15 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
   bool done=false;
   int writeCount=0;
 
+  // shadow registers for the optimizer.
+  // not used in direct stream mode, where delayed writes may come in between.
+  int* shadow=NULL;
+  int redundantWrites=0;
+  if (optimize && !directStream) {
+    shadow=new int[DIV_MAX_CHIPS*VGM_SHADOW_SIZE];
+    for (int i=0; i<DIV_MAX_CHIPS*VGM_SHADOW_SIZE; i++) shadow[i]=-1;
+  }
+
   int gd3Off=0;
 
   int hasSN=0;
@@ -2418,6 +2563,7 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
     chan[i].goneThroughNote=false;
   }
   while (!done) {
+    if (streamExportStep()) break;
     if (loopPos==-1) {
       if (loopOrder==curOrder && loopRow==curRow) {
         if ((ticks-((tempoAccum+curSubSong->virtualTempoN)/curSubSong->virtualTempoD))<=0) {
@@ -2428,6 +2574,7 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
     songTick++;
     tickPos.push_back(w->tell());
     tickSample.push_back(tickCount);
+    applyMessages();
     if (nextTick(false,true)) {
       if (trailing) beenOneLoopAlready=true;
       trailing=true;
@@ -2509,6 +2656,9 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
     // get register dumps
     for (int i=0; i<song.systemLen; i++) {
       std::vector<DivRegWrite>& writes=disCont[i].dispatch->getRegisterWrites();
+      if (shadow!=NULL) {
+        redundantWrites+=vgmOptimizeWrites(song.system[i],writes,&shadow[i*VGM_SHADOW_SIZE]);
+      }
       for (DivRegWrite& j: writes) {
         performVGMWrite(w,song.system[i],j,streamIDs[i],loopTimer,loopFreq,loopSample,sampleDir,isSecond[i],pendingFreq,playingSample,setPos,sampleOff8,sampleLen8,bankOffset[i],directStream);
         writeCount++;
@@ -2630,6 +2780,10 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
       alreadyWroteLoop=true;
       loopPos=w->tell();
       loopTickSong=songTick;
+      // the state at the end of the song is not the one we have now
+      if (shadow!=NULL) {
+        for (int i=0; i<DIV_MAX_CHIPS*VGM_SHADOW_SIZE; i++) shadow[i]=-1;
+      }
     }
   }
   // end of song
@@ -2714,8 +2868,35 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
   freelance=false;
   extValuePresent=false;
 
+  if (shadow!=NULL) {
+    delete[] shadow;
+    shadow=NULL;
+  }
+
+  if (streamExportHalt) {
+    BUSY_END;
+    w->finish();
+    delete w;
+    lastError="export cancelled";
+    return NULL;
+  }
+
   logI("%d register writes total.",writeCount);
+  if (optimize && !directStream) {
+    // every optimized chip uses 3-byte write commands
+    logI("%d redundant writes removed (%d bytes saved).",redundantWrites,redundantWrites*3);
+  }
 
   BUSY_END;
+
+  if (compress) {
+    SafeWriter* gz=compressVGZ(w);
+    w->finish();
+    delete w;
+    if (gz==NULL) {
+      lastError="could not compress VGM";
+    }
+    return gz;
+  }
   return w;
 }
@@ -29,11 +29,120 @@ void _runExportThread(DivEngine* caller) {
   caller->runExportThread();
 }
 
+void _runStemWorker(DivEngine* caller, DivEngine* inst, std::vector<int>* stems, std::atomic<size_t>* nextStem) {
+  caller->runStemWorker(inst,stems,nextStem);
+}
+
 bool DivEngine::isExporting() {
   return exporting;
 }
 
 #ifdef HAVE_SNDFILE
+bool DivEngine::renderChanStem(int ch, const String& fname, std::atomic<bool>* halt) {
+  size_t fadeOutSamples=got.rate*exportFadeOut;
+  size_t curFadeOutSample=0;
+  bool isFadingOut=false;
+
+  SNDFILE* sf;
+  SF_INFO si;
+  SFWrapper sfWrap;
+  logI("- %s",fname.c_str());
+  si.samplerate=got.rate;
+  si.channels=2;
+  si.format=SF_FORMAT_WAV|SF_FORMAT_PCM_16;
+
+  sf=sfWrap.doOpen(fname.c_str(),SFM_WRITE,&si);
+  if (sf==NULL) {
+    logE("could not open file for writing! (%s)",sf_strerror(NULL));
+    return false;
+  }
+
+  float* outBuf[3];
+  outBuf[0]=new float[EXPORT_BUFSIZE];
+  outBuf[1]=new float[EXPORT_BUFSIZE];
+  outBuf[2]=new float[EXPORT_BUFSIZE*2];
+
+  for (int j=0; j<chans; j++) {
+    bool mute=(j!=ch);
+    isMuted[j]=mute;
+  }
+  if (getChannelType(ch)==5) {
+    for (int j=ch; j<chans; j++) {
+      if (getChannelType(j)!=5) break;
+      isMuted[j]=false;
+    }
+  }
+  for (int j=0; j<chans; j++) {
+    if (disCont[dispatchOfChan[j]].dispatch!=NULL) {
+      disCont[dispatchOfChan[j]].dispatch->muteChannel(dispatchChanOfChan[j],isMuted[j]);
+    }
+  }
+
+  curOrder=0;
+  prevOrder=0;
+  lastLoopPos=-1;
+  totalLoops=0;
+  remainingLoops=-1;
+  playSub(false);
+
+  while (playing) {
+    size_t total=0;
+    if (*halt) break;
+    nextBuf(NULL,outBuf,0,2,EXPORT_BUFSIZE);
+    if (totalProcessed>EXPORT_BUFSIZE) {
+      logE("error: total processed is bigger than export bufsize! %d>%d",totalProcessed,EXPORT_BUFSIZE);
+      totalProcessed=EXPORT_BUFSIZE;
+    }
+    for (int j=0; j<(int)totalProcessed; j++) {
+      total++;
+      if (isFadingOut) {
+        double mul=(1.0-((double)curFadeOutSample/(double)fadeOutSamples));
+        outBuf[2][j<<1]=MAX(-1.0f,MIN(1.0f,outBuf[0][j]))*mul;
+        outBuf[2][1+(j<<1)]=MAX(-1.0f,MIN(1.0f,outBuf[1][j]))*mul;
+        if (++curFadeOutSample>=fadeOutSamples) {
+          playing=false;
+          break;
+        }
+      } else {
+        outBuf[2][j<<1]=MAX(-1.0f,MIN(1.0f,outBuf[0][j]));
+        outBuf[2][1+(j<<1)]=MAX(-1.0f,MIN(1.0f,outBuf[1][j]));
+        if (lastLoopPos>-1 && j>=lastLoopPos && totalLoops>=exportLoopCount) {
+          logD("start fading out...");
+          isFadingOut=true;
+          if (fadeOutSamples==0) break;
+        }
+      }
+    }
+    if (sf_writef_float(sf,outBuf[2],total)!=(int)total) {
+      logE("error: failed to write entire buffer!");
+      break;
+    }
+  }
+  playing=false;
+
+  delete[] outBuf[0];
+  delete[] outBuf[1];
+  delete[] outBuf[2];
+
+  if (sfWrap.doClose()!=0) {
+    logE("could not close audio file!");
+  }
+  return true;
+}
+
+void DivEngine::runStemWorker(DivEngine* inst, std::vector<int>* stems, std::atomic<size_t>* nextStem) {
+  while (!stopExport) {
+    size_t which=(*nextStem)++;
+    if (which>=stems->size()) break;
+    int ch=(*stems)[which];
+    if (!inst->renderChanStem(ch,fmt::sprintf("%s_c%02d.wav",exportPath,ch+1),&stopExport)) {
+      // can't write files. don't bother with the rest
+      stopExport=true;
+      break;
+    }
+  }
+}
+
 void DivEngine::runExportThread() {
   size_t fadeOutSamples=got.rate*exportFadeOut;
   size_t curFadeOutSample=0;
@@ -237,112 +346,71 @@ void DivEngine::runExportThread() {
       // take control of audio output
       deinitAudioBackend();
 
-      float* outBuf[3];
-      outBuf[0]=new float[EXPORT_BUFSIZE];
-      outBuf[1]=new float[EXPORT_BUFSIZE];
-      outBuf[2]=new float[EXPORT_BUFSIZE*2];
-
-      logI("rendering to files...");
-      
+      // one stem per channel (consecutive type 5 channels go together)
+      std::vector<int> stems;
       for (int i=0; i<chans; i++) {
-        SNDFILE* sf;
-        SF_INFO si;
-        SFWrapper sfWrap;
-        String fname=fmt::sprintf("%s_c%02d.wav",exportPath,i+1);
-        logI("- %s",fname.c_str());
-        si.samplerate=got.rate;
-        si.channels=2;
-        si.format=SF_FORMAT_WAV|SF_FORMAT_PCM_16;
-
-        sf=sfWrap.doOpen(fname.c_str(),SFM_WRITE,&si);
-        if (sf==NULL) {
-          logE("could not open file for writing! (%s)",sf_strerror(NULL));
-          break;
-        }
-
-        for (int j=0; j<chans; j++) {
-          bool mute=(j!=i);
-          isMuted[j]=mute;
-        }
+        stems.push_back(i);
         if (getChannelType(i)==5) {
-          for (int j=i; j<chans; j++) {
-            if (getChannelType(j)!=5) break;
-            isMuted[j]=false;
+          while (i+1<chans) {
+            if (getChannelType(i+1)!=5) break;
+            i++;
           }
         }
-        for (int j=0; j<chans; j++) {
-          if (disCont[dispatchOfChan[j]].dispatch!=NULL) {
-            disCont[dispatchOfChan[j]].dispatch->muteChannel(dispatchChanOfChan[j],isMuted[j]);
-          }
+      }
+
+      int jobs=exportJobs;
+      if (jobs<1) jobs=std::thread::hardware_concurrency();
+      if (jobs>(int)stems.size()) jobs=stems.size();
+      if (jobs<1) jobs=1;
+
+      // create render instances
+      std::vector<DivEngine*> instances;
+      if (jobs>1) {
+        logI("creating %d render instances...",jobs);
+        for (int i=0; i<jobs; i++) {
+          DivEngine* inst=createRenderInstance();
+          if (inst==NULL) break;
+          inst->exportLoopCount=exportLoopCount;
+          inst->exportFadeOut=exportFadeOut;
+          instances.push_back(inst);
         }
-        
-        curOrder=0;
-        prevOrder=0;
-        curFadeOutSample=0;
-        lastLoopPos=-1;
-        totalLoops=0;
-        isFadingOut=false;
-        remainingLoops=-1;
-        playSub(false);
-
-        while (playing) {
-          size_t total=0;
-          nextBuf(NULL,outBuf,0,2,EXPORT_BUFSIZE);
-          if (totalProcessed>EXPORT_BUFSIZE) {
-            logE("error: total processed is bigger than export bufsize! %d>%d",totalProcessed,EXPORT_BUFSIZE);
-            totalProcessed=EXPORT_BUFSIZE;
-          }
-          for (int j=0; j<(int)totalProcessed; j++) {
-            total++;
-            if (isFadingOut) {
-              double mul=(1.0-((double)curFadeOutSample/(double)fadeOutSamples));
-              outBuf[2][j<<1]=MAX(-1.0f,MIN(1.0f,outBuf[0][j]))*mul;
-              outBuf[2][1+(j<<1)]=MAX(-1.0f,MIN(1.0f,outBuf[1][j]))*mul;
-              if (++curFadeOutSample>=fadeOutSamples) {
-                playing=false;
-                break;
-              }
-            } else {
-              outBuf[2][j<<1]=MAX(-1.0f,MIN(1.0f,outBuf[0][j]));
-              outBuf[2][1+(j<<1)]=MAX(-1.0f,MIN(1.0f,outBuf[1][j]));
-              if (lastLoopPos>-1 && j>=lastLoopPos && totalLoops>=exportLoopCount) {
-                logD("start fading out...");
-                isFadingOut=true;
-                if (fadeOutSamples==0) break;
-              }
-            }
-          }
-          if (sf_writef_float(sf,outBuf[2],total)!=(int)total) {
-            logE("error: failed to write entire buffer!");
-            break;
+        if (instances.size()<2) {
+          logW("could not create render instances. rendering one stem at a time.");
+          for (DivEngine* i: instances) {
+            i->quit();
+            delete i;
           }
+          instances.clear();
         }
+      }
 
-        if (sfWrap.doClose()!=0) {
-          logE("could not close audio file!");
+      logI("rendering to files...");
+
+      if (instances.empty()) {
+        for (int i: stems) {
+          if (!renderChanStem(i,fmt::sprintf("%s_c%02d.wav",exportPath,i+1),&stopExport)) break;
+          if (stopExport) break;
         }
 
-        if (getChannelType(i)==5) {
-          i++;
-          while (true) {
-            if (i>=chans) break;
-            if (getChannelType(i)!=5) break;
-            i++;
+        for (int i=0; i<chans; i++) {
+          isMuted[i]=false;
+          if (disCont[dispatchOfChan[i]].dispatch!=NULL) {
+            disCont[dispatchOfChan[i]].dispatch->muteChannel(dispatchChanOfChan[i],false);
           }
-          i--;
         }
-
-        if (stopExport) break;
-      }
-
-      delete[] outBuf[0];
-      delete[] outBuf[1];
-      delete[] outBuf[2];
-
-      for (int i=0; i<chans; i++) {
-        isMuted[i]=false;
-        if (disCont[dispatchOfChan[i]].dispatch!=NULL) {
-          disCont[dispatchOfChan[i]].dispatch->muteChannel(dispatchChanOfChan[i],false);
+      } else {
+        std::atomic<size_t> nextStem(0);
+        std::vector<std::thread*> workers;
+        for (DivEngine* i: instances) {
+          workers.push_back(new std::thread(_runStemWorker,this,i,&stems,&nextStem));
+        }
+        for (std::thread* i: workers) {
+          i->join();
+          delete i;
+        }
+        for (DivEngine* i: instances) {
+          i->quit();
+          delete i;
         }
       }
 
@@ -364,6 +432,13 @@ void DivEngine::runExportThread() {
   stopExport=false;
 }
 #else
+bool DivEngine::renderChanStem(int ch, const String& fname, std::atomic<bool>* halt) {
+  return false;
+}
+
+void DivEngine::runStemWorker(DivEngine* inst, std::vector<int>* stems, std::atomic<size_t>* nextStem) {
+}
+
 void DivEngine::runExportThread() {
 }
 #endif
@@ -373,7 +448,7 @@ bool DivEngine::shallSwitchCores() {
   return true;
 }
 
-bool DivEngine::saveAudio(const char* path, int loops, DivAudioExportModes mode, double fadeOutTime) {
+bool DivEngine::saveAudio(const char* path, int loops, DivAudioExportModes mode, double fadeOutTime, int jobs) {
 #ifndef HAVE_SNDFILE
   logE("Furnace was not compiled with libsndfile. cannot export!");
   return false;
@@ -381,6 +456,7 @@ bool DivEngine::saveAudio(const char* path, int loops, DivAudioExportModes mode,
   exportPath=path;
   exportMode=mode;
   exportFadeOut=fadeOutTime;
+  exportJobs=jobs;
   if (exportMode!=DIV_EXPORT_MODE_ONE) {
     // remove extension
     String lowerCase=exportPath;
@@ -399,7 +475,7 @@ bool DivEngine::saveAudio(const char* path, int loops, DivAudioExportModes mode,
   setOrder(0);
   remainingLoops=-1;
 
-  if (shallSwitchCores()) {
+  if (shallSwitchCores() && !renderInstance) {
     bool isMutedBefore[DIV_MAX_CHANS];
     memcpy(isMutedBefore,isMuted,DIV_MAX_CHANS*sizeof(bool));
     quitDispatch();
@@ -421,6 +497,8 @@ bool DivEngine::saveAudio(const char* path, int loops, DivAudioExportModes mode,
 void DivEngine::waitAudioFile() {
   if (exportThread!=NULL) {
     exportThread->join();
+    delete exportThread;
+    exportThread=NULL;
   }
 }
 
@@ -433,7 +511,7 @@ bool DivEngine::haltAudioFile() {
 }
 
 void DivEngine::finishAudioFile() {
-  if (shallSwitchCores()) {
+  if (shallSwitchCores() && !renderInstance) {
     bool isMutedBefore[DIV_MAX_CHANS];
     memcpy(isMutedBefore,isMuted,DIV_MAX_CHANS*sizeof(bool));
     quitDispatch();
@@ -447,3 +525,62 @@ void DivEngine::finishAudioFile() {
   }
 }
 
+
+bool DivEngine::renderToBuffer(std::vector<short>& out, int loops, double fadeOutTime, std::atomic<bool>* halt) {
+  size_t fadeOutSamples=got.rate*fadeOutTime;
+  size_t curFadeOutSample=0;
+  bool isFadingOut=false;
+  bool wasHalted=false;
+
+  float* outBuf[2];
+  outBuf[0]=new float[EXPORT_BUFSIZE];
+  outBuf[1]=new float[EXPORT_BUFSIZE];
+
+  stop();
+  repeatPattern=false;
+  setOrder(0);
+  curOrder=0;
+  prevOrder=0;
+  lastLoopPos=-1;
+  totalLoops=0;
+  remainingLoops=-1;
+  playSub(false);
+
+  out.clear();
+  while (playing) {
+    if (halt!=NULL && *halt) {
+      wasHalted=true;
+      break;
+    }
+    nextBuf(NULL,outBuf,0,2,EXPORT_BUFSIZE);
+    if (totalProcessed>EXPORT_BUFSIZE) {
+      logE("error: total processed is bigger than export bufsize! %d>%d",totalProcessed,EXPORT_BUFSIZE);
+      totalProcessed=EXPORT_BUFSIZE;
+    }
+    for (int j=0; j<(int)totalProcessed; j++) {
+      float mul=1.0f;
+      if (isFadingOut) {
+        mul=(1.0-((double)curFadeOutSample/(double)fadeOutSamples));
+      }
+      out.push_back((short)(MAX(-1.0f,MIN(1.0f,outBuf[0][j]))*mul*32767.0f));
+      out.push_back((short)(MAX(-1.0f,MIN(1.0f,outBuf[1][j]))*mul*32767.0f));
+      if (isFadingOut) {
+        if (++curFadeOutSample>=fadeOutSamples) {
+          playing=false;
+          break;
+        }
+      } else if (lastLoopPos>-1 && j>=lastLoopPos && totalLoops>=loops) {
+        isFadingOut=true;
+        if (fadeOutSamples==0) {
+          playing=false;
+          break;
+        }
+      }
+    }
+  }
+  playing=false;
+
+  delete[] outBuf[0];
+  delete[] outBuf[1];
+  return !wasHalted;
+}
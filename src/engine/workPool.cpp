@@ -20,88 +20,116 @@
 #include "workPool.h"
 #include "../ta-log.h"
 #include <thread>
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#endif
+
+#define DIV_WORK_QUEUE_MASK (DIV_WORK_QUEUE_SIZE-1)
+
+// wait a little before looking for work again.
+// pauses for 1, 2, 4... iterations, then yields.
+static inline void backOff(int round) {
+  if (round<DIV_WORK_PAUSE_COUNT) {
+    for (int i=0; i<(1<<round); i++) {
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+      _mm_pause();
+#elif defined(__aarch64__)
+      __asm__ __volatile__("yield");
+#endif
+    }
+  } else {
+    std::this_thread::yield();
+  }
+}
 
 void* _workThread(void* inst) {
   ((DivWorkThread*)inst)->run();
   return NULL;
 }
 
+bool DivWorkQueue::push(void (*what)(void*), void* arg) {
+  unsigned int t=tail.load(std::memory_order_relaxed);
+  unsigned int h=head.load(std::memory_order_acquire);
+  if ((t-h)>=DIV_WORK_QUEUE_SIZE) return false;
+  slots[t&DIV_WORK_QUEUE_MASK].func.store(what,std::memory_order_relaxed);
+  slots[t&DIV_WORK_QUEUE_MASK].funcArg.store(arg,std::memory_order_relaxed);
+  tail.store(t+1,std::memory_order_release);
+  return true;
+}
+
+bool DivWorkQueue::pop(DivPendingTask& task) {
+  unsigned int h=head.load(std::memory_order_acquire);
+  while (true) {
+    unsigned int t=tail.load(std::memory_order_acquire);
+    if ((int)(t-h)<=0) return false;
+    // the slot can only be reused after head moves past it, in which case the CAS fails
+    task.func=slots[h&DIV_WORK_QUEUE_MASK].func.load(std::memory_order_relaxed);
+    task.funcArg=slots[h&DIV_WORK_QUEUE_MASK].funcArg.load(std::memory_order_relaxed);
+    if (head.compare_exchange_weak(h,h+1,std::memory_order_acq_rel,std::memory_order_acquire)) {
+      return true;
+    }
+  }
+}
+
+bool DivWorkQueue::empty() {
+  return (int)(tail.load(std::memory_order_acquire)-head.load(std::memory_order_acquire))<=0;
+}
+
 void DivWorkThread::run() {
-  //std::unique_lock<std::mutex> unique(selfLock);
-  DivPendingTask task;
-  bool setFuckingPromise=false;
+  int spin=0;
 
   logV("running work thread");
 
   while (true) {
-    lock.lock();
-    if (tasks.empty()) {
-      lock.unlock();
-      isBusy=false;
-      if (setFuckingPromise) {
-        parent->notify.set_value();
-        setFuckingPromise=false;
-        //std::this_thread::yield();
-      }
-      if (terminate) {
-        break;
-      }
-      std::future<void> future=notify.get_future();
-      future.wait();
-      lock.lock();
-      notify=std::promise<void>();
-      promiseAlreadySet=false;
-      lock.unlock();
+    unsigned int seen=parent->epoch.load();
+    if (parent->runTask(index)) {
+      spin=0;
       continue;
-    } else {
-      task=tasks.front();
-      tasks.pop();
-      lock.unlock();
+    }
+    isBusy=false;
+    if (terminate) break;
 
-      task.func(task.funcArg);
+    // spin for a bit before parking, since more work is likely coming soon
+    if (spin<DIV_WORK_SPIN_COUNT) {
+      backOff(spin++);
+      continue;
+    }
+    spin=0;
 
-      int busyCount=--parent->busyCount;
-      if (busyCount<0) {
-        logE("oh no PROBLEM...");
-      }
-      if (busyCount==0) {
-        setFuckingPromise=true;
-      }
+    std::unique_lock<std::mutex> unique(parent->parkLock);
+    parent->parked++;
+    while (parent->epoch.load()==seen && !terminate) {
+      parent->parkCond.wait(unique);
     }
+    parent->parked--;
   }
 }
 
 bool DivWorkThread::assign(void (*what)(void*), void* arg) {
-  lock.lock();
-  if (tasks.size()>=30) {
-    lock.unlock();
+  parent->busyCount++;
+  if (!tasks.push(what,arg)) {
+    parent->busyCount--;
     return false;
   }
-  tasks.push(DivPendingTask(what,arg));
-  parent->busyCount++;
   isBusy=true;
-  lock.unlock();
   return true;
 }
 
-void DivWorkThread::wait() {
-  if (!isBusy) return;
-}
-
 bool DivWorkThread::busy() {
   return isBusy;
 }
 
 void DivWorkThread::finish() {
-  lock.lock();
   terminate=true;
-  notify.set_value();
-  lock.unlock();
+  parent->wake(true);
   thread->join();
+  delete thread;
+  thread=NULL;
 }
 
-bool DivWorkThread::init(DivWorkPool* p) {
+bool DivWorkThread::init(DivWorkPool* p, unsigned int i) {
   parent=p;
+  index=i;
   try {
     thread=new std::thread(_workThread,this);
   } catch (std::system_error& e) {
@@ -112,6 +140,46 @@ bool DivWorkThread::init(DivWorkPool* p) {
   return true;
 }
 
+bool DivWorkPool::runTask(unsigned int from) {
+  DivPendingTask task;
+  for (unsigned int i=0; i<count; i++) {
+    unsigned int which=from+i;
+    if (which>=count) which-=count;
+    if (workThreads[which].tasks.pop(task)) {
+      task.func(task.funcArg);
+      taskDone();
+      return true;
+    }
+  }
+  return false;
+}
+
+void DivWorkPool::wake(bool all) {
+  epoch++;
+  if (parked.load()>0 || all) {
+    // lock to make sure no thread is between checking the epoch and waiting
+    parkLock.lock();
+    parkLock.unlock();
+    if (all) {
+      parkCond.notify_all();
+    } else {
+      parkCond.notify_one();
+    }
+  }
+}
+
+void DivWorkPool::taskDone() {
+  int left=--busyCount;
+  if (left<0) {
+    logE("oh no PROBLEM...");
+  }
+  if (left==0 && waiterParked.load()) {
+    doneLock.lock();
+    doneLock.unlock();
+    doneCond.notify_one();
+  }
+}
+
 void DivWorkPool::push(void (*what)(void*), void* arg) {
   // if no work threads, just execute
   if (!threaded) {
@@ -121,51 +189,44 @@ void DivWorkPool::push(void (*what)(void*), void* arg) {
 
   for (unsigned int tryCount=0; tryCount<count; tryCount++) {
     if (pos>=count) pos=0;
-    if (workThreads[pos++].assign(what,arg)) return;
+    if (workThreads[pos++].assign(what,arg)) {
+      wake(false);
+      return;
+    }
   }
 
-  // all threads are busy
+  // all queues are full
   logW("DivWorkPool: all work threads busy!");
   what(arg);
 }
 
 bool DivWorkPool::busy() {
   if (!threaded) return false;
-  for (unsigned int i=0; i<count; i++) {
-    if (workThreads[i].busy()) return true;
-  }
-  return false;
+  return busyCount>0;
 }
 
 void DivWorkPool::wait() {
   if (!threaded) return;
 
-  if (busyCount==0) {
-    return;
+  // help out while there are tasks left
+  while (busyCount>0) {
+    if (!runTask(pos%count)) break;
   }
 
-  std::future<void> future=notify.get_future();
+  // spin until the rest is done...
+  for (int i=0; i<DIV_WORK_SPIN_COUNT && busyCount>0; i++) {
+    backOff(i);
+  }
 
-  // start running
-  for (unsigned int i=0; i<count; i++) {
-    if (!workThreads[i].promiseAlreadySet && !workThreads[i].tasks.empty()) {
-      try {
-        workThreads[i].lock.lock();
-        workThreads[i].promiseAlreadySet=true;
-        workThreads[i].notify.set_value();
-        workThreads[i].lock.unlock();
-      } catch (std::exception& e) {
-        logE("ERROR IN THREAD SYNC! %s",e.what());
-        abort();
-      }
+  // ...or park
+  if (busyCount>0) {
+    std::unique_lock<std::mutex> unique(doneLock);
+    waiterParked=true;
+    while (busyCount>0) {
+      doneCond.wait(unique);
     }
+    waiterParked=false;
   }
-  //std::this_thread::yield();
-
-  // wait
-  future.wait();
-
-  notify=std::promise<void>();
 
   pos=0;
 }
@@ -174,11 +235,14 @@ DivWorkPool::DivWorkPool(unsigned int threads):
   threaded(threads>0),
   count(threads),
   pos(0),
+  epoch(0),
+  parked(0),
+  waiterParked(false),
   busyCount(0) {
   if (threaded) {
     workThreads=new DivWorkThread[threads];
     for (unsigned int i=0; i<count; i++) {
-      if (!workThreads[i].init(this)) { 
+      if (!workThreads[i].init(this,i)) { 
         count=i;
         break;
       }
@@ -22,10 +22,17 @@
 
 #include <thread>
 #include <atomic>
-#include <functional>
-#include <future>
+#include <mutex>
+#include <condition_variable>
 
-#include "../fixedQueue.h"
+// must be a power of 2
+#define DIV_WORK_QUEUE_SIZE 256
+// how many times a thread shall look for work before parking.
+// the wait between looks doubles every time (see backOff() in workPool.cpp),
+// so this bounds spinning to a few tens of microseconds.
+#define DIV_WORK_SPIN_COUNT 14
+// after this many looks, yield instead of pausing
+#define DIV_WORK_PAUSE_COUNT 10
 
 class DivWorkPool;
 
@@ -40,46 +47,106 @@ struct DivPendingTask {
     funcArg(NULL) {}
 };
 
+/**
+ * a bounded lock-free task queue.
+ * only one thread (the one calling DivWorkPool::push()) may put tasks in it,
+ * but any thread may take tasks out of it (this is how work stealing is done).
+ */
+struct DivWorkQueue {
+  struct Slot {
+    std::atomic<void (*)(void*)> func;
+    std::atomic<void*> funcArg;
+    Slot():
+      func(NULL),
+      funcArg(NULL) {}
+  };
+  std::atomic<unsigned int> head;
+  std::atomic<unsigned int> tail;
+  Slot slots[DIV_WORK_QUEUE_SIZE];
+
+  bool push(void (*what)(void*), void* arg);
+  bool pop(DivPendingTask& task);
+  bool empty();
+  DivWorkQueue():
+    head(0),
+    tail(0) {}
+};
+
 struct DivWorkThread {
   DivWorkPool* parent;
-  std::mutex lock;
   std::thread* thread;
-  std::promise<void> notify;
-  FixedQueue<DivPendingTask,32> tasks;
+  DivWorkQueue tasks;
   std::atomic<bool> isBusy;
-  bool terminate;
-  bool promiseAlreadySet;
+  std::atomic<bool> terminate;
+  unsigned int index;
 
   void run();
   bool assign(void (*what)(void*), void* arg);
-  void wait();
   bool busy();
   void finish();
 
-  bool init(DivWorkPool* p);
+  bool init(DivWorkPool* p, unsigned int i);
   DivWorkThread():
     parent(NULL),
+    thread(NULL),
     isBusy(false),
     terminate(false),
-    promiseAlreadySet(false) {}
+    index(0) {}
 };
 
 /**
  * this class provides an implementation of a "thread pool" for executing tasks in parallel.
  * it is highly recommended to use `new` when allocating a DivWorkPool.
+ *
+ * work threads are persistent. each one has its own task queue, and idle threads steal
+ * tasks from the queues of other threads. threads spin for a short while (backing off
+ * exponentially) before parking, so successive push()/wait() rounds (e.g. one per tick)
+ * don't have to wake them up again.
+ *
+ * push() and wait() must be called from the same thread.
  */
 class DivWorkPool {
   bool threaded;
   unsigned int count;
   unsigned int pos;
   DivWorkThread* workThreads;
+
+  // parking
+  std::mutex parkLock;
+  std::condition_variable parkCond;
+  std::atomic<unsigned int> epoch;
+  std::atomic<int> parked;
+
+  // barrier
+  std::mutex doneLock;
+  std::condition_variable doneCond;
+  std::atomic<bool> waiterParked;
+
+  friend struct DivWorkThread;
+
+  /**
+   * run one task, looking at the queue of the given thread first and then
+   * stealing from the others.
+   * @return whether a task was run.
+   */
+  bool runTask(unsigned int from);
+
+  /**
+   * wake up parked work threads.
+   */
+  void wake(bool all);
+
+  /**
+   * mark a task as finished.
+   */
+  void taskDone();
+
   public:
-    std::promise<void> notify;
     std::atomic<int> busyCount;
     
     /**
      * push a new job to this work pool.
-     * if all work threads are busy, this will block until one is free.
+     * if the task queues are full, the job will be executed on the calling thread.
      */
     void push(void (*what)(void*), void* arg);
     
@@ -89,7 +156,8 @@ class DivWorkPool {
     bool busy();
 
     /**
-     * wait for all work threads to finish.
+     * wait for all jobs to finish.
+     * the calling thread helps executing pending jobs while waiting.
      */
     void wait();
 
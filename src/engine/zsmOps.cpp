@@ -123,6 +123,7 @@ SafeWriter* DivEngine::saveZSM(unsigned int zsmrate, bool loop, bool optimize) {
   zsm.setOptimize(optimize);
 
   while (!done) {
+    if (streamExportStep()) break;
     if (loopPos==-1) {
       if (loopOrder==curOrder && loopRow==curRow && loop)
         loopNow=true;
@@ -137,6 +138,7 @@ SafeWriter* DivEngine::saveZSM(unsigned int zsmrate, bool loop, bool optimize) {
         }
       }
     }
+    applyMessages();
     if (nextTick() || !playing) {
       done=true;
       if (!loop) {
@@ -204,5 +206,14 @@ SafeWriter* DivEngine::saveZSM(unsigned int zsmrate, bool loop, bool optimize) {
   extValuePresent=false;
 
   BUSY_END;
+  if (streamExportHalt) {
+    SafeWriter* w=zsm.finish();
+    if (w!=NULL) {
+      w->finish();
+      delete w;
+    }
+    lastError="export cancelled";
+    return NULL;
+  }
   return zsm.finish();
 }
@@ -27,6 +27,246 @@
 #define FURNACE_FFT_SIZE 4096
 #define FURNACE_FFT_RATE 80.0
 #define FURNACE_FFT_CUTOFF 0.1
+// channels transformed together by one FFTW plan
+#define FURNACE_FFT_BATCH 8
+#define FURNACE_FFT_COMPLEX_SIZE ((FURNACE_FFT_SIZE>>1)+1)
+
+struct FurnaceGUI::ChanOscAnalyzer {
+  struct Batch {
+    double* inBuf;
+    fftw_complex* outBuf;
+    double* corrBuf;
+    ChanOscStatus* chan[FURNACE_FFT_BATCH];
+    int count;
+    ChanOscAnalyzer* parent;
+    Batch():
+      inBuf(NULL),
+      outBuf(NULL),
+      corrBuf(NULL),
+      count(0),
+      parent(NULL) {
+      memset(chan,0,FURNACE_FFT_BATCH*sizeof(ChanOscStatus*));
+    }
+  };
+
+  // plan[i] transforms i+1 channels at once
+  fftw_plan plan[FURNACE_FFT_BATCH];
+  fftw_plan planI[FURNACE_FFT_BATCH];
+  double window[FURNACE_FFT_SIZE];
+  std::vector<Batch*> batches;
+  float timer;
+  bool ready;
+
+  Batch* newBatch() {
+    Batch* b=new Batch;
+    b->inBuf=(double*)fftw_malloc(FURNACE_FFT_BATCH*FURNACE_FFT_SIZE*sizeof(double));
+    b->outBuf=(fftw_complex*)fftw_malloc(FURNACE_FFT_BATCH*FURNACE_FFT_COMPLEX_SIZE*sizeof(fftw_complex));
+    b->corrBuf=(double*)fftw_malloc(FURNACE_FFT_BATCH*FURNACE_FFT_SIZE*sizeof(double));
+    b->parent=this;
+    batches.push_back(b);
+    return b;
+  }
+
+  // must be called from the GUI thread (FFTW planning is not thread-safe)
+  bool init() {
+    for (int i=0; i<FURNACE_FFT_SIZE; i++) {
+      window[i]=0.55-0.45*cos(M_PI*(double)i/(double)(FURNACE_FFT_SIZE>>1));
+    }
+
+    Batch* b=newBatch();
+    if (b->inBuf==NULL || b->outBuf==NULL || b->corrBuf==NULL) {
+      logE("failed to create FFT buffers");
+      return false;
+    }
+
+    // plans are executed on other batches' buffers (they are all allocated the same way)
+    int n=FURNACE_FFT_SIZE;
+    for (int i=0; i<FURNACE_FFT_BATCH; i++) {
+      plan[i]=fftw_plan_many_dft_r2c(1,&n,i+1,b->inBuf,NULL,1,FURNACE_FFT_SIZE,b->outBuf,NULL,1,FURNACE_FFT_COMPLEX_SIZE,FFTW_ESTIMATE);
+      planI[i]=fftw_plan_many_dft_c2r(1,&n,i+1,b->outBuf,NULL,1,FURNACE_FFT_COMPLEX_SIZE,b->corrBuf,NULL,1,FURNACE_FFT_SIZE,FFTW_ESTIMATE);
+      if (plan[i]==NULL) {
+        logE("failed to create plan!");
+        return false;
+      }
+      if (planI[i]==NULL) {
+        logE("failed to create inverse plan!");
+        return false;
+      }
+    }
+    ready=true;
+    return true;
+  }
+
+  ChanOscAnalyzer():
+    timer(0.0f),
+    ready(false) {
+    memset(plan,0,FURNACE_FFT_BATCH*sizeof(fftw_plan));
+    memset(planI,0,FURNACE_FFT_BATCH*sizeof(fftw_plan));
+  }
+
+  ~ChanOscAnalyzer() {
+    for (int i=0; i<FURNACE_FFT_BATCH; i++) {
+      if (plan[i]!=NULL) fftw_destroy_plan(plan[i]);
+      if (planI[i]!=NULL) fftw_destroy_plan(planI[i]);
+    }
+    for (Batch* i: batches) {
+      if (i->inBuf!=NULL) fftw_free(i->inBuf);
+      if (i->outBuf!=NULL) fftw_free(i->outBuf);
+      if (i->corrBuf!=NULL) fftw_free(i->corrBuf);
+      delete i;
+    }
+    batches.clear();
+  }
+};
+
+// the STRATEGY
+// 1. FFT of windowed signal
+// 2. inverse FFT of auto-correlation
+// 3. find size of one period
+// 4. DFT of the fundamental of ONE PERIOD
+// 5. now we can get phase information
+//
+// steps 1 and 2 are done for a batch of channels at once.
+void FurnaceGUI::chanOscAnalyzeBatch(void* batch_v) {
+  ChanOscAnalyzer::Batch* batch=(ChanOscAnalyzer::Batch*)batch_v;
+  ChanOscAnalyzer* an=batch->parent;
+  ChanOscStatus* loud[FURNACE_FFT_BATCH];
+  int displaySizes[FURNACE_FFT_BATCH];
+  int loudCount=0;
+
+  // gather windowed input
+  for (int i=0; i<batch->count; i++) {
+    ChanOscStatus* fft=batch->chan[i];
+    DivDispatchOscBuffer* buf=fft->relatedBuf;
+    const short* data=buf->getData();
+
+    int displaySize=(float)(buf->getRate())*(fft->windowSize/1000.0f);
+    displaySizes[i]=displaySize;
+    fft->loudEnough=false;
+    fft->needle=buf->getNeedle();
+    fft->lastNeedle=fft->needle;
+    fft->lastWindowSize=fft->windowSize;
+    fft->lastWaveCorr=fft->waveCorr;
+
+    for (int j=0; j<FURNACE_FFT_SIZE; j++) {
+      fft->inBuf[j]=(double)data[(unsigned short)(fft->needle-displaySize*2+((j*displaySize*2)/(FURNACE_FFT_SIZE)))]/32768.0;
+      if (fft->inBuf[j]>0.001 || fft->inBuf[j]<-0.001) fft->loudEnough=true;
+      fft->inBuf[j]*=an->window[j];
+    }
+
+    // only proceed if not quiet
+    if (fft->loudEnough) {
+      memcpy(&batch->inBuf[loudCount*FURNACE_FFT_SIZE],fft->inBuf,FURNACE_FFT_SIZE*sizeof(double));
+      loud[loudCount++]=fft;
+    }
+  }
+
+  if (loudCount>0) {
+    // first FFT
+    fftw_execute_dft_r2c(an->plan[loudCount-1],batch->inBuf,batch->outBuf);
+
+    // auto-correlation and second FFT
+    for (int i=0; i<loudCount; i++) {
+      fftw_complex* out=&batch->outBuf[i*FURNACE_FFT_COMPLEX_SIZE];
+      for (int j=0; j<FURNACE_FFT_COMPLEX_SIZE; j++) {
+        out[j][0]/=FURNACE_FFT_SIZE;
+        out[j][1]/=FURNACE_FFT_SIZE;
+        out[j][0]=out[j][0]*out[j][0]+out[j][1]*out[j][1];
+        out[j][1]=0;
+      }
+      out[0][0]=0;
+      out[0][1]=0;
+      out[1][0]=0;
+      out[1][1]=0;
+    }
+    fftw_execute_dft_c2r(an->planI[loudCount-1],batch->outBuf,batch->corrBuf);
+
+    for (int i=0; i<loudCount; i++) {
+      memcpy(loud[i]->corrBuf,&batch->corrBuf[i*FURNACE_FFT_SIZE],FURNACE_FFT_SIZE*sizeof(double));
+    }
+  }
+
+  for (int i=0; i<batch->count; i++) {
+    ChanOscStatus* fft=batch->chan[i];
+    const short* data=fft->relatedBuf->getData();
+    int displaySize=displaySizes[i];
+
+    if (fft->loudEnough) {
+      // window
+      for (int j=0; j<(FURNACE_FFT_SIZE>>1); j++) {
+        fft->corrBuf[j]*=1.0-((double)j/(double)(FURNACE_FFT_SIZE<<1));
+      }
+
+      // find size of period
+      double waveLenCandL=DBL_MAX;
+      double waveLenCandH=DBL_MIN;
+      fft->waveLen=FURNACE_FFT_SIZE-1;
+      fft->waveLenBottom=0;
+      fft->waveLenTop=0;
+
+      // find lowest point
+      for (int j=(FURNACE_FFT_SIZE>>2); j>2; j--) {
+        if (fft->corrBuf[j]<waveLenCandL) {
+          waveLenCandL=fft->corrBuf[j];
+          fft->waveLenBottom=j;
+        }
+      }
+      
+      // find highest point
+      for (int j=(FURNACE_FFT_SIZE>>1)-1; j>fft->waveLenBottom; j--) {
+        if (fft->corrBuf[j]>waveLenCandH) {
+          waveLenCandH=fft->corrBuf[j];
+          fft->waveLen=j;
+        }
+      }
+      fft->waveLenTop=fft->waveLen;
+
+      // did we find the period size?
+      if (fft->waveLen<(FURNACE_FFT_SIZE-32)) {
+        // we got pitch
+        fft->pitch=pow(1.0-(fft->waveLen/(double)(FURNACE_FFT_SIZE>>1)),4.0);
+        
+        fft->waveLen*=(double)displaySize*2.0/(double)FURNACE_FFT_SIZE;
+
+        // DFT of one period (x_1)
+        // the twiddle factor is rotated instead of calling sin/cos for every sample
+        double dft[2];
+        dft[0]=0.0;
+        dft[1]=0.0;
+        double rotCos=cos(-2.0*M_PI/fft->waveLen);
+        double rotSin=sin(-2.0*M_PI/fft->waveLen);
+        double twCos=1.0;
+        double twSin=0.0;
+        for (int j=fft->needle-1-(displaySize>>1)-(int)fft->waveLen, k=0; k<fft->waveLen; j++, k++) {
+          double one=((double)data[j&0xffff]/32768.0);
+          dft[0]+=one*twCos;
+          dft[1]+=one*twSin;
+          double nextCos=twCos*rotCos-twSin*rotSin;
+          twSin=twSin*rotCos+twCos*rotSin;
+          twCos=nextCos;
+        }
+
+        // calculate and lock into phase
+        double phase=(0.5+(atan2(dft[1],dft[0])/(2.0*M_PI)));
+
+        if (fft->waveCorr) {
+          fft->needle-=(phase+(fft->phaseOff*2))*fft->waveLen;
+        }
+      }
+    }
+
+    fft->needle-=displaySize;
+    fft->lastResult=fft->needle;
+    fft->analyzed=true;
+  }
+}
+
+void FurnaceGUI::freeChanOscAnalyzer() {
+  if (chanOscAnalyzer!=NULL) {
+    delete chanOscAnalyzer;
+    chanOscAnalyzer=NULL;
+  }
+}
 
 const char* chanOscRefs[]={
   "None (0%)",
@@ -84,24 +324,31 @@ void FurnaceGUI::calcChanOsc() {
   std::vector<int> oscChans;
 
   int chans=e->getTotalChannelCount();
+  // channel volume is only used by the oscilloscope and the "real" channel volume styles.
+  // don't request osc buffers (and thereby enable capture) if nobody needs it.
+  bool needVol=chanOscOpen || settings.channelVolStyle>=3;
   
   for (int i=0; i<chans; i++) {
     int tryAgain=i;
-    DivDispatchOscBuffer* buf=e->getOscBuffer(i);
-    while (buf==NULL) {
-      if (--tryAgain<0) break;
-      buf=e->getOscBuffer(tryAgain);
+    DivDispatchOscBuffer* buf=NULL;
+    if (needVol) {
+      buf=e->requestOscBuffer(i);
+      while (buf==NULL) {
+        if (--tryAgain<0) break;
+        buf=e->requestOscBuffer(tryAgain);
+      }
     }
     if (buf!=NULL && e->curSubSong->chanShowChanOsc[i]) {
       // 30ms should be enough
-      int displaySize=(float)(buf->rate)*0.03f;
+      int displaySize=(float)(buf->getRate())*0.03f;
       if (e->isRunning()) {
         short minLevel=32767;
         short maxLevel=-32768;
-        unsigned short needlePos=buf->needle;
+        const short* data=buf->getData();
+        unsigned short needlePos=buf->getNeedle();
         needlePos-=displaySize;
         for (unsigned short i=0; i<512; i++) {
-          short y=buf->data[(unsigned short)(needlePos+(i*displaySize/512))];
+          short y=data[(unsigned short)(needlePos+(i*displaySize/512))];
           if (minLevel>y) minLevel=y;
           if (maxLevel<y) maxLevel=y;
         }
@@ -174,6 +421,19 @@ void FurnaceGUI::drawChanOsc() {
         ImGui::TableNextColumn();
         if (ImGui::Checkbox("Randomize phase on note",&chanOscRandomPhase)) {
         }
+
+        ImGui::TableNextColumn();
+        ImGui::AlignTextToFramePadding();
+        ImGui::Text("Analysis rate (Hz)");
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
+        if (ImGui::InputInt("##COSAnalysisRate",&chanOscAnalysisRate,1,10)) {
+          if (chanOscAnalysisRate<0) chanOscAnalysisRate=0;
+          if (chanOscAnalysisRate>240) chanOscAnalysisRate=240;
+        }
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip("how many times per second to look for the period of each channel.\n0 means every frame.");
+        }
         ImGui::EndTable();
       }
 
@@ -380,7 +640,7 @@ void FurnaceGUI::drawChanOsc() {
 
         // fill buffers
         for (int i=0; i<chans; i++) {
-          DivDispatchOscBuffer* buf=e->getOscBuffer(i);
+          DivDispatchOscBuffer* buf=e->requestOscBuffer(i);
           if (buf!=NULL && e->curSubSong->chanShowChanOsc[i]) {
             oscBufs.push_back(buf);
             oscFFTs.push_back(&chanOscChan[i]);
@@ -388,7 +648,26 @@ void FurnaceGUI::drawChanOsc() {
           }
         }
 
+        // check analyzer
+        if (chanOscAnalyzer==NULL) {
+          logD("creating chan osc analyzer");
+          chanOscAnalyzer=new ChanOscAnalyzer;
+          chanOscAnalyzer->init();
+        }
+
+        // throttle analysis
+        bool analyzeNow=true;
+        if (chanOscAnalysisRate>0) {
+          chanOscAnalyzer->timer+=ImGui::GetIO().DeltaTime;
+          if (chanOscAnalyzer->timer<1.0f/(float)chanOscAnalysisRate) {
+            analyzeNow=false;
+          } else {
+            chanOscAnalyzer->timer=fmod(chanOscAnalyzer->timer,1.0f/(float)chanOscAnalysisRate);
+          }
+        }
+
         // process
+        size_t batchCount=0;
         for (size_t i=0; i<oscBufs.size(); i++) {
           ChanOscStatus* fft_=oscFFTs[i];
 
@@ -398,137 +677,73 @@ void FurnaceGUI::drawChanOsc() {
           if (fft_->relatedBuf!=NULL) {
             // prepare
             if (centerSettingReset) {
-              fft_->relatedBuf->readNeedle=fft_->relatedBuf->needle;
+              fft_->relatedBuf->readNeedle=fft_->relatedBuf->getNeedle();
+              fft_->analyzed=false;
             }
 
-            // check FFT status existence
+            // check buffer existence
             if (!fft_->ready) {
-              logD("creating FFT plan for channel %d",fft_->relatedCh);
               fft_->inBuf=(double*)fftw_malloc(FURNACE_FFT_SIZE*sizeof(double));
-              fft_->outBuf=(fftw_complex*)fftw_malloc(FURNACE_FFT_SIZE*sizeof(fftw_complex));
               fft_->corrBuf=(double*)fftw_malloc(FURNACE_FFT_SIZE*sizeof(double));
-              fft_->plan=fftw_plan_dft_r2c_1d(FURNACE_FFT_SIZE,fft_->inBuf,fft_->outBuf,FFTW_ESTIMATE);
-              fft_->planI=fftw_plan_dft_c2r_1d(FURNACE_FFT_SIZE,fft_->outBuf,fft_->corrBuf,FFTW_ESTIMATE);
-              if (fft_->plan==NULL) {
-                logE("failed to create plan!");
-              } else if (fft_->planI==NULL) {
-                logE("failed to create inverse plan!");
-              } else if (fft_->inBuf==NULL || fft_->outBuf==NULL || fft_->corrBuf==NULL) {
+              if (fft_->inBuf==NULL || fft_->corrBuf==NULL) {
                 logE("failed to create FFT buffers");
               } else {
+                memset(fft_->inBuf,0,FURNACE_FFT_SIZE*sizeof(double));
+                memset(fft_->corrBuf,0,FURNACE_FFT_SIZE*sizeof(double));
                 fft_->ready=true;
               }
             }
 
-            if (fft_->ready && e->isRunning()) {
+            if (fft_->ready && chanOscAnalyzer->ready && e->isRunning()) {
               fft_->windowSize=chanOscWindowSize;
               fft_->waveCorr=chanOscWaveCorr;
-              chanOscWorkPool->push([](void* fft_v) {
-                ChanOscStatus* fft=(ChanOscStatus*)fft_v;
-                DivDispatchOscBuffer* buf=fft->relatedBuf;
-
-                // the STRATEGY
-                // 1. FFT of windowed signal
-                // 2. inverse FFT of auto-correlation
-                // 3. find size of one period
-                // 4. DFT of the fundamental of ONE PERIOD
-                // 5. now we can get phase information
-                //
-                // I have a feeling this could be simplified to two FFTs or even one...
-                // if you know how, please tell me
-
-                // initialization
-                double phase=0.0;
-                int displaySize=(float)(buf->rate)*(fft->windowSize/1000.0f);
-                fft->loudEnough=false;
-                fft->needle=buf->needle;
-
-                // first FFT
-                for (int j=0; j<FURNACE_FFT_SIZE; j++) {
-                  fft->inBuf[j]=(double)buf->data[(unsigned short)(fft->needle-displaySize*2+((j*displaySize*2)/(FURNACE_FFT_SIZE)))]/32768.0;
-                  if (fft->inBuf[j]>0.001 || fft->inBuf[j]<-0.001) fft->loudEnough=true;
-                  fft->inBuf[j]*=0.55-0.45*cos(M_PI*(double)j/(double)(FURNACE_FFT_SIZE>>1));
-                }
 
-                // only proceed if not quiet
-                if (fft->loudEnough) {
-                  fftw_execute(fft->plan);
-
-                  // auto-correlation and second FFT
-                  for (int j=0; j<FURNACE_FFT_SIZE; j++) {
-                    fft->outBuf[j][0]/=FURNACE_FFT_SIZE;
-                    fft->outBuf[j][1]/=FURNACE_FFT_SIZE;
-                    fft->outBuf[j][0]=fft->outBuf[j][0]*fft->outBuf[j][0]+fft->outBuf[j][1]*fft->outBuf[j][1];
-                    fft->outBuf[j][1]=0;
-                  }
-                  fft->outBuf[0][0]=0;
-                  fft->outBuf[0][1]=0;
-                  fft->outBuf[1][0]=0;
-                  fft->outBuf[1][1]=0;
-                  fftw_execute(fft->planI);
-
-                  // window
-                  for (int j=0; j<(FURNACE_FFT_SIZE>>1); j++) {
-                    fft->corrBuf[j]*=1.0-((double)j/(double)(FURNACE_FFT_SIZE<<1));
-                  }
-
-                  // find size of period
-                  double waveLenCandL=DBL_MAX;
-                  double waveLenCandH=DBL_MIN;
-                  fft->waveLen=FURNACE_FFT_SIZE-1;
-                  fft->waveLenBottom=0;
-                  fft->waveLenTop=0;
-
-                  // find lowest point
-                  for (int j=(FURNACE_FFT_SIZE>>2); j>2; j--) {
-                    if (fft->corrBuf[j]<waveLenCandL) {
-                      waveLenCandL=fft->corrBuf[j];
-                      fft->waveLenBottom=j;
-                    }
-                  }
-                  
-                  // find highest point
-                  for (int j=(FURNACE_FFT_SIZE>>1)-1; j>fft->waveLenBottom; j--) {
-                    if (fft->corrBuf[j]>waveLenCandH) {
-                      waveLenCandH=fft->corrBuf[j];
-                      fft->waveLen=j;
-                    }
-                  }
-                  fft->waveLenTop=fft->waveLen;
-
-                  // did we find the period size?
-                  if (fft->waveLen<(FURNACE_FFT_SIZE-32)) {
-                    // we got pitch
-                    fft->pitch=pow(1.0-(fft->waveLen/(double)(FURNACE_FFT_SIZE>>1)),4.0);
-                    
-                    fft->waveLen*=(double)displaySize*2.0/(double)FURNACE_FFT_SIZE;
-
-                    // DFT of one period (x_1)
-                    double dft[2];
-                    dft[0]=0.0;
-                    dft[1]=0.0;
-                    for (int j=fft->needle-1-(displaySize>>1)-(int)fft->waveLen, k=0; k<fft->waveLen; j++, k++) {
-                      double one=((double)buf->data[j&0xffff]/32768.0);
-                      double two=(double)k*(-2.0*M_PI)/fft->waveLen;
-                      dft[0]+=one*cos(two);
-                      dft[1]+=one*sin(two);
-                    }
-
-                    // calculate and lock into phase
-                    phase=(0.5+(atan2(dft[1],dft[0])/(2.0*M_PI)));
-
-                    if (fft->waveCorr) {
-                      fft->needle-=(phase+(fft->phaseOff*2))*fft->waveLen;
-                    }
+              unsigned short curNeedle=fft_->relatedBuf->getNeedle();
+              bool sameParams=fft_->analyzed && fft_->lastWindowSize==fft_->windowSize && fft_->lastWaveCorr==fft_->waveCorr;
+              if (sameParams && curNeedle==fft_->lastNeedle) {
+                // nothing new - reuse last result
+                fft_->needle=fft_->lastResult;
+              } else if (sameParams && !analyzeNow) {
+                // follow the needle, moving by whole periods to stay in phase
+                unsigned short delta=curNeedle-fft_->lastNeedle;
+                if (fft_->waveCorr && fft_->loudEnough && fft_->waveLen>=1.0) {
+                  fft_->needle=fft_->lastResult+(unsigned short)(round((double)delta/fft_->waveLen)*fft_->waveLen);
+                } else {
+                  fft_->needle=fft_->lastResult+delta;
+                }
+              } else {
+                // analyze
+                if (batchCount>=chanOscAnalyzer->batches.size()) {
+                  chanOscAnalyzer->newBatch();
+                }
+                ChanOscAnalyzer::Batch* batch=chanOscAnalyzer->batches[batchCount];
+                if (batch->count>=FURNACE_FFT_BATCH) {
+                  batchCount++;
+                  if (batchCount>=chanOscAnalyzer->batches.size()) {
+                    chanOscAnalyzer->newBatch();
                   }
+                  batch=chanOscAnalyzer->batches[batchCount];
                 }
-
-                fft->needle-=displaySize;
-              },fft_);
+                batch->chan[batch->count++]=fft_;
+              }
             }
           }
         }
+
+        // run analysis (one task per batch)
+        for (ChanOscAnalyzer::Batch* i: chanOscAnalyzer->batches) {
+          if (i->count<1) continue;
+          if (i->inBuf==NULL || i->outBuf==NULL || i->corrBuf==NULL) {
+            logE("failed to create FFT buffers");
+            i->count=0;
+            continue;
+          }
+          chanOscWorkPool->push(chanOscAnalyzeBatch,i);
+        }
         chanOscWorkPool->wait();
+        for (ChanOscAnalyzer::Batch* i: chanOscAnalyzer->batches) {
+          i->count=0;
+        }
 
         // 0: none
         // 1: sqrt(chans)
@@ -588,7 +803,8 @@ void FurnaceGUI::drawChanOsc() {
                   waveform[j]=ImLerp(inRect.Min,inRect.Max,ImVec2(x,0.5f));
                 }
               } else {
-                int displaySize=(float)(buf->rate)*(chanOscWindowSize/1000.0f);
+                int displaySize=(float)(buf->getRate())*(chanOscWindowSize/1000.0f);
+                const short* data=buf->getData();
 
                 float minLevel=1.0f;
                 float maxLevel=-1.0f;
@@ -635,14 +851,14 @@ void FurnaceGUI::drawChanOsc() {
                   }
                 } else {
                   for (unsigned short j=0; j<precision; j++) {
-                    float y=(float)buf->data[(unsigned short)(fft->needle+(j*displaySize/precision))]/32768.0f;
+                    float y=(float)data[(unsigned short)(fft->needle+(j*displaySize/precision))]/32768.0f;
                     if (minLevel>y) minLevel=y;
                     if (maxLevel<y) maxLevel=y;
                   }
                   dcOff=(minLevel+maxLevel)*0.5f;
                   for (unsigned short j=0; j<precision; j++) {
                     float x=(float)j/(float)precision;
-                    float y=(float)buf->data[(unsigned short)(fft->needle+(j*displaySize/precision))]/32768.0f;
+                    float y=(float)data[(unsigned short)(fft->needle+(j*displaySize/precision))]/32768.0f;
                     y-=dcOff;
                     if (y<-0.5f) y=-0.5f;
                     if (y>0.5f) y=0.5f;
@@ -253,7 +253,7 @@ void FurnaceGUI::drawDebug() {
                 ImGui::Checkbox(fmt::sprintf("##%d_OSCFollow_%d",i,c).c_str(),&oscBuf->follow);
                 // address
                 ImGui::TableNextColumn();
-                int needle=oscBuf->follow?oscBuf->needle:oscBuf->followNeedle;
+                int needle=oscBuf->follow?oscBuf->getNeedle():oscBuf->followNeedle;
                 ImGui::BeginDisabled(oscBuf->follow);
                 if (ImGui::InputInt(fmt::sprintf("##%d_OSCFollowNeedle_%d",i,c).c_str(),&needle,1,100)) {
                   oscBuf->followNeedle=MIN(MAX(needle,0),65535);
@@ -261,7 +261,12 @@ void FurnaceGUI::drawDebug() {
                 ImGui::EndDisabled();
                 // data
                 ImGui::TableNextColumn();
-                ImGui::Text("%d",oscBuf->data[needle]);
+                const short* oscData=oscBuf->getData();
+                if (oscData==NULL) {
+                  ImGui::Text("(not captured)");
+                } else {
+                  ImGui::Text("%d",oscData[needle]);
+                }
               }
               ImGui::EndTable();
             }
@@ -362,13 +367,24 @@ void FurnaceGUI::drawDebug() {
         ImGui::TableNextColumn();
         ImGui::Text("Delta");
 
+        int bases[12];
+        int finals[12];
+        // the frequency cache belongs to the engine thread
+        e->synchronized([&]() {
+          for (int i=0; i<12; i++) {
+            int note=(12*ptcOctave)+i;
+            bases[i]=e->calcBaseFreq(ptcClock,ptcDivider,note,ptcMode==1);
+            finals[i]=e->calcFreq(bases[i],0,ptcMode==1,0,0,ptcClock,ptcDivider,(ptcMode==2)?ptcBlockBits:0);
+          }
+        });
+
         int lastFinal=0;
         for (int i=0; i<12; i++) {
           int note=(12*ptcOctave)+i;
           int pitch=0;
 
-          int base=e->calcBaseFreq(ptcClock,ptcDivider,note,ptcMode==1);
-          int final=e->calcFreq(base,pitch,ptcMode==1,0,0,ptcClock,ptcDivider,(ptcMode==2)?ptcBlockBits:0);
+          int base=bases[i];
+          int final=finals[i];
 
           ImGui::TableNextRow();
           ImGui::TableNextColumn();
@@ -616,6 +632,76 @@ void FurnaceGUI::drawDebug() {
       for (int i=0; i<perfMetricsLastLen; i++) {
         ImGui::Text("%s: %.0fµs",perfMetricsLast[i].name,(double)perfMetricsLast[i].elapsed/perfFreq);
       }
+      ImGui::Separator();
+
+      bool profilerEnabled=e->profiler.enabled;
+      if (ImGui::Checkbox("Audio profiler",&profilerEnabled)) {
+        e->enableProfiler(profilerEnabled);
+      }
+      if (profilerEnabled) {
+        static const char* stageNames[DIV_PROF_MAX]={
+          "MIDI", "preview", "tick", "render", "fill", "mix", "osc", "total"
+        };
+        ImGui::Text("buffers: %llu, overruns: %llu, soft-locks: %llu, hangs: %llu",(unsigned long long)e->profiler.buffers,(unsigned long long)e->profiler.overruns,(unsigned long long)e->profiler.softLocks,(unsigned long long)e->profiler.hangs);
+        ImGui::Text("slowest tick: %.0fµs at order %.2X, row %d",(double)e->profiler.slowestTick/1000.0,(int)e->profiler.slowestTickOrder,(int)e->profiler.slowestTickRow);
+        if (ImGui::BeginTable("ProfilerStats",5,ImGuiTableFlags_Borders)) {
+          ImGui::TableNextRow(ImGuiTableRowFlags_Headers);
+          ImGui::TableNextColumn();
+          ImGui::Text("stage");
+          ImGui::TableNextColumn();
+          ImGui::Text("min");
+          ImGui::TableNextColumn();
+          ImGui::Text("avg");
+          ImGui::TableNextColumn();
+          ImGui::Text("max");
+          ImGui::TableNextColumn();
+          ImGui::Text("p99");
+          for (int i=0; i<DIV_PROF_MAX; i++) {
+            DivProfilerStats s=e->profiler.stage[i].getStats();
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s",stageNames[i]);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0fµs",s.min);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0fµs",s.avg);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0fµs",s.max);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0fµs",s.p99);
+          }
+          {
+            DivProfilerStats s=e->profiler.tick.getStats();
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("per tick");
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0fµs",s.min);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0fµs",s.avg);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0fµs",s.max);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0fµs",s.p99);
+          }
+          int chips=e->profiler.chips;
+          for (int i=0; i<chips; i++) {
+            DivProfilerStats s=e->profiler.chipAcquire[i].getStats();
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("chip %d",i+1);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0fµs",s.min);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0fµs",s.avg);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0fµs",s.max);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0fµs",s.p99);
+          }
+          ImGui::EndTable();
+        }
+      }
       ImGui::TreePop();
     }
     if (ImGui::TreeNode("Settings")) {
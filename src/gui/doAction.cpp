@@ -1016,6 +1016,7 @@ void FurnaceGUI::doAction(int what) {
             memcpy(&(sample->data16[pos]),sampleClipboard,sizeof(short)*sampleClipboardLen);
           }
         }
+        sample->invalidateSummary(pos,pos+sampleClipboardLen);
         e->renderSamples(curSample);
       });
       sampleSelStart=pos;
@@ -1046,6 +1047,7 @@ void FurnaceGUI::doAction(int what) {
             sample->data16[pos+i]=sampleClipboard[i];
           }
         }
+        sample->invalidateSummary(pos,pos+sampleClipboardLen);
         e->renderSamples(curSample);
       });
       sampleSelStart=pos;
@@ -1083,6 +1085,7 @@ void FurnaceGUI::doAction(int what) {
             sample->data16[pos+i]=val;
           }
         }
+        sample->invalidateSummary(pos,pos+sampleClipboardLen);
         e->renderSamples(curSample);
       });
       sampleSelStart=pos;
@@ -1152,6 +1155,7 @@ void FurnaceGUI::doAction(int what) {
             }
           }
         }
+        sample->invalidateSummary(start,end);
 
         updateSampleTex=true;
 
@@ -1183,6 +1187,7 @@ void FurnaceGUI::doAction(int what) {
             sample->data8[i]=val;
           }
         }
+        sample->invalidateSummary(start,end);
 
         updateSampleTex=true;
 
@@ -1214,6 +1219,7 @@ void FurnaceGUI::doAction(int what) {
             sample->data8[i]=val;
           }
         }
+        sample->invalidateSummary(start,end);
 
         updateSampleTex=true;
 
@@ -1243,6 +1249,7 @@ void FurnaceGUI::doAction(int what) {
             sample->data8[i]=0;
           }
         }
+        sample->invalidateSummary(start,end);
 
         updateSampleTex=true;
 
@@ -1312,6 +1319,7 @@ void FurnaceGUI::doAction(int what) {
             sample->data8[i]^=sample->data8[ri];
           }
         }
+        sample->invalidateSummary(start,end);
 
         updateSampleTex=true;
 
@@ -1339,6 +1347,7 @@ void FurnaceGUI::doAction(int what) {
             if (sample->data8[i]==-128) sample->data8[i]=127;
           }
         }
+        sample->invalidateSummary(start,end);
 
         updateSampleTex=true;
 
@@ -1364,6 +1373,7 @@ void FurnaceGUI::doAction(int what) {
             sample->data8[i]^=0x80;
           }
         }
+        sample->invalidateSummary(start,end);
 
         updateSampleTex=true;
 
@@ -79,7 +79,7 @@ void FurnaceGUI::prepareUndo(ActionType action) {
       }
       break;
     case GUI_UNDO_PATTERN_COLLAPSE_SONG:
-    case GUI_UNDO_PATTERN_EXPAND_SONG: // this is handled by doCollapseSong/doExpandSong
+    case GUI_UNDO_PATTERN_EXPAND_SONG: // this is handled by doCollapseSong/doExpandSong (which also touch the patterns)
       break;
     case GUI_UNDO_REPLACE: // this is handled by doReplace()
       break;
@@ -133,6 +133,7 @@ void FurnaceGUI::makeUndo(ActionType action) {
     case GUI_UNDO_PATTERN_DRAG:
       for (int i=0; i<e->getTotalChannelCount(); i++) {
         DivPattern* p=e->curPat[i].getPattern(e->curOrders->ord[i][curOrder],false);
+        size_t prevCount=s.pat.size();
         for (int j=0; j<e->curSubSong->patLen; j++) {
           for (int k=0; k<DIV_MAX_COLS; k++) {
             if (p->data[j][k]!=oldPat[i]->data[j][k]) {
@@ -152,13 +153,14 @@ void FurnaceGUI::makeUndo(ActionType action) {
             }
           }
         }
+        if (s.pat.size()!=prevCount) p->touch();
       }
       if (!s.pat.empty()) {
         doPush=true;
       }
       break;
     case GUI_UNDO_PATTERN_COLLAPSE_SONG:
-    case GUI_UNDO_PATTERN_EXPAND_SONG: // this is handled by doCollapseSong/doExpandSong
+    case GUI_UNDO_PATTERN_EXPAND_SONG: // this is handled by doCollapseSong/doExpandSong (which also touch the patterns)
       break;
     case GUI_UNDO_REPLACE: // this is handled by doReplace()
       break;
@@ -1573,6 +1575,12 @@ void FurnaceGUI::doCollapseSong(int divider) {
   DivPattern patCopy;
 
   size_t subSong=e->getCurrentSubSong();
+  // the loop below uses all rows
+  e->lockEngine([this]() {
+    for (int i=0; i<e->getTotalChannelCount(); i++) {
+      e->curPat[i].growPatterns(DIV_MAX_ROWS);
+    }
+  });
   for (int i=0; i<e->getTotalChannelCount(); i++) {
     for (int j=0; j<DIV_MAX_PATTERNS; j++) {
       if (e->curPat[i].data[j]==NULL) continue;
@@ -1605,6 +1613,7 @@ void FurnaceGUI::doCollapseSong(int divider) {
           }
         }
       }
+      pat->touch();
 
       // put undo
       for (int k=0; k<DIV_MAX_ROWS; k++) {
@@ -1619,7 +1628,7 @@ void FurnaceGUI::doCollapseSong(int divider) {
   // magic
   unsigned char* subSongInfoCopy=new unsigned char[1024];
   memcpy(subSongInfoCopy,e->curSubSong,1024);
-  e->curSubSong->patLen/=divider;
+  e->curSubSong->setPatLen(e->curSubSong->patLen/divider);
   for (int i=0; i<e->curSubSong->speeds.len; i++) {
     e->curSubSong->speeds.val[i]=CLAMP(e->curSubSong->speeds.val[i]*divider,1,255);
   }
@@ -1653,6 +1662,12 @@ void FurnaceGUI::doExpandSong(int multiplier) {
   DivPattern patCopy;
 
   size_t subSong=e->getCurrentSubSong();
+  // the loop below uses all rows
+  e->lockEngine([this]() {
+    for (int i=0; i<e->getTotalChannelCount(); i++) {
+      e->curPat[i].growPatterns(DIV_MAX_ROWS);
+    }
+  });
   for (int i=0; i<e->getTotalChannelCount(); i++) {
     for (int j=0; j<DIV_MAX_PATTERNS; j++) {
       if (e->curPat[i].data[j]==NULL) continue;
@@ -1685,6 +1700,7 @@ void FurnaceGUI::doExpandSong(int multiplier) {
           }
         }
       }
+      pat->touch();
 
       // put undo
       for (int k=0; k<DIV_MAX_ROWS; k++) {
@@ -1699,7 +1715,7 @@ void FurnaceGUI::doExpandSong(int multiplier) {
   // magic
   unsigned char* subSongInfoCopy=new unsigned char[1024];
   memcpy(subSongInfoCopy,e->curSubSong,1024);
-  e->curSubSong->patLen*=multiplier;
+  e->setPatternLength(subSong,e->curSubSong->patLen*multiplier);
   for (int i=0; i<e->curSubSong->speeds.len; i++) {
     e->curSubSong->speeds.val[i]=CLAMP(e->curSubSong->speeds.val[i]/multiplier,1,255);
   }
@@ -1774,7 +1790,11 @@ void FurnaceGUI::doUndo() {
       for (UndoPatternData& i: us.pat) {
         e->changeSongP(i.subSong);
         DivPattern* p=e->curPat[i.chan].getPattern(i.pat,true);
+        if (p->rows<=i.row) e->lockEngine([p,&i]() {
+          p->grow(i.row+1);
+        });
         p->data[i.row][i.col]=i.oldVal;
+        p->touch();
       }
       if (us.type!=GUI_UNDO_REPLACE) {
         if (!e->isPlaying() || !followPattern) {
@@ -1791,6 +1811,7 @@ void FurnaceGUI::doUndo() {
   }
 
   bool shallReplay=false;
+  int patLenSubSong=-1;
   for (UndoOtherData& i: us.other) {
     switch (i.target) {
       case GUI_UNDO_TARGET_SONG:
@@ -1800,10 +1821,13 @@ void FurnaceGUI::doUndo() {
       case GUI_UNDO_TARGET_SUBSONG:
         if (i.subtarget<0 || i.subtarget>=(int)e->song.subsong.size()) break;
         ((unsigned char*)(e->song.subsong[i.subtarget]))[i.off]=i.oldVal;
+        patLenSubSong=i.subtarget;
         shallReplay=true;
         break;
     }
   }
+  // the pattern length may have been restored
+  if (patLenSubSong>=0) e->setPatternLength(patLenSubSong,e->song.subsong[patLenSubSong]->patLen);
   if (shallReplay && e->isPlaying()) play();
 
   if (curOrder>=e->curSubSong->ordersLen) {
@@ -1850,7 +1874,11 @@ void FurnaceGUI::doRedo() {
       for (UndoPatternData& i: us.pat) {
         e->changeSongP(i.subSong);
         DivPattern* p=e->curPat[i.chan].getPattern(i.pat,true);
+        if (p->rows<=i.row) e->lockEngine([p,&i]() {
+          p->grow(i.row+1);
+        });
         p->data[i.row][i.col]=i.newVal;
+        p->touch();
       }
       if (us.type!=GUI_UNDO_REPLACE) {
         if (!e->isPlaying() || !followPattern) {
@@ -1867,6 +1895,7 @@ void FurnaceGUI::doRedo() {
   }
 
   bool shallReplay=false;
+  int patLenSubSong=-1;
   for (UndoOtherData& i: us.other) {
     switch (i.target) {
       case GUI_UNDO_TARGET_SONG:
@@ -1876,10 +1905,13 @@ void FurnaceGUI::doRedo() {
       case GUI_UNDO_TARGET_SUBSONG:
         if (i.subtarget<0 || i.subtarget>=(int)e->song.subsong.size()) break;
         ((unsigned char*)(e->song.subsong[i.subtarget]))[i.off]=i.newVal;
+        patLenSubSong=i.subtarget;
         shallReplay=true;
         break;
     }
   }
+  // the pattern length may have been restored
+  if (patLenSubSong>=0) e->setPatternLength(patLenSubSong,e->song.subsong[patLenSubSong]->patLen);
   if (shallReplay && e->isPlaying()) play();
 
   if (curOrder>=e->curSubSong->ordersLen) {
@@ -35,6 +35,14 @@ void FurnaceGUI::drawExportAudio(bool onWindow) {
   if (ImGui::InputDouble("Fade out (seconds)",&exportFadeOut,1.0,2.0,"%.1f")) {
     if (exportFadeOut<0.0) exportFadeOut=0.0;
   }
+  if (audioExportType==2) {
+    if (ImGui::InputInt("Jobs",&exportJobs,1,2)) {
+      if (exportJobs<0) exportJobs=0;
+    }
+    if (ImGui::IsItemHovered()) {
+      ImGui::SetTooltip("number of channels to render at once.\n0 means one per CPU core.");
+    }
+  }
 
   if (onWindow) {
     ImGui::Separator();
@@ -115,6 +123,23 @@ void FurnaceGUI::drawExportVGM(bool onWindow) {
       "at the cost of a massive increase in file size."
     );
   }
+  ImGui::BeginDisabled(vgmExportDirectStream);
+  ImGui::Checkbox("remove redundant writes",&vgmExportOptimize);
+  ImGui::EndDisabled();
+  if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) {
+    ImGui::SetTooltip(
+      "drops register writes which don't change anything\n"
+      "(and writes overwritten within the same tick) on FM/AY chips.\n\n"
+      "not available in direct stream mode."
+    );
+  }
+  ImGui::Checkbox("compress (VGZ)",&vgmExportCompress);
+  if (e->song.subsong.size()>1) {
+    ImGui::Checkbox("export all subsongs",&vgmExportAllSubSongs);
+    if (ImGui::IsItemHovered()) {
+      ImGui::SetTooltip("writes one file per subsong, with the subsong number appended to the file name.");
+    }
+  }
   ImGui::Text("chips to export:");
   bool hasOneAtLeast=false;
   for (int i=0; i<e->song.systemLen; i++) {
@@ -355,3 +380,103 @@ void FurnaceGUI::drawExport() {
       break;
   }
 }
+
+void FurnaceGUI::startStreamExport(DivStreamExportOptions& opts, const String& path, const char* what, bool allSubSongs) {
+  if (!allSubSongs || e->song.subsong.size()<2) {
+    DivStreamExport* job=e->startStreamExport(opts);
+    if (job==NULL) {
+      showError(fmt::sprintf("could not write %s! (%s)",what,e->getLastError()));
+      return;
+    }
+    streamExports.push_back(StreamExportJob(job,path,what));
+    return;
+  }
+
+  // song.vgm -> song_01.vgm, song_02.vgm...
+  String base=path;
+  String ext;
+  size_t extPos=path.rfind('.');
+  size_t dirPos=path.find_last_of("/\\");
+  if (extPos!=String::npos && (dirPos==String::npos || extPos>dirPos)) {
+    base=path.substr(0,extPos);
+    ext=path.substr(extPos);
+  }
+  for (size_t i=0; i<e->song.subsong.size(); i++) {
+    opts.subSong=i;
+    DivStreamExport* job=e->startStreamExport(opts);
+    if (job==NULL) {
+      showError(fmt::sprintf("could not write %s! (%s)",what,e->getLastError()));
+      return;
+    }
+    streamExports.push_back(StreamExportJob(job,fmt::sprintf("%s_%.2d%s",base,(int)i+1,ext),what));
+  }
+}
+
+void FurnaceGUI::finishStreamExport(StreamExportJob& job) {
+  SafeWriter* w=job.job->finish();
+  if (w!=NULL && job.cancelled) {
+    // aborted. don't leave a partial file behind
+    w->finish();
+    delete w;
+  } else if (w!=NULL) {
+    FILE* f=ps_fopen(job.path.c_str(),"wb");
+    if (f!=NULL) {
+      fwrite(w->getFinalBuf(),1,w->size(),f);
+      fclose(f);
+      pushRecentSys(job.path.c_str());
+    } else {
+      showError("could not open file!");
+    }
+    w->finish();
+    delete w;
+    if (!job.job->getWarnings().empty()) {
+      showWarning(job.job->getWarnings(),GUI_WARN_GENERIC);
+    }
+  } else if (!job.cancelled) {
+    showError(fmt::sprintf("could not write %s! (%s)",job.what,job.job->getError()));
+  }
+  delete job.job;
+  job.job=NULL;
+}
+
+void FurnaceGUI::drawStreamExports() {
+  if (streamExports.empty()) return;
+
+  for (size_t i=0; i<streamExports.size(); i++) {
+    if (!streamExports[i].job->isRunning()) {
+      finishStreamExport(streamExports[i]);
+      streamExports.erase(streamExports.begin()+i);
+      i--;
+    }
+  }
+  if (streamExports.empty()) return;
+
+  // not modal, so that playback and editing may continue
+  ImGui::SetNextWindowPos(ImVec2(canvasW-20.0f*dpiScale,canvasH-20.0f*dpiScale),ImGuiCond_Always,ImVec2(1.0f,1.0f));
+  if (ImGui::Begin("Exporting",NULL,ImGuiWindowFlags_AlwaysAutoResize|ImGuiWindowFlags_NoDocking|ImGuiWindowFlags_NoMove|ImGuiWindowFlags_NoCollapse|ImGuiWindowFlags_NoSavedSettings)) {
+    for (size_t i=0; i<streamExports.size(); i++) {
+      StreamExportJob& job=streamExports[i];
+      size_t namePos=job.path.find_last_of("/\\");
+      String name=(namePos==String::npos)?job.path:job.path.substr(namePos+1);
+      ImGui::PushID(i);
+      ImGui::ProgressBar(job.job->getProgress(),ImVec2(300.0f*dpiScale,0),fmt::sprintf("%s: %s",job.what,name).c_str());
+      ImGui::SameLine();
+      ImGui::BeginDisabled(job.cancelled);
+      if (ImGui::Button("Abort")) {
+        job.job->cancel();
+        job.cancelled=true;
+      }
+      ImGui::EndDisabled();
+      ImGui::PopID();
+    }
+    if (streamExports.size()>1) {
+      if (ImGui::Button("Abort all")) {
+        for (StreamExportJob& i: streamExports) {
+          i.job->cancel();
+          i.cancelled=true;
+        }
+      }
+    }
+  }
+  ImGui::End();
+}
@@ -481,6 +481,7 @@ void FurnaceGUI::doReplace() {
         us.pat.push_back(UndoPatternData(i.subsong,i.x,patIndex,i.y,j,prevVal[j],p->data[i.y][j]));
       }
     }
+    p->touch();
   }
 
   for (int i=0; i<DIV_MAX_CHANS; i++) {
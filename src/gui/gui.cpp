@@ -41,6 +41,7 @@
 #include <zlib.h>
 #include <fmt/printf.h>
 #include <stdexcept>
+#include <chrono>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -1867,7 +1868,7 @@ void FurnaceGUI::openFileDialog(FurnaceGUIFileDialogs type) {
       if (!dirExists(workingDirVGMExport)) workingDirVGMExport=getHomeDir();
       hasOpened=fileDialog->openSave(
         "Export VGM",
-        {"VGM file", "*.vgm"},
+        vgmExportCompress?std::vector<String>({"compressed VGM file", "*.vgz"}):std::vector<String>({"VGM file", "*.vgm"}),
         workingDirVGMExport,
         dpiScale
       );
@@ -2069,6 +2070,7 @@ void FurnaceGUI::openFileDialog(FurnaceGUIFileDialogs type) {
 int FurnaceGUI::save(String path, int dmfVersion) {
   SafeWriter* w;
   logD("saving file...");
+  std::chrono::steady_clock::time_point saveStart=std::chrono::steady_clock::now();
   if (dmfVersion) {
     if (dmfVersion<24) dmfVersion=24;
     w=e->saveDMF(dmfVersion);
@@ -2168,7 +2170,7 @@ int FurnaceGUI::save(String path, int dmfVersion) {
   }
   pushRecentFile(path);
   pushRecentSys(path.c_str());
-  logD("save complete.");
+  logI("saved song in %dms.",(int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()-saveStart).count());
   return 0;
 }
 
@@ -2384,7 +2386,7 @@ int FurnaceGUI::loadStream(String path) {
 
 
 void FurnaceGUI::exportAudio(String path, DivAudioExportModes mode) {
-  e->saveAudio(path.c_str(),exportLoops+1,mode,exportFadeOut);
+  e->saveAudio(path.c_str(),exportLoops+1,mode,exportFadeOut,exportJobs);
   displayExporting=true;
 }
 
@@ -2561,6 +2563,9 @@ void FurnaceGUI::processDrags(int dragX, int dragY) {
           if (val>127) val=127;
           for (int i=x; i<=x1; i++) ((signed char*)sampleDragTarget)[i]=val;
         }
+        if (curSample>=0 && curSample<(int)e->song.sample.size()) {
+          e->song.sample[curSample]->invalidateSummary(x,x1+1);
+        }
         updateSampleTex=true;
       }
     } else { // select
@@ -3911,15 +3916,7 @@ bool FurnaceGUI::loop() {
       }
       memset(chanOscBright,0,DIV_MAX_CHANS*sizeof(float));
 
-      e->synchronized([this]() {
-        for (int i=0; i<e->getTotalChannelCount(); i++) {
-          DivDispatchOscBuffer* buf=e->getOscBuffer(i);
-          if (buf!=NULL) {
-            buf->needle=0;
-            buf->readNeedle=0;
-          }
-        }
-      });
+      e->resetOscBuffers();
     }
 
     // recover from dead graphics
@@ -4827,7 +4824,7 @@ bool FurnaceGUI::loop() {
             checkExtension(".raw");
           }
           if (curFileDialog==GUI_FILE_EXPORT_VGM) {
-            checkExtension(".vgm");
+            checkExtension(vgmExportCompress?".vgz":".vgm");
           }
           if (curFileDialog==GUI_FILE_EXPORT_ZSM) {
             checkExtension(".zsm");
@@ -5164,45 +5161,26 @@ bool FurnaceGUI::loop() {
               break;
             }
             case GUI_FILE_EXPORT_VGM: {
-              SafeWriter* w=e->saveVGM(willExport,vgmExportLoop,vgmExportVersion,vgmExportPatternHints,vgmExportDirectStream,vgmExportTrailingTicks);
-              if (w!=NULL) {
-                FILE* f=ps_fopen(copyOfName.c_str(),"wb");
-                if (f!=NULL) {
-                  fwrite(w->getFinalBuf(),1,w->size(),f);
-                  fclose(f);
-                  pushRecentSys(copyOfName.c_str());
-                } else {
-                  showError("could not open file!");
-                }
-                w->finish();
-                delete w;
-                if (!e->getWarnings().empty()) {
-                  showWarning(e->getWarnings(),GUI_WARN_GENERIC);
-                }
-              } else {
-                showError(fmt::sprintf("could not write VGM! (%s)",e->getLastError()));
-              }
+              DivStreamExportOptions opts;
+              opts.type=DIV_STREAM_EXPORT_VGM;
+              memcpy(opts.vgmSystems,willExport,DIV_MAX_CHIPS*sizeof(bool));
+              opts.loop=vgmExportLoop;
+              opts.vgmVersion=vgmExportVersion;
+              opts.vgmPatternHints=vgmExportPatternHints;
+              opts.vgmDirectStream=vgmExportDirectStream;
+              opts.vgmTrailingTicks=vgmExportTrailingTicks;
+              opts.vgmOptimize=vgmExportOptimize;
+              opts.vgmCompress=vgmExportCompress;
+              startStreamExport(opts,copyOfName,"VGM",vgmExportAllSubSongs);
               break;
             }
             case GUI_FILE_EXPORT_ZSM: {
-              SafeWriter* w=e->saveZSM(zsmExportTickRate,zsmExportLoop,zsmExportOptimize);
-              if (w!=NULL) {
-                FILE* f=ps_fopen(copyOfName.c_str(),"wb");
-                if (f!=NULL) {
-                  fwrite(w->getFinalBuf(),1,w->size(),f);
-                  fclose(f);
-                  pushRecentSys(copyOfName.c_str());
-                } else {
-                  showError("could not open file!");
-                }
-                w->finish();
-                delete w;
-                if (!e->getWarnings().empty()) {
-                  showWarning(e->getWarnings(),GUI_WARN_GENERIC);
-                }
-              } else {
-                showError(fmt::sprintf("Could not write ZSM! (%s)",e->getLastError()));
-              }
+              DivStreamExportOptions opts;
+              opts.type=DIV_STREAM_EXPORT_ZSM;
+              opts.loop=zsmExportLoop;
+              opts.zsmRate=zsmExportTickRate;
+              opts.zsmOptimize=zsmExportOptimize;
+              startStreamExport(opts,copyOfName,"ZSM");
               break;
             }
             case GUI_FILE_EXPORT_ROM:
@@ -5231,26 +5209,9 @@ bool FurnaceGUI::loop() {
             }
             case GUI_FILE_EXPORT_CMDSTREAM:
             case GUI_FILE_EXPORT_CMDSTREAM_BINARY: {
-              bool isBinary=(curFileDialog==GUI_FILE_EXPORT_CMDSTREAM_BINARY);
-
-              SafeWriter* w=e->saveCommand(isBinary);
-              if (w!=NULL) {
-                FILE* f=ps_fopen(copyOfName.c_str(),"wb");
-                if (f!=NULL) {
-                  fwrite(w->getFinalBuf(),1,w->size(),f);
-                  fclose(f);
-                  pushRecentSys(copyOfName.c_str());
-                } else {
-                  showError("could not open file!");
-                }
-                w->finish();
-                delete w;
-                if (!e->getWarnings().empty()) {
-                  showWarning(e->getWarnings(),GUI_WARN_GENERIC);
-                }
-              } else {
-                showError(fmt::sprintf("could not write command stream! (%s)",e->getLastError()));
-              }
+              DivStreamExportOptions opts;
+              opts.type=(curFileDialog==GUI_FILE_EXPORT_CMDSTREAM_BINARY)?DIV_STREAM_EXPORT_COMMAND_BINARY:DIV_STREAM_EXPORT_COMMAND;
+              startStreamExport(opts,copyOfName,"command stream");
               break;
             }
             case GUI_FILE_LOAD_MAIN_FONT:
@@ -5411,6 +5372,8 @@ bool FurnaceGUI::loop() {
       ImGui::EndPopup();
     }
 
+    drawStreamExports();
+
     drawTutorial();
 
     ImVec2 newSongMinSize=mobileUI?ImVec2(canvasW-(portrait?0:(60.0*dpiScale)),canvasH-60.0*dpiScale):ImVec2(400.0f*dpiScale,200.0f*dpiScale);
@@ -5675,11 +5638,7 @@ bool FurnaceGUI::loop() {
               e->lockEngine([this]() {
                 for (int i=0; i<e->getTotalChannelCount(); i++) {
                   DivPattern* pat=e->curPat[i].getPattern(e->curOrders->ord[i][curOrder],true);
-                  memset(pat->data,-1,DIV_MAX_ROWS*DIV_MAX_COLS*sizeof(short));
-                  for (int j=0; j<DIV_MAX_ROWS; j++) {
-                    pat->data[j][0]=0;
-                    pat->data[j][1]=0;
-                  }
+                  pat->clear();
                 }
               });
               MARK_MODIFIED;
@@ -6484,6 +6443,8 @@ bool FurnaceGUI::init() {
   if (exportLoops<0) exportLoops=0;
   exportFadeOut=e->getConfDouble("exportFadeOut",0.0);
   if (exportFadeOut<0.0) exportFadeOut=0.0;
+  exportJobs=e->getConfInt("exportJobs",0);
+  if (exportJobs<0) exportJobs=0;
   orderEditMode=e->getConfInt("orderEditMode",0);
   if (orderEditMode<0) orderEditMode=0;
   if (orderEditMode>3) orderEditMode=3;
@@ -6515,6 +6476,7 @@ bool FurnaceGUI::init() {
   chanOscOptions=e->getConfBool("chanOscOptions",false);
   chanOscNormalize=e->getConfBool("chanOscNormalize",false);
   chanOscRandomPhase=e->getConfBool("chanOscRandomPhase",false);
+  chanOscAnalysisRate=e->getConfInt("chanOscAnalysisRate",60);
   chanOscTextFormat=e->getConfString("chanOscTextFormat","%c");
   chanOscColor.x=e->getConfFloat("chanOscColorR",1.0f);
   chanOscColor.y=e->getConfFloat("chanOscColorG",1.0f);
@@ -7035,6 +6997,7 @@ void FurnaceGUI::commitState() {
   e->setConf("followPattern",followPattern);
   e->setConf("orderEditMode",orderEditMode);
   e->setConf("noteInputPoly",noteInputPoly);
+  e->setConf("exportJobs",exportJobs);
   if (settings.persistFadeOut) {
     e->setConf("exportLoops",exportLoops);
     e->setConf("exportFadeOut",exportFadeOut);
@@ -7070,6 +7033,7 @@ void FurnaceGUI::commitState() {
   e->setConf("chanOscOptions",chanOscOptions);
   e->setConf("chanOscNormalize",chanOscNormalize);
   e->setConf("chanOscRandomPhase",chanOscRandomPhase);
+  e->setConf("chanOscAnalysisRate",chanOscAnalysisRate);
   e->setConf("chanOscTextFormat",chanOscTextFormat);
   e->setConf("chanOscColorR",chanOscColor.x);
   e->setConf("chanOscColorG",chanOscColor.y);
@@ -7134,6 +7098,14 @@ bool FurnaceGUI::finish() {
   if (chanOscWorkPool!=NULL) {
     delete chanOscWorkPool;
   }
+  freeChanOscAnalyzer();
+  freePatCells();
+
+  // don't wait for unfinished exports
+  for (StreamExportJob& i: streamExports) {
+    delete i.job;
+  }
+  streamExports.clear();
 
   return true;
 }
@@ -7167,6 +7139,9 @@ FurnaceGUI::FurnaceGUI():
   zsmExportOptimize(true),
   vgmExportPatternHints(false),
   vgmExportDirectStream(false),
+  vgmExportAllSubSongs(false),
+  vgmExportOptimize(false),
+  vgmExportCompress(false),
   displayInsTypeList(false),
   portrait(false),
   injectBackUp(false),
@@ -7271,6 +7246,7 @@ FurnaceGUI::FurnaceGUI():
   oldRow(0),
   editStep(1),
   exportLoops(0),
+  exportJobs(0),
   soloChan(-1),
   orderEditMode(0),
   orderCursor(-1),
@@ -7377,6 +7353,7 @@ FurnaceGUI::FurnaceGUI():
   curWindowLast(GUI_WINDOW_NOTHING),
   curWindowThreadSafe(GUI_WINDOW_NOTHING),
   failedNoteOn(false),
+  patCellEpoch(0),
   lastPatternWidth(0.0f),
   longThreshold(0.48f),
   buttonLongThreshold(0.20f),
@@ -7577,6 +7554,8 @@ FurnaceGUI::FurnaceGUI():
   chanOscGrad(64,64),
   chanOscGradTex(NULL),
   chanOscWorkPool(NULL),
+  chanOscAnalyzer(NULL),
+  chanOscAnalysisRate(60),
   xyOscPointTex(NULL),
   xyOscOptions(false),
   xyOscXChannel(0),
@@ -46,8 +46,7 @@
 
 #define RESET_WAVE_MACRO_ZOOM \
   for (DivInstrument* _wi: e->song.ins) { \
-    _wi->std.waveMacro.vZoom=-1; \
-    _wi->std.waveMacro.vScroll=-1; \
+    _wi->std.waveMacro.edit.resetZoom(); \
   }
 
 #define CHECK_LONG_HOLD (mobileUI && ImGui::GetIO().MouseDown[ImGuiMouseButton_Left] && ImGui::GetIO().MouseDownDuration[ImGuiMouseButton_Left]>=longThreshold && ImGui::GetIO().MouseDownDurationPrev[ImGuiMouseButton_Left]<longThreshold && ImGui::GetIO().MouseDragMaxDistanceSqr[ImGuiMouseButton_Left]<=ImGui::GetIO().ConfigInertialScrollToleranceSqr)
@@ -67,6 +66,11 @@
 
 #define FM_PREVIEW_SIZE 512
 
+// pattern cell cache: slots per channel (current pattern plus previous/next
+// order ghost rows) and bytes per formatted cell
+#define GUI_PAT_CELL_SLOTS 3
+#define GUI_PAT_CELL_LEN 24
+
 enum FurnaceGUIRenderBackend {
   GUI_BACKEND_SDL=0,
   GUI_BACKEND_GL,
@@ -1451,7 +1455,7 @@ class FurnaceGUI {
   std::vector<String> availAudioDrivers;
 
   bool quit, warnQuit, willCommit, edit, editClone, isPatUnique, modified, displayError, displayExporting, vgmExportLoop, zsmExportLoop, zsmExportOptimize, vgmExportPatternHints;
-  bool vgmExportDirectStream, displayInsTypeList, displayWaveSizeList;
+  bool vgmExportDirectStream, vgmExportAllSubSongs, vgmExportOptimize, vgmExportCompress, displayInsTypeList, displayWaveSizeList;
   bool portrait, injectBackUp, mobileMenuOpen, warnColorPushed;
   bool wantCaptureKeyboard, oldWantCaptureKeyboard, displayMacroMenu;
   bool displayNew, displayExport, fullScreen, preserveChanPos, wantScrollList, noteInputPoly, notifyWaveChange;
@@ -1713,6 +1717,7 @@ class FurnaceGUI {
     int wasapiEx;
     int chanOscThreads;
     int renderPoolThreads;
+    int renderPoolBatch;
     int showPool;
     int writeInsNames;
     int readInsNames;
@@ -1910,6 +1915,7 @@ class FurnaceGUI {
       wasapiEx(0),
       chanOscThreads(0),
       renderPoolThreads(0),
+      renderPoolBatch(0),
       showPool(0),
       writeInsNames(0),
       readInsNames(1),
@@ -1956,7 +1962,7 @@ class FurnaceGUI {
 
   DivInstrument* prevInsData;
 
-  int curIns, curWave, curSample, curOctave, curOrder, playOrder, prevIns, oldRow, editStep, exportLoops, soloChan, orderEditMode, orderCursor;
+  int curIns, curWave, curSample, curOctave, curOrder, playOrder, prevIns, oldRow, editStep, exportLoops, exportJobs, soloChan, orderEditMode, orderCursor;
   int loopOrder, loopRow, loopEnd, isClipping, newSongCategory, latchTarget;
   int wheelX, wheelY, dragSourceX, dragSourceXFine, dragSourceY, dragDestinationX, dragDestinationXFine, dragDestinationY, oldBeat, oldBar;
   int curGroove, exitDisabledTimer;
@@ -1992,6 +1998,41 @@ class FurnaceGUI {
   float peak[DIV_MAX_OUTPUTS];
   float patChanX[DIV_MAX_CHANS+1];
   float patChanSlideY[DIV_MAX_CHANS+1];
+  // pre-formatted pattern cell labels (see getPatCellRow() in pattern.cpp).
+  // a slot is refreshed when its pattern's revision or the display key changes,
+  // and rows are formatted on first draw only.
+  struct PatCellCache {
+    const DivPattern* pat;
+    unsigned int revision, key, gen;
+    int rows, cols, lastUsed;
+    // row i is formatted if rowGen[i]==gen
+    unsigned int* rowGen;
+    char* text;
+    PatCellCache():
+      pat(NULL),
+      revision(0),
+      key(0),
+      gen(0),
+      rows(0),
+      cols(0),
+      lastUsed(0),
+      rowGen(NULL),
+      text(NULL) {}
+  } patCells[DIV_MAX_CHANS][GUI_PAT_CELL_SLOTS];
+  // bumped when labels change (applyUISettings)
+  unsigned int patCellEpoch;
+  // VGM/ZSM/command stream exports running in the background
+  struct StreamExportJob {
+    DivStreamExport* job;
+    String path, what;
+    bool cancelled;
+    StreamExportJob(DivStreamExport* j, const String& p, const char* w):
+      job(j),
+      path(p),
+      what(w),
+      cancelled(false) {}
+  };
+  std::vector<StreamExportJob> streamExports;
   float lastPatternWidth, longThreshold;
   float buttonLongThreshold;
   String nextDesc;
@@ -2235,7 +2276,6 @@ class FurnaceGUI {
   unsigned short lastCorrPos[DIV_MAX_CHANS];
   struct ChanOscStatus {
     double* inBuf;
-    fftw_complex* outBuf;
     double* corrBuf;
     DivDispatchOscBuffer* relatedBuf;
     size_t inBufPos;
@@ -2245,11 +2285,12 @@ class FurnaceGUI {
     float pitch, windowSize, phaseOff;
     unsigned short needle;
     bool ready, loudEnough, waveCorr;
-    fftw_plan plan;
-    fftw_plan planI;
+    // result of the last analysis (reused while the needle doesn't move, or between throttled analyses)
+    unsigned short lastNeedle, lastResult;
+    float lastWindowSize;
+    bool lastWaveCorr, analyzed;
     ChanOscStatus():
       inBuf(NULL),
-      outBuf(NULL),
       corrBuf(NULL),
       relatedBuf(NULL),
       inBufPos(0),
@@ -2265,9 +2306,17 @@ class FurnaceGUI {
       ready(false),
       loudEnough(false),
       waveCorr(false),
-      plan(NULL),
-      planI(NULL) {}
+      lastNeedle(0),
+      lastResult(0),
+      lastWindowSize(0.0f),
+      lastWaveCorr(false),
+      analyzed(false) {}
   } chanOscChan[DIV_MAX_CHANS];
+  // batched FFT plans and buffers for chan osc analysis (see chanOsc.cpp)
+  struct ChanOscAnalyzer;
+  ChanOscAnalyzer* chanOscAnalyzer;
+  // how many times per second to analyze (0: every frame)
+  int chanOscAnalysisRate;
 
   // x-y oscilloscope
   FurnaceGUITexture* xyOscPointTex;
@@ -2365,6 +2414,10 @@ class FurnaceGUI {
   void drawExportText(bool onWindow=false);
   void drawExportCommand(bool onWindow=false);
 
+  void startStreamExport(DivStreamExportOptions& opts, const String& path, const char* what, bool allSubSongs=false);
+  void finishStreamExport(StreamExportJob& job);
+  void drawStreamExports();
+
   void drawSSGEnv(unsigned char type, const ImVec2& size);
   void drawWaveform(unsigned char type, bool opz, const ImVec2& size);
   void drawAlgorithm(unsigned char alg, FurnaceGUIFMAlgs algType, const ImVec2& size);
@@ -2404,6 +2457,8 @@ class FurnaceGUI {
 
   void readOsc();
   void calcChanOsc();
+  void freeChanOscAnalyzer();
+  static void chanOscAnalyzeBatch(void* batch);
 
   void pushAccentColors(const ImVec4& one, const ImVec4& two, const ImVec4& border, const ImVec4& borderShadow);
   void popAccentColors();
@@ -2417,6 +2472,8 @@ class FurnaceGUI {
 
   float calcBPM(const DivGroovePattern& speeds, float hz, int vN, int vD);
 
+  const char* getPatCellRow(int chan, const DivPattern* pat, int row);
+  void freePatCells();
   void patternRow(int i, bool isPlaying, float lineHeight, int chans, int ord, const DivPattern** patCache, bool inhibitSel);
 
   void drawMacroEdit(FurnaceGUIMacroDesc& i, int totalFit, float availableWidth, int index);
@@ -387,7 +387,7 @@ const char* macroQSoundMode="QSound";
 const char* macroDummyMode="Bug";
 
 String macroHoverNote(int id, float val, void* u) {
-  int* macroVal=(int*)u;
+  const DivMacroData& macroVal=*(const DivMacroData*)u;
   if ((macroVal[id]&0xc0000000)==0x40000000 || (macroVal[id]&0xc0000000)==0x80000000) {
     if (val<-60 || val>=120) return "???";
     return fmt::sprintf("%d: %s",id,noteNames[(int)val+60]);
@@ -1379,15 +1379,17 @@ void FurnaceGUI::drawMacroEdit(FurnaceGUIMacroDesc& i, int totalFit, float avail
   static bool doHighlight[256];
 
   if ((i.macro->open&6)==0) {
+    // read through a const reference so that drawing doesn't allocate
+    const DivMacroData& macroVal=i.macro->val;
     for (int j=0; j<256; j++) {
       bit30Indicator[j]=0;
       if (j+macroDragScroll>=i.macro->len) {
         asFloat[j]=0;
         asInt[j]=0;
       } else {
-        asFloat[j]=deBit30(i.macro->val[j+macroDragScroll]);
-        asInt[j]=deBit30(i.macro->val[j+macroDragScroll])+i.bitOffset;
-        if (i.bit30) bit30Indicator[j]=enBit30(i.macro->val[j+macroDragScroll]);
+        asFloat[j]=deBit30(macroVal[j+macroDragScroll]);
+        asInt[j]=deBit30(macroVal[j+macroDragScroll])+i.bitOffset;
+        if (i.bit30) bit30Indicator[j]=enBit30(macroVal[j+macroDragScroll]);
       }
       if (j+macroDragScroll>=i.macro->len || (j+macroDragScroll>i.macro->rel && i.macro->loop<i.macro->rel)) {
         loopIndicator[j]=0;
@@ -1397,20 +1399,20 @@ void FurnaceGUI::drawMacroEdit(FurnaceGUIMacroDesc& i, int totalFit, float avail
     }
     ImGui::PushStyleVar(ImGuiStyleVar_FramePadding,ImVec2(0.0f,0.0f));
 
-    if (i.macro->vZoom<1) {
+    if (i.macro->edit->vZoom<1) {
       if (i.macro->macroType==DIV_MACRO_ARP) {
-        i.macro->vZoom=24;
-        i.macro->vScroll=120-12;
+        i.macro->edit->vZoom=24;
+        i.macro->edit->vScroll=120-12;
       } else if (i.macro->macroType==DIV_MACRO_PITCH) {
-        i.macro->vZoom=128;
-        i.macro->vScroll=2048-64;
+        i.macro->edit->vZoom=128;
+        i.macro->edit->vScroll=2048-64;
       } else {
-        i.macro->vZoom=i.max-i.min;
-        i.macro->vScroll=0;
+        i.macro->edit->vZoom=i.max-i.min;
+        i.macro->edit->vScroll=0;
       }
     }
-    if (i.macro->vZoom>(i.max-i.min)) {
-      i.macro->vZoom=i.max-i.min;
+    if (i.macro->edit->vZoom>(i.max-i.min)) {
+      i.macro->edit->vZoom=i.max-i.min;
     }
 
     memset(doHighlight,0,256*sizeof(bool));
@@ -1438,7 +1440,7 @@ void FurnaceGUI::drawMacroEdit(FurnaceGUIMacroDesc& i, int totalFit, float avail
     if (i.isBitfield) {
       PlotBitfield("##IMacro",asInt,totalFit,0,i.bitfieldBits,i.max,ImVec2(availableWidth,(i.macro->open&1)?(i.height*dpiScale):(32.0f*dpiScale)),sizeof(float),doHighlight);
     } else {
-      PlotCustom("##IMacro",asFloat,totalFit,macroDragScroll,NULL,i.min+i.macro->vScroll,i.min+i.macro->vScroll+i.macro->vZoom,ImVec2(availableWidth,(i.macro->open&1)?(i.height*dpiScale):(32.0f*dpiScale)),sizeof(float),i.color,i.macro->len-macroDragScroll,i.hoverFunc,i.hoverFuncUser,i.blockMode,(i.macro->open&1)?genericGuide:NULL,doHighlight);
+      PlotCustom("##IMacro",asFloat,totalFit,macroDragScroll,NULL,i.min+i.macro->edit->vScroll,i.min+i.macro->edit->vScroll+i.macro->edit->vZoom,ImVec2(availableWidth,(i.macro->open&1)?(i.height*dpiScale):(32.0f*dpiScale)),sizeof(float),i.color,i.macro->len-macroDragScroll,i.hoverFunc,i.hoverFuncUser,i.blockMode,(i.macro->open&1)?genericGuide:NULL,doHighlight);
     }
     if ((i.macro->open&1) && (ImGui::IsItemClicked(ImGuiMouseButton_Left) || ImGui::IsItemClicked(ImGuiMouseButton_Right))) {
       ImGui::InhibitInertialScroll();
@@ -1448,8 +1450,8 @@ void FurnaceGUI::drawMacroEdit(FurnaceGUIMacroDesc& i, int totalFit, float avail
         macroDragMin=i.min;
         macroDragMax=i.max;
       } else {
-        macroDragMin=i.min+i.macro->vScroll;
-        macroDragMax=i.min+i.macro->vScroll+i.macro->vZoom;
+        macroDragMin=i.min+i.macro->edit->vScroll;
+        macroDragMax=i.min+i.macro->edit->vScroll+i.macro->edit->vZoom;
       }
       macroDragBitOff=i.bitOffset;
       macroDragBitMode=i.isBitfield;
@@ -1470,11 +1472,11 @@ void FurnaceGUI::drawMacroEdit(FurnaceGUIMacroDesc& i, int totalFit, float avail
       if (ImGui::IsItemHovered()) {
         if (ctrlWheeling) {
           if (ImGui::IsKeyDown(ImGuiKey_LeftShift) || ImGui::IsKeyDown(ImGuiKey_RightShift)) {
-            i.macro->vZoom+=wheelY*(1+(i.macro->vZoom>>4));
-            if (i.macro->vZoom<1) i.macro->vZoom=1;
-            if (i.macro->vZoom>(i.max-i.min)) i.macro->vZoom=i.max-i.min;
-            if ((i.macro->vScroll+i.macro->vZoom)>(i.max-i.min)) {
-              i.macro->vScroll=(i.max-i.min)-i.macro->vZoom;
+            i.macro->edit->vZoom+=wheelY*(1+(i.macro->edit->vZoom>>4));
+            if (i.macro->edit->vZoom<1) i.macro->edit->vZoom=1;
+            if (i.macro->edit->vZoom>(i.max-i.min)) i.macro->edit->vZoom=i.max-i.min;
+            if ((i.macro->edit->vScroll+i.macro->edit->vZoom)>(i.max-i.min)) {
+              i.macro->edit->vScroll=(i.max-i.min)-i.macro->edit->vZoom;
             }
           } else {
             macroPointSize+=wheelY;
@@ -1482,9 +1484,9 @@ void FurnaceGUI::drawMacroEdit(FurnaceGUIMacroDesc& i, int totalFit, float avail
             if (macroPointSize>256) macroPointSize=256;
           }
         } else if ((ImGui::IsKeyDown(ImGuiKey_LeftShift) || ImGui::IsKeyDown(ImGuiKey_RightShift)) && wheelY!=0) {
-          i.macro->vScroll+=wheelY*(1+(i.macro->vZoom>>4));
-          if (i.macro->vScroll<0) i.macro->vScroll=0;
-          if (i.macro->vScroll>((i.max-i.min)-i.macro->vZoom)) i.macro->vScroll=(i.max-i.min)-i.macro->vZoom;
+          i.macro->edit->vScroll+=wheelY*(1+(i.macro->edit->vZoom>>4));
+          if (i.macro->edit->vScroll<0) i.macro->edit->vScroll=0;
+          if (i.macro->edit->vScroll>((i.max-i.min)-i.macro->edit->vZoom)) i.macro->edit->vScroll=(i.max-i.min)-i.macro->edit->vZoom;
         }
       }
 
@@ -1492,18 +1494,18 @@ void FurnaceGUI::drawMacroEdit(FurnaceGUIMacroDesc& i, int totalFit, float avail
       if (!i.isBitfield) {
         if (settings.oldMacroVSlider) {
           ImGui::SameLine(0.0f);
-          if (ImGui::VSliderInt("##IMacroVScroll",ImVec2(20.0f*dpiScale,i.height*dpiScale),&i.macro->vScroll,0,(i.max-i.min)-i.macro->vZoom,"",ImGuiSliderFlags_NoInput)) {
-            if (i.macro->vScroll<0) i.macro->vScroll=0;
-            if (i.macro->vScroll>((i.max-i.min)-i.macro->vZoom)) i.macro->vScroll=(i.max-i.min)-i.macro->vZoom;
+          if (ImGui::VSliderInt("##IMacroVScroll",ImVec2(20.0f*dpiScale,i.height*dpiScale),&i.macro->edit->vScroll,0,(i.max-i.min)-i.macro->edit->vZoom,"",ImGuiSliderFlags_NoInput)) {
+            if (i.macro->edit->vScroll<0) i.macro->edit->vScroll=0;
+            if (i.macro->edit->vScroll>((i.max-i.min)-i.macro->edit->vZoom)) i.macro->edit->vScroll=(i.max-i.min)-i.macro->edit->vZoom;
           }
           if (ImGui::IsItemHovered() && ctrlWheeling) {
-            i.macro->vScroll+=wheelY*(1+(i.macro->vZoom>>4));
-            if (i.macro->vScroll<0) i.macro->vScroll=0;
-            if (i.macro->vScroll>((i.max-i.min)-i.macro->vZoom)) i.macro->vScroll=(i.max-i.min)-i.macro->vZoom;
+            i.macro->edit->vScroll+=wheelY*(1+(i.macro->edit->vZoom>>4));
+            if (i.macro->edit->vScroll<0) i.macro->edit->vScroll=0;
+            if (i.macro->edit->vScroll>((i.max-i.min)-i.macro->edit->vZoom)) i.macro->edit->vScroll=(i.max-i.min)-i.macro->edit->vZoom;
           }
         } else {
-          ImS64 scrollV=(i.max-i.min-i.macro->vZoom)-i.macro->vScroll;
-          ImS64 availV=i.macro->vZoom;
+          ImS64 scrollV=(i.max-i.min-i.macro->edit->vZoom)-i.macro->edit->vScroll;
+          ImS64 availV=i.macro->edit->vZoom;
           ImS64 contentsV=(i.max-i.min);
 
           ImGui::SameLine(0.0f);
@@ -1513,15 +1515,15 @@ void FurnaceGUI::drawMacroEdit(FurnaceGUIMacroDesc& i, int totalFit, float avail
           scrollbarPos.Max.y+=i.height*dpiScale;
           ImGui::Dummy(ImVec2(ImGui::GetStyle().ScrollbarSize,i.height*dpiScale));
           if (ImGui::IsItemHovered() && ctrlWheeling) {
-            i.macro->vScroll+=wheelY*(1+(i.macro->vZoom>>4));
-            if (i.macro->vScroll<0) i.macro->vScroll=0;
-            if (i.macro->vScroll>((i.max-i.min)-i.macro->vZoom)) i.macro->vScroll=(i.max-i.min)-i.macro->vZoom;
+            i.macro->edit->vScroll+=wheelY*(1+(i.macro->edit->vZoom>>4));
+            if (i.macro->edit->vScroll<0) i.macro->edit->vScroll=0;
+            if (i.macro->edit->vScroll>((i.max-i.min)-i.macro->edit->vZoom)) i.macro->edit->vScroll=(i.max-i.min)-i.macro->edit->vZoom;
           }
 
           ImGuiID scrollbarID=ImGui::GetID("##IMacroVScroll");
           ImGui::KeepAliveID(scrollbarID);
           if (ImGui::ScrollbarEx(scrollbarPos,scrollbarID,ImGuiAxis_Y,&scrollV,availV,contentsV,0)) {
-            i.macro->vScroll=(i.max-i.min-i.macro->vZoom)-scrollV;
+            i.macro->edit->vScroll=(i.max-i.min-i.macro->edit->vZoom)-scrollV;
           }
         }
       }
@@ -1577,7 +1579,9 @@ void FurnaceGUI::drawMacroEdit(FurnaceGUIMacroDesc& i, int totalFit, float avail
         decodeMMLStr(mmlStr,i.macro->val,i.macro->len,i.macro->loop,i.min,(i.isBitfield)?((1<<(i.isBitfield?i.max:0))-1):i.max,i.macro->rel,i.bit30);
       }
       if (!ImGui::IsItemActive()) {
-        encodeMMLStr(mmlStr,i.macro->val,i.macro->len,i.macro->loop,i.macro->rel,false,i.bit30);
+        int macroVals[256];
+        i.macro->val.copyTo(macroVals);
+        encodeMMLStr(mmlStr,macroVals,i.macro->len,i.macro->loop,i.macro->rel,false,i.bit30);
       }
     }
     ImGui::PopStyleVar();
@@ -1771,14 +1775,14 @@ void FurnaceGUI::drawMacroEdit(FurnaceGUIMacroDesc& i, int totalFit, float avail
       /* swap memory */ \
       /* this way the macro isn't corrupted if the user decides to go */ \
       /* back to sequence mode */ \
-      i.macro->len^=i.macro->lenMemory; \
-      i.macro->lenMemory^=i.macro->len; \
-      i.macro->len^=i.macro->lenMemory; \
+      i.macro->len^=i.macro->edit->lenMemory; \
+      i.macro->edit->lenMemory^=i.macro->len; \
+      i.macro->len^=i.macro->edit->lenMemory; \
 \
       for (int j=0; j<16; j++) { \
-        i.macro->val[j]^=i.macro->typeMemory[j]; \
-        i.macro->typeMemory[j]^=i.macro->val[j]; \
-        i.macro->val[j]^=i.macro->typeMemory[j]; \
+        i.macro->val[j]^=i.macro->edit->typeMemory[j]; \
+        i.macro->edit->typeMemory[j]^=i.macro->val[j]; \
+        i.macro->val[j]^=i.macro->edit->typeMemory[j]; \
       } \
 \
       /* if ADSR/LFO, populate min/max */ \
@@ -2913,45 +2917,45 @@ void FurnaceGUI::drawInsEdit() {
               ins->type=i;
 
               // reset macro zoom
-              ins->std.volMacro.vZoom=-1;
-              ins->std.dutyMacro.vZoom=-1;
-              ins->std.waveMacro.vZoom=-1;
-              ins->std.ex1Macro.vZoom=-1;
-              ins->std.ex2Macro.vZoom=-1;
-              ins->std.ex3Macro.vZoom=-1;
-              ins->std.ex4Macro.vZoom=-1;
-              ins->std.ex5Macro.vZoom=-1;
-              ins->std.ex6Macro.vZoom=-1;
-              ins->std.ex7Macro.vZoom=-1;
-              ins->std.ex8Macro.vZoom=-1;
-              ins->std.panLMacro.vZoom=-1;
-              ins->std.panRMacro.vZoom=-1;
-              ins->std.phaseResetMacro.vZoom=-1;
-              ins->std.algMacro.vZoom=-1;
-              ins->std.fbMacro.vZoom=-1;
-              ins->std.fmsMacro.vZoom=-1;
-              ins->std.amsMacro.vZoom=-1;
+              ins->std.volMacro.edit.resetZoom();
+              ins->std.dutyMacro.edit.resetZoom();
+              ins->std.waveMacro.edit.resetZoom();
+              ins->std.ex1Macro.edit.resetZoom();
+              ins->std.ex2Macro.edit.resetZoom();
+              ins->std.ex3Macro.edit.resetZoom();
+              ins->std.ex4Macro.edit.resetZoom();
+              ins->std.ex5Macro.edit.resetZoom();
+              ins->std.ex6Macro.edit.resetZoom();
+              ins->std.ex7Macro.edit.resetZoom();
+              ins->std.ex8Macro.edit.resetZoom();
+              ins->std.panLMacro.edit.resetZoom();
+              ins->std.panRMacro.edit.resetZoom();
+              ins->std.phaseResetMacro.edit.resetZoom();
+              ins->std.algMacro.edit.resetZoom();
+              ins->std.fbMacro.edit.resetZoom();
+              ins->std.fmsMacro.edit.resetZoom();
+              ins->std.amsMacro.edit.resetZoom();
               for (int j=0; j<4; j++) {
-                ins->std.opMacros[j].amMacro.vZoom=-1;
-                ins->std.opMacros[j].arMacro.vZoom=-1;
-                ins->std.opMacros[j].drMacro.vZoom=-1;
-                ins->std.opMacros[j].multMacro.vZoom=-1;
-                ins->std.opMacros[j].rrMacro.vZoom=-1;
-                ins->std.opMacros[j].slMacro.vZoom=-1;
-                ins->std.opMacros[j].tlMacro.vZoom=-1;
-                ins->std.opMacros[j].dt2Macro.vZoom=-1;
-                ins->std.opMacros[j].rsMacro.vZoom=-1;
-                ins->std.opMacros[j].dtMacro.vZoom=-1;
-                ins->std.opMacros[j].d2rMacro.vZoom=-1;
-                ins->std.opMacros[j].ssgMacro.vZoom=-1;
-                ins->std.opMacros[j].damMacro.vZoom=-1;
-                ins->std.opMacros[j].dvbMacro.vZoom=-1;
-                ins->std.opMacros[j].egtMacro.vZoom=-1;
-                ins->std.opMacros[j].kslMacro.vZoom=-1;
-                ins->std.opMacros[j].susMacro.vZoom=-1;
-                ins->std.opMacros[j].vibMacro.vZoom=-1;
-                ins->std.opMacros[j].wsMacro.vZoom=-1;
-                ins->std.opMacros[j].ksrMacro.vZoom=-1;
+                ins->std.opMacros[j].amMacro.edit.resetZoom();
+                ins->std.opMacros[j].arMacro.edit.resetZoom();
+                ins->std.opMacros[j].drMacro.edit.resetZoom();
+                ins->std.opMacros[j].multMacro.edit.resetZoom();
+                ins->std.opMacros[j].rrMacro.edit.resetZoom();
+                ins->std.opMacros[j].slMacro.edit.resetZoom();
+                ins->std.opMacros[j].tlMacro.edit.resetZoom();
+                ins->std.opMacros[j].dt2Macro.edit.resetZoom();
+                ins->std.opMacros[j].rsMacro.edit.resetZoom();
+                ins->std.opMacros[j].dtMacro.edit.resetZoom();
+                ins->std.opMacros[j].d2rMacro.edit.resetZoom();
+                ins->std.opMacros[j].ssgMacro.edit.resetZoom();
+                ins->std.opMacros[j].damMacro.edit.resetZoom();
+                ins->std.opMacros[j].dvbMacro.edit.resetZoom();
+                ins->std.opMacros[j].egtMacro.edit.resetZoom();
+                ins->std.opMacros[j].kslMacro.edit.resetZoom();
+                ins->std.opMacros[j].susMacro.edit.resetZoom();
+                ins->std.opMacros[j].vibMacro.edit.resetZoom();
+                ins->std.opMacros[j].wsMacro.edit.resetZoom();
+                ins->std.opMacros[j].ksrMacro.edit.resetZoom();
               }
             }
           }
@@ -5004,11 +5008,11 @@ void FurnaceGUI::drawInsEdit() {
           popToggleColors();
 
           if (ImGui::Checkbox("Absolute Cutoff Macro",&ins->c64.filterIsAbs)) {
-            ins->std.algMacro.vZoom=-1;
+            ins->std.algMacro.edit.resetZoom();
             PARAMETER;
           }
           if (ImGui::Checkbox("Absolute Duty Macro",&ins->c64.dutyIsAbs)) {
-            ins->std.dutyMacro.vZoom=-1;
+            ins->std.dutyMacro.edit.resetZoom();
             PARAMETER;
           }
           P(ImGui::Checkbox("Don't test before new note",&ins->c64.noTest));
@@ -6331,7 +6335,7 @@ void FurnaceGUI::drawInsEdit() {
             macroList.push_back(FurnaceGUIMacroDesc(volumeLabel,&ins->std.volMacro,volMin,volMax,160,uiColors[GUI_COLOR_MACRO_VOLUME]));
           }
           if (ins->type!=DIV_INS_MSM6258 && ins->type!=DIV_INS_MSM6295 && ins->type!=DIV_INS_ADPCMA) {
-            macroList.push_back(FurnaceGUIMacroDesc("Arpeggio",&ins->std.arpMacro,-120,120,160,uiColors[GUI_COLOR_MACRO_PITCH],true,NULL,macroHoverNote,false,NULL,0,true,ins->std.arpMacro.val));
+            macroList.push_back(FurnaceGUIMacroDesc("Arpeggio",&ins->std.arpMacro,-120,120,160,uiColors[GUI_COLOR_MACRO_PITCH],true,NULL,macroHoverNote,false,NULL,0,true,&ins->std.arpMacro.val));
           }
           if (dutyMax>0) {
             if (ins->type==DIV_INS_MIKEY) {
@@ -6540,7 +6544,9 @@ void FurnaceGUI::drawInsEdit() {
     if (ImGui::BeginPopup("macroMenu",ImGuiWindowFlags_NoMove|ImGuiWindowFlags_AlwaysAutoResize|ImGuiWindowFlags_NoTitleBar|ImGuiWindowFlags_NoSavedSettings)) {
       if (ImGui::MenuItem("copy")) {
         String mmlStr;
-        encodeMMLStr(mmlStr,lastMacroDesc.macro->val,lastMacroDesc.macro->len,lastMacroDesc.macro->loop,lastMacroDesc.macro->rel);
+        int macroVals[256];
+        lastMacroDesc.macro->val.copyTo(macroVals);
+        encodeMMLStr(mmlStr,macroVals,lastMacroDesc.macro->len,lastMacroDesc.macro->loop,lastMacroDesc.macro->rel);
         SDL_SetClipboardText(mmlStr.c_str());
       }
       if (ImGui::MenuItem("paste")) {
@@ -6576,8 +6582,7 @@ void FurnaceGUI::drawInsEdit() {
         ImGui::InputInt("Y",&macroOffY,1,10);
         if (ImGui::Button("offset")) {
           int oldData[256];
-          memset(oldData,0,256*sizeof(int));
-          memcpy(oldData,lastMacroDesc.macro->val,lastMacroDesc.macro->len*sizeof(int));
+          lastMacroDesc.macro->val.copyTo(oldData);
 
           for (int i=0; i<lastMacroDesc.macro->len; i++) {
             int val=0;
@@ -6612,8 +6617,7 @@ void FurnaceGUI::drawInsEdit() {
         ImGui::InputFloat("Y",&macroScaleY,1.0f,10.0f,"%.2f%%");
         if (ImGui::Button("scale")) {
           int oldData[256];
-          memset(oldData,0,256*sizeof(int));
-          memcpy(oldData,lastMacroDesc.macro->val,lastMacroDesc.macro->len*sizeof(int));
+          lastMacroDesc.macro->val.copyTo(oldData);
 
           lastMacroDesc.macro->len=MIN(128,((double)lastMacroDesc.macro->len*(macroScaleX/100.0)));
 
@@ -68,6 +68,97 @@ void FurnaceGUI::popPartBlend() {
   rend->setBlendMode(GUI_BLEND_MODE_BLEND);
 }
 
+// get the pre-formatted cells of a pattern row.
+// cell 0 is the note, 1 the instrument, 2 the volume and then effect/value pairs,
+// each GUI_PAT_CELL_LEN bytes long.
+// labels end in a fixed ID (e.g. "##PN"); patternRow() pushes the row/channel ID.
+const char* FurnaceGUI::getPatCellRow(int chan, const DivPattern* pat, int row) {
+  PatCellCache* c=NULL;
+  PatCellCache* victim=&patCells[chan][0];
+  for (int i=0; i<GUI_PAT_CELL_SLOTS; i++) {
+    if (patCells[chan][i].pat==pat) {
+      c=&patCells[chan][i];
+      break;
+    }
+    if (patCells[chan][i].lastUsed<victim->lastUsed) victim=&patCells[chan][i];
+  }
+  if (c==NULL) {
+    c=victim;
+    c->pat=pat;
+    c->revision=pat->revision-1;
+  }
+  c->lastUsed=ImGui::GetFrameCount();
+
+  int rows=e->curSubSong->patLen;
+  int cols=3+e->curPat[chan].effectCols*2;
+  unsigned int key=(patCellEpoch<<3)|(settings.oneDigitEffects?1:0)|(settings.flatNotes?2:0)|(settings.germanNotation?4:0);
+  if (c->rows<rows || c->cols!=cols) {
+    delete[] c->rowGen;
+    delete[] c->text;
+    c->rows=rows;
+    c->cols=cols;
+    c->rowGen=new unsigned int[rows];
+    c->text=new char[rows*cols*GUI_PAT_CELL_LEN];
+    memset(c->rowGen,0,rows*sizeof(unsigned int));
+    c->gen=1;
+  } else if (c->revision!=pat->revision || c->key!=key) {
+    if (++c->gen==0) {
+      memset(c->rowGen,0,c->rows*sizeof(unsigned int));
+      c->gen=1;
+    }
+  }
+  c->revision=pat->revision;
+  c->key=key;
+
+  char* text=c->text+row*cols*GUI_PAT_CELL_LEN;
+  if (c->rowGen[row]==c->gen) return text;
+
+  const short* d=pat->data[row];
+  snprintf(text,GUI_PAT_CELL_LEN,"%.12s##PN",noteName(d[0],d[1]));
+  if (d[2]==-1) {
+    snprintf(text+GUI_PAT_CELL_LEN,GUI_PAT_CELL_LEN,"%.12s##PI",emptyLabel2);
+  } else {
+    snprintf(text+GUI_PAT_CELL_LEN,GUI_PAT_CELL_LEN,"%.2X##PI",d[2]);
+  }
+  if (d[3]==-1) {
+    snprintf(text+2*GUI_PAT_CELL_LEN,GUI_PAT_CELL_LEN,"%.12s##PV",emptyLabel2);
+  } else {
+    snprintf(text+2*GUI_PAT_CELL_LEN,GUI_PAT_CELL_LEN,"%.2X##PV",d[3]);
+  }
+  for (int k=0; k<e->curPat[chan].effectCols; k++) {
+    int index=4+(k<<1);
+    char* fx=text+(index-1)*GUI_PAT_CELL_LEN;
+    char* fxVal=text+index*GUI_PAT_CELL_LEN;
+    if (d[index]==-1) {
+      snprintf(fx,GUI_PAT_CELL_LEN,"%.12s##PE%d",emptyLabel2,k);
+    } else if (d[index]>0xff) {
+      snprintf(fx,GUI_PAT_CELL_LEN,"??##PE%d",k);
+    } else if (d[index]>=0x10 || settings.oneDigitEffects==0) {
+      snprintf(fx,GUI_PAT_CELL_LEN,"%.2X##PE%d",(unsigned char)d[index],k);
+    } else {
+      snprintf(fx,GUI_PAT_CELL_LEN," %.1X##PE%d",(unsigned char)d[index],k);
+    }
+    if (d[index+1]==-1) {
+      snprintf(fxVal,GUI_PAT_CELL_LEN,"%.12s##PF%d",emptyLabel2,k);
+    } else {
+      snprintf(fxVal,GUI_PAT_CELL_LEN,"%.2X##PF%d",d[index+1],k);
+    }
+  }
+  c->rowGen[row]=c->gen;
+  return text;
+}
+
+void FurnaceGUI::freePatCells() {
+  for (int i=0; i<DIV_MAX_CHANS; i++) {
+    for (int j=0; j<GUI_PAT_CELL_SLOTS; j++) {
+      PatCellCache& c=patCells[i][j];
+      delete[] c.rowGen;
+      delete[] c.text;
+      c=PatCellCache();
+    }
+  }
+}
+
 // draw a pattern row
 inline void FurnaceGUI::patternRow(int i, bool isPlaying, float lineHeight, int chans, int ord, const DivPattern** patCache, bool inhibitSel) {
   static char id[64];
@@ -162,7 +253,9 @@ inline void FurnaceGUI::patternRow(int i, bool isPlaying, float lineHeight, int
     int chanVolMax=e->getMaxVolumeChan(j);
     if (chanVolMax<1) chanVolMax=1;
     const DivPattern* pat=patCache[j];
+    const char* cells=getPatCellRow(j,pat,i);
     ImGui::TableNextColumn();
+    ImGui::PushID(i*DIV_MAX_CHANS+j);
     for (int k=mustSetXOf; k<=j; k++)  {
       patChanX[k]=ImGui::GetCursorScreenPos().x;
     }
@@ -180,7 +273,6 @@ inline void FurnaceGUI::patternRow(int i, bool isPlaying, float lineHeight, int
     bool cursorVol=(cursor.y==i && cursor.xCoarse==j && cursor.xFine==2 && curWindowLast==GUI_WINDOW_PATTERN);
 
     // note
-    snprintf(id,63,"%.31s##PN_%d_%d",noteName(pat->data[i][0],pat->data[i][1]),i,j);
     if (pat->data[i][0]==0 && pat->data[i][1]==0) {
       ImGui::PushStyleColor(ImGuiCol_Text,inactiveColor);
     } else {
@@ -190,12 +282,12 @@ inline void FurnaceGUI::patternRow(int i, bool isPlaying, float lineHeight, int
       ImGui::PushStyleColor(ImGuiCol_Header,uiColors[GUI_COLOR_PATTERN_CURSOR]);
       ImGui::PushStyleColor(ImGuiCol_HeaderActive,uiColors[GUI_COLOR_PATTERN_CURSOR_ACTIVE]);
       ImGui::PushStyleColor(ImGuiCol_HeaderHovered,uiColors[GUI_COLOR_PATTERN_CURSOR_HOVER]);
-      ImGui::Selectable(id,true,ImGuiSelectableFlags_NoPadWithHalfSpacing,noteCellSize);
+      ImGui::Selectable(cells,true,ImGuiSelectableFlags_NoPadWithHalfSpacing,noteCellSize);
       demandX=ImGui::GetCursorPosX();
       ImGui::PopStyleColor(3);
     } else {
       if (selectedNote) ImGui::PushStyleColor(ImGuiCol_Header,uiColors[GUI_COLOR_PATTERN_SELECTION]);
-      ImGui::Selectable(id,isPushing || selectedNote,ImGuiSelectableFlags_NoPadWithHalfSpacing,noteCellSize);
+      ImGui::Selectable(cells,isPushing || selectedNote,ImGuiSelectableFlags_NoPadWithHalfSpacing,noteCellSize);
       if (selectedNote) ImGui::PopStyleColor();
     }
     if (ImGui::IsItemClicked()) {
@@ -215,7 +307,6 @@ inline void FurnaceGUI::patternRow(int i, bool isPlaying, float lineHeight, int
       // instrument
       if (pat->data[i][2]==-1) {
         ImGui::PushStyleColor(ImGuiCol_Text,inactiveColor);
-        snprintf(id,63,"%.31s##PI_%d_%d",emptyLabel2,i,j);
       } else {
         if (pat->data[i][2]<0 || pat->data[i][2]>=e->song.insLen) {
           ImGui::PushStyleColor(ImGuiCol_Text,uiColors[GUI_COLOR_PATTERN_INS_ERROR]);
@@ -227,19 +318,18 @@ inline void FurnaceGUI::patternRow(int i, bool isPlaying, float lineHeight, int
             ImGui::PushStyleColor(ImGuiCol_Text,uiColors[GUI_COLOR_PATTERN_INS]);
           }
         }
-        snprintf(id,63,"%.2X##PI_%d_%d",pat->data[i][2],i,j);
       }
       ImGui::SameLine(0.0f,0.0f);
       if (cursorIns) {
         ImGui::PushStyleColor(ImGuiCol_Header,uiColors[GUI_COLOR_PATTERN_CURSOR]);
         ImGui::PushStyleColor(ImGuiCol_HeaderActive,uiColors[GUI_COLOR_PATTERN_CURSOR_ACTIVE]);
         ImGui::PushStyleColor(ImGuiCol_HeaderHovered,uiColors[GUI_COLOR_PATTERN_CURSOR_HOVER]);
-        ImGui::Selectable(id,true,ImGuiSelectableFlags_NoPadWithHalfSpacing,insCellSize);
+        ImGui::Selectable(cells+GUI_PAT_CELL_LEN,true,ImGuiSelectableFlags_NoPadWithHalfSpacing,insCellSize);
         demandX=ImGui::GetCursorPosX();
         ImGui::PopStyleColor(3);
       } else {
         if (selectedIns) ImGui::PushStyleColor(ImGuiCol_Header,uiColors[GUI_COLOR_PATTERN_SELECTION]);
-        ImGui::Selectable(id,isPushing || selectedIns,ImGuiSelectableFlags_NoPadWithHalfSpacing,insCellSize);
+        ImGui::Selectable(cells+GUI_PAT_CELL_LEN,isPushing || selectedIns,ImGuiSelectableFlags_NoPadWithHalfSpacing,insCellSize);
         if (selectedIns) ImGui::PopStyleColor();
       }
       if (ImGui::IsItemClicked()) {
@@ -258,13 +348,11 @@ inline void FurnaceGUI::patternRow(int i, bool isPlaying, float lineHeight, int
     if (e->curSubSong->chanCollapse[j]<2) {
       // volume
       if (pat->data[i][3]==-1) {
-        snprintf(id,63,"%.31s##PV_%d_%d",emptyLabel2,i,j);
         ImGui::PushStyleColor(ImGuiCol_Text,inactiveColor);
       } else {
         int volColor=(pat->data[i][3]*127)/chanVolMax;
         if (volColor>127) volColor=127;
         if (volColor<0) volColor=0;
-        snprintf(id,63,"%.2X##PV_%d_%d",pat->data[i][3],i,j);
         ImGui::PushStyleColor(ImGuiCol_Text,volColors[volColor]);
       }
       ImGui::SameLine(0.0f,0.0f);
@@ -272,12 +360,12 @@ inline void FurnaceGUI::patternRow(int i, bool isPlaying, float lineHeight, int
         ImGui::PushStyleColor(ImGuiCol_Header,uiColors[GUI_COLOR_PATTERN_CURSOR]);
         ImGui::PushStyleColor(ImGuiCol_HeaderActive,uiColors[GUI_COLOR_PATTERN_CURSOR_ACTIVE]);
         ImGui::PushStyleColor(ImGuiCol_HeaderHovered,uiColors[GUI_COLOR_PATTERN_CURSOR_HOVER]);
-        ImGui::Selectable(id,true,ImGuiSelectableFlags_NoPadWithHalfSpacing,volCellSize);
+        ImGui::Selectable(cells+2*GUI_PAT_CELL_LEN,true,ImGuiSelectableFlags_NoPadWithHalfSpacing,volCellSize);
         demandX=ImGui::GetCursorPosX();
         ImGui::PopStyleColor(3);
       } else {
         if (selectedVol) ImGui::PushStyleColor(ImGuiCol_Header,uiColors[GUI_COLOR_PATTERN_SELECTION]);
-        ImGui::Selectable(id,isPushing || selectedVol,ImGuiSelectableFlags_NoPadWithHalfSpacing,volCellSize);
+        ImGui::Selectable(cells+2*GUI_PAT_CELL_LEN,isPushing || selectedVol,ImGuiSelectableFlags_NoPadWithHalfSpacing,volCellSize);
         if (selectedVol) ImGui::PopStyleColor();
       }
       if (ImGui::IsItemClicked()) {
@@ -304,19 +392,12 @@ inline void FurnaceGUI::patternRow(int i, bool isPlaying, float lineHeight, int
         
         // effect
         if (pat->data[i][index]==-1) {
-          snprintf(id,63,"%.31s##PE%d_%d_%d",emptyLabel2,k,i,j);
           ImGui::PushStyleColor(ImGuiCol_Text,inactiveColor);
         } else {
           if (pat->data[i][index]>0xff) {
-            snprintf(id,63,"??##PE%d_%d_%d",k,i,j);
             ImGui::PushStyleColor(ImGuiCol_Text,uiColors[GUI_COLOR_PATTERN_EFFECT_INVALID]);
-          } else if (pat->data[i][index]>=0x10 || settings.oneDigitEffects==0) {
-            const unsigned char data=pat->data[i][index];
-            snprintf(id,63,"%.2X##PE%d_%d_%d",data,k,i,j);
-            ImGui::PushStyleColor(ImGuiCol_Text,uiColors[fxColors[data]]);
           } else {
             const unsigned char data=pat->data[i][index];
-            snprintf(id,63," %.1X##PE%d_%d_%d",data,k,i,j);
             ImGui::PushStyleColor(ImGuiCol_Text,uiColors[fxColors[data]]);
           }
         }
@@ -325,12 +406,12 @@ inline void FurnaceGUI::patternRow(int i, bool isPlaying, float lineHeight, int
           ImGui::PushStyleColor(ImGuiCol_Header,uiColors[GUI_COLOR_PATTERN_CURSOR]);  
           ImGui::PushStyleColor(ImGuiCol_HeaderActive,uiColors[GUI_COLOR_PATTERN_CURSOR_ACTIVE]);
           ImGui::PushStyleColor(ImGuiCol_HeaderHovered,uiColors[GUI_COLOR_PATTERN_CURSOR_HOVER]);
-          ImGui::Selectable(id,true,ImGuiSelectableFlags_NoPadWithHalfSpacing,effectCellSize);
+          ImGui::Selectable(cells+(index-1)*GUI_PAT_CELL_LEN,true,ImGuiSelectableFlags_NoPadWithHalfSpacing,effectCellSize);
           demandX=ImGui::GetCursorPosX();
           ImGui::PopStyleColor(3);
         } else {
           if (selectedEffect) ImGui::PushStyleColor(ImGuiCol_Header,uiColors[GUI_COLOR_PATTERN_SELECTION]);
-          ImGui::Selectable(id,isPushing || selectedEffect,ImGuiSelectableFlags_NoPadWithHalfSpacing,effectCellSize);
+          ImGui::Selectable(cells+(index-1)*GUI_PAT_CELL_LEN,isPushing || selectedEffect,ImGuiSelectableFlags_NoPadWithHalfSpacing,effectCellSize);
           if (selectedEffect) ImGui::PopStyleColor();
         }
         if (ImGui::IsItemClicked()) {
@@ -345,22 +426,17 @@ inline void FurnaceGUI::patternRow(int i, bool isPlaying, float lineHeight, int
         }
 
         // effect value
-        if (pat->data[i][index+1]==-1) {
-          snprintf(id,63,"%.31s##PF%d_%d_%d",emptyLabel2,k,i,j);
-        } else {
-          snprintf(id,63,"%.2X##PF%d_%d_%d",pat->data[i][index+1],k,i,j);
-        }
         ImGui::SameLine(0.0f,0.0f);
         if (cursorEffectVal) {
           ImGui::PushStyleColor(ImGuiCol_Header,uiColors[GUI_COLOR_PATTERN_CURSOR]);  
           ImGui::PushStyleColor(ImGuiCol_HeaderActive,uiColors[GUI_COLOR_PATTERN_CURSOR_ACTIVE]);
           ImGui::PushStyleColor(ImGuiCol_HeaderHovered,uiColors[GUI_COLOR_PATTERN_CURSOR_HOVER]);
-          ImGui::Selectable(id,true,ImGuiSelectableFlags_NoPadWithHalfSpacing,effectValCellSize);
+          ImGui::Selectable(cells+index*GUI_PAT_CELL_LEN,true,ImGuiSelectableFlags_NoPadWithHalfSpacing,effectValCellSize);
           demandX=ImGui::GetCursorPosX();
           ImGui::PopStyleColor(3);
         } else {
           if (selectedEffectVal) ImGui::PushStyleColor(ImGuiCol_Header,uiColors[GUI_COLOR_PATTERN_SELECTION]);
-          ImGui::Selectable(id,isPushing || selectedEffectVal,ImGuiSelectableFlags_NoPadWithHalfSpacing,effectValCellSize);
+          ImGui::Selectable(cells+index*GUI_PAT_CELL_LEN,isPushing || selectedEffectVal,ImGuiSelectableFlags_NoPadWithHalfSpacing,effectValCellSize);
           if (selectedEffectVal) ImGui::PopStyleColor();
         }
         if (ImGui::IsItemClicked()) {
@@ -376,6 +452,7 @@ inline void FurnaceGUI::patternRow(int i, bool isPlaying, float lineHeight, int
         ImGui::PopStyleColor();
       }
     }
+    ImGui::PopID();
   }
   if (isPushing) {
     ImGui::PopStyleColor();
@@ -1002,6 +1002,7 @@ void FurnaceGUI::drawSampleEdit() {
                 sample->data8[i]=val;
               }
             }
+            sample->invalidateSummary(start,end);
 
             updateSampleTex=true;
 
@@ -1212,6 +1213,7 @@ void FurnaceGUI::drawSampleEdit() {
                 sample->data8[i]=val;
               }
             }
+            sample->invalidateSummary(start,end);
 
             updateSampleTex=true;
 
@@ -1283,6 +1285,7 @@ void FurnaceGUI::drawSampleEdit() {
                   crossFadeOutput++;
                 }
               }
+              sample->invalidateSummary(sample->loopEnd-sampleCrossFadeLoopLength,sample->loopEnd);
               updateSampleTex=true;
 
               e->renderSamples(curSample);
@@ -1502,41 +1505,20 @@ void FurnaceGUI::drawSampleEdit() {
             for (unsigned int i=0; i<(unsigned int)availX; i++) {
               if (xCoarse>=sample->samples) break;
               int y1, y2;
-              int candMin=INT_MAX;
-              int candMax=INT_MIN;
+              int candMin=0;
+              int candMax=0;
               int totalAdvance=0;
-              if (sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
-                if (candMin>sample->data8[xCoarse]) candMin=sample->data8[xCoarse];
-                if (candMax<sample->data8[xCoarse]) candMax=sample->data8[xCoarse];
-              } else {
-                if (candMin>sample->data16[xCoarse]) candMin=sample->data16[xCoarse];
-                if (candMax<sample->data16[xCoarse]) candMax=sample->data16[xCoarse];
-              }
               xFine+=xAdvanceFine;
               if (xFine>=16777216) {
                 xFine-=16777216;
                 totalAdvance++;
               }
               totalAdvance+=xAdvanceCoarse;
-              if (xCoarse>=sample->samples) break;
-              do {
-                if (xCoarse>=sample->samples) break;
-                if (sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
-                  if (candMin>sample->data8[xCoarse]) candMin=sample->data8[xCoarse];
-                  if (candMax<sample->data8[xCoarse]) candMax=sample->data8[xCoarse];
-                } else {
-                  if (candMin>sample->data16[xCoarse]) candMin=sample->data16[xCoarse];
-                  if (candMax<sample->data16[xCoarse]) candMax=sample->data16[xCoarse];
-                }
-                if (totalAdvance>0) xCoarse++;
-              } while ((totalAdvance--)>0);
-              if (sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
-                y1=(((unsigned char)candMin^0x80)*availY)>>8;
-                y2=(((unsigned char)candMax^0x80)*availY)>>8;
-              } else {
-                y1=(((unsigned short)candMin^0x8000)*availY)>>16;
-                y2=(((unsigned short)candMax^0x8000)*availY)>>16;
-              }
+              // this column covers xCoarse to xCoarse+totalAdvance (inclusive)
+              if (!sample->getSummary(xCoarse,xCoarse+totalAdvance+1,candMin,candMax)) break;
+              xCoarse+=totalAdvance;
+              y1=(((unsigned short)candMin^0x8000)*availY)>>16;
+              y2=(((unsigned short)candMax^0x8000)*availY)>>16;
               if (y1>y2) {
                 y2^=y1;
                 y1^=y2;
@@ -1027,6 +1027,15 @@ void FurnaceGUI::drawSettings() {
             }
             popWarningColor();
           }
+
+          bool renderPoolBatchB=settings.renderPoolBatch;
+          if (ImGui::Checkbox("Render chips in batches (EXPERIMENTAL)",&renderPoolBatchB)) {
+            settings.renderPoolBatch=renderPoolBatchB;
+            settingsChanged=true;
+          }
+          if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("runs all ticks in a buffer first, and then renders each chip in one go.\nreduces the amount of synchronization between threads.\n\nonly some chips support this. the rest will be rendered normally.");
+          }
         }
 
         bool lowLatencyB=settings.lowLatency;
@@ -3756,6 +3765,7 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
 
     settings.chanOscThreads=conf.getInt("chanOscThreads",0);
     settings.renderPoolThreads=conf.getInt("renderPoolThreads",0);
+    settings.renderPoolBatch=conf.getInt("renderPoolBatch",0);
     settings.showPool=conf.getInt("showPool",0);
     settings.writeInsNames=conf.getInt("writeInsNames",0);
     settings.readInsNames=conf.getInt("readInsNames",1);
@@ -4180,6 +4190,7 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
   clampSetting(settings.wasapiEx,0,1);
   clampSetting(settings.chanOscThreads,0,256);
   clampSetting(settings.renderPoolThreads,0,DIV_MAX_CHIPS);
+  clampSetting(settings.renderPoolBatch,0,1);
   clampSetting(settings.showPool,0,1);
   clampSetting(settings.writeInsNames,0,1);
   clampSetting(settings.readInsNames,0,1);
@@ -4215,6 +4226,7 @@ void FurnaceGUI::writeConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
     
     conf.set("chanOscThreads",settings.chanOscThreads);
     conf.set("renderPoolThreads",settings.renderPoolThreads);
+    conf.set("renderPoolBatch",settings.renderPoolBatch);
     conf.set("showPool",settings.showPool);
     conf.set("writeInsNames",settings.writeInsNames);
     conf.set("readInsNames",settings.readInsNames);
@@ -4986,6 +4998,7 @@ void FurnaceGUI::applyUISettings(bool updateFonts) {
   setupLabel(settings.macroRelLabel.c_str(),macroRelLabel,3);
   setupLabel(settings.emptyLabel.c_str(),emptyLabel,3);
   setupLabel(settings.emptyLabel2.c_str(),emptyLabel2,2);
+  patCellEpoch++;
 
   if (updateFonts) {
     // get scale factor
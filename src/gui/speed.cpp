@@ -236,7 +236,7 @@ void FurnaceGUI::drawSpeed(bool asChild) {
       if (ImGui::InputInt("##PatLength",&patLen,1,16)) { MARK_MODIFIED
         if (patLen<1) patLen=1;
         if (patLen>DIV_MAX_PATTERNS) patLen=DIV_MAX_PATTERNS;
-        e->curSubSong->patLen=patLen;
+        e->setPatternLength(e->getCurrentSubSong(),patLen);
       }
 
       if (!basicMode) {
@@ -43,6 +43,7 @@ struct sigaction termsa;
 #endif
 
 #include "cli/cli.h"
+#include "cli/batch.h"
 
 #ifdef HAVE_GUI
 #include "gui/gui.h"
@@ -60,9 +61,12 @@ String outName;
 String vgmOutName;
 String zsmOutName;
 String cmdOutName;
+String batchName;
+String profileName;
 int loops=1;
 int benchMode=0;
 int subsong=-1;
+int jobs=0;
 DivAudioExportModes outMode=DIV_EXPORT_MODE_ONE;
 
 #ifdef HAVE_GUI
@@ -316,6 +320,21 @@ TAParamResult pOutMode(String val) {
   return TA_PARAM_SUCCESS;
 }
 
+TAParamResult pJobs(String val) {
+  try {
+    int v=std::stoi(val);
+    if (v<0) {
+      logE("job count shall be 0 or higher.");
+      return TA_PARAM_ERROR;
+    }
+    jobs=v;
+  } catch (std::exception& e) {
+    logE("job count shall be a number.");
+    return TA_PARAM_ERROR;
+  }
+  return TA_PARAM_SUCCESS;
+}
+
 TAParamResult pBenchmark(String val) {
   if (val=="render") {
     benchMode=1;
@@ -329,12 +348,23 @@ TAParamResult pBenchmark(String val) {
   return TA_PARAM_SUCCESS;
 }
 
+TAParamResult pProfile(String val) {
+  profileName=val;
+  return TA_PARAM_SUCCESS;
+}
+
 TAParamResult pOutput(String val) {
   outName=val;
   e.setAudio(DIV_AUDIO_DUMMY);
   return TA_PARAM_SUCCESS;
 }
 
+TAParamResult pBatch(String val) {
+  batchName=val;
+  e.setAudio(DIV_AUDIO_DUMMY);
+  return TA_PARAM_SUCCESS;
+}
+
 TAParamResult pVGMOut(String val) {
   vgmOutName=val;
   e.setAudio(DIV_AUDIO_DUMMY);
@@ -380,10 +410,13 @@ void initParams() {
   params.push_back(TAParam("l","loops",true,pLoops,"<count>","set number of loops (-1 means loop forever)"));
   params.push_back(TAParam("s","subsong",true,pSubSong,"<number>","set sub-song"));
   params.push_back(TAParam("o","outmode",true,pOutMode,"one|persys|perchan","set file output mode"));
+  params.push_back(TAParam("j","jobs",true,pJobs,"<count>","set number of channels to render at once in perchan mode, or songs at once in batch mode (0 means one per CPU core)"));
+  params.push_back(TAParam("R","batch",true,pBatch,"<filename>","render every song in a job list (- for standard input). each line is <input>[<TAB><output>]"));
   params.push_back(TAParam("S","safemode",false,pSafeMode,"","enable safe mode (software rendering and no audio)"));
   params.push_back(TAParam("A","safeaudio",false,pSafeModeAudio,"","enable safe mode (with audio"));
 
   params.push_back(TAParam("B","benchmark",true,pBenchmark,"render|seek","run performance test"));
+  params.push_back(TAParam("P","profile",true,pProfile,"<filename>","measure time spent in each stage and chip, and write the results to a file on exit (.csv or .json)"));
 
   params.push_back(TAParam("V","version",false,pVersion,"","view information about Furnace."));
   params.push_back(TAParam("W","warranty",false,pWarranty,"","view warranty disclaimer."));
@@ -464,6 +497,7 @@ int main(int argc, char** argv) {
   vgmOutName="";
   zsmOutName="";
   cmdOutName="";
+  profileName="";
 
   initParams();
 
@@ -516,6 +550,11 @@ int main(int argc, char** argv) {
 
   e.setConsoleMode(consoleMode);
 
+  // nobody is going to look at the oscilloscopes without a GUI
+  if (consoleMode || benchMode || infoMode || outName!="" || vgmOutName!="" || cmdOutName!="" || batchName!="") {
+    e.setOscCapture(false);
+  }
+
 #ifdef _WIN32
   if (consoleMode) {
     HANDLE winin=GetStdHandle(STD_INPUT_HANDLE);
@@ -531,7 +570,7 @@ int main(int argc, char** argv) {
   }
 #endif
 
-  if (fileName.empty() && consoleMode) {
+  if (fileName.empty() && consoleMode && batchName.empty()) {
     logI("usage: %s file",argv[0]);
     return 1;
   }
@@ -542,8 +581,8 @@ int main(int argc, char** argv) {
   }
 
 #ifdef HAVE_GUI
-  if (e.preInit(consoleMode || benchMode || infoMode || outName!="" || vgmOutName!="" || cmdOutName!="")) {
-    if (consoleMode || benchMode || infoMode || outName!="" || vgmOutName!="" || cmdOutName!="") {
+  if (e.preInit(consoleMode || benchMode || infoMode || outName!="" || vgmOutName!="" || cmdOutName!="" || batchName!="")) {
+    if (consoleMode || benchMode || infoMode || outName!="" || vgmOutName!="" || cmdOutName!="" || batchName!="") {
       logW("engine wants safe mode, but Furnace GUI is not going to start.");
     } else {
       safeMode=true;
@@ -555,7 +594,7 @@ int main(int argc, char** argv) {
   }
 #endif
 
-  if (safeMode && (consoleMode || benchMode || infoMode || outName!="" || vgmOutName!="" || cmdOutName!="")) {
+  if (safeMode && (consoleMode || benchMode || infoMode || outName!="" || vgmOutName!="" || cmdOutName!="" || batchName!="")) {
     logE("you can't use safe mode and console/export mode together.");
     return 1;
   }
@@ -564,7 +603,7 @@ int main(int argc, char** argv) {
     e.setAudio(DIV_AUDIO_DUMMY);
   }
 
-  if (!fileName.empty() && ((!e.getConfBool("tutIntroPlayed",false)) || e.getConfInt("alwaysPlayIntro",0)!=3 || consoleMode || benchMode || infoMode || outName!="" || vgmOutName!="" || cmdOutName!="")) {
+  if (!fileName.empty() && ((!e.getConfBool("tutIntroPlayed",false)) || e.getConfInt("alwaysPlayIntro",0)!=3 || consoleMode || benchMode || infoMode || outName!="" || vgmOutName!="" || cmdOutName!="" || batchName!="")) {
     logI("loading module...");
     FILE* f=ps_fopen(fileName.c_str(),"rb");
     if (f==NULL) {
@@ -645,6 +684,24 @@ int main(int argc, char** argv) {
     e.changeSongP(subsong);
   }
 
+  if (profileName!="") {
+    e.enableProfiler(true);
+  }
+
+  if (batchName!="") {
+    FurnaceBatch batch;
+    batch.bindEngine(&e);
+    batch.setOptions(loops,subsong,outMode);
+    if (!batch.readJobs(batchName)) {
+      reportError("could not read job list!");
+      finishLogFile();
+      return 1;
+    }
+    int failed=batch.run(jobs);
+    finishLogFile();
+    return (failed>0)?1:0;
+  }
+
   if (benchMode) {
     logI("starting benchmark!");
     if (benchMode==2) {
@@ -652,6 +709,7 @@ int main(int argc, char** argv) {
     } else {
       e.benchmarkPlayback();
     }
+    if (profileName!="") e.saveProfile(profileName.c_str());
     finishLogFile();
     return 0;
   }
@@ -691,9 +749,10 @@ int main(int argc, char** argv) {
     }
     if (outName!="") {
       e.setConsoleMode(true);
-      e.saveAudio(outName.c_str(),loops,outMode);
+      e.saveAudio(outName.c_str(),loops,outMode,0.0,jobs);
       e.waitAudioFile();
     }
+    if (profileName!="") e.saveProfile(profileName.c_str());
     finishLogFile();
     return 0;
   }
@@ -711,6 +770,7 @@ int main(int argc, char** argv) {
     if (cliSuccess) {
       cli.loop();
       cli.finish();
+      if (profileName!="") e.saveProfile(profileName.c_str());
       e.quit();
       finishLogFile();
       return 0;
@@ -769,6 +829,7 @@ int main(int argc, char** argv) {
   logE("GUI requested but GUI not compiled!");
 #endif
 
+  if (profileName!="") e.saveProfile(profileName.c_str());
   logI("stopping engine.");
   e.quit();
 
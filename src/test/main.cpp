@@ -0,0 +1,150 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2023 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+// furnace-test: golden-render regression runner.
+
+#include <stdio.h>
+#include "../ta-log.h"
+#include "../fileutils.h"
+#include "regression.h"
+
+DivEngine e;
+FurnaceRegression test;
+
+void printUsage(const char* argv0) {
+  printf("usage: %s [options] song...\n\n",argv0);
+  printf("renders every song and compares it against a reference list.\n\n");
+  printf("options:\n");
+  printf("  -r <file>     reference list (test/reference.txt by default)\n");
+  printf("  -p <dir>      also keep raw PCM references in dir, so that output can be compared with a tolerance\n");
+  printf("  -t <delta>    largest sample difference (16-bit) allowed when comparing PCM (0 by default)\n");
+  printf("  -u            update references instead of comparing\n");
+  printf("  -c            check that render instances (used by batch mode and background export) work first\n");
+  printf("  -j <count>    number of songs to render at once (0 means one per CPU core)\n");
+  printf("  -l <count>    number of loops (1 by default)\n");
+  printf("  -o <file>     write a report (.csv or .json)\n");
+  printf("  -v            verbose log\n");
+}
+
+int main(int argc, char** argv) {
+  String refPath="test/reference.txt";
+  String pcmDir;
+  String outName;
+  int tolerance=0;
+  int jobs=0;
+  int loops=1;
+  bool update=false;
+  bool checkInstances=false;
+  bool anySong=false;
+
+  initLog();
+  logLevel=LOGLEVEL_INFO;
+
+  for (int i=1; i<argc; i++) {
+    String arg=argv[i];
+    bool hasValue=(i+1<argc);
+    try {
+      if (arg=="-r" && hasValue) {
+        refPath=argv[++i];
+      } else if (arg=="-p" && hasValue) {
+        pcmDir=argv[++i];
+      } else if (arg=="-t" && hasValue) {
+        tolerance=std::stoi(argv[++i]);
+      } else if (arg=="-u") {
+        update=true;
+      } else if (arg=="-c") {
+        checkInstances=true;
+      } else if (arg=="-j" && hasValue) {
+        jobs=std::stoi(argv[++i]);
+      } else if (arg=="-l" && hasValue) {
+        loops=std::stoi(argv[++i]);
+      } else if (arg=="-o" && hasValue) {
+        outName=argv[++i];
+      } else if (arg=="-v") {
+        logLevel=LOGLEVEL_DEBUG;
+      } else if (arg=="-h" || arg=="--help") {
+        printUsage(argv[0]);
+        return 0;
+      } else if (!arg.empty() && arg[0]=='-') {
+        logE("invalid option %s.",arg);
+        printUsage(argv[0]);
+        return 1;
+      } else {
+        test.addSong(arg);
+        anySong=true;
+      }
+    } catch (std::exception& ex) {
+      logE("invalid value for %s.",arg);
+      return 1;
+    }
+  }
+
+  if (!anySong) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  if (!pcmDir.empty() && !dirExists(pcmDir.c_str())) {
+    if (!makeDir(pcmDir.c_str())) {
+      logE("could not create %s!",pcmDir);
+      return 1;
+    }
+  }
+
+  e.setAudio(DIV_AUDIO_DUMMY);
+  e.preInit(true);
+  if (!e.init()) {
+    logE("could not initialize engine!");
+    finishLogFile();
+    return 1;
+  }
+
+  test.bindEngine(&e);
+  test.setOptions(refPath,pcmDir,tolerance,loops,update);
+  if (!test.checkSynthesis()) {
+    e.quit();
+    finishLogFile();
+    return 1;
+  }
+  if (checkInstances && !test.checkRenderInstance()) {
+    e.quit();
+    finishLogFile();
+    return 1;
+  }
+  int failed=test.run(jobs);
+
+  if (!outName.empty()) {
+    String lowerName=outName;
+    for (char& i: lowerName) i=tolower(i);
+    bool csv=(lowerName.size()>=4 && lowerName.substr(lowerName.size()-4)==".csv");
+    String data=test.report(csv);
+    FILE* f=ps_fopen(outName.c_str(),"wb");
+    if (f!=NULL) {
+      fwrite(data.c_str(),1,data.size(),f);
+      fclose(f);
+    } else {
+      logE("could not write report! (%s)",strerror(errno));
+    }
+  }
+
+  e.quit();
+  finishLogFile();
+  return (failed>0)?1:0;
+}
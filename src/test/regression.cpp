@@ -0,0 +1,469 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2023 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "regression.h"
+#include "../ta-log.h"
+#include "../fileutils.h"
+#include "../engine/blip_buf.h"
+#include <chrono>
+#include <thread>
+
+static const char* statusNames[]={
+  "pending",
+  "ok",
+  "ok (within tolerance)",
+  "FAIL",
+  "new",
+  "error"
+};
+
+void _regressionWorker(FurnaceRegression* test, DivEngine* eng) {
+  test->runWorker(eng);
+}
+
+static unsigned long long hashPCM(const std::vector<short>& pcm) {
+  // FNV-1a over the little-endian samples
+  unsigned long long hash=0xcbf29ce484222325ULL;
+  for (short i: pcm) {
+    hash^=(unsigned char)(i&0xff);
+    hash*=0x100000001b3ULL;
+    hash^=(unsigned char)((i>>8)&0xff);
+    hash*=0x100000001b3ULL;
+  }
+  return hash;
+}
+
+FurnaceTestSong::FurnaceTestSong(const String& p):
+  path(p),
+  hasRef(false),
+  refFrames(0),
+  refHash(0),
+  status(FUR_TEST_PENDING),
+  frames(0),
+  hash(0),
+  maxDelta(0),
+  firstDiff(-1),
+  renderTime(0.0) {
+  size_t dirPos=p.find_last_of("/\\");
+  name=(dirPos==String::npos)?p:p.substr(dirPos+1);
+}
+
+void FurnaceRegression::bindEngine(DivEngine* eng) {
+  e=eng;
+}
+
+void FurnaceRegression::setOptions(const String& refs, const String& pcm, int tol, int loopCount, bool updateRefs) {
+  refPath=refs;
+  pcmDir=pcm;
+  tolerance=tol;
+  loops=loopCount;
+  update=updateRefs;
+}
+
+void FurnaceRegression::addSong(const String& path) {
+  songs.push_back(FurnaceTestSong(path));
+}
+
+bool FurnaceRegression::readReferences() {
+  FILE* f=ps_fopen(refPath.c_str(),"rb");
+  if (f==NULL) {
+    // every song will be new
+    if (!update) logW("could not open reference list! (%s)",strerror(errno));
+    return true;
+  }
+
+  // each line is <name><TAB><frames><TAB><hash>
+  char line[4096];
+  while (fgets(line,4096,f)!=NULL) {
+    String l=line;
+    while (!l.empty() && (l.back()=='\n' || l.back()=='\r')) l.pop_back();
+    if (l.empty()) continue;
+    if (l[0]=='#') continue;
+
+    size_t tab1=l.find('\t');
+    size_t tab2=(tab1==String::npos)?String::npos:l.find('\t',tab1+1);
+    if (tab2==String::npos) {
+      logW("invalid line in reference list: %s",l);
+      continue;
+    }
+    String name=l.substr(0,tab1);
+    size_t frames=strtoull(l.substr(tab1+1,tab2-tab1-1).c_str(),NULL,10);
+    unsigned long long hash=strtoull(l.substr(tab2+1).c_str(),NULL,16);
+    for (FurnaceTestSong& i: songs) {
+      if (i.name!=name) continue;
+      i.hasRef=true;
+      i.refFrames=frames;
+      i.refHash=hash;
+    }
+  }
+  fclose(f);
+  return true;
+}
+
+bool FurnaceRegression::writeReferences() {
+  // merge into the existing list, so that updating a subset of the songs
+  // doesn't drop the others. songs which failed to render keep their entry.
+  std::vector<String> lines;
+  std::vector<bool> written(songs.size(),false);
+  FILE* f=ps_fopen(refPath.c_str(),"rb");
+  if (f!=NULL) {
+    char line[4096];
+    while (fgets(line,4096,f)!=NULL) {
+      String l=line;
+      while (!l.empty() && (l.back()=='\n' || l.back()=='\r')) l.pop_back();
+      if (l.empty()) continue;
+      if (l[0]=='#') continue;
+
+      String name=l.substr(0,l.find('\t'));
+      for (size_t i=0; i<songs.size(); i++) {
+        if (songs[i].name!=name || songs[i].status==FUR_TEST_ERROR) continue;
+        if (!written[i]) {
+          l=fmt::sprintf("%s\t%d\t%.16llx",songs[i].name,(unsigned long long)songs[i].frames,songs[i].hash);
+          written[i]=true;
+        } else {
+          // duplicate entry
+          l="";
+        }
+        break;
+      }
+      if (!l.empty()) lines.push_back(l);
+    }
+    fclose(f);
+  }
+  for (size_t i=0; i<songs.size(); i++) {
+    if (written[i] || songs[i].status==FUR_TEST_ERROR) continue;
+    lines.push_back(fmt::sprintf("%s\t%d\t%.16llx",songs[i].name,(unsigned long long)songs[i].frames,songs[i].hash));
+    written[i]=true;
+  }
+
+  f=ps_fopen(refPath.c_str(),"wb");
+  if (f==NULL) {
+    logE("could not write reference list! (%s)",strerror(errno));
+    return false;
+  }
+  fputs("# furnace-test reference list\n# <name>\t<frames>\t<hash>\n",f);
+  for (String& i: lines) {
+    fputs(i.c_str(),f);
+    fputc('\n',f);
+  }
+  fclose(f);
+  return true;
+}
+
+bool FurnaceRegression::loadFile(const String& path, std::vector<unsigned char>& data, String& error) {
+  FILE* f=ps_fopen(path.c_str(),"rb");
+  if (f==NULL) {
+    error=strerror(errno);
+    return false;
+  }
+  unsigned char buf[4096];
+  size_t got;
+  data.clear();
+  while ((got=fread(buf,1,4096,f))>0) {
+    data.insert(data.end(),buf,buf+got);
+  }
+  fclose(f);
+  return true;
+}
+
+void FurnaceRegression::compare(FurnaceTestSong& song, const std::vector<short>& pcm) {
+  String pcmPath;
+  if (!pcmDir.empty()) pcmPath=pcmDir+DIR_SEPARATOR_STR+song.name+".pcm";
+
+  if (update) {
+    song.status=FUR_TEST_NEW;
+    if (!pcmPath.empty()) {
+      FILE* f=ps_fopen(pcmPath.c_str(),"wb");
+      if (f==NULL) {
+        song.status=FUR_TEST_ERROR;
+        song.error=fmt::sprintf("could not write PCM reference (%s)",strerror(errno));
+        return;
+      }
+      // stored as little-endian
+      for (short i: pcm) {
+        fputc(i&0xff,f);
+        fputc((i>>8)&0xff,f);
+      }
+      fclose(f);
+    }
+    return;
+  }
+
+  if (!song.hasRef) {
+    song.status=FUR_TEST_NEW;
+    return;
+  }
+  if (song.frames==song.refFrames && song.hash==song.refHash) {
+    song.status=FUR_TEST_PASS;
+    return;
+  }
+  song.status=FUR_TEST_FAIL;
+  if (song.frames!=song.refFrames) {
+    song.error=fmt::sprintf("length changed (%d -> %d frames)",(int)song.refFrames,(int)song.frames);
+  } else {
+    song.error="output changed";
+  }
+
+  // compare against the reference PCM if there is one
+  if (pcmPath.empty()) return;
+  std::vector<unsigned char> refData;
+  String error;
+  if (!loadFile(pcmPath,refData,error)) {
+    song.error+=fmt::sprintf(" (no PCM reference: %s)",error);
+    return;
+  }
+  size_t refSamples=refData.size()>>1;
+  size_t common=MIN(refSamples,pcm.size());
+  for (size_t i=0; i<common; i++) {
+    short ref=(short)(refData[i<<1]|(refData[1+(i<<1)]<<8));
+    int delta=abs((int)pcm[i]-(int)ref);
+    if (delta>song.maxDelta) song.maxDelta=delta;
+    if (delta>0 && song.firstDiff<0) song.firstDiff=i>>1;
+  }
+  if (refSamples!=pcm.size()) {
+    if (song.firstDiff<0) song.firstDiff=common>>1;
+    return;
+  }
+  if (song.maxDelta<=tolerance) {
+    song.status=FUR_TEST_WITHIN_TOLERANCE;
+    song.error="";
+  } else {
+    song.error=fmt::sprintf("output changed (max delta %d at frame %d)",song.maxDelta,(int)song.firstDiff);
+  }
+}
+
+bool FurnaceRegression::loadSong(DivEngine* eng, const String& path, String& error) {
+  std::vector<unsigned char> data;
+  if (!loadFile(path,data,error)) {
+    error=fmt::sprintf("could not open file (%s)",error);
+    return false;
+  }
+  if (data.empty()) {
+    error="file is empty";
+    return false;
+  }
+
+  // load() takes ownership of the buffer
+  unsigned char* file=new unsigned char[data.size()];
+  memcpy(file,data.data(),data.size());
+  if (!eng->load(file,data.size())) {
+    error=fmt::sprintf("could not load song (%s)",eng->getLastError());
+    return false;
+  }
+  return true;
+}
+
+void FurnaceRegression::runSong(DivEngine* eng, FurnaceTestSong& song) {
+  String error;
+  if (!loadSong(eng,song.path,error)) {
+    song.status=FUR_TEST_ERROR;
+    song.error=error;
+    return;
+  }
+
+  std::vector<short> pcm;
+  std::chrono::steady_clock::time_point renderStart=std::chrono::steady_clock::now();
+  eng->renderToBuffer(pcm,loops);
+  song.renderTime=std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-renderStart).count();
+
+  song.frames=pcm.size()>>1;
+  song.hash=hashPCM(pcm);
+  compare(song,pcm);
+}
+
+void FurnaceRegression::runWorker(DivEngine* eng) {
+  while (true) {
+    size_t which=nextSong++;
+    if (which>=songs.size()) break;
+    FurnaceTestSong& song=songs[which];
+    runSong(eng,song);
+    if (song.status==FUR_TEST_FAIL || song.status==FUR_TEST_ERROR) {
+      logE("[%d/%d] %s: %s (%s)",(int)which+1,(int)songs.size(),song.name,statusNames[song.status],song.error);
+    } else {
+      logI("[%d/%d] %s: %s (%.0fms)",(int)which+1,(int)songs.size(),song.name,statusNames[song.status],song.renderTime);
+    }
+  }
+}
+
+bool FurnaceRegression::checkRenderInstance() {
+  if (songs.empty()) return true;
+  const String& first=songs.front().path;
+  const String& second=songs.back().path;
+  String error;
+
+  logI("checking render instances...");
+  if (!loadSong(e,first,error)) {
+    logE("render instance check: %s: %s",first,error);
+    return false;
+  }
+
+  // a clone of the loaded song must render exactly like the song itself
+  DivEngine* inst=e->createRenderInstance();
+  if (inst==NULL) {
+    logE("render instance check: could not clone %s!",first);
+    return false;
+  }
+  std::vector<short> clonePCM;
+  inst->renderToBuffer(clonePCM,1);
+  inst->quit();
+  delete inst;
+
+  std::vector<short> pcm;
+  e->renderToBuffer(pcm,1);
+  if (pcm.empty() || clonePCM.size()!=pcm.size() || hashPCM(clonePCM)!=hashPCM(pcm)) {
+    logE("render instance check: %s: the clone renders differently! (%d/%d frames)",first,(int)(clonePCM.size()>>1),(int)(pcm.size()>>1));
+    return false;
+  }
+
+  // so must a background stream export, which also runs on a clone
+  DivStreamExportOptions opts;
+  opts.type=DIV_STREAM_EXPORT_COMMAND_BINARY;
+  DivStreamExport* job=e->startStreamExport(opts);
+  if (job==NULL) {
+    logE("render instance check: could not start stream export! (%s)",e->getLastError());
+    return false;
+  }
+  SafeWriter* w=job->finish();
+  if (w==NULL) {
+    logE("render instance check: stream export failed! (%s)",job->getError());
+    delete job;
+    return false;
+  }
+  w->finish();
+  delete w;
+  delete job;
+
+  // the parent must still be able to load and play songs afterwards
+  if (!loadSong(e,second,error)) {
+    logE("render instance check: %s: %s (after cloning)",second,error);
+    return false;
+  }
+  e->renderToBuffer(pcm,1);
+  if (pcm.empty()) {
+    logE("render instance check: %s: no output after cloning!",second);
+    return false;
+  }
+
+  logI("render instances OK.");
+  return true;
+}
+
+bool FurnaceRegression::checkSynthesis() {
+  const char* failed=blip_check_kernels();
+  if (failed!=NULL) {
+    logE("synthesis check: the %s kernel differs from the scalar one!",failed);
+    return false;
+  }
+  logI("synthesis kernels OK. (using %s)",blip_simd_name());
+  return true;
+}
+
+int FurnaceRegression::run(int threads) {
+  if (songs.empty()) return 0;
+  if (!readReferences()) return (int)songs.size();
+
+  if (threads<1) threads=std::thread::hardware_concurrency();
+  if (threads>(int)songs.size()) threads=songs.size();
+  if (threads<1) threads=1;
+
+  std::chrono::steady_clock::time_point timeStart=std::chrono::steady_clock::now();
+
+  std::vector<DivEngine*> engines;
+  for (int i=0; i<threads; i++) {
+    DivEngine* inst=e->createRenderInstance();
+    if (inst==NULL) break;
+    engines.push_back(inst);
+  }
+  if (engines.empty()) {
+    logE("could not create any render engine!");
+    return (int)songs.size();
+  }
+  logI("rendering %d songs with %d engines...",(int)songs.size(),(int)engines.size());
+
+  nextSong=0;
+  std::vector<std::thread*> workers;
+  for (DivEngine* i: engines) {
+    workers.push_back(new std::thread(_regressionWorker,this,i));
+  }
+  for (std::thread* i: workers) {
+    i->join();
+    delete i;
+  }
+  for (DivEngine* i: engines) {
+    i->quit();
+    delete i;
+  }
+
+  if (update) {
+    if (!writeReferences()) return (int)songs.size();
+  }
+
+  int failed=0;
+  for (FurnaceTestSong& i: songs) {
+    if (i.status==FUR_TEST_FAIL || i.status==FUR_TEST_ERROR) failed++;
+  }
+
+  std::chrono::steady_clock::time_point timeEnd=std::chrono::steady_clock::now();
+  logI("%d songs done in %dms (%d failed).",(int)songs.size(),(int)std::chrono::duration_cast<std::chrono::milliseconds>(timeEnd-timeStart).count(),failed);
+  return failed;
+}
+
+String FurnaceRegression::report(bool csv) {
+  String ret;
+  if (csv) {
+    ret="name,status,frames,hash,render_ms,max_delta,first_diff,error\n";
+    for (FurnaceTestSong& i: songs) {
+      String err;
+      for (char c: i.error) {
+        if (c=='"') err+='"';
+        err+=c;
+      }
+      ret+=fmt::sprintf("\"%s\",%s,%d,%.16llx,%.2f,%d,%d,\"%s\"\n",i.name,statusNames[i.status],(int)i.frames,i.hash,i.renderTime,i.maxDelta,(int)i.firstDiff,err);
+    }
+    return ret;
+  }
+
+  ret="{\n  \"songs\": [\n";
+  for (size_t j=0; j<songs.size(); j++) {
+    FurnaceTestSong& i=songs[j];
+    String name, err;
+    for (char c: i.name) {
+      if (c=='"' || c=='\\') name+='\\';
+      name+=c;
+    }
+    for (char c: i.error) {
+      if (c=='"' || c=='\\') err+='\\';
+      err+=c;
+    }
+    ret+=fmt::sprintf("    {\"name\": \"%s\", \"status\": \"%s\", \"frames\": %d, \"hash\": \"%.16llx\", \"renderMs\": %.2f, \"maxDelta\": %d, \"firstDiff\": %d, \"error\": \"%s\"}%s\n",
+      name,statusNames[i.status],(int)i.frames,i.hash,i.renderTime,i.maxDelta,(int)i.firstDiff,err,
+      (j<songs.size()-1)?",":""
+    );
+  }
+  ret+="  ]\n}\n";
+  return ret;
+}
+
+FurnaceRegression::FurnaceRegression():
+  e(NULL),
+  nextSong(0),
+  tolerance(0),
+  loops(1),
+  update(false) {}
@@ -0,0 +1,99 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2023 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef _FUR_REGRESSION_H
+#define _FUR_REGRESSION_H
+
+#include "../engine/engine.h"
+
+enum FurnaceTestStatus {
+  FUR_TEST_PENDING=0,
+  FUR_TEST_PASS,
+  FUR_TEST_WITHIN_TOLERANCE,
+  FUR_TEST_FAIL,
+  FUR_TEST_NEW,
+  FUR_TEST_ERROR
+};
+
+struct FurnaceTestSong {
+  String path;
+  // file name without directory. used as key in the reference list
+  String name;
+
+  // reference
+  bool hasRef;
+  size_t refFrames;
+  unsigned long long refHash;
+
+  // result
+  FurnaceTestStatus status;
+  size_t frames;
+  unsigned long long hash;
+  // largest difference against the reference PCM (in 16-bit units)
+  int maxDelta;
+  // first frame which differs, or -1
+  ssize_t firstDiff;
+  double renderTime;
+  String error;
+
+  FurnaceTestSong(const String& p);
+};
+
+// renders songs in-process and compares them against a list of reference hashes.
+// optionally, the rendered PCM is kept to compare with a tolerance.
+class FurnaceRegression {
+  DivEngine* e;
+  std::vector<FurnaceTestSong> songs;
+  std::atomic<size_t> nextSong;
+  String refPath;
+  String pcmDir;
+  int tolerance, loops;
+  bool update;
+
+  bool loadFile(const String& path, std::vector<unsigned char>& data, String& error);
+  bool loadSong(DivEngine* eng, const String& path, String& error);
+  void compare(FurnaceTestSong& song, const std::vector<short>& pcm);
+  void runSong(DivEngine* eng, FurnaceTestSong& song);
+
+  public:
+    void runWorker(DivEngine* eng);
+    void bindEngine(DivEngine* eng);
+    // pcm: directory with raw PCM references (empty to only use hashes).
+    // tol: largest difference allowed when comparing PCM.
+    // updateRefs: write new references instead of comparing.
+    void setOptions(const String& refs, const String& pcm, int tol, int loopCount, bool updateRefs);
+    void addSong(const String& path);
+    bool readReferences();
+    bool writeReferences();
+    // load the first song, clone it with createRenderInstance() and check that
+    // both render the same, and export it in the background through another
+    // clone. then load and play the last song in the original engine.
+    bool checkRenderInstance();
+    // check that the SIMD kernels of band-limited synthesis produce the same
+    // output as the scalar one. doesn't need any songs.
+    bool checkSynthesis();
+    // render and check all songs using up to threads engines (0 means one per CPU core).
+    // returns the number of failed songs.
+    int run(int threads);
+    String report(bool csv);
+    FurnaceRegression();
+};
+
+#endif
@@ -0,0 +1,24 @@
+#!/bin/bash
+# renders all files in test/songs/ and checks them against test/reference.txt.
+# useful when doing changes to playback.
+# requires furnace-test (configure with -DBUILD_REGRESSION_TEST=ON).
+# test/furnace-test.sh is the older render+delta pipeline which doesn't need it.
+# extra arguments are passed to furnace-test, e.g.:
+# - `-u` to accept the current output as the new reference
+# - `-p test/reference` to also keep raw PCM references in test/reference/
+# - `-p test/reference -t 4` to allow small differences against those
+
+runner=${FURNACE_TEST:-./build/furnace-test}
+
+if [ ! -x "$runner" ]; then
+  echo "$runner not found. build it with -DBUILD_REGRESSION_TEST=ON."
+  exit 1
+fi
+
+if [ ! -e "test/songs" ]; then
+  echo "test/songs not found."
+  exit 1
+fi
+
+echo "furnace test suite begin..."
+exec "$runner" -c -r test/reference.txt -o test/report.csv "$@" test/songs/*